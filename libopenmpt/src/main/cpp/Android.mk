@@ -76,6 +76,16 @@ endif
 
 LOCAL_SRC_FILES := 
 
+ifeq ($(MPT_FLOATMIXER),1)
+LOCAL_CFLAGS     += -DMPT_FLOATMIXER
+LOCAL_CPPFLAGS   +=#-DMPT_FLOATMIXER
+endif
+
+ifeq ($(MPT_NEON_KERNELS),1)
+LOCAL_CFLAGS     += -DMPT_NEON_KERNELS
+LOCAL_CPPFLAGS   +=#-DMPT_NEON_KERNELS
+endif
+
 ifeq ($(MPT_WITH_MINIMP3),1)
 LOCAL_CFLAGS     += -DMPT_WITH_MINIMP3
 LOCAL_CPPFLAGS   +=#-DMPT_WITH_MINIMP3
@@ -212,6 +222,8 @@ LOCAL_SRC_FILES += \
 	soundlib/MixerLoops.cpp \
 	soundlib/MixerSettings.cpp \
 	soundlib/MixFuncTable.cpp \
+	soundlib/MixFuncTableAVX2.cpp \
+	soundlib/MixThreadPool.cpp \
 	soundlib/ModChannel.cpp \
 	soundlib/modcommand.cpp \
 	soundlib/ModInstrument.cpp \
@@ -228,6 +240,8 @@ LOCAL_SRC_FILES += \
 	soundlib/pattern.cpp \
 	soundlib/PlaybackTest.cpp \
 	soundlib/PlayState.cpp \
+	soundlib/RenderProfile.cpp \
+	soundlib/ResamplerTables.cpp \
 	soundlib/RowVisitor.cpp \
 	soundlib/S3MTools.cpp \
 	soundlib/SampleFormats.cpp \
@@ -0,0 +1,108 @@
+/*
+ * gen_resampler_tables.cpp
+ * ------------------------
+ * Purpose: Generates soundlib/ResamplerTables.cpp, the precomputed resampler and Amiga BLEP tables for the default resampler settings.
+ * Notes  : Run `make resampler-tables` after changing anything that affects the table contents.
+ *          The tables are computed with CResampler(true), which never uses the precomputed tables itself.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#include "stdafx.h"
+
+#include "../../soundlib/Resampler.h"
+
+#include <iostream>
+#include <memory>
+
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+template <typename T>
+static void WriteValues(std::ostream &out, const T *data, std::size_t count, const char *indent)
+{
+	for(std::size_t i = 0; i < count; i++)
+	{
+		if((i % 16) == 0)
+			out << indent;
+		else
+			out << " ";
+		out << static_cast<int64>(data[i]) << ",";
+		if((i % 16) == 15 || i + 1 == count)
+			out << "\n";
+	}
+}
+
+
+template <typename T>
+static void WriteTable(std::ostream &out, const char *type, const char *name, const char *size, const T *data, std::size_t count)
+{
+	out << "const " << type << " " << name << "[" << size << "] =\n{\n";
+	WriteValues(out, data, count, "\t");
+	out << "};\n\n";
+}
+
+
+static int GenerateResamplerTables(std::ostream &out)
+{
+#ifndef MPT_INTMIXER
+	std::cerr << "Precomputed resampler tables are only used by the integer mixer." << std::endl;
+	return 1;
+#else
+	const auto resampler = std::make_unique<CResampler>(true);
+
+	out << "/*\n";
+	out << " * ResamplerTables.cpp\n";
+	out << " * -------------------\n";
+	out << " * Purpose: Precomputed resampler and Amiga BLEP tables for the default resampler settings of the integer mixer.\n";
+	out << " * Notes  : Generated by build/gen/gen_resampler_tables.cpp (`make resampler-tables`). Do not edit.\n";
+	out << " * Authors: OpenMPT Devs\n";
+	out << " * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.\n";
+	out << " */\n\n\n";
+	out << "#include \"stdafx.h\"\n";
+	out << "#include \"ResamplerTables.h\"\n\n";
+	out << "#ifdef MPT_RESAMPLER_TABLES_PRECOMPUTED\n\n";
+	out << "OPENMPT_NAMESPACE_BEGIN\n\n\n";
+	out << "static_assert(SINC_PHASES * 8 == " << (SINC_PHASES * 8) << ");\n";
+	out << "static_assert(WFIR_LUTLEN * WFIR_WIDTH == " << (WFIR_LUTLEN * WFIR_WIDTH) << ");\n";
+	out << "static_assert(Paula::BLEP_SIZE == " << Paula::BLEP_SIZE << ");\n\n\n";
+	out << "namespace ResamplerTables\n{\n\n";
+	WriteTable(out, "SINC_TYPE", "KaiserSinc", "SINC_PHASES * 8", resampler->gKaiserSinc, SINC_PHASES * 8);
+	WriteTable(out, "SINC_TYPE", "Downsample13x", "SINC_PHASES * 8", resampler->gDownsample13x, SINC_PHASES * 8);
+	WriteTable(out, "SINC_TYPE", "Downsample2x", "SINC_PHASES * 8", resampler->gDownsample2x, SINC_PHASES * 8);
+	WriteTable(out, "WFIR_TYPE", "WindowedFIR", "WFIR_LUTLEN * WFIR_WIDTH", resampler->m_WindowedFIR.lut, WFIR_LUTLEN * WFIR_WIDTH);
+	const std::pair<Resampling::AmigaFilter, bool> blepTypes[] =
+	{
+		{Resampling::AmigaFilter::A500, false},
+		{Resampling::AmigaFilter::A500, true},
+		{Resampling::AmigaFilter::A1200, false},
+		{Resampling::AmigaFilter::A1200, true},
+		{Resampling::AmigaFilter::Unfiltered, false},
+	};
+	static_assert(std::size(blepTypes) == Paula::BlepTables::NumTables);
+	out << "const mixsample_t AmigaBlep[Paula::BlepTables::NumTables][Paula::BLEP_SIZE] =\n{\n";
+	for(const auto &[amigaType, enableFilter] : blepTypes)
+	{
+		const Paula::BlepArray &table = resampler->blepTables.GetAmigaTable(amigaType, enableFilter);
+		out << "\t{\n";
+		WriteValues(out, table.data(), table.size(), "\t\t");
+		out << "\t},\n";
+	}
+	out << "};\n\n";
+	out << "}  // namespace ResamplerTables\n\n\n";
+	out << "OPENMPT_NAMESPACE_END\n\n";
+	out << "#endif  // MPT_RESAMPLER_TABLES_PRECOMPUTED\n";
+	return out ? 0 : 1;
+#endif  // MPT_INTMIXER
+}
+
+
+OPENMPT_NAMESPACE_END
+
+
+int main()
+{
+	return OPENMPT_NAMESPACE::GenerateResamplerTables(std::cout);
+}
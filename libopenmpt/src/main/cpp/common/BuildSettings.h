@@ -116,6 +116,12 @@
 // Use architecture-specific intrinsics
 #define MPT_ENABLE_ARCH_INTRINSICS
 
+// Allow spreading voice mixing over worker threads (opt-in at runtime)
+#define MPT_ENABLE_MIX_THREADS
+
+// Per-stage timing of the render path (opt-in at runtime)
+#define MPT_ENABLE_RENDER_PROFILE
+
 #define MPT_ENABLE_UPDATE
 
 #if defined(MPT_BUILD_DEBUG)
@@ -177,8 +183,16 @@
 #else
 //#define MPT_ENABLE_CHARSET_LOCALE
 #endif
-// Do not use architecture-specifid intrinsics in library builds. There is just about no codepath which would use it anyway.
-//#define MPT_ENABLE_ARCH_INTRINSICS
+// Use architecture-specific intrinsics. The mixer selects its SIMD implementation at runtime.
+#define MPT_ENABLE_ARCH_INTRINSICS
+// Allow spreading voice mixing over worker threads (opt-in at runtime, see render.mix_threads)
+#define MPT_ENABLE_MIX_THREADS
+// Allow mapping uncompressed sample data directly from memory-mapped module files (opt-in at runtime, see load.map_sample_data)
+#define MPT_ENABLE_MAPPED_SAMPLES
+// Per-stage timing of the render path (opt-in at runtime, see profile.enabled)
+#if !defined(MPT_BUILD_NO_RENDER_PROFILE)
+#define MPT_ENABLE_RENDER_PROFILE
+#endif
 #if defined(MPT_BUILD_HACK_ARCHIVE_SUPPORT)
 //#define NO_ARCHIVE_SUPPORT
 #else
@@ -240,6 +254,7 @@
 
 #define MPT_WANT_ARCH_INTRINSICS_X86_SSE
 #define MPT_WANT_ARCH_INTRINSICS_X86_SSE2
+#define MPT_WANT_ARCH_INTRINSICS_X86_AVX2
 
 #elif MPT_ARCH_AMD64
 
@@ -247,10 +262,30 @@
 
 #define MPT_WANT_ARCH_INTRINSICS_X86_SSE
 #define MPT_WANT_ARCH_INTRINSICS_X86_SSE2
+#define MPT_WANT_ARCH_INTRINSICS_X86_AVX2
+
+#elif MPT_ARCH_AARCH64
+
+#define MPT_WANT_ARCH_INTRINSICS_ARM_NEON
+
+#elif MPT_ARCH_ARM
+
+#if defined(MPT_NEON_KERNELS)
+// The NEON kernels are only tested on AArch64, so they are opt-in on 32-bit ARM
+#define MPT_WANT_ARCH_INTRINSICS_ARM_NEON
+#endif
 
 #endif // arch
 #endif // MPT_ENABLE_ARCH_INTRINSICS
 
+#if defined(MPT_LIBCXX_QUIRK_NO_STD_THREAD) && defined(MPT_ENABLE_MIX_THREADS)
+#undef MPT_ENABLE_MIX_THREADS // Parallel mixing requires std::thread
+#endif
+
+#if (MPT_OS_WINDOWS || MPT_OS_DJGPP || MPT_OS_EMSCRIPTEN) && defined(MPT_ENABLE_MAPPED_SAMPLES)
+#undef MPT_ENABLE_MAPPED_SAMPLES // Mapped samples require POSIX mmap with MAP_FIXED
+#endif
+
 #if defined(ENABLE_TESTS) && defined(MODPLUG_NO_FILESAVE)
 #undef MODPLUG_NO_FILESAVE // tests recommend file saving
 #endif
@@ -54,8 +54,13 @@
  *
  * \section libopenmpt_c_fileio File I/O
  *
- * libopenmpt can use 3 different strategies for file I/O.
+ * libopenmpt can use 4 different strategies for file I/O.
  *
+ * - openmpt_module_create_from_file() will load the module from the named
+ * file. On POSIX systems, the file is memory-mapped and the loaders read
+ * directly from the operating system page cache, which means neither a copy
+ * of the file nor per-read callbacks are required. Files that cannot be mapped
+ * (and all files on other systems) are read via a seekable stream instead.
  * - openmpt_module_create_from_memory2() will load the module from the provided
  * memory buffer, which will require loading all data upfront by the library
  * caller.
@@ -71,13 +76,15 @@
  *
  * | create function                                 | speed  | memory consumption |
  * | ----------------------------------------------: | :----: | :----------------: |
+ * | openmpt_module_create_from_file()               | <p style="background-color:green" >fast  </p> | <p style="background-color:green" >low   </p> |
  * | openmpt_module_create_from_memory2()            | <p style="background-color:green" >fast  </p> | <p style="background-color:yellow">medium</p> | 
  * | openmpt_module_create2() with seekable stream   | <p style="background-color:red"   >slow  </p> | <p style="background-color:green" >low   </p> |
  * | openmpt_module_create2() with unseekable stream | <p style="background-color:yellow">medium</p> | <p style="background-color:red"   >high  </p> |
  *
  * In all cases, the data or stream passed to the create function is no longer
  * needed after the openmpt_module has been created and can be freed by the
- * caller.
+ * caller. openmpt_module_create_from_file() releases the mapping before it
+ * returns.
  *
  * \section libopenmpt_c_outputformat Output Format
  *
@@ -654,6 +661,71 @@ LIBOPENMPT_API int openmpt_probe_file_header_without_filesize( uint64_t flags, c
  */
 LIBOPENMPT_API int openmpt_probe_file_header_from_stream( uint64_t flags, openmpt_stream_callbacks stream_callbacks, void * stream, openmpt_log_func logfunc, void * loguser, openmpt_error_func errfunc, void * erruser, int * error, const char * * error_message );
 
+/*! \brief Subsong cache lookup callback
+ *
+ * \param user User-defined data passed to openmpt_subsong_cache_set_callbacks().
+ * \param key Cache key, see openmpt_subsong_cache_get_key().
+ * \param value Buffer that receives the stored value as a zero-terminated string.
+ * \param value_size Size of the value buffer in bytes.
+ * \return 0 if the key was not found, otherwise the size in bytes of the stored value including the terminating zero. If this is larger than value_size, the buffer contents are ignored and the callback is invoked again with a sufficiently large buffer.
+ */
+typedef size_t (*openmpt_subsong_cache_lookup_func)( void * user, const char * key, char * value, size_t value_size );
+
+/*! \brief Subsong cache store callback
+ *
+ * \param user User-defined data passed to openmpt_subsong_cache_set_callbacks().
+ * \param key Cache key, see openmpt_subsong_cache_get_key().
+ * \param value Opaque zero-terminated value to store. Replaces any previously stored value for the same key.
+ */
+typedef void (*openmpt_subsong_cache_store_func)( void * user, const char * key, const char * value );
+
+/*! \brief Subsong cache invalidate callback
+ *
+ * \param user User-defined data passed to openmpt_subsong_cache_set_callbacks().
+ * \param key Cache key of the entry to remove, or NULL to remove all entries.
+ */
+typedef void (*openmpt_subsong_cache_invalidate_func)( void * user, const char * key );
+
+/*! \brief Use the default on-disk subsong cache for all subsequently loaded modules
+ *
+ * Loading a module normally simulates playback of every sequence once in order to determine subsong durations and start/restart positions. With a subsong cache registered, these results are stored keyed by the module file contents and loading the same file again skips the simulation.
+ * \param path Path of the cache file, or NULL to disable caching (the default). The file is created on the first store if it does not exist yet.
+ * \return 1 on success, 0 on failure.
+ * \remarks Modules loaded with the ctl load.skip_subsongs_init or load.skip_patterns set neither query nor update the cache.
+ * \remarks Only modules loaded from memory, from a file name, or from an unseekable stream use the cache. Modules loaded from seekable streams neither query nor update it.
+ * \remarks Cached values record the libopenmpt core version and the load settings they were created with. Values that do not match are treated as a cache miss and get replaced.
+ * \remarks The cache keeps at most 4096 entries. Storing more entries drops the entries that were stored first.
+ * \sa openmpt_subsong_cache_set_callbacks()
+ */
+LIBOPENMPT_API int openmpt_subsong_cache_set_file( const char * path );
+
+/*! \brief Use a custom subsong cache for all subsequently loaded modules
+ *
+ * \param lookup Lookup callback, or NULL to disable caching.
+ * \param store Store callback, or NULL to disable caching.
+ * \param invalidate Invalidate callback. May be NULL.
+ * \param user User-defined data passed to all callbacks.
+ * \return 1 on success, 0 on failure.
+ * \remarks The callbacks may be invoked concurrently from all threads that load modules and must be thread-safe.
+ * \sa openmpt_subsong_cache_set_file()
+ */
+LIBOPENMPT_API int openmpt_subsong_cache_set_callbacks( openmpt_subsong_cache_lookup_func lookup, openmpt_subsong_cache_store_func store, openmpt_subsong_cache_invalidate_func invalidate, void * user );
+
+/*! \brief Remove entries from the registered subsong cache
+ *
+ * \param key Cache key as returned by openmpt_subsong_cache_get_key(), or NULL to remove all entries.
+ * \remarks Does nothing if no cache is registered.
+ */
+LIBOPENMPT_API void openmpt_subsong_cache_invalidate( const char * key );
+
+/*! \brief Calculate the subsong cache key for a module file
+ *
+ * \param filedata Data of the module file.
+ * \param filesize Size of the module file in bytes.
+ * \return The cache key, or NULL on failure. The returned string must be freed with openmpt_free_string().
+ */
+LIBOPENMPT_API const char * openmpt_subsong_cache_get_key( const void * filedata, size_t filesize );
+
 
 /*! \brief Opaque type representing a libopenmpt module
  */
@@ -730,6 +802,23 @@ LIBOPENMPT_API LIBOPENMPT_DEPRECATED openmpt_module * openmpt_module_create_from
  */
 LIBOPENMPT_API openmpt_module * openmpt_module_create_from_memory2( const void * filedata, size_t filesize, openmpt_log_func logfunc, void * loguser, openmpt_error_func errfunc, void * erruser, int * error, const char * * error_message, const openmpt_module_initial_ctl * ctls );
 
+/*! \brief Construct an openmpt_module from a file
+ *
+ * \param filename Path of the file to load the module from, encoded in UTF-8.
+ * \param logfunc Logging function where warning and errors are written. The logging function may be called throughout the lifetime of openmpt_module. May be NULL.
+ * \param loguser User-defined data associated with this module. This value will be passed to the logging callback function (logfunc)
+ * \param errfunc Error function to define error behaviour. May be NULL.
+ * \param erruser Error function user context. Used to pass any user-defined data associated with this module to the logging function.
+ * \param error Pointer to an integer where an error may get stored. May be NULL.
+ * \param error_message Pointer to a string pointer where an error message may get stored. May be NULL.
+ * \param ctls An array of initial ctl and value pairs stored in \ref openmpt_module_initial_ctl, terminated by a pair of NULL and NULL. See \ref openmpt_module_get_ctls and \ref openmpt_module_ctl_set.
+ * \return A pointer to the constructed openmpt_module, or NULL on failure.
+ * \remarks On POSIX systems, regular files are memory-mapped while loading. The file must not be truncated by another process during that time.
+ * \remarks The file is closed and unmapped before this function returns.
+ * \sa \ref libopenmpt_c_fileio
+ */
+LIBOPENMPT_API openmpt_module * openmpt_module_create_from_file( const char * filename, openmpt_log_func logfunc, void * loguser, openmpt_error_func errfunc, void * erruser, int * error, const char * * error_message, const openmpt_module_initial_ctl * ctls );
+
 /*! \brief Unload a previously created openmpt_module from memory.
  *
  * \param mod The module to unload.
@@ -1167,6 +1256,7 @@ LIBOPENMPT_API const char * openmpt_module_get_metadata_keys( openmpt_module * m
  *          - message: Song message. If the song message is empty or the module format does not support song messages, a list of instrument and sample names is returned instead.
  *          - message_raw: Song message. If the song message is empty or the module format does not support song messages, an empty string is returned.
  *          - warnings: A list of warnings that were generated while loading the module.
+ *          - sample_memory: Number of bytes of memory currently used by decoded sample data, including the interpolation lookahead buffers, after any reductions made to fit into load.sample_memory_budget. Samples that have not been decoded yet (see load.lazy_samples) are not counted.
  * \return The associated value for key.
  * \sa openmpt_module_get_metadata_keys
  */
@@ -1502,10 +1592,15 @@ LIBOPENMPT_API const char * openmpt_module_highlight_pattern_row_channel( openmp
  * \return A semicolon-separated list containing all supported ctl keys.
  * \remarks Currently supported ctl values are:
  *          - load.skip_samples (boolean): Set to "1" to avoid loading samples into memory
+ *          - load.lazy_samples (boolean): Set to "1" to decode sample data only when a sample is played for the first time instead of when loading the module. This makes loading faster and saves memory for samples that are never played. If any sample was deferred, a copy of the module file is kept in memory until all samples have been decoded (unless the module was loaded with openmpt_module_create_from_file()). Samples are decoded and allocated inside the render functions, mostly one row before they are played, so rendering is not real-time safe with this option. Currently only supported for IT and MPTM files.
+ *          - load.map_sample_data (boolean): Set to "1" to map uncompressed sample data directly from the module file instead of copying it into memory. Sample memory is then backed by the file and only pages that are actually played are read from disk. Only effective for modules loaded with openmpt_module_create_from_file() on POSIX systems, and only for uncompressed sample data in IT, MPTM, MOD and S3M files. Has no effect if load.lazy_samples is enabled. The file must not be modified while the module is loaded. Sample data that has not been played before is read from disk by the render functions when it is first accessed, so rendering is not real-time safe with this option. Has to be passed to the module constructor to have any effect.
+ *          - load.sample_decode_threads (integer): Number of threads used for decoding compressed samples while loading the module. 0 uses one thread per CPU core, 1 (the default) decodes on the calling thread only. The decoded samples are identical to decoding on a single thread. Currently only used for MO3 files. Has to be passed to the module constructor to have any effect.
+ *          - load.sample_memory_budget (integer): Maximum number of bytes of sample data to keep in memory, or 0 (the default) for no limit. If the decoded samples of a module need more memory, they are reduced step by step until they fit, starting with the largest samples: stereo samples with identical channels are converted to mono, then 16-bit samples are converted to 8-bit with noise shaping, and finally samples longer than 16384 frames are downsampled to half their sample rate (not for MOD and other formats that use period tables, and not for samples with loops shorter than 16 frames). Only the first step is lossless. The resulting size is available through the sample_memory metadata key. Samples that are decoded lazily (see load.lazy_samples) are counted with their decoded size. Their reductions are decided while loading and applied to their data when they are decoded, so no other sample is changed during playback. Has to be passed to the module constructor to have any effect.
  *          - load.skip_patterns (boolean): Set to "1" to avoid loading patterns into memory
  *          - load.skip_plugins (boolean): Set to "1" to avoid loading plugins
  *          - load.skip_subsongs_init (boolean): Set to "1" to avoid pre-initializing sub-songs. Skipping results in faster module loading but slower seeking.
  *          - seek.sync_samples (boolean): Set to "0" to not sync sample playback when using openmpt_module_set_position_seconds or openmpt_module_set_position_order_row.
+ *          - seek.checkpoint_interval (floatingpoint): Set to a positive number of seconds to let openmpt_module_set_position_seconds remember the playback state at this interval. Subsequent seeks resume from the closest remembered state, which makes seeking in long modules much faster at the cost of roughly 1 KiB of memory per channel and interval. Intervals shorter than 0.5 seconds are rounded up. At most 256 states are remembered; in longer modules, every other state is dropped and the interval is doubled whenever that limit is reached. "0.0" (the default) disables it.
  *          - subsong (integer): The current subsong. Setting it has identical semantics as openmpt_module_select_subsong(), getting it returns the currently selected subsong.
  *          - play.at_end (text): Chooses the behaviour when the end of song is reached. The song end is considered to be reached after the number of reptitions set by openmpt_module_set_repeat_count was played, so if the song is set to repeat infinitely, its end is never considered to be reached.
  *                         - "fadeout": Fades the module out for a short while. Subsequent reads after the fadeout will return 0 rendered frames.
@@ -1520,6 +1615,10 @@ LIBOPENMPT_API const char * openmpt_module_highlight_pattern_row_channel( openmp
  *                    - "a1200": Amiga A1200 filter.
  *                    - "unfiltered": BLEP synthesis without model-specific filters. The LED filter is ignored by this setting. This filter mode is considered to be experimental and might change in the future.
  *          - render.opl.volume_factor (floatingpoint): Set volume factor applied to synthesized OPL sounds, relative to the default OPL volume.
+ *          - render.mix_threads (integer): Number of threads used for mixing the individual voices. 0 uses one thread per CPU core, 1 (the default) mixes on the calling thread only. The rendered output is bit-identical to mixing on a single thread when libopenmpt is built with the default fixed-point mixer. Only worthwhile for modules with many simultaneously playing voices.
+ *          - render.sample_storage (text): Sample data format used for playback. "original" (the default) keeps the format of the module file. "int16" converts 8-bit samples to 16-bit when they are loaded, so that fewer mixer code paths are used, at the cost of twice the memory for those samples. The rendered output is identical with both settings.
+ *          - profile.enabled (boolean): Enables per-stage timing of the render path (pattern processing, mixing, OPL, reverb, plugins, post-mix, DSP and output conversion) as well as voice statistics. Setting this ctl resets all counters. Disabled by default; a disabled profile has negligible overhead. Always false if libopenmpt was built without profiling support.
+ *          - profile.report (text): Read-only. The counters accumulated since profile.enabled was last set, as newline-separated key=value pairs: frames, chunks, chunks.silent (chunks that skipped mixing because nothing was audible), voices.average, voices.peak and, for each stage (total, read_note, mix, opl, reverb, plugins, post_mix, dsp, output), STAGE.calls, STAGE.seconds and, on platforms with a cycle counter, STAGE.cycles. Empty if profiling is disabled.
  *          - dither (integer): Set the dither algorithm that is used for the 16 bit versions of openmpt_module_read. Supported values are:
  *                    - 0: No dithering.
  *                    - 1: Default mode. Chosen by OpenMPT code, might change.
@@ -16,6 +16,7 @@
 #include <iosfwd>
 #include <iostream>
 #include <map>
+#include <memory>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -387,6 +388,77 @@ LIBOPENMPT_CXX_API int probe_file_header( std::uint64_t flags, const std::uint8_
 */
 LIBOPENMPT_CXX_API int probe_file_header( std::uint64_t flags, std::istream & stream );
 
+//! Subsong cache interface
+/*!
+  Loading a module normally simulates playback of every sequence once in order to determine subsong durations and start/restart positions.
+  A subsong cache allows storing the results of this pass across module instances (and, depending on the implementation, across processes), so that loading a module that has been seen before does not need to simulate playback again.
+  Entries are keyed by openmpt::get_subsong_cache_key(), which identifies the module file contents. The value is an opaque string produced and parsed by libopenmpt that also records the libopenmpt core version and the load settings that influence the result. Values that do not match the current library and settings are treated as a cache miss and get replaced.
+  Implementations must be thread-safe, as modules may be loaded concurrently from multiple threads.
+  \sa openmpt::set_subsong_cache
+  \sa openmpt::create_subsong_cache_file
+*/
+class LIBOPENMPT_CXX_API_CLASS subsong_cache {
+public:
+	LIBOPENMPT_CXX_API_MEMBER virtual ~subsong_cache();
+	//! Look up an entry
+	/*!
+	  \param key Cache key as returned by openmpt::get_subsong_cache_key().
+	  \param value Receives the stored value if the key was found.
+	  \return true if the key was found, false otherwise.
+	*/
+	virtual bool lookup( const std::string & key, std::string & value ) = 0;
+	//! Store an entry
+	/*!
+	  \param key Cache key as returned by openmpt::get_subsong_cache_key().
+	  \param value Opaque value to store. Replaces any previously stored value for the same key.
+	*/
+	virtual void store( const std::string & key, const std::string & value ) = 0;
+	//! Remove an entry
+	/*!
+	  \param key Cache key as returned by openmpt::get_subsong_cache_key(), or an empty string to remove all entries.
+	*/
+	virtual void invalidate( const std::string & key ) = 0;
+}; // class subsong_cache
+
+//! Register the subsong cache used by all subsequently loaded modules
+/*!
+  \param cache Cache to use, or an empty pointer to disable caching (the default).
+  \remarks Modules loaded with the ctl load.skip_subsongs_init or load.skip_patterns set neither query nor update the cache.
+  \remarks Only modules loaded from memory or from an unseekable stream use the cache. Modules loaded from seekable streams neither query nor update it.
+  \sa openmpt::subsong_cache
+*/
+LIBOPENMPT_CXX_API void set_subsong_cache( std::shared_ptr<subsong_cache> cache );
+
+//! Get the currently registered subsong cache
+/*!
+  \return The cache set by openmpt::set_subsong_cache(), or an empty pointer if caching is disabled.
+*/
+LIBOPENMPT_CXX_API std::shared_ptr<subsong_cache> get_subsong_cache();
+
+//! Create the default on-disk subsong cache
+/*!
+  \param path Path of the cache file. The file is created on the first store if it does not exist yet.
+  \return A subsong cache that keeps all entries in memory and persists them to a single text file. Multiple instances must not share the same file.
+  \remarks The returned cache still has to be registered with openmpt::set_subsong_cache().
+  \remarks The cache keeps at most 4096 entries. Storing more entries drops the entries that were stored first.
+*/
+LIBOPENMPT_CXX_API std::shared_ptr<subsong_cache> create_subsong_cache_file( const std::string & path );
+
+//! Calculate the subsong cache key for a module file
+/*!
+  \param data Beginning of the file data.
+  \param size Size of the file data.
+  \return The key under which the subsong information of this file is cached, e.g. for passing to openmpt::invalidate_subsong_cache().
+*/
+LIBOPENMPT_CXX_API std::string get_subsong_cache_key( const void * data, std::size_t size );
+
+//! Remove entries from the registered subsong cache
+/*!
+  \param key Cache key as returned by openmpt::get_subsong_cache_key(), or an empty string to remove all entries.
+  \remarks Does nothing if no cache is registered.
+*/
+LIBOPENMPT_CXX_API void invalidate_subsong_cache( const std::string & key = std::string() );
+
 class module_impl;
 
 class module_ext;
@@ -856,6 +928,7 @@ public:
 	           - message: Song message. If the song message is empty or the module format does not support song messages, a list of instrument and sample names is returned instead.
 	           - message_raw: Song message. If the song message is empty or the module format does not support song messages, an empty string is returned.
 	           - warnings: A list of warnings that were generated while loading the module.
+	           - sample_memory: Number of bytes of memory currently used by decoded sample data, including the interpolation lookahead buffers, after any reductions made to fit into load.sample_memory_budget. Samples that have not been decoded yet (see load.lazy_samples) are not counted.
 	  \return The associated value for key.
 	  \sa openmpt::module::get_metadata_keys
 	*/
@@ -1148,10 +1221,15 @@ public:
 	  \return A vector containing all supported ctl keys.
 	  \remarks Currently supported ctl values are:
 	           - load.skip_samples (boolean): Set to "1" to avoid loading samples into memory
+	           - load.lazy_samples (boolean): Set to "1" to decode sample data only when a sample is played for the first time instead of when loading the module. This makes loading faster and saves memory for samples that are never played. If any sample was deferred, a copy of the module file is kept in memory until all samples have been decoded (unless the module was loaded with openmpt_module_create_from_file()). Samples are decoded and allocated inside the render functions, mostly one row before they are played, so rendering is not real-time safe with this option. Currently only supported for IT and MPTM files.
+	           - load.map_sample_data (boolean): Set to "1" to map uncompressed sample data directly from the module file instead of copying it into memory. Sample memory is then backed by the file and only pages that are actually played are read from disk. Only effective for modules loaded with openmpt_module_create_from_file() (C API) on POSIX systems, and only for uncompressed sample data in IT, MPTM, MOD and S3M files. Has no effect if load.lazy_samples is enabled. The file must not be modified while the module is loaded. Sample data that has not been played before is read from disk by the render functions when it is first accessed, so rendering is not real-time safe with this option. Has to be passed to the module constructor to have any effect.
+	           - load.sample_decode_threads (integer): Number of threads used for decoding compressed samples while loading the module. 0 uses one thread per CPU core, 1 (the default) decodes on the calling thread only. The decoded samples are identical to decoding on a single thread. Currently only used for MO3 files. Has to be passed to the module constructor to have any effect.
+	           - load.sample_memory_budget (integer): Maximum number of bytes of sample data to keep in memory, or 0 (the default) for no limit. If the decoded samples of a module need more memory, they are reduced step by step until they fit, starting with the largest samples: stereo samples with identical channels are converted to mono, then 16-bit samples are converted to 8-bit with noise shaping, and finally samples longer than 16384 frames are downsampled to half their sample rate (not for MOD and other formats that use period tables, and not for samples with loops shorter than 16 frames). Only the first step is lossless. The resulting size is available through the sample_memory metadata key. Samples that are decoded lazily (see load.lazy_samples) are counted with their decoded size. Their reductions are decided while loading and applied to their data when they are decoded, so no other sample is changed during playback. Has to be passed to the module constructor to have any effect.
 	           - load.skip_patterns (boolean): Set to "1" to avoid loading patterns into memory
 	           - load.skip_plugins (boolean): Set to "1" to avoid loading plugins
 	           - load.skip_subsongs_init (boolean): Set to "1" to avoid pre-initializing sub-songs. Skipping results in faster module loading but slower seeking.
 	           - seek.sync_samples (boolean): Set to "0" to not sync sample playback when using openmpt::module::set_position_seconds or openmpt::module::set_position_order_row.
+	           - seek.checkpoint_interval (floatingpoint): Set to a positive number of seconds to let openmpt::module::set_position_seconds remember the playback state at this interval. Subsequent seeks resume from the closest remembered state, which makes seeking in long modules much faster at the cost of roughly 1 KiB of memory per channel and interval. Intervals shorter than 0.5 seconds are rounded up. At most 256 states are remembered; in longer modules, every other state is dropped and the interval is doubled whenever that limit is reached. "0.0" (the default) disables it.
 	           - subsong (integer): The current subsong. Setting it has identical semantics as openmpt::module::select_subsong(), getting it returns the currently selected subsong.
 	           - play.at_end (text): Chooses the behaviour when the end of song is reached. The song end is considered to be reached after the number of reptitions set by openmpt::module::set_repeat_count was played, so if the song is set to repeat infinitely, its end is never considered to be reached.
 	                          - "fadeout": Fades the module out for a short while. Subsequent reads after the fadeout will return 0 rendered frames.
@@ -1166,6 +1244,10 @@ public:
 	                     - "a1200": Amiga A1200 filter.
 	                     - "unfiltered": BLEP synthesis without model-specific filters. The LED filter is ignored by this setting. This filter mode is considered to be experimental and might change in the future.
 	           - render.opl.volume_factor (floatingpoint): Set volume factor applied to synthesized OPL sounds, relative to the default OPL volume.
+	           - render.mix_threads (integer): Number of threads used for mixing the individual voices. 0 uses one thread per CPU core, 1 (the default) mixes on the calling thread only. The rendered output is bit-identical to mixing on a single thread when libopenmpt is built with the default fixed-point mixer. Only worthwhile for modules with many simultaneously playing voices.
+	           - render.sample_storage (text): Sample data format used for playback. "original" (the default) keeps the format of the module file. "int16" converts 8-bit samples to 16-bit when they are loaded, so that fewer mixer code paths are used, at the cost of twice the memory for those samples. The rendered output is identical with both settings.
+	           - profile.enabled (boolean): Enables per-stage timing of the render path (pattern processing, mixing, OPL, reverb, plugins, post-mix, DSP and output conversion) as well as voice statistics. Setting this ctl resets all counters. Disabled by default; a disabled profile has negligible overhead. Always false if libopenmpt was built without profiling support.
+	           - profile.report (text): Read-only. The counters accumulated since profile.enabled was last set, as newline-separated key=value pairs: frames, chunks, chunks.silent (chunks that skipped mixing because nothing was audible), voices.average, voices.peak and, for each stage (total, read_note, mix, opl, reverb, plugins, post_mix, dsp, output), STAGE.calls, STAGE.seconds and, on platforms with a cycle counter, STAGE.cycles. Empty if profiling is disabled.
 	           - dither (integer): Set the dither algorithm that is used for the 16 bit versions of openmpt::module::read. Supported values are:
 	                     - 0: No dithering.
 	                     - 1: Default mode. Chosen by OpenMPT code, might change.
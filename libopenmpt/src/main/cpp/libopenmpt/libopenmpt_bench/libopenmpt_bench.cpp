@@ -0,0 +1,655 @@
+/*
+ * libopenmpt_bench.cpp
+ * --------------------
+ * Purpose: libopenmpt benchmark suite driver
+ * Notes  : All inputs are generated synthetically, so results do not depend on any module collection.
+ *          Results are written to stdout as JSON, so that they can be compared across releases.
+ *          The "mixer" field tells apart results from default and FLOATMIXER=1 builds.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+/*
+ * Usage: libopenmpt_bench [--seconds SECONDS] [--render-seconds SECONDS] [--section NAME]...
+ *
+ * --seconds         Minimum wall clock time spent on each probe, load and subsongs measurement (default 1).
+ * --render-seconds  Amount of audio rendered for each render measurement (default 30).
+ * --section         Only run the given section (probe, load, subsongs, render, lazy_load). Can be given more than once.
+ */
+
+#include <libopenmpt/libopenmpt.hpp>
+
+#include "libopenmpt_bench_modules.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace libopenmpt_bench {
+
+struct corpus_file {
+	std::string name;
+	std::vector<std::uint8_t> data;
+	std::uint64_t filesize;
+};
+
+// Deterministic filler, so that the corpus is the same on every run and platform.
+class xorshift {
+	std::uint32_t state;
+public:
+	explicit xorshift( std::uint32_t seed ) : state( seed ? seed : 1 ) { }
+	std::uint8_t next() {
+		state ^= state << 13;
+		state ^= state >> 17;
+		state ^= state << 5;
+		return static_cast<std::uint8_t>( state >> 24 );
+	}
+};
+
+static std::vector<std::uint8_t> make_random( std::size_t size, std::uint32_t seed ) {
+	std::vector<std::uint8_t> data( size );
+	xorshift rng( seed );
+	for ( auto & b : data ) {
+		b = rng.next();
+	}
+	return data;
+}
+
+static std::vector<std::uint8_t> make_text( std::size_t size ) {
+	static const char text[] = "The quick brown fox jumps over the lazy dog.\n";
+	std::vector<std::uint8_t> data( size );
+	for ( std::size_t i = 0; i < size; ++i ) {
+		data[i] = static_cast<std::uint8_t>( text[i % ( sizeof( text ) - 1 )] );
+	}
+	return data;
+}
+
+static std::vector<corpus_file> make_module_corpus( std::size_t headersize ) {
+	std::vector<corpus_file> corpus;
+	const std::uint64_t filesize = 256 * 1024;
+	{
+		std::vector<std::uint8_t> data( headersize );
+		put( data, 0, "IMPM", 4 );
+		put_le16( data, 0x20, 2 ); // orders
+		put_le16( data, 0x28, 0x0214 ); // cwtv
+		put_le16( data, 0x2A, 0x0214 ); // cmwt
+		corpus.push_back( { "it", data, filesize } );
+	}
+	{
+		std::vector<std::uint8_t> data( headersize );
+		put( data, 0, "Extended Module: ", 17 );
+		data[37] = 0x1A;
+		put( data, 38, "FastTracker v2.00   ", 20 );
+		put_le16( data, 58, 0x0104 ); // version
+		put_le16( data, 60, 276 ); // header size
+		put_le16( data, 64, 1 ); // orders
+		put_le16( data, 68, 8 ); // channels
+		corpus.push_back( { "xm", data, filesize } );
+	}
+	{
+		std::vector<std::uint8_t> data( headersize );
+		data[28] = 0x1A;
+		data[29] = 16; // S3M module
+		put_le16( data, 40, 0x1320 ); // ST3.20
+		put_le16( data, 42, 2 ); // unsigned samples
+		put( data, 44, "SCRM", 4 );
+		corpus.push_back( { "s3m", data, filesize } );
+	}
+	{
+		std::vector<std::uint8_t> data( headersize );
+		data[950] = 1; // orders
+		data[951] = 127;
+		put( data, 1080, "M.K.", 4 );
+		corpus.push_back( { "mod", data, filesize } );
+	}
+	{
+		std::vector<std::uint8_t> data( headersize );
+		put( data, 0, "MTM", 3 );
+		data[3] = 0x10;
+		data[33] = 1; // channels
+		corpus.push_back( { "mtm", data, filesize } );
+	}
+	return corpus;
+}
+
+static std::vector<corpus_file> make_other_corpus( std::size_t headersize ) {
+	std::vector<corpus_file> corpus;
+	const std::uint64_t filesize = 1024 * 1024;
+	struct magic {
+		const char * name;
+		const char * bytes;
+		std::size_t len;
+	};
+	static const magic magics[] = {
+		{ "png", "\x89PNG\r\n\x1A\n", 8 },
+		{ "jpeg", "\xFF\xD8\xFF\xE0", 4 },
+		{ "gif", "GIF89a", 6 },
+		{ "wav", "RIFF\x24\x00\x10\x00WAVEfmt ", 16 },
+		{ "mp3", "ID3\x03\x00", 5 },
+		{ "zip", "PK\x03\x04", 4 },
+		{ "pdf", "%PDF-1.4\n", 9 },
+		{ "elf", "\x7F" "ELF\x02\x01\x01", 7 },
+	};
+	std::uint32_t seed = 1;
+	for ( const auto & m : magics ) {
+		std::vector<std::uint8_t> data = make_random( headersize, seed++ );
+		put( data, 0, m.bytes, m.len );
+		corpus.push_back( { m.name, data, filesize } );
+	}
+	corpus.push_back( { "random", make_random( headersize, seed++ ), filesize } );
+	corpus.push_back( { "zero", std::vector<std::uint8_t>( headersize ), filesize } );
+	corpus.push_back( { "text", make_text( headersize ), filesize } );
+	return corpus;
+}
+
+struct probe_result {
+	std::uint64_t probes = 0;
+	std::uint64_t detected = 0;
+	double seconds = 0.0;
+};
+
+static probe_result bench_probe( const std::vector<corpus_file> & corpus, double min_seconds ) {
+	probe_result result;
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		for ( const auto & file : corpus ) {
+			int probe = openmpt::probe_file_header( openmpt::probe_file_header_flags_default2, file.data.data(), file.data.size(), file.filesize );
+			if ( probe == openmpt::probe_file_header_result_success ) {
+				result.detected++;
+			}
+			result.probes++;
+		}
+		result.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	} while ( result.seconds < min_seconds );
+	return result;
+}
+
+// Collects the members of one JSON object.
+class json_object {
+	std::ostringstream str;
+	bool empty = true;
+	void key( const std::string & name ) {
+		str << ( empty ? "{ " : ", " ) << "\"" << name << "\": ";
+		empty = false;
+	}
+public:
+	json_object & add( const std::string & name, const std::string & value ) {
+		key( name );
+		str << "\"" << value << "\"";
+		return *this;
+	}
+	json_object & add( const std::string & name, const char * value ) {
+		return add( name, std::string( value ) );
+	}
+	json_object & add( const std::string & name, bool value ) {
+		key( name );
+		str << ( value ? "true" : "false" );
+		return *this;
+	}
+	template < typename T >
+	json_object & add( const std::string & name, T value ) {
+		key( name );
+		str << value;
+		return *this;
+	}
+	std::string get() const {
+		return str.str() + ( empty ? "{ }" : " }" );
+	}
+};
+
+static double per_second( double count, double seconds ) {
+	return seconds > 0.0 ? count / seconds : 0.0;
+}
+
+static std::string json_probe_result( const std::string & name, const std::vector<corpus_file> & corpus, const probe_result & result ) {
+	return json_object()
+		.add( "name", name )
+		.add( "files", corpus.size() )
+		.add( "probes", result.probes )
+		.add( "detected", result.detected )
+		.add( "seconds", result.seconds )
+		.add( "probes_per_second", per_second( static_cast<double>( result.probes ), result.seconds ) )
+		.get();
+}
+
+struct module_file {
+	std::string name;
+	std::string format;
+	std::vector<std::uint8_t> data;
+};
+
+static std::vector<module_file> make_load_corpus() {
+	std::vector<module_file> corpus;
+	corpus.push_back( { "mod-4ch", "mod", make_mod( 4 ) } );
+	corpus.push_back( { "mod-32ch", "mod", make_mod( 32 ) } );
+	corpus.push_back( { "s3m-16ch", "s3m", make_s3m( 16 ) } );
+	corpus.push_back( { "xm-32ch", "xm", make_xm( 32 ) } );
+	it_options it;
+	it.channels = 32;
+	corpus.push_back( { "it-32ch", "it", make_it( it ) } );
+	it.patterns = 64;
+	corpus.push_back( { "it-32ch-64pat", "it", make_it( it ) } );
+	it.patterns = 4;
+	it.plugins = true;
+	corpus.push_back( { "it-32ch-plugins", "it", make_it( it ) } );
+	return corpus;
+}
+
+static std::string bench_load( const module_file & file, double min_seconds ) {
+	std::uint64_t loads = 0;
+	double seconds = 0.0;
+	std::string type;
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		std::ostringstream log;
+		openmpt::module mod( file.data, log );
+		if ( type.empty() ) {
+			type = mod.get_metadata( "type" );
+		}
+		loads++;
+		seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	} while ( seconds < min_seconds );
+	if ( type != file.format ) {
+		throw std::runtime_error( file.name + " was loaded as " + type );
+	}
+	return json_object()
+		.add( "name", file.name )
+		.add( "format", file.format )
+		.add( "bytes", file.data.size() )
+		.add( "loads", loads )
+		.add( "seconds", seconds )
+		.add( "ms_per_load", per_second( seconds * 1000.0, static_cast<double>( loads ) ) )
+		.add( "bytes_per_second", per_second( static_cast<double>( file.data.size() * loads ), seconds ) )
+		.get();
+}
+
+// The song structure is analyzed while loading unless load.skip_subsongs_init is set,
+// in which case every query that needs it does the analysis again.
+static std::string bench_subsongs( const module_file & file, double min_seconds ) {
+	std::ostringstream log;
+	openmpt::module mod( file.data, log, { { "load.skip_subsongs_init", "1" } } );
+	std::uint64_t calls = 0;
+	std::int32_t subsongs = 0;
+	double seconds = 0.0;
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		subsongs = mod.get_num_subsongs();
+		calls++;
+		seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	} while ( seconds < min_seconds );
+	return json_object()
+		.add( "name", file.name )
+		.add( "format", file.format )
+		.add( "subsongs", subsongs )
+		.add( "duration", mod.get_duration_seconds() )
+		.add( "calls", calls )
+		.add( "seconds", seconds )
+		.add( "ms_per_call", per_second( seconds * 1000.0, static_cast<double>( calls ) ) )
+		.get();
+}
+
+enum class sample_format {
+	int16,
+	float32,
+};
+
+struct render_case {
+	std::string name;
+	std::string module;
+	int channels = 2;
+	sample_format format = sample_format::float32;
+	bool interleaved = false;
+	int interpolation = 8;
+	std::map<std::string, std::string> ctls;
+};
+
+static const std::int32_t samplerate = 48000;
+static const std::size_t block_frames = 1024;
+
+template < typename Tsample >
+static std::size_t read_block( openmpt::module & mod, const render_case & config, std::vector<Tsample> & buffer ) {
+	Tsample * ch[4] = { buffer.data(), buffer.data() + block_frames, buffer.data() + block_frames * 2, buffer.data() + block_frames * 3 };
+	if ( config.interleaved ) {
+		switch ( config.channels ) {
+			case 2: return mod.read_interleaved_stereo( samplerate, block_frames, buffer.data() );
+			case 4: return mod.read_interleaved_quad( samplerate, block_frames, buffer.data() );
+		}
+	} else {
+		switch ( config.channels ) {
+			case 1: return mod.read( samplerate, block_frames, ch[0] );
+			case 2: return mod.read( samplerate, block_frames, ch[0], ch[1] );
+			case 4: return mod.read( samplerate, block_frames, ch[0], ch[1], ch[2], ch[3] );
+		}
+	}
+	throw std::invalid_argument( "unsupported channel configuration" );
+}
+
+struct render_result {
+	std::uint64_t frames = 0;
+	double seconds = 0.0;
+	double voices = 0.0;
+};
+
+template < typename Tsample >
+static render_result render( openmpt::module & mod, const render_case & config, double render_seconds ) {
+	std::vector<Tsample> buffer( block_frames * 4 );
+	const std::uint64_t total_frames = static_cast<std::uint64_t>( render_seconds * samplerate );
+	render_result result;
+	std::uint64_t blocks = 0;
+	std::uint64_t voices = 0;
+	const auto start = std::chrono::steady_clock::now();
+	while ( result.frames < total_frames ) {
+		const std::size_t count = read_block( mod, config, buffer );
+		if ( count == 0 ) {
+			break;
+		}
+		result.frames += count;
+		voices += mod.get_current_playing_channels();
+		blocks++;
+	}
+	result.seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	result.voices = blocks ? static_cast<double>( voices ) / blocks : 0.0;
+	return result;
+}
+
+static const char * interpolation_name( int interpolation ) {
+	switch ( interpolation ) {
+		case 1: return "nearest";
+		case 2: return "linear";
+		case 4: return "cubic";
+		case 8: return "sinc8";
+	}
+	return "default";
+}
+
+static std::vector<render_case> make_render_cases() {
+	std::vector<render_case> cases;
+	const auto add = [&cases]( const std::string & name, const std::string & module, const std::function<void( render_case & )> & setup ) {
+		render_case config;
+		config.name = name;
+		config.module = module;
+		setup( config );
+		cases.push_back( config );
+	};
+	// Resamplers
+	for ( int interpolation : { 1, 2, 4, 8 } ) {
+		add( std::string( "resampler-" ) + interpolation_name( interpolation ), "it-32ch", [=]( render_case & c ) { c.interpolation = interpolation; } );
+	}
+	add( "resampler-mod-sinc8", "mod-4ch", []( render_case & ) { } );
+	for ( const char * type : { "a500", "a1200" } ) {
+		add( std::string( "resampler-amiga-" ) + type, "mod-4ch", [=]( render_case & c ) {
+			c.ctls["render.resampler.emulate_amiga"] = "1";
+			c.ctls["render.resampler.emulate_amiga_type"] = type;
+		} );
+	}
+	// Number of module channels
+	for ( const char * module : { "it-4ch", "it-16ch", "it-32ch", "it-64ch", "mod-32ch", "s3m-16ch", "xm-32ch" } ) {
+		add( std::string( "module-" ) + module, module, []( render_case & ) { } );
+	}
+	// Output formats
+	for ( int channels : { 1, 2, 4 } ) {
+		for ( sample_format format : { sample_format::int16, sample_format::float32 } ) {
+			const std::string name = std::string( "output-" ) + ( channels == 1 ? "mono" : channels == 2 ? "stereo" : "quad" ) + ( format == sample_format::int16 ? "-int16" : "-float" );
+			add( name, "it-32ch", [=]( render_case & c ) {
+				c.channels = channels;
+				c.format = format;
+			} );
+			if ( channels > 1 ) {
+				add( name + "-interleaved", "it-32ch", [=]( render_case & c ) {
+					c.channels = channels;
+					c.format = format;
+					c.interleaved = true;
+				} );
+			}
+		}
+	}
+	// DMO reverb and echo plugins
+	add( "plugins-on", "it-32ch-plugins", []( render_case & ) { } );
+	add( "plugins-off", "it-32ch-plugins", []( render_case & c ) { c.ctls["load.skip_plugins"] = "1"; } );
+	// A chain of eight more DMO effects spread out over the plugin slots
+	add( "plugins-chain", "it-32ch-plugin-chain", []( render_case & ) { } );
+	// Each DMO effect on its own, on top of a cheap 4-channel module, so that the plugin dominates the render time.
+	// Compare with dmo-none to get the throughput of the plugin itself.
+	add( "dmo-none", "it-4ch", []( render_case & c ) { c.interpolation = 1; } );
+	for ( const auto & effect : dmo_effects() ) {
+		add( std::string( "dmo-" ) + effect.name, std::string( "it-4ch-dmo-" ) + effect.name, []( render_case & c ) { c.interpolation = 1; } );
+	}
+	// Built-in reverb, enabled with S99 on every note. Compare with reverb-none.
+	add( "reverb-none", "it-4ch-plain", []( render_case & c ) { c.interpolation = 1; } );
+	add( "reverb", "it-4ch-reverb", []( render_case & c ) { c.interpolation = 1; } );
+	// Sample storage: 8-bit samples widened to 16-bit at load time trade sample_memory for fewer mixer code paths
+	for ( const char * module : { "mod-32ch", "it-32ch" } ) {
+		for ( const char * storage : { "original", "int16" } ) {
+			add( std::string( "storage-" ) + storage + "-" + module, module, [=]( render_case & c ) { c.ctls["render.sample_storage"] = storage; } );
+		}
+	}
+	// Sample memory budget: 8 x 256k frames of 16-bit samples (4 MiB) reduced to 8-bit and then downsampled. Compare sample_memory and speed.
+	for ( const char * budget : { "none", "2MiB", "1MiB" } ) {
+		add( std::string( "budget-" ) + budget, "it-8x512KiB", [=]( render_case & c ) {
+			c.ctls["load.sample_memory_budget"] = budget == std::string( "2MiB" ) ? "2097152" : budget == std::string( "1MiB" ) ? "1048576" : "0";
+		} );
+	}
+	// Many voices fading out in the background after New Note Actions
+	add( "nna-16ch", "it-nna-16ch", []( render_case & ) { } );
+	add( "nna-32ch", "it-nna-32ch", []( render_case & ) { } );
+	// Background voices never fade out, so every new note has to steal one of them
+	add( "nna-saturated", "it-nna-64ch-sustained", []( render_case & ) { } );
+	return cases;
+}
+
+static std::map<std::string, std::vector<std::uint8_t>> make_render_corpus() {
+	std::map<std::string, std::vector<std::uint8_t>> corpus;
+	for ( int channels : { 4, 16, 32, 64 } ) {
+		it_options it;
+		it.channels = channels;
+		corpus["it-" + std::to_string( channels ) + "ch"] = make_it( it );
+	}
+	{
+		it_options it;
+		it.plugins = true;
+		corpus["it-32ch-plugins"] = make_it( it );
+		it.plugin_chain = 8;
+		corpus["it-32ch-plugin-chain"] = make_it( it );
+	}
+	for ( const auto & effect : dmo_effects() ) {
+		it_options it;
+		it.channels = 4;
+		it.dmo = &effect;
+		corpus[std::string( "it-4ch-dmo-" ) + effect.name] = make_it( it );
+	}
+	{
+		it_options it;
+		it.channels = 4;
+		it.effects = false;
+		corpus["it-4ch-plain"] = make_it( it );
+		it.reverb = true;
+		corpus["it-4ch-reverb"] = make_it( it );
+	}
+	for ( int channels : { 16, 32 } ) {
+		it_options it;
+		it.channels = channels;
+		it.effects = false;
+		it.fadeout = 16;
+		corpus["it-nna-" + std::to_string( channels ) + "ch"] = make_it( it );
+	}
+	{
+		it_options it;
+		it.channels = 64;
+		it.effects = false;
+		it.fadeout = 0;
+		corpus["it-nna-64ch-sustained"] = make_it( it );
+	}
+	corpus["it-8x512KiB"] = make_it_big_samples( 8, 256 * 1024, 4 );
+	corpus["mod-4ch"] = make_mod( 4 );
+	corpus["mod-32ch"] = make_mod( 32 );
+	corpus["s3m-16ch"] = make_s3m( 16 );
+	corpus["xm-32ch"] = make_xm( 32 );
+	return corpus;
+}
+
+static std::string bench_render( const render_case & config, const std::vector<std::uint8_t> & data, double render_seconds ) {
+	std::ostringstream log;
+	openmpt::module mod( data, log, config.ctls );
+	mod.set_repeat_count( -1 );
+	mod.set_render_param( openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH, config.interpolation );
+	const render_result result = ( config.format == sample_format::int16 ) ? render<std::int16_t>( mod, config, render_seconds ) : render<float>( mod, config, render_seconds );
+	return json_object()
+		.add( "name", config.name )
+		.add( "module", config.module )
+		.add( "module_channels", mod.get_num_channels() )
+		.add( "output_channels", config.channels )
+		.add( "format", config.format == sample_format::int16 ? "int16" : "float" )
+		.add( "interleaved", config.interleaved )
+		.add( "interpolation", interpolation_name( config.interpolation ) )
+		.add( "samplerate", samplerate )
+		.add( "frames", result.frames )
+		.add( "seconds", result.seconds )
+		.add( "frames_per_second", per_second( static_cast<double>( result.frames ), result.seconds ) )
+		.add( "realtime_factor", per_second( static_cast<double>( result.frames ) / samplerate, result.seconds ) )
+		.add( "average_voices", result.voices )
+		.add( "sample_memory", std::stoull( mod.get_metadata( "sample_memory" ) ) )
+		.get();
+}
+
+// Compares loading all sample data up front with decoding it on first use,
+// for a module with many large samples of which only a few are played.
+static std::string bench_lazy_load( const std::string & name, const std::vector<std::uint8_t> & data, bool lazy, double min_seconds ) {
+	const std::map<std::string, std::string> ctls = { { "load.lazy_samples", lazy ? "1" : "0" } };
+	std::uint64_t loads = 0;
+	double load_seconds = 0.0;
+	double first_block_seconds = 0.0;
+	double seconds = 0.0;
+	std::vector<float> buffer( block_frames * 2 );
+	const auto start = std::chrono::steady_clock::now();
+	do {
+		std::ostringstream log;
+		const auto load_start = std::chrono::steady_clock::now();
+		openmpt::module mod( data, log, ctls );
+		const auto load_end = std::chrono::steady_clock::now();
+		mod.read_interleaved_stereo( samplerate, block_frames, buffer.data() );
+		const auto first_block_end = std::chrono::steady_clock::now();
+		load_seconds += std::chrono::duration<double>( load_end - load_start ).count();
+		first_block_seconds += std::chrono::duration<double>( first_block_end - load_end ).count();
+		loads++;
+		seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	} while ( seconds < min_seconds );
+	return json_object()
+		.add( "name", name )
+		.add( "lazy", lazy )
+		.add( "bytes", data.size() )
+		.add( "loads", loads )
+		.add( "ms_per_load", per_second( load_seconds * 1000.0, static_cast<double>( loads ) ) )
+		.add( "ms_first_block", per_second( first_block_seconds * 1000.0, static_cast<double>( loads ) ) )
+		.get();
+}
+
+static void print_section( bool & first_section, const std::string & name, const std::vector<std::string> & results ) {
+	std::cout << ( first_section ? "" : "," ) << std::endl;
+	first_section = false;
+	std::cout << "  \"" << name << "\": [" << std::endl;
+	for ( std::size_t i = 0; i < results.size(); ++i ) {
+		std::cout << "    " << results[i] << ( i + 1 < results.size() ? "," : "" ) << std::endl;
+	}
+	std::cout << "  ]";
+}
+
+static int main( int argc, char * argv[] ) {
+	double min_seconds = 1.0;
+	double render_seconds = 30.0;
+	std::set<std::string> sections;
+	const std::set<std::string> all_sections = { "probe", "load", "subsongs", "render", "lazy_load" };
+	for ( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		if ( arg == "--seconds" && i + 1 < argc ) {
+			min_seconds = std::atof( argv[++i] );
+		} else if ( arg == "--render-seconds" && i + 1 < argc ) {
+			render_seconds = std::atof( argv[++i] );
+		} else if ( arg == "--section" && i + 1 < argc && all_sections.count( argv[i + 1] ) ) {
+			sections.insert( argv[++i] );
+		} else {
+			std::cerr << "Usage: libopenmpt_bench [--seconds SECONDS] [--render-seconds SECONDS] [--section probe|load|subsongs|render|lazy_load]..." << std::endl;
+			return 1;
+		}
+	}
+	if ( sections.empty() ) {
+		sections = all_sections;
+	}
+	bool first_section = true;
+	std::cout << "{" << std::endl;
+	std::cout << "  \"library_version\": \"" << openmpt::string::get( "library_version" ) << "\"," << std::endl;
+#if defined( MPT_FLOATMIXER )
+	std::cout << "  \"mixer\": \"float\"," << std::endl;
+#else
+	std::cout << "  \"mixer\": \"integer\"," << std::endl;
+#endif
+	std::cout << "  \"seconds\": " << min_seconds << "," << std::endl;
+	std::cout << "  \"render_seconds\": " << render_seconds << ",";
+	if ( sections.count( "probe" ) ) {
+		const std::size_t headersize = openmpt::probe_file_header_get_recommended_size();
+		const std::vector<corpus_file> modules = make_module_corpus( headersize );
+		const std::vector<corpus_file> others = make_other_corpus( headersize );
+		std::vector<corpus_file> mixed = others;
+		mixed.insert( mixed.end(), modules.begin(), modules.end() );
+		print_section( first_section, "probe", {
+			json_probe_result( "modules", modules, bench_probe( modules, min_seconds ) ),
+			json_probe_result( "other", others, bench_probe( others, min_seconds ) ),
+			json_probe_result( "mixed", mixed, bench_probe( mixed, min_seconds ) ),
+		} );
+	}
+	if ( sections.count( "load" ) || sections.count( "subsongs" ) ) {
+		const std::vector<module_file> corpus = make_load_corpus();
+		if ( sections.count( "load" ) ) {
+			std::vector<std::string> results;
+			for ( const auto & file : corpus ) {
+				results.push_back( bench_load( file, min_seconds ) );
+			}
+			print_section( first_section, "load", results );
+		}
+		if ( sections.count( "subsongs" ) ) {
+			std::vector<std::string> results;
+			for ( const auto & file : corpus ) {
+				results.push_back( bench_subsongs( file, min_seconds ) );
+			}
+			print_section( first_section, "subsongs", results );
+		}
+	}
+	if ( sections.count( "render" ) ) {
+		const std::map<std::string, std::vector<std::uint8_t>> corpus = make_render_corpus();
+		std::vector<std::string> results;
+		for ( const auto & config : make_render_cases() ) {
+			results.push_back( bench_render( config, corpus.at( config.module ), render_seconds ) );
+		}
+		print_section( first_section, "render", results );
+	}
+	if ( sections.count( "lazy_load" ) ) {
+		const std::vector<std::uint8_t> big = make_it_big_samples( 32, 256 * 1024, 4 );
+		print_section( first_section, "lazy_load", {
+			bench_lazy_load( "it-32x512KiB", big, false, min_seconds ),
+			bench_lazy_load( "it-32x512KiB", big, true, min_seconds ),
+		} );
+	}
+	std::cout << std::endl << "}" << std::endl;
+	return 0;
+}
+
+} // namespace libopenmpt_bench
+
+int main( int argc, char * argv[] ) {
+	try {
+		return libopenmpt_bench::main( argc, argv );
+	} catch ( const std::exception & e ) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
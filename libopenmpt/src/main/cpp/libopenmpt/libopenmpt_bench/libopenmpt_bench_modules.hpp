@@ -0,0 +1,679 @@
+/*
+ * libopenmpt_bench_modules.hpp
+ * ----------------------------
+ * Purpose: Synthetic module generators for libopenmpt_bench and libopenmpt_rtcheck
+ * Notes  : All modules are generated deterministically, so benchmark results do not depend on any module collection.
+ *          The generators only write the parts of each format that libopenmpt needs to load and play the files.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+#ifndef LIBOPENMPT_BENCH_MODULES_HPP
+#define LIBOPENMPT_BENCH_MODULES_HPP
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace libopenmpt_bench {
+
+inline void put( std::vector<std::uint8_t> & data, std::size_t offset, const char * str, std::size_t len ) {
+	std::memcpy( data.data() + offset, str, len );
+}
+
+inline void put_le16( std::vector<std::uint8_t> & data, std::size_t offset, std::uint16_t value ) {
+	data[offset + 0] = static_cast<std::uint8_t>( value >> 0 );
+	data[offset + 1] = static_cast<std::uint8_t>( value >> 8 );
+}
+
+inline void put_be16( std::vector<std::uint8_t> & data, std::size_t offset, std::uint16_t value ) {
+	data[offset + 0] = static_cast<std::uint8_t>( value >> 8 );
+	data[offset + 1] = static_cast<std::uint8_t>( value >> 0 );
+}
+
+inline void put_le32( std::vector<std::uint8_t> & data, std::size_t offset, std::uint32_t value ) {
+	put_le16( data, offset + 0, static_cast<std::uint16_t>( value >> 0 ) );
+	put_le16( data, offset + 2, static_cast<std::uint16_t>( value >> 16 ) );
+}
+
+inline void append( std::vector<std::uint8_t> & data, const std::vector<std::uint8_t> & other ) {
+	data.insert( data.end(), other.begin(), other.end() );
+}
+
+// Signed 8-bit sawtooth with some noise, so that the resamplers have high frequencies to work on.
+inline std::vector<std::uint8_t> make_sample_data( std::uint32_t length, std::uint32_t seed ) {
+	std::vector<std::uint8_t> data( length );
+	std::uint32_t rng = seed;
+	for ( std::uint32_t i = 0; i < length; ++i ) {
+		rng = rng * 1103515245u + 12345u;
+		data[i] = static_cast<std::uint8_t>( static_cast<std::int8_t>( ( ( i * ( 4 + seed % 4 ) ) & 0x7F ) - 64 + static_cast<int>( ( rng >> 16 ) & 0x0F ) ) );
+	}
+	return data;
+}
+
+struct dmo_effect {
+	std::uint32_t id;
+	const char * name;
+	// Parameters stored in the plugin data. If empty, the plugin uses its default parameters.
+	std::vector<float> params;
+};
+
+// All DMO effects, with parameters that make sure that none of them are bypassed,
+// e.g. ParamEq with its default gain of 0 dB just copies its input.
+inline const std::vector<dmo_effect> & dmo_effects() {
+	static const std::vector<dmo_effect> effects = {
+		{ 0xEFE6629C, "Chorus", {} },
+		{ 0xEF011F79, "Compressor", {} },
+		{ 0xEF114C90, "Distortion", {} },
+		{ 0xEF3E932C, "Echo", { 0.5f, 0.5f, 0.25f, 0.3f, 1.0f } },
+		{ 0xEFCA3D92, "Flanger", {} },
+		{ 0xDAFD8210, "Gargle", {} },
+		{ 0xEF985E71, "I3DL2Reverb", {} },
+		{ 0x120CED89, "ParamEq", { 0.3f, 0.3f, 0.8f } },
+		{ 0x87FC0268, "WavesReverb", {} },
+	};
+	return effects;
+}
+
+struct it_options {
+	int channels = 32;
+	int patterns = 4;
+	// Cycle through most effects and use envelopes, filters and random variations. Otherwise, every cell is a plain note.
+	bool effects = true;
+	bool pingpong = false;
+	// Enable the built-in reverb on every note with S99. Only used if effects is not set.
+	bool reverb = false;
+	// Put an I3DL2Reverb DMO on the master output and route all channels through an Echo DMO.
+	bool plugins = false;
+	// With plugins, chain this many more DMO effects after the Echo DMO, spread out over the plugin slots.
+	int plugin_chain = 0;
+	// Put only this DMO effect (see dmo_effects) on the master output. Ignored if plugins is set.
+	const dmo_effect * dmo = nullptr;
+	std::uint16_t fadeout = 64;
+	std::uint8_t speed = 3;
+	std::uint8_t tempo = 150;
+};
+
+inline std::vector<std::uint8_t> make_it_plugin_chunk( int index, std::uint32_t id, const char * name, bool master, int output = -1, const std::vector<float> & params = {} ) {
+	const std::size_t data_size = params.empty() ? 0 : 4 + 4 * params.size();
+	std::vector<std::uint8_t> chunk( 8 + 128 + 4 + data_size + 4 );
+	chunk[0] = 'F';
+	chunk[1] = 'X';
+	chunk[2] = static_cast<std::uint8_t>( '0' + index / 10 );
+	chunk[3] = static_cast<std::uint8_t>( '0' + index % 10 );
+	put_le32( chunk, 4, static_cast<std::uint32_t>( chunk.size() - 8 ) );
+	put( chunk, 8, "OMXD", 4 ); // DMO plugin
+	put_le32( chunk, 12, id );
+	chunk[16] = master ? 0x01 : 0x00; // apply to master mix
+	if ( output >= 0 ) {
+		put_le32( chunk, 20, static_cast<std::uint32_t>( 0x80 + output ) ); // send output to another plugin
+	}
+	put( chunk, 8 + 64, name, std::strlen( name ) );
+	// plugin data is either empty, i.e. the plugin uses its default parameters, or a parameter list (type 0)
+	put_le32( chunk, 8 + 128, static_cast<std::uint32_t>( data_size ) );
+	for ( std::size_t i = 0; i < params.size(); ++i ) {
+		std::uint32_t bits;
+		std::memcpy( &bits, &params[i], 4 );
+		put_le32( chunk, 8 + 128 + 4 + 4 + 4 * i, bits );
+	}
+	// extra chunks are left empty
+	return chunk;
+}
+
+// Builds an IT file in which every channel triggers a new note on every row.
+// With effects, it keeps as much of the playback code busy as possible: instruments use NNAs, envelopes and filters,
+// and Zxx commands go through the default MIDI macros.
+inline std::vector<std::uint8_t> make_it( const it_options & options ) {
+	const int num_patterns = options.patterns;
+	const int rows = 64;
+	const std::uint32_t sample_length = 4096;
+	std::vector<std::uint8_t> header( 0xC0 );
+	put( header, 0, "IMPM", 4 );
+	put( header, 4, "libopenmpt_bench", 16 );
+	const int num_orders = num_patterns + 1;
+	put_le16( header, 0x20, static_cast<std::uint16_t>( num_orders ) );
+	put_le16( header, 0x22, 1 ); // instruments
+	put_le16( header, 0x24, 1 ); // samples
+	put_le16( header, 0x26, static_cast<std::uint16_t>( num_patterns ) );
+	put_le16( header, 0x28, 0x0214 ); // cwtv
+	put_le16( header, 0x2A, 0x0214 ); // cmwt
+	put_le16( header, 0x2C, 0x0D ); // stereo, instruments, linear slides
+	header[0x30] = 128; // global volume
+	header[0x31] = 48; // mix volume
+	header[0x32] = options.speed;
+	header[0x33] = options.tempo;
+	header[0x34] = 128; // separation
+	for ( int chn = 0; chn < 64; ++chn ) {
+		header[0x40 + chn] = static_cast<std::uint8_t>( chn < options.channels ? ( chn * 17 ) % 65 : 160 );
+		header[0x80 + chn] = 64;
+	}
+	std::vector<std::uint8_t> orders;
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		orders.push_back( static_cast<std::uint8_t>( pat ) );
+	}
+	orders.push_back( 0xFF );
+
+	std::vector<std::uint8_t> plugins;
+	if ( options.plugins ) {
+		append( plugins, make_it_plugin_chunk( 0, 0xEF985E71, "I3DL2Reverb", true ) );
+		static const std::pair<std::uint32_t, const char *> chain_effects[] = {
+			{ 0xEFE6629C, "Chorus" },
+			{ 0xEF011F79, "Compressor" },
+			{ 0xEF114C90, "Distortion" },
+			{ 0xEFCA3D92, "Flanger" },
+			{ 0xDAFD8210, "Gargle" },
+			{ 0x120CED89, "ParamEq" },
+			{ 0x87FC0268, "WavesReverb" },
+		};
+		const auto chain_slot = [&options]( int link ) { return 2 + link * 97 / options.plugin_chain; };
+		append( plugins, make_it_plugin_chunk( 1, 0xEF3E932C, "Echo", false, options.plugin_chain > 0 ? chain_slot( 0 ) : -1 ) );
+		for ( int link = 0; link < options.plugin_chain; ++link ) {
+			const auto & effect = chain_effects[link % std::size( chain_effects )];
+			append( plugins, make_it_plugin_chunk( chain_slot( link ), effect.first, effect.second, false, link + 1 < options.plugin_chain ? chain_slot( link + 1 ) : -1 ) );
+		}
+		std::vector<std::uint8_t> chfx( 8 + 4 * options.channels );
+		put( chfx, 0, "CHFX", 4 );
+		put_le32( chfx, 4, static_cast<std::uint32_t>( 4 * options.channels ) );
+		for ( int chn = 0; chn < options.channels; ++chn ) {
+			put_le32( chfx, 8 + 4 * chn, 2 ); // 1-based, i.e. FX01 = Echo
+		}
+		append( plugins, chfx );
+	} else if ( options.dmo ) {
+		append( plugins, make_it_plugin_chunk( 0, options.dmo->id, options.dmo->name, true, -1, options.dmo->params ) );
+	}
+
+	std::vector<std::uint8_t> instrument( 554 );
+	put( instrument, 0, "IMPI", 4 );
+	instrument[0x11] = 3; // NNA fade
+	put_le16( instrument, 0x14, options.fadeout );
+	instrument[0x18] = 128; // global volume
+	instrument[0x19] = 32 | 0x80; // default pan
+	for ( int note = 0; note < 120; ++note ) {
+		instrument[0x40 + note * 2] = static_cast<std::uint8_t>( note );
+		instrument[0x41 + note * 2] = 1;
+	}
+	if ( options.effects ) {
+		instrument[0x12] = 1; // DCT note
+		instrument[0x13] = 2; // DCA fade
+		instrument[0x1A] = 20; // random volume variation
+		instrument[0x1B] = 20; // random pan variation
+		instrument[0x3A] = 0x80 | 96; // filter cutoff
+		instrument[0x3B] = 0x80 | 64; // filter resonance
+		// volume envelope with sustain loop
+		instrument[0x130] = 0x01 | 0x04;
+		instrument[0x131] = 3;
+		instrument[0x134] = 1;
+		instrument[0x135] = 1;
+		const std::uint8_t env_values[3] = { 64, 40, 0 };
+		const std::uint16_t env_ticks[3] = { 0, 10, 40 };
+		for ( int node = 0; node < 3; ++node ) {
+			instrument[0x136 + node * 3] = env_values[node];
+			put_le16( instrument, 0x137 + node * 3, env_ticks[node] );
+		}
+		// pitch envelope used as filter envelope
+		instrument[0x1D4] = 0x01 | 0x80;
+		instrument[0x1D5] = 2;
+		instrument[0x1DA] = static_cast<std::uint8_t>( 32 );
+		instrument[0x1DD] = static_cast<std::uint8_t>( -32 );
+		put_le16( instrument, 0x1DE, 30 );
+	}
+
+	std::vector<std::uint8_t> sample( 80 );
+	put( sample, 0, "IMPS", 4 );
+	sample[0x11] = 64; // global volume
+	sample[0x12] = 0x01 | 0x10 | ( options.pingpong ? 0x40 : 0x00 ); // sample data, loop
+	sample[0x13] = 64; // default volume
+	sample[0x2E] = 1; // signed
+	put_le32( sample, 0x30, sample_length );
+	put_le32( sample, 0x34, 256 ); // loop start
+	put_le32( sample, 0x38, sample_length ); // loop end
+	put_le32( sample, 0x3C, 8363 * 4 );
+	if ( options.effects ) {
+		sample[0x4C] = 32; // vibrato speed
+		sample[0x4D] = 16; // vibrato depth
+		sample[0x4F] = 8; // vibrato rate
+	}
+	const std::vector<std::uint8_t> sample_data = make_sample_data( sample_length, 1 );
+
+	// effect letter (A = 1) and parameter
+	static const std::uint8_t effects[][2] = {
+		{ 4, 0x0F },  // D volume slide
+		{ 5, 0x08 },  // E portamento down
+		{ 6, 0x08 },  // F portamento up
+		{ 7, 0x20 },  // G tone portamento
+		{ 8, 0x48 },  // H vibrato
+		{ 9, 0x21 },  // I tremor
+		{ 10, 0x37 }, // J arpeggio
+		{ 14, 0x0F }, // N channel volume slide
+		{ 15, 0x08 }, // O sample offset
+		{ 16, 0x10 }, // P panning slide
+		{ 17, 0x13 }, // Q retrigger
+		{ 18, 0x48 }, // R tremolo
+		{ 19, 0x73 }, // S73 NNA continue
+		{ 19, 0x91 }, // S91 surround
+		{ 21, 0x44 }, // U fine vibrato
+		{ 23, 0x10 }, // W global volume slide
+		{ 24, 0x80 }, // X panning
+		{ 25, 0x44 }, // Y panbrello
+		{ 26, 0x40 }, // Z MIDI macro (filter cutoff)
+		{ 26, 0x10 },
+	};
+	const std::size_t num_effects = sizeof( effects ) / sizeof( effects[0] );
+
+	std::vector<std::vector<std::uint8_t>> patterns;
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		std::vector<std::uint8_t> packed;
+		for ( int row = 0; row < rows; ++row ) {
+			for ( int chn = 0; chn < options.channels; ++chn ) {
+				packed.push_back( static_cast<std::uint8_t>( ( chn + 1 ) | 0x80 ) );
+				packed.push_back( options.effects ? 0x0F : options.reverb ? 0x0B : 0x03 ); // note, instrument, (volume, effect)
+				packed.push_back( static_cast<std::uint8_t>( 36 + ( row * 7 + chn * 5 + pat ) % 48 ) );
+				packed.push_back( 1 );
+				if ( !options.effects && options.reverb ) {
+					packed.push_back( 19 ); // S99 reverb on
+					packed.push_back( 0x99 );
+				} else if ( options.effects ) {
+					const std::size_t effect = ( row * 3 + chn * 7 + pat ) % num_effects;
+					packed.push_back( static_cast<std::uint8_t>( ( row + chn ) % 65 ) ); // volume
+					packed.push_back( effects[effect][0] );
+					packed.push_back( effects[effect][1] );
+				}
+			}
+			if ( options.effects && pat == num_patterns - 1 && row == 0 ) {
+				// tempo change on channel 1 of the last pattern
+				packed.push_back( 1 | 0x80 );
+				packed.push_back( 0x08 );
+				packed.push_back( 20 ); // T tempo
+				packed.push_back( 0x20 | 0x0A ); // tempo slide up
+			}
+			packed.push_back( 0 );
+		}
+		std::vector<std::uint8_t> pattern( 8 );
+		put_le16( pattern, 0, static_cast<std::uint16_t>( packed.size() ) );
+		put_le16( pattern, 2, static_cast<std::uint16_t>( rows ) );
+		append( pattern, packed );
+		patterns.push_back( pattern );
+	}
+
+	// Plugin chunks are read from between the pointer tables and the first instrument.
+	const std::size_t pointers_offset = header.size() + orders.size();
+	const std::size_t offset = pointers_offset + 4 * ( 2 + num_patterns ) + plugins.size();
+	std::vector<std::uint8_t> pointers( 4 * ( 2 + num_patterns ) );
+	std::vector<std::uint8_t> body;
+	put_le32( pointers, 0, static_cast<std::uint32_t>( offset + body.size() ) );
+	append( body, instrument );
+	const std::size_t sample_header_offset = body.size();
+	put_le32( pointers, 4, static_cast<std::uint32_t>( offset + body.size() ) );
+	append( body, sample );
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		put_le32( pointers, 8 + 4 * pat, static_cast<std::uint32_t>( offset + body.size() ) );
+		append( body, patterns[pat] );
+	}
+	put_le32( body, sample_header_offset + 0x48, static_cast<std::uint32_t>( offset + body.size() ) );
+	append( body, sample_data );
+
+	std::vector<std::uint8_t> file;
+	append( file, header );
+	append( file, orders );
+	append( file, pointers );
+	append( file, plugins );
+	append( file, body );
+	return file;
+}
+
+// Builds an IT file with many large 16-bit samples, of which the song only plays the first few.
+// This is the worst case for loading all sample data up front.
+inline std::vector<std::uint8_t> make_it_big_samples( int num_samples, std::uint32_t sample_length, int used_samples ) {
+	std::vector<std::uint8_t> header( 0xC0 );
+	put( header, 0, "IMPM", 4 );
+	put( header, 4, "libopenmpt_bench", 16 );
+	const std::vector<std::uint8_t> orders = { 0x00, 0xFF };
+	put_le16( header, 0x20, static_cast<std::uint16_t>( orders.size() ) );
+	put_le16( header, 0x24, static_cast<std::uint16_t>( num_samples ) );
+	put_le16( header, 0x26, 1 ); // patterns
+	put_le16( header, 0x28, 0x0214 ); // cwtv
+	put_le16( header, 0x2A, 0x0214 ); // cmwt
+	put_le16( header, 0x2C, 0x09 ); // stereo, linear slides
+	header[0x30] = 128; // global volume
+	header[0x31] = 48; // mix volume
+	header[0x32] = 6; // speed
+	header[0x33] = 125; // tempo
+	header[0x34] = 128; // separation
+	for ( int chn = 0; chn < 64; ++chn ) {
+		header[0x40 + chn] = static_cast<std::uint8_t>( chn < 4 ? 32 : 160 );
+		header[0x80 + chn] = 64;
+	}
+
+	std::vector<std::uint8_t> packed;
+	for ( int row = 0; row < 64; ++row ) {
+		if ( row % 4 == 0 ) {
+			packed.push_back( static_cast<std::uint8_t>( ( ( row / 4 ) % 4 + 1 ) | 0x80 ) );
+			packed.push_back( 0x03 ); // note, instrument
+			packed.push_back( static_cast<std::uint8_t>( 48 + row % 12 ) );
+			packed.push_back( static_cast<std::uint8_t>( 1 + ( row / 4 ) % used_samples ) );
+		}
+		packed.push_back( 0 );
+	}
+	std::vector<std::uint8_t> pattern( 8 );
+	put_le16( pattern, 0, static_cast<std::uint16_t>( packed.size() ) );
+	put_le16( pattern, 2, 64 );
+	append( pattern, packed );
+
+	const std::size_t offset = header.size() + orders.size() + 4 * ( num_samples + 1 );
+	std::vector<std::uint8_t> pointers( 4 * ( num_samples + 1 ) );
+	std::vector<std::uint8_t> body( 80 * num_samples );
+	put_le32( pointers, 4 * num_samples, static_cast<std::uint32_t>( offset + body.size() ) );
+	append( body, pattern );
+	std::uint32_t rng = 1;
+	for ( int smp = 0; smp < num_samples; ++smp ) {
+		const std::size_t sample_offset = 80 * smp;
+		put_le32( pointers, 4 * smp, static_cast<std::uint32_t>( offset + sample_offset ) );
+		put( body, sample_offset, "IMPS", 4 );
+		body[sample_offset + 0x11] = 64; // global volume
+		body[sample_offset + 0x12] = 0x01 | 0x02; // sample data, 16-bit
+		body[sample_offset + 0x13] = 64; // default volume
+		body[sample_offset + 0x2E] = 1; // signed
+		put_le32( body, sample_offset + 0x30, sample_length );
+		put_le32( body, sample_offset + 0x3C, 22050 );
+		put_le32( body, sample_offset + 0x48, static_cast<std::uint32_t>( offset + body.size() ) );
+		const std::size_t data_offset = body.size();
+		body.resize( body.size() + sample_length * 2 );
+		for ( std::uint32_t i = 0; i < sample_length; ++i ) {
+			rng = rng * 1103515245u + 12345u;
+			// triangle wave with a different period per sample, plus noise
+			const std::uint32_t period = 64 + 16 * smp;
+			const std::int32_t phase = static_cast<std::int32_t>( i % period ) - static_cast<std::int32_t>( period / 2 );
+			const std::int32_t value = ( std::abs( phase ) * 16000 ) / static_cast<std::int32_t>( period / 2 ) - 8000 + static_cast<std::int32_t>( ( rng >> 16 ) & 0x7F ) - 64;
+			put_le16( body, data_offset + i * 2, static_cast<std::uint16_t>( static_cast<std::int16_t>( value ) ) );
+		}
+	}
+
+	std::vector<std::uint8_t> file;
+	append( file, header );
+	append( file, orders );
+	append( file, pointers );
+	append( file, body );
+	return file;
+}
+
+// Amiga periods from C-1 to B-3
+inline constexpr std::uint16_t mod_periods[36] = {
+	856, 808, 762, 720, 678, 640, 604, 570, 538, 508, 480, 453,
+	428, 404, 381, 360, 339, 320, 302, 285, 269, 254, 240, 226,
+	214, 202, 190, 180, 170, 160, 151, 143, 135, 127, 120, 113,
+};
+
+// Builds a ProTracker-style MOD file with up to 32 channels.
+inline std::vector<std::uint8_t> make_mod( int channels ) {
+	const int num_patterns = 4;
+	const int num_samples = 8;
+	const std::uint32_t sample_length = 4096;
+	std::vector<std::uint8_t> header( 1084 );
+	put( header, 0, "libopenmpt_bench", 16 );
+	for ( int smp = 0; smp < 31; ++smp ) {
+		const std::size_t offset = 20 + smp * 30;
+		if ( smp < num_samples ) {
+			put_be16( header, offset + 22, static_cast<std::uint16_t>( sample_length / 2 ) );
+			header[offset + 25] = 64; // volume
+			put_be16( header, offset + 26, 128 ); // loop start
+			put_be16( header, offset + 28, static_cast<std::uint16_t>( sample_length / 2 - 128 ) ); // loop length
+		} else {
+			put_be16( header, offset + 28, 1 );
+		}
+	}
+	header[950] = num_patterns;
+	header[951] = 127;
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		header[952 + pat] = static_cast<std::uint8_t>( pat );
+	}
+	const std::string tag = ( channels == 4 ) ? std::string( "M.K." ) : ( channels < 10 ) ? std::to_string( channels ) + "CHN" : std::to_string( channels ) + "CH";
+	put( header, 1080, tag.c_str(), 4 );
+
+	// effect and parameter
+	static const std::uint8_t effects[][2] = {
+		{ 0x0, 0x37 }, // arpeggio
+		{ 0x1, 0x04 }, // portamento up
+		{ 0x2, 0x04 }, // portamento down
+		{ 0x3, 0x10 }, // tone portamento
+		{ 0x4, 0x48 }, // vibrato
+		{ 0x7, 0x48 }, // tremolo
+		{ 0x8, 0x80 }, // panning
+		{ 0x9, 0x04 }, // sample offset
+		{ 0xA, 0x02 }, // volume slide
+		{ 0xC, 0x30 }, // volume
+		{ 0xE, 0x93 }, // retrigger
+		{ 0xE, 0xC2 }, // note cut
+	};
+	const std::size_t num_effects = sizeof( effects ) / sizeof( effects[0] );
+
+	std::vector<std::uint8_t> file = header;
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		for ( int row = 0; row < 64; ++row ) {
+			for ( int chn = 0; chn < channels; ++chn ) {
+				const int smp = 1 + ( row + chn ) % num_samples;
+				const std::uint16_t period = mod_periods[( row * 7 + chn * 5 + pat ) % 36];
+				const std::size_t effect = ( row * 3 + chn * 7 + pat ) % num_effects;
+				file.push_back( static_cast<std::uint8_t>( ( smp & 0xF0 ) | ( period >> 8 ) ) );
+				file.push_back( static_cast<std::uint8_t>( period & 0xFF ) );
+				file.push_back( static_cast<std::uint8_t>( ( ( smp & 0x0F ) << 4 ) | effects[effect][0] ) );
+				file.push_back( effects[effect][1] );
+			}
+		}
+	}
+	for ( int smp = 0; smp < num_samples; ++smp ) {
+		append( file, make_sample_data( sample_length, smp + 1 ) );
+	}
+	return file;
+}
+
+// Builds a ScreamTracker 3 file. S3M supports at most 16 PCM channels.
+inline std::vector<std::uint8_t> make_s3m( int channels ) {
+	const int num_patterns = 4;
+	const int num_samples = 8;
+	const std::uint32_t sample_length = 4096;
+	const int num_orders = num_patterns + 2; // must be even
+	std::vector<std::uint8_t> header( 0x60 );
+	put( header, 0, "libopenmpt_bench", 16 );
+	header[0x1C] = 0x1A;
+	header[0x1D] = 16; // S3M module
+	put_le16( header, 0x20, static_cast<std::uint16_t>( num_orders ) );
+	put_le16( header, 0x22, static_cast<std::uint16_t>( num_samples ) );
+	put_le16( header, 0x24, static_cast<std::uint16_t>( num_patterns ) );
+	put_le16( header, 0x28, 0x1320 ); // ST3.20
+	put_le16( header, 0x2A, 2 ); // unsigned samples
+	put( header, 0x2C, "SCRM", 4 );
+	header[0x30] = 64; // global volume
+	header[0x31] = 3; // speed
+	header[0x32] = 150; // tempo
+	header[0x33] = 0x80 | 48; // stereo, master volume
+	for ( int chn = 0; chn < 32; ++chn ) {
+		// alternate between left and right PCM channels
+		header[0x40 + chn] = static_cast<std::uint8_t>( chn < channels ? ( ( chn % 2 ) * 8 + chn / 2 ) : 0xFF );
+	}
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		header.push_back( static_cast<std::uint8_t>( pat ) );
+	}
+	header.push_back( 0xFF );
+	header.push_back( 0xFF );
+	const std::size_t pointers_offset = header.size();
+	header.resize( header.size() + 2 * ( num_samples + num_patterns ) );
+	header.resize( ( header.size() + 15 ) & ~std::size_t( 15 ) );
+
+	// command letter (A = 1) and parameter
+	static const std::uint8_t effects[][2] = {
+		{ 4, 0x0F },  // D volume slide
+		{ 5, 0x08 },  // E portamento down
+		{ 6, 0x08 },  // F portamento up
+		{ 7, 0x20 },  // G tone portamento
+		{ 8, 0x48 },  // H vibrato
+		{ 9, 0x21 },  // I tremor
+		{ 10, 0x37 }, // J arpeggio
+		{ 15, 0x08 }, // O sample offset
+		{ 17, 0x13 }, // Q retrigger
+		{ 18, 0x48 }, // R tremolo
+		{ 19, 0xC2 }, // SC2 note cut
+		{ 21, 0x44 }, // U fine vibrato
+		{ 24, 0x40 }, // X panning
+	};
+	const std::size_t num_effects = sizeof( effects ) / sizeof( effects[0] );
+
+	std::vector<std::uint8_t> file = header;
+	const auto paragraph = [&file]() {
+		file.resize( ( file.size() + 15 ) & ~std::size_t( 15 ) );
+		return static_cast<std::uint16_t>( file.size() / 16 );
+	};
+	std::vector<std::size_t> sample_headers;
+	for ( int smp = 0; smp < num_samples; ++smp ) {
+		put_le16( file, pointers_offset + 2 * smp, paragraph() );
+		std::vector<std::uint8_t> sample( 0x50 );
+		sample[0x00] = 1; // PCM
+		put_le32( sample, 0x10, sample_length );
+		put_le32( sample, 0x14, 128 ); // loop start
+		put_le32( sample, 0x18, sample_length ); // loop end
+		sample[0x1C] = 64; // volume
+		sample[0x1F] = 1; // loop
+		put_le32( sample, 0x20, 8363 );
+		put( sample, 0x4C, "SCRS", 4 );
+		sample_headers.push_back( file.size() );
+		append( file, sample );
+	}
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		put_le16( file, pointers_offset + 2 * ( num_samples + pat ), paragraph() );
+		std::vector<std::uint8_t> packed( 2 );
+		for ( int row = 0; row < 64; ++row ) {
+			for ( int chn = 0; chn < channels; ++chn ) {
+				const int note = ( row * 7 + chn * 5 + pat ) % 36;
+				const std::size_t effect = ( row * 3 + chn * 7 + pat ) % num_effects;
+				packed.push_back( static_cast<std::uint8_t>( chn | 0x20 | 0x40 | 0x80 ) ); // note, instrument, volume, effect
+				packed.push_back( static_cast<std::uint8_t>( ( ( 3 + note / 12 ) << 4 ) | ( note % 12 ) ) );
+				packed.push_back( static_cast<std::uint8_t>( 1 + ( row + chn ) % num_samples ) );
+				packed.push_back( static_cast<std::uint8_t>( ( row + chn ) % 65 ) );
+				packed.push_back( effects[effect][0] );
+				packed.push_back( effects[effect][1] );
+			}
+			packed.push_back( 0 );
+		}
+		put_le16( packed, 0, static_cast<std::uint16_t>( packed.size() ) );
+		append( file, packed );
+	}
+	for ( int smp = 0; smp < num_samples; ++smp ) {
+		const std::uint16_t data_paragraph = paragraph();
+		file[sample_headers[smp] + 0x0E] = static_cast<std::uint8_t>( data_paragraph & 0xFF );
+		file[sample_headers[smp] + 0x0F] = static_cast<std::uint8_t>( data_paragraph >> 8 );
+		std::vector<std::uint8_t> data = make_sample_data( sample_length, smp + 1 );
+		for ( auto & b : data ) {
+			b ^= 0x80; // unsigned
+		}
+		append( file, data );
+	}
+	return file;
+}
+
+// Builds a FastTracker 2 file with up to 32 channels.
+inline std::vector<std::uint8_t> make_xm( int channels ) {
+	const int num_patterns = 4;
+	const int num_instruments = 8;
+	const std::uint32_t sample_length = 4096;
+	std::vector<std::uint8_t> file( 60 + 276 );
+	put( file, 0, "Extended Module: ", 17 );
+	put( file, 17, "libopenmpt_bench", 16 );
+	file[37] = 0x1A;
+	put( file, 38, "FastTracker v2.00   ", 20 );
+	put_le16( file, 58, 0x0104 ); // version
+	put_le32( file, 60, 276 ); // header size
+	put_le16( file, 64, static_cast<std::uint16_t>( num_patterns ) ); // orders
+	put_le16( file, 68, static_cast<std::uint16_t>( channels ) );
+	put_le16( file, 70, static_cast<std::uint16_t>( num_patterns ) );
+	put_le16( file, 72, static_cast<std::uint16_t>( num_instruments ) );
+	put_le16( file, 74, 1 ); // linear slides
+	put_le16( file, 76, 3 ); // speed
+	put_le16( file, 78, 150 ); // tempo
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		file[80 + pat] = static_cast<std::uint8_t>( pat );
+	}
+
+	// effect and parameter
+	static const std::uint8_t effects[][2] = {
+		{ 0x0, 0x37 },  // arpeggio
+		{ 0x1, 0x08 },  // portamento up
+		{ 0x2, 0x08 },  // portamento down
+		{ 0x3, 0x20 },  // tone portamento
+		{ 0x4, 0x48 },  // vibrato
+		{ 0x7, 0x48 },  // tremolo
+		{ 0x8, 0x40 },  // panning
+		{ 0x9, 0x08 },  // sample offset
+		{ 0xA, 0x0F },  // volume slide
+		{ 0xE, 0x93 },  // retrigger
+		{ 0x11, 0x10 }, // H global volume slide
+		{ 0x14, 0x20 }, // K key off
+		{ 0x19, 0x0F }, // P panning slide
+		{ 0x1B, 0x13 }, // R multi retrigger
+	};
+	const std::size_t num_effects = sizeof( effects ) / sizeof( effects[0] );
+
+	for ( int pat = 0; pat < num_patterns; ++pat ) {
+		std::vector<std::uint8_t> pattern( 9 );
+		put_le32( pattern, 0, 9 ); // header size
+		put_le16( pattern, 5, 64 ); // rows
+		for ( int row = 0; row < 64; ++row ) {
+			for ( int chn = 0; chn < channels; ++chn ) {
+				const std::size_t effect = ( row * 3 + chn * 7 + pat ) % num_effects;
+				pattern.push_back( static_cast<std::uint8_t>( 25 + ( row * 7 + chn * 5 + pat ) % 48 ) );
+				pattern.push_back( static_cast<std::uint8_t>( 1 + ( row + chn ) % num_instruments ) );
+				pattern.push_back( static_cast<std::uint8_t>( 0x10 + ( row + chn ) % 65 ) ); // set volume
+				pattern.push_back( effects[effect][0] );
+				pattern.push_back( effects[effect][1] );
+			}
+		}
+		put_le16( pattern, 7, static_cast<std::uint16_t>( pattern.size() - 9 ) );
+		append( file, pattern );
+	}
+	for ( int ins = 0; ins < num_instruments; ++ins ) {
+		std::vector<std::uint8_t> instrument( 263 );
+		put_le32( instrument, 0, 263 );
+		put_le16( instrument, 27, 1 ); // samples
+		put_le32( instrument, 29, 40 ); // sample header size
+		// volume envelope with sustain point
+		const std::uint16_t env[3][2] = { { 0, 64 }, { 8, 40 }, { 32, 0 } };
+		for ( int node = 0; node < 3; ++node ) {
+			put_le16( instrument, 129 + node * 4, env[node][0] );
+			put_le16( instrument, 131 + node * 4, env[node][1] );
+		}
+		instrument[225] = 3; // volume envelope points
+		instrument[227] = 1; // sustain point
+		instrument[233] = 0x01 | 0x02; // volume envelope on, sustain
+		instrument[235] = 0; // auto-vibrato type
+		instrument[237] = 8; // auto-vibrato depth
+		instrument[238] = 16; // auto-vibrato rate
+		put_le16( instrument, 239, 512 ); // fadeout
+		std::vector<std::uint8_t> sample( 40 );
+		put_le32( sample, 0, sample_length );
+		put_le32( sample, 4, 128 ); // loop start
+		put_le32( sample, 8, sample_length - 128 ); // loop length
+		sample[12] = 64; // volume
+		sample[14] = static_cast<std::uint8_t>( ( ins % 2 ) ? 0x02 : 0x01 ); // ping-pong or forward loop
+		sample[15] = 128; // panning
+		append( file, instrument );
+		append( file, sample );
+		// delta-encoded sample data
+		std::vector<std::uint8_t> data = make_sample_data( sample_length, ins + 1 );
+		std::uint8_t prev = 0;
+		for ( auto & b : data ) {
+			const std::uint8_t cur = b;
+			b = static_cast<std::uint8_t>( cur - prev );
+			prev = cur;
+		}
+		append( file, data );
+	}
+	return file;
+}
+
+} // namespace libopenmpt_bench
+
+#endif // LIBOPENMPT_BENCH_MODULES_HPP
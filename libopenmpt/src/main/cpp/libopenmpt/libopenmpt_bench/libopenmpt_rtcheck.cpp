@@ -0,0 +1,357 @@
+/*
+ * libopenmpt_rtcheck.cpp
+ * ----------------------
+ * Purpose: Check that rendering audio never allocates memory or locks a mutex
+ * Notes  : Interposes the C allocator and the pthread locking functions, so this only works with glibc.
+ *          Every module is rendered once before the check is armed, so that one-time initialization is not reported.
+ *          Hits are reported with a raw backtrace, which can be resolved with `addr2line -Cfpe bin/libopenmpt_rtcheck ADDRESS...`.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+/*
+ * Usage: libopenmpt_rtcheck [--seconds SECONDS] [FILE...]
+ *
+ * Without files, the test modules in test/ and a synthetic stress corpus are checked.
+ */
+
+#include <libopenmpt/libopenmpt.hpp>
+
+#include "libopenmpt_bench_modules.hpp"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__)
+#include <dlfcn.h>
+#include <execinfo.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#if defined(__GLIBC__)
+
+extern "C" {
+void * __libc_malloc( std::size_t size );
+void * __libc_calloc( std::size_t count, std::size_t size );
+void * __libc_realloc( void * ptr, std::size_t size );
+void * __libc_memalign( std::size_t alignment, std::size_t size );
+void __libc_free( void * ptr );
+}
+
+namespace libopenmpt_rtcheck {
+
+// Only the thread that renders is checked, and only while it is inside a read call.
+static thread_local bool armed = false;
+static thread_local bool reporting = false;
+static int hits = 0;
+static const int max_reported_hits = 16;
+
+static void write_stderr( const char * str ) {
+	ssize_t ignored = ::write( STDERR_FILENO, str, std::strlen( str ) );
+	static_cast<void>( ignored );
+}
+
+// Must not allocate: called from inside the interposed functions.
+static void hit( const char * what ) {
+	if ( !armed || reporting ) {
+		return;
+	}
+	reporting = true;
+	hits++;
+	if ( hits <= max_reported_hits ) {
+		write_stderr( "realtime violation: " );
+		write_stderr( what );
+		write_stderr( " while rendering\n" );
+		void * frames[64];
+		int num_frames = ::backtrace( frames, 64 );
+		::backtrace_symbols_fd( frames, num_frames, STDERR_FILENO );
+		write_stderr( "\n" );
+	}
+	reporting = false;
+}
+
+class armed_scope {
+public:
+	armed_scope() {
+		armed = true;
+	}
+	~armed_scope() {
+		armed = false;
+	}
+};
+
+template < typename Tfuncptr >
+static void resolve_next( Tfuncptr & func, const char * name ) {
+	func = reinterpret_cast<Tfuncptr>( ::dlsym( RTLD_NEXT, name ) );
+}
+
+static decltype( &::pthread_mutex_lock ) real_pthread_mutex_lock = nullptr;
+static decltype( &::pthread_mutex_trylock ) real_pthread_mutex_trylock = nullptr;
+static decltype( &::pthread_mutex_unlock ) real_pthread_mutex_unlock = nullptr;
+static decltype( &::pthread_rwlock_rdlock ) real_pthread_rwlock_rdlock = nullptr;
+static decltype( &::pthread_rwlock_wrlock ) real_pthread_rwlock_wrlock = nullptr;
+static decltype( &::pthread_rwlock_unlock ) real_pthread_rwlock_unlock = nullptr;
+static decltype( &::pthread_cond_wait ) real_pthread_cond_wait = nullptr;
+
+// Resolve the real functions before anything can be armed. backtrace() loads libgcc on first use, so do that now as well.
+static void init() {
+	resolve_next( real_pthread_mutex_lock, "pthread_mutex_lock" );
+	resolve_next( real_pthread_mutex_trylock, "pthread_mutex_trylock" );
+	resolve_next( real_pthread_mutex_unlock, "pthread_mutex_unlock" );
+	resolve_next( real_pthread_rwlock_rdlock, "pthread_rwlock_rdlock" );
+	resolve_next( real_pthread_rwlock_wrlock, "pthread_rwlock_wrlock" );
+	resolve_next( real_pthread_rwlock_unlock, "pthread_rwlock_unlock" );
+	resolve_next( real_pthread_cond_wait, "pthread_cond_wait" );
+	void * frames[1];
+	::backtrace( frames, 1 );
+}
+
+} // namespace libopenmpt_rtcheck
+
+extern "C" {
+
+void * malloc( std::size_t size ) {
+	libopenmpt_rtcheck::hit( "malloc" );
+	return __libc_malloc( size );
+}
+
+void * calloc( std::size_t count, std::size_t size ) {
+	libopenmpt_rtcheck::hit( "calloc" );
+	return __libc_calloc( count, size );
+}
+
+void * realloc( void * ptr, std::size_t size ) {
+	libopenmpt_rtcheck::hit( "realloc" );
+	return __libc_realloc( ptr, size );
+}
+
+void * memalign( std::size_t alignment, std::size_t size ) {
+	libopenmpt_rtcheck::hit( "memalign" );
+	return __libc_memalign( alignment, size );
+}
+
+void * aligned_alloc( std::size_t alignment, std::size_t size ) {
+	libopenmpt_rtcheck::hit( "aligned_alloc" );
+	return __libc_memalign( alignment, size );
+}
+
+int posix_memalign( void ** ptr, std::size_t alignment, std::size_t size ) {
+	libopenmpt_rtcheck::hit( "posix_memalign" );
+	void * result = __libc_memalign( alignment, size );
+	if ( !result ) {
+		return ENOMEM;
+	}
+	*ptr = result;
+	return 0;
+}
+
+void free( void * ptr ) {
+	if ( ptr ) {
+		libopenmpt_rtcheck::hit( "free" );
+	}
+	__libc_free( ptr );
+}
+
+int pthread_mutex_lock( pthread_mutex_t * mutex ) {
+	libopenmpt_rtcheck::hit( "pthread_mutex_lock" );
+	return libopenmpt_rtcheck::real_pthread_mutex_lock( mutex );
+}
+
+int pthread_mutex_trylock( pthread_mutex_t * mutex ) {
+	libopenmpt_rtcheck::hit( "pthread_mutex_trylock" );
+	return libopenmpt_rtcheck::real_pthread_mutex_trylock( mutex );
+}
+
+int pthread_mutex_unlock( pthread_mutex_t * mutex ) {
+	libopenmpt_rtcheck::hit( "pthread_mutex_unlock" );
+	return libopenmpt_rtcheck::real_pthread_mutex_unlock( mutex );
+}
+
+int pthread_rwlock_rdlock( pthread_rwlock_t * rwlock ) {
+	libopenmpt_rtcheck::hit( "pthread_rwlock_rdlock" );
+	return libopenmpt_rtcheck::real_pthread_rwlock_rdlock( rwlock );
+}
+
+int pthread_rwlock_wrlock( pthread_rwlock_t * rwlock ) {
+	libopenmpt_rtcheck::hit( "pthread_rwlock_wrlock" );
+	return libopenmpt_rtcheck::real_pthread_rwlock_wrlock( rwlock );
+}
+
+int pthread_rwlock_unlock( pthread_rwlock_t * rwlock ) {
+	libopenmpt_rtcheck::hit( "pthread_rwlock_unlock" );
+	return libopenmpt_rtcheck::real_pthread_rwlock_unlock( rwlock );
+}
+
+int pthread_cond_wait( pthread_cond_t * cond, pthread_mutex_t * mutex ) {
+	libopenmpt_rtcheck::hit( "pthread_cond_wait" );
+	return libopenmpt_rtcheck::real_pthread_cond_wait( cond, mutex );
+}
+
+} // extern "C"
+
+#endif // __GLIBC__
+
+namespace libopenmpt_rtcheck {
+
+struct corpus_file {
+	std::string name;
+	std::vector<std::uint8_t> data;
+};
+
+static std::vector<std::uint8_t> read_file( const std::string & filename ) {
+	std::ifstream file( filename, std::ios::binary );
+	if ( !file ) {
+		throw std::runtime_error( "cannot open " + filename );
+	}
+	return std::vector<std::uint8_t>( ( std::istreambuf_iterator<char>( file ) ), std::istreambuf_iterator<char>() );
+}
+
+struct render_config {
+	const char * name;
+	int channels;
+	bool use_float;
+	bool interleaved;
+	int interpolation;
+	int ramping;
+	std::map<std::string, std::string> ctls;
+};
+
+static const std::size_t block_frames = 480;
+static const std::int32_t samplerate = 48000;
+
+template < typename Tsample >
+static std::size_t read_block( openmpt::module & mod, const render_config & config, std::vector<Tsample> & buffer ) {
+	Tsample * ch[4] = { buffer.data(), buffer.data() + block_frames, buffer.data() + block_frames * 2, buffer.data() + block_frames * 3 };
+	if ( config.interleaved ) {
+		switch ( config.channels ) {
+			case 2: return mod.read_interleaved_stereo( samplerate, block_frames, buffer.data() );
+			case 4: return mod.read_interleaved_quad( samplerate, block_frames, buffer.data() );
+		}
+	} else {
+		switch ( config.channels ) {
+			case 1: return mod.read( samplerate, block_frames, ch[0] );
+			case 2: return mod.read( samplerate, block_frames, ch[0], ch[1] );
+			case 4: return mod.read( samplerate, block_frames, ch[0], ch[1], ch[2], ch[3] );
+		}
+	}
+	return 0;
+}
+
+template < typename Tsample >
+static std::size_t render( openmpt::module & mod, const render_config & config, double seconds ) {
+	std::vector<Tsample> buffer( block_frames * 4 );
+	// Let one-time initialization (e.g. of plugins) happen before arming the check.
+	read_block( mod, config, buffer );
+	const std::size_t blocks = static_cast<std::size_t>( seconds * samplerate / block_frames );
+	std::size_t frames = 0;
+	for ( std::size_t block = 0; block < blocks; ++block ) {
+		std::size_t count = 0;
+		{
+#if defined(__GLIBC__)
+			armed_scope armed;
+#endif
+			count = read_block( mod, config, buffer );
+		}
+		frames += count;
+		if ( count == 0 ) {
+			break;
+		}
+	}
+	return frames;
+}
+
+static int main( int argc, char * argv[] ) {
+#if !defined(__GLIBC__)
+	static_cast<void>( argc );
+	static_cast<void>( argv );
+	std::cerr << "libopenmpt_rtcheck requires glibc, skipping." << std::endl;
+	return 0;
+#else
+	init();
+	double seconds = 20.0;
+	std::vector<std::string> filenames;
+	for ( int i = 1; i < argc; ++i ) {
+		std::string arg = argv[i];
+		if ( arg == "--seconds" && i + 1 < argc ) {
+			seconds = std::atof( argv[++i] );
+		} else if ( arg.substr( 0, 1 ) == "-" ) {
+			std::cerr << "Usage: libopenmpt_rtcheck [--seconds SECONDS] [FILE...]" << std::endl;
+			return 1;
+		} else {
+			filenames.push_back( arg );
+		}
+	}
+	std::vector<corpus_file> corpus;
+	if ( filenames.empty() ) {
+		for ( const char * name : { "test/test.mod", "test/test.s3m", "test/test.xm", "test/test.mptm" } ) {
+			corpus.push_back( { name, read_file( name ) } );
+		}
+		libopenmpt_bench::it_options options;
+		options.channels = 64;
+		corpus.push_back( { "stress-64ch", libopenmpt_bench::make_it( options ) } );
+		options.channels = 16;
+		options.pingpong = true;
+		corpus.push_back( { "stress-16ch-pingpong", libopenmpt_bench::make_it( options ) } );
+	} else {
+		for ( const auto & filename : filenames ) {
+			corpus.push_back( { filename, read_file( filename ) } );
+		}
+	}
+	const std::vector<render_config> configs = {
+		{ "stereo-int16", 2, false, false, 8, -1, {} },
+		{ "interleaved-stereo-float", 2, true, true, 8, -1, {} },
+		{ "mono-float-linear", 1, true, false, 2, 0, {} },
+		{ "quad-int16-nearest", 4, false, false, 1, 5, { { "dither", "2" } } },
+		{ "interleaved-quad-float-cubic", 4, true, true, 4, 2, {} },
+		{ "stereo-float-amiga", 2, true, false, 8, -1, { { "render.resampler.emulate_amiga", "1" } } },
+		{ "stereo-int16-loop", 2, false, false, 8, -1, { { "play.at_end", "continue" } } },
+	};
+	int failed_files = 0;
+	for ( const auto & file : corpus ) {
+		const int hits_before = hits;
+		for ( const auto & config : configs ) {
+			std::ostringstream log;
+			openmpt::module mod( file.data, log, config.ctls );
+			mod.set_repeat_count( -1 );
+			mod.set_render_param( openmpt::module::RENDER_INTERPOLATIONFILTER_LENGTH, config.interpolation );
+			mod.set_render_param( openmpt::module::RENDER_VOLUMERAMPING_STRENGTH, config.ramping );
+			const std::size_t frames = config.use_float ? render<float>( mod, config, seconds ) : render<std::int16_t>( mod, config, seconds );
+			if ( frames == 0 ) {
+				std::cerr << file.name << ": " << config.name << ": rendered nothing" << std::endl;
+				failed_files++;
+			}
+		}
+		const bool ok = ( hits == hits_before );
+		std::cout << ( ok ? "PASS" : "FAIL" ) << ": " << file.name << ( ok ? "" : " (" + std::to_string( hits - hits_before ) + " violations)" ) << std::endl;
+		if ( !ok ) {
+			failed_files++;
+		}
+	}
+	return failed_files > 0 ? 1 : 0;
+#endif
+}
+
+} // namespace libopenmpt_rtcheck
+
+int main( int argc, char * argv[] ) {
+	try {
+		return libopenmpt_rtcheck::main( argc, argv );
+	} catch ( const std::exception & e ) {
+		std::cerr << "Error: " << e.what() << std::endl;
+		return 1;
+	}
+}
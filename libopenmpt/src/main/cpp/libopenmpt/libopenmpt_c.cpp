@@ -24,6 +24,7 @@
 #include <new>
 #include <stdexcept>
 #include <string_view>
+#include <vector>
 
 #include <cmath>
 #include <cstdio>
@@ -62,6 +63,41 @@ public:
 	}
 }; // class logfunc_logger
 
+class callbacks_subsong_cache : public subsong_cache {
+private:
+	openmpt_subsong_cache_lookup_func m_lookup;
+	openmpt_subsong_cache_store_func m_store;
+	openmpt_subsong_cache_invalidate_func m_invalidate;
+	void * m_user;
+public:
+	callbacks_subsong_cache( openmpt_subsong_cache_lookup_func lookup, openmpt_subsong_cache_store_func store, openmpt_subsong_cache_invalidate_func invalidate, void * user ) : m_lookup(lookup), m_store(store), m_invalidate(invalidate), m_user(user) {
+		return;
+	}
+	bool lookup( const std::string & key, std::string & value ) override {
+		// Keep one byte beyond what the callback may fill, so that terminating the string never cuts off the value.
+		std::vector<char> buf( 256 + 1 );
+		std::size_t size = m_lookup( m_user, key.c_str(), buf.data(), buf.size() - 1 );
+		if ( size > buf.size() - 1 ) {
+			buf.resize( size + 1 );
+			size = m_lookup( m_user, key.c_str(), buf.data(), buf.size() - 1 );
+		}
+		if ( size == 0 || size > buf.size() - 1 ) {
+			return false;
+		}
+		buf[size] = '\0';
+		value = buf.data();
+		return true;
+	}
+	void store( const std::string & key, const std::string & value ) override {
+		m_store( m_user, key.c_str(), value.c_str() );
+	}
+	void invalidate( const std::string & key ) override {
+		if ( m_invalidate ) {
+			m_invalidate( m_user, key.empty() ? NULL : key.c_str() );
+		}
+	}
+}; // class callbacks_subsong_cache
+
 namespace interface {
 
 class invalid_module_pointer : public openmpt::exception {
@@ -517,6 +553,50 @@ int openmpt_probe_file_header_from_stream( uint64_t flags, openmpt_stream_callba
 	return OPENMPT_PROBE_FILE_HEADER_RESULT_ERROR;
 }
 
+int openmpt_subsong_cache_set_file( const char * path ) {
+	try {
+		openmpt::module_impl::set_subsong_cache( path ? openmpt::module_impl::create_subsong_cache_file( path ) : nullptr );
+		return 1;
+	} catch ( ... ) {
+		openmpt::report_exception( __func__ );
+	}
+	return 0;
+}
+
+int openmpt_subsong_cache_set_callbacks( openmpt_subsong_cache_lookup_func lookup, openmpt_subsong_cache_store_func store, openmpt_subsong_cache_invalidate_func invalidate, void * user ) {
+	try {
+		if ( !lookup || !store ) {
+			openmpt::module_impl::set_subsong_cache( nullptr );
+		} else {
+			openmpt::module_impl::set_subsong_cache( std::make_shared<openmpt::callbacks_subsong_cache>( lookup, store, invalidate, user ) );
+		}
+		return 1;
+	} catch ( ... ) {
+		openmpt::report_exception( __func__ );
+	}
+	return 0;
+}
+
+void openmpt_subsong_cache_invalidate( const char * key ) {
+	try {
+		openmpt::module_impl::invalidate_subsong_cache( key ? key : "" );
+	} catch ( ... ) {
+		openmpt::report_exception( __func__ );
+	}
+}
+
+const char * openmpt_subsong_cache_get_key( const void * filedata, size_t filesize ) {
+	try {
+		if ( !filedata && filesize > 0 ) {
+			throw openmpt::interface::argument_null_pointer();
+		}
+		return openmpt::strdup( openmpt::module_impl::get_subsong_cache_key( filedata, filesize ).c_str() );
+	} catch ( ... ) {
+		openmpt::report_exception( __func__ );
+	}
+	return NULL;
+}
+
 openmpt_module * openmpt_module_create( openmpt_stream_callbacks stream_callbacks, void * stream, openmpt_log_func logfunc, void * user, const openmpt_module_initial_ctl * ctls ) {
 	return openmpt_module_create2( stream_callbacks, stream, logfunc, user, NULL, NULL, NULL, NULL, ctls );
 }
@@ -628,6 +708,58 @@ openmpt_module * openmpt_module_create_from_memory2( const void * filedata, size
 	return NULL;
 }
 
+openmpt_module * openmpt_module_create_from_file( const char * filename, openmpt_log_func logfunc, void * loguser, openmpt_error_func errfunc, void * erruser, int * error, const char * * error_message, const openmpt_module_initial_ctl * ctls ) {
+	try {
+		openmpt_module * mod = (openmpt_module*)std::calloc( 1, sizeof( openmpt_module ) );
+		if ( !mod ) {
+			throw std::bad_alloc();
+		}
+		std::memset( mod, 0, sizeof( openmpt_module ) );
+		mod->logfunc = logfunc ? logfunc : openmpt_log_func_default;
+		mod->loguser = loguser;
+		mod->errfunc = errfunc ? errfunc : NULL;
+		mod->erruser = erruser;
+		mod->error = OPENMPT_ERROR_OK;
+		mod->error_message = NULL;
+		mod->impl = 0;
+		try {
+			std::map< std::string, std::string > ctls_map;
+			if ( ctls ) {
+				for ( const openmpt_module_initial_ctl * it = ctls; it->ctl; ++it ) {
+					if ( it->value ) {
+						ctls_map[ it->ctl ] = it->value;
+					} else {
+						ctls_map.erase( it->ctl );
+					}
+				}
+			}
+			openmpt::filename_wrapper ifile = { filename };
+			mod->impl = new openmpt::module_impl( ifile, openmpt::helper::make_unique<openmpt::logfunc_logger>( mod->logfunc, mod->loguser ), ctls_map );
+			return mod;
+		} catch ( ... ) {
+			#if defined(_MSC_VER)
+			#pragma warning(push)
+			#pragma warning(disable:6001) // false-positive: Using uninitialized memory 'mod'.
+			#endif // _MSC_VER
+				openmpt::report_exception( __func__, mod, error, error_message );
+			#if defined(_MSC_VER)
+			#pragma warning(pop)
+			#endif // _MSC_VER
+		}
+		delete mod->impl;
+		mod->impl = 0;
+		if ( mod->error_message ) {
+			openmpt_free_string( mod->error_message );
+			mod->error_message = NULL;
+		}
+		std::free( (void*)mod );
+		mod = NULL;
+	} catch ( ... ) {
+		openmpt::report_exception( __func__, 0, error, error_message );
+	}
+	return NULL;
+}
+
 void openmpt_module_destroy( openmpt_module * mod ) {
 	try {
 		openmpt::interface::check_soundfile( mod );
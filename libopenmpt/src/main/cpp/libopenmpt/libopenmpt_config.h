@@ -130,6 +130,20 @@
  */
 #define LIBOPENMPT_STREAM_CALLBACKS_FILE_POSIX_LFS64
 
+/*! \brief Defined if libopenmpt/libopenmpt_stream_callbacks_mmap.h exists.
+ * \remarks
+ *   This macro does not determine if the interfaces required to use libopenmpt/libopenmpt_stream_callbacks_mmap.h are available.
+ *   It is the libopenmpt user's responsibility to check for availability of mmap(), munmap(), and fstat().
+ *   Use the following to check for availability:
+ *   \code
+ *   #include <libopenmpt/libopenmpt.h>
+ *   #if defined(LIBOPENMPT_STREAM_CALLBACKS_MMAP)
+ *   #include <libopenmpt/libopenmpt_stream_callbacks_mmap.h>
+ *   #endif
+ *   \endcode
+ */
+#define LIBOPENMPT_STREAM_CALLBACKS_MMAP
+
 /*!
   @}
 */
@@ -158,6 +158,26 @@ int probe_file_header( std::uint64_t flags, std::istream & stream ) {
 	return openmpt::module_impl::probe_file_header( flags, stream );
 }
 
+subsong_cache::~subsong_cache() {
+	return;
+}
+
+void set_subsong_cache( std::shared_ptr<subsong_cache> cache ) {
+	openmpt::module_impl::set_subsong_cache( std::move( cache ) );
+}
+std::shared_ptr<subsong_cache> get_subsong_cache() {
+	return openmpt::module_impl::get_subsong_cache();
+}
+std::shared_ptr<subsong_cache> create_subsong_cache_file( const std::string & path ) {
+	return openmpt::module_impl::create_subsong_cache_file( path );
+}
+std::string get_subsong_cache_key( const void * data, std::size_t size ) {
+	return openmpt::module_impl::get_subsong_cache_key( data, size );
+}
+void invalidate_subsong_cache( const std::string & key ) {
+	openmpt::module_impl::invalidate_subsong_cache( key );
+}
+
 #if defined(_MSC_VER)
 #pragma warning(push)
 #pragma warning(disable:4702) // unreachable code
@@ -266,6 +266,7 @@ namespace openmpt {
 		}
 
 		OpenMPT::ModChannel &chn = m_sndFile->m_PlayState.Chn[free_channel];
+		m_sndFile->m_PlayState.SetBackgroundChannelInUse( free_channel );
 		chn.Reset( OpenMPT::ModChannel::resetTotal, *m_sndFile, OpenMPT::CHANNELINDEX_INVALID, OpenMPT::CHN_MUTE );
 		chn.nMasterChn = 0;	// remove NNA association
 		chn.nNewNote = chn.nLastNote = static_cast<std::uint8_t>(note);
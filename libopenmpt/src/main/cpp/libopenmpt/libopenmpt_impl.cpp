@@ -15,11 +15,16 @@
 #include "libopenmpt_impl.hpp"
 
 #include <algorithm>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <istream>
 #include <iterator>
 #include <limits>
+#include <locale>
+#include <map>
 #include <ostream>
+#include <sstream>
 
 #include <cmath>
 #include <cstdlib>
@@ -30,14 +35,17 @@
 #include "mpt/base/detect.hpp"
 #include "mpt/base/saturate_cast.hpp"
 #include "mpt/base/saturate_round.hpp"
+#include "mpt/crc/crc.hpp"
 #include "mpt/format/default_integer.hpp"
 #include "mpt/format/default_floatingpoint.hpp"
 #include "mpt/format/default_string.hpp"
 #include "mpt/format/join.hpp"
+#include "mpt/io_file/fstream.hpp"
 #include "mpt/io_read/callbackstream.hpp"
 #include "mpt/io_read/filecursor_callbackstream.hpp"
 #include "mpt/io_read/filecursor_memory.hpp"
 #include "mpt/io_read/filecursor_stdstream.hpp"
+#include "mpt/io_read/filedata_mmap.hpp"
 #include "mpt/mutex/mutex.hpp"
 #include "mpt/parse/parse.hpp"
 #include "mpt/string/types.hpp"
@@ -306,6 +314,141 @@ void loader_log::AddToLog( OpenMPT::LogLevel level, const mpt::ustring & text )
 	m_Messages.push_back( std::make_pair( level, mpt::transcode<std::string>( mpt::common_encoding::utf8, text ) ) );
 }
 
+// Default subsong cache: all entries are held in memory and persisted as "key<TAB>value" lines in a single file.
+// New entries are appended, later lines override earlier ones. The file is rewritten without superseded lines when it is loaded,
+// when an entry is invalidated, and when it has accumulated too many superseded lines.
+// At most max_entries entries are kept; storing more drops the entries that were stored first.
+// I/O errors are ignored, the cache then simply behaves like an in-memory cache.
+class subsong_cache_file : public subsong_cache {
+public:
+	static constexpr std::size_t max_entries = 4096;
+private:
+	struct entry {
+		std::uint64_t generation;
+		std::string value;
+	};
+	const std::string m_Path;
+	mpt::mutex m_Mutex;
+	std::map<std::string, entry> m_Entries;
+	std::uint64_t m_Generation = 0;
+	std::size_t m_FileLines = 0;
+public:
+	subsong_cache_file( const std::string & path );
+	~subsong_cache_file() override;
+	bool lookup( const std::string & key, std::string & value ) override;
+	void store( const std::string & key, const std::string & value ) override;
+	void invalidate( const std::string & key ) override;
+private:
+	bool drop_oldest_entries();
+	void read_file();
+	void write_file();
+}; // class subsong_cache_file
+
+subsong_cache_file::subsong_cache_file( const std::string & path )
+	: m_Path(path)
+{
+	read_file();
+}
+subsong_cache_file::~subsong_cache_file() {
+	return;
+}
+bool subsong_cache_file::lookup( const std::string & key, std::string & value ) {
+	mpt::lock_guard<mpt::mutex> guard( m_Mutex );
+	auto it = m_Entries.find( key );
+	if ( it == m_Entries.end() ) {
+		return false;
+	}
+	value = it->second.value;
+	return true;
+}
+void subsong_cache_file::store( const std::string & key, const std::string & value ) {
+	if ( key.empty() || key.find_first_of( "\t\r\n" ) != std::string::npos || value.find_first_of( "\r\n" ) != std::string::npos ) {
+		return;
+	}
+	mpt::lock_guard<mpt::mutex> guard( m_Mutex );
+	m_Entries[key] = entry{ ++m_Generation, value };
+	if ( drop_oldest_entries() || m_FileLines >= 2 * max_entries ) {
+		write_file();
+		return;
+	}
+	std::ofstream f( m_Path, std::ios::binary | std::ios::app );
+	if ( f ) {
+		f << key << '\t' << value << '\n';
+		m_FileLines++;
+	}
+}
+void subsong_cache_file::invalidate( const std::string & key ) {
+	mpt::lock_guard<mpt::mutex> guard( m_Mutex );
+	if ( key.empty() ) {
+		m_Entries.clear();
+	} else if ( m_Entries.erase( key ) == 0 ) {
+		return;
+	}
+	write_file();
+}
+bool subsong_cache_file::drop_oldest_entries() {
+	if ( m_Entries.size() <= max_entries ) {
+		return false;
+	}
+	std::vector<std::pair<std::uint64_t, std::string> > generations;
+	generations.reserve( m_Entries.size() );
+	for ( const auto & e : m_Entries ) {
+		generations.emplace_back( e.second.generation, e.first );
+	}
+	const std::size_t excess = m_Entries.size() - max_entries;
+	std::nth_element( generations.begin(), generations.begin() + excess, generations.end() );
+	for ( std::size_t i = 0; i < excess; ++i ) {
+		m_Entries.erase( generations[i].second );
+	}
+	return true;
+}
+void subsong_cache_file::read_file() {
+	std::ifstream f( m_Path, std::ios::binary );
+	if ( !f ) {
+		return;
+	}
+	std::size_t lines = 0;
+	std::string line;
+	while ( std::getline( f, line ) ) {
+		lines++;
+		std::size_t tab = line.find( '\t' );
+		if ( tab == std::string::npos || tab == 0 ) {
+			continue;
+		}
+		m_Entries[line.substr( 0, tab )] = entry{ ++m_Generation, line.substr( tab + 1 ) };
+	}
+	f.close();
+	drop_oldest_entries();
+	m_FileLines = lines;
+	if ( lines != m_Entries.size() ) {
+		// Drop superseded, malformed and excess lines
+		write_file();
+	}
+}
+void subsong_cache_file::write_file() {
+	// Keep the order in which entries were stored, so that the oldest entries are still dropped first after reloading
+	std::vector<std::pair<std::uint64_t, const std::pair<const std::string, entry> *> > entries;
+	entries.reserve( m_Entries.size() );
+	for ( const auto & e : m_Entries ) {
+		entries.emplace_back( e.second.generation, &e );
+	}
+	std::sort( entries.begin(), entries.end() );
+	std::ofstream f( m_Path, std::ios::binary | std::ios::trunc );
+	for ( const auto & e : entries ) {
+		f << e.second->first << '\t' << e.second->second.value << '\n';
+	}
+	m_FileLines = m_Entries.size();
+}
+
+static mpt::mutex & subsong_cache_mutex() {
+	static mpt::mutex m;
+	return m;
+}
+static std::shared_ptr<subsong_cache> & subsong_cache_instance() {
+	static std::shared_ptr<subsong_cache> cache;
+	return cache;
+}
+
 void module_impl::PushToCSoundFileLog( const std::string & text ) const {
 	m_sndFile->AddToLog( OpenMPT::LogError, mpt::transcode<mpt::ustring>( mpt::common_encoding::utf8, text ) );
 }
@@ -435,7 +578,11 @@ void module_impl::apply_mixer_settings( std::int32_t samplerate, int channels )
 }
 void module_impl::apply_libopenmpt_defaults() {
 	set_render_param( module::RENDER_STEREOSEPARATION_PERCENT, 100 );
-	m_sndFile->Order.SetSequence( 0 );
+	if ( m_sndFile->Order.GetCurrentSequenceIndex() != 0 ) {
+		// The playback state has been set up for the sequence that was selected when the module was saved.
+		m_sndFile->Order.SetSequence( 0 );
+		m_sndFile->ResetPlayPos();
+	}
 }
 module_impl::subsongs_type module_impl::get_subsongs() const {
 	std::vector<subsong_data> subsongs;
@@ -456,6 +603,80 @@ void module_impl::init_subsongs( subsongs_type & subsongs ) const {
 bool module_impl::has_subsongs_inited() const {
 	return !m_subsongs.empty();
 }
+std::string module_impl::get_subsong_cache_settings() const {
+	// Everything besides the file contents that influences the result of get_subsongs().
+	// All user-settable playback ctls are only applied after the subsongs have been determined.
+	std::ostringstream str;
+	str.imbue( std::locale::classic() );
+	str << std::hex << "v" << OpenMPT::Version::Current().GetRawVersion() << ( m_ctl_load_skip_samples ? "s" : "" ) << ( m_ctl_load_skip_plugins ? "p" : "" );
+	return str.str();
+}
+bool module_impl::load_cached_subsongs( subsong_cache & cache, const std::string & key, subsongs_type & subsongs ) const {
+	std::string value;
+	if ( !cache.lookup( key, value ) ) {
+		return false;
+	}
+	const std::string settings = get_subsong_cache_settings() + "|";
+	if ( value.compare( 0, settings.length(), settings ) != 0 ) {
+		return false;
+	}
+	std::istringstream str( value.substr( settings.length() ) );
+	str.imbue( std::locale::classic() );
+	subsongs_type result;
+	std::string entry;
+	while ( std::getline( str, entry, ';' ) ) {
+		std::istringstream entry_str( entry );
+		entry_str.imbue( std::locale::classic() );
+		double duration = 0.0;
+		std::int32_t start_row = 0, start_order = 0, sequence = 0, restart_row = 0, restart_order = 0;
+		if ( !( entry_str >> duration >> start_row >> start_order >> sequence >> restart_row >> restart_order ) ) {
+			return false;
+		}
+		if ( !std::isfinite( duration ) || duration < 0.0 || sequence < 0 || sequence >= m_sndFile->Order.GetNumSequences() ) {
+			return false;
+		}
+		// Positions must exist in the loaded module, as they are used for seeking without further checks.
+		// The order after the last order is a valid position (with row 0), it is reported when playback continues past the end of the sequence.
+		const OpenMPT::ModSequence & order = m_sndFile->Order( static_cast<OpenMPT::SEQUENCEINDEX>( sequence ) );
+		const auto is_valid_position = [&]( std::int32_t ord, std::int32_t row ) {
+			if ( ord < 0 || ord > static_cast<std::int32_t>( order.GetLength() ) || row < 0 ) {
+				return false;
+			}
+			if ( order.IsValidPat( static_cast<OpenMPT::ORDERINDEX>( ord ) ) ) {
+				return row < static_cast<std::int32_t>( m_sndFile->Patterns[ order[ ord ] ].GetNumRows() );
+			}
+			return row == 0;
+		};
+		const bool restart_unknown = ( restart_order == static_cast<std::int32_t>( OpenMPT::ORDERINDEX_INVALID ) && restart_row == static_cast<std::int32_t>( OpenMPT::ROWINDEX_INVALID ) );
+		if ( !is_valid_position( start_order, start_row ) || ( !restart_unknown && !is_valid_position( restart_order, restart_row ) ) ) {
+			return false;
+		}
+		result.push_back( subsong_data( duration, start_row, start_order, sequence, restart_row, restart_order ) );
+	}
+	if ( result.empty() ) {
+		return false;
+	}
+	subsongs = std::move( result );
+	return true;
+}
+void module_impl::store_cached_subsongs( subsong_cache & cache, const std::string & key, const subsongs_type & subsongs ) const {
+	std::ostringstream str;
+	str.imbue( std::locale::classic() );
+	str.precision( std::numeric_limits<double>::max_digits10 );
+	str << get_subsong_cache_settings() << "|";
+	bool first = true;
+	for ( const auto & subsong : subsongs ) {
+		if ( !std::isfinite( subsong.duration ) ) {
+			return;
+		}
+		if ( !first ) {
+			str << ";";
+		}
+		first = false;
+		str << subsong.duration << " " << subsong.start_row << " " << subsong.start_order << " " << subsong.sequence << " " << subsong.restart_row << " " << subsong.restart_order;
+	}
+	cache.store( key, str.str() );
+}
 void module_impl::ctor( const std::map< std::string, std::string > & ctls ) {
 	m_sndFile = std::make_unique<OpenMPT::CSoundFile>();
 	m_loaded = false;
@@ -468,6 +689,8 @@ void module_impl::ctor( const std::map< std::string, std::string > & ctls ) {
 	m_Gain = 1.0f;
 	m_ctl_play_at_end = song_end_action::fadeout_song;
 	m_ctl_load_skip_samples = false;
+	m_ctl_load_lazy_samples = false;
+	m_ctl_load_map_sample_data = false;
 	m_ctl_load_skip_patterns = false;
 	m_ctl_load_skip_plugins = false;
 	m_ctl_load_skip_subsongs_init = false;
@@ -477,14 +700,18 @@ void module_impl::ctor( const std::map< std::string, std::string > & ctls ) {
 		ctl_set( ctl.first, ctl.second, false );
 	}
 }
-void module_impl::load( const OpenMPT::FileCursor & file, const std::map< std::string, std::string > & ctls ) {
+void module_impl::load( const OpenMPT::FileCursor & input_file, const std::map< std::string, std::string > & ctls, bool file_data_outlives_module, bool file_data_in_memory ) {
 	loader_log loaderlog;
 	m_sndFile->SetCustomLog( &loaderlog );
 	{
+		OpenMPT::FileCursor file = input_file;
 		int load_flags = OpenMPT::CSoundFile::loadCompleteModule;
 		if ( m_ctl_load_skip_samples ) {
 			load_flags &= ~OpenMPT::CSoundFile::loadSampleData;
 		}
+		if ( m_ctl_load_lazy_samples ) {
+			load_flags |= OpenMPT::CSoundFile::deferSampleData;
+		}
 		if ( m_ctl_load_skip_patterns ) {
 			load_flags &= ~OpenMPT::CSoundFile::loadPatternData;
 		}
@@ -494,8 +721,30 @@ void module_impl::load( const OpenMPT::FileCursor & file, const std::map< std::s
 		if ( !m_sndFile->Create( file, static_cast<OpenMPT::CSoundFile::ModLoadingFlags>( load_flags ) ) ) {
 			throw openmpt::exception("error loading file");
 		}
+		if ( m_sndFile->HasDeferredSamples() && !file_data_outlives_module ) {
+			// Deferred samples are decoded from the file data, but the caller's buffer or stream may go away after construction.
+			// Memory-mapped files (openmpt_module_create_from_file) are referenced by the file cursor itself and need no copy.
+			m_sndFile->CopyDeferredSampleData();
+		}
 		if ( !m_ctl_load_skip_subsongs_init ) {
-			init_subsongs( m_subsongs );
+			std::shared_ptr<subsong_cache> cache = m_ctl_load_skip_patterns ? nullptr : get_subsong_cache();
+			if ( cache && !file_data_in_memory ) {
+				// Hashing a seekable stream would read all of it into memory a second time, which costs more than simulating playback.
+				cache = nullptr;
+			}
+			std::string cache_key;
+			if ( cache ) {
+				OpenMPT::FileCursor data = file;
+				data.Rewind();
+				auto view = data.GetPinnedView();
+				cache_key = get_subsong_cache_key( view.data(), view.size() );
+			}
+			if ( !cache || !load_cached_subsongs( *cache, cache_key, m_subsongs ) ) {
+				init_subsongs( m_subsongs );
+				if ( cache ) {
+					store_cached_subsongs( *cache, cache_key, m_subsongs );
+				}
+			}
 		}
 		m_loaded = true;
 	}
@@ -873,6 +1122,33 @@ int module_impl::probe_file_header( std::uint64_t flags, callback_stream_wrapper
 	}
 	return result;
 }
+void module_impl::set_subsong_cache( std::shared_ptr<subsong_cache> cache ) {
+	mpt::lock_guard<mpt::mutex> guard( subsong_cache_mutex() );
+	subsong_cache_instance() = std::move( cache );
+}
+std::shared_ptr<subsong_cache> module_impl::get_subsong_cache() {
+	mpt::lock_guard<mpt::mutex> guard( subsong_cache_mutex() );
+	return subsong_cache_instance();
+}
+std::shared_ptr<subsong_cache> module_impl::create_subsong_cache_file( const std::string & path ) {
+	return std::make_shared<subsong_cache_file>( path );
+}
+std::string module_impl::get_subsong_cache_key( const void * data, std::size_t size ) {
+	mpt::crc64_jones crc;
+	if ( data && size > 0 ) {
+		crc( static_cast<const std::byte *>( data ), static_cast<const std::byte *>( data ) + size );
+	}
+	std::ostringstream str;
+	str.imbue( std::locale::classic() );
+	str << std::hex << std::setfill( '0' ) << std::setw( 16 ) << crc.result() << "-" << std::setw( 0 ) << static_cast<std::uint64_t>( size );
+	return str.str();
+}
+void module_impl::invalidate_subsong_cache( const std::string & key ) {
+	std::shared_ptr<subsong_cache> cache = get_subsong_cache();
+	if ( cache ) {
+		cache->invalidate( key );
+	}
+}
 module_impl::module_impl( callback_stream_wrapper stream, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls ) : m_Log(std::move(log)) {
 	ctor( ctls );
 	mpt::IO::CallbackStream fstream;
@@ -880,12 +1156,50 @@ module_impl::module_impl( callback_stream_wrapper stream, std::unique_ptr<log_in
 	fstream.read = stream.read;
 	fstream.seek = stream.seek;
 	fstream.tell = stream.tell;
-	load( mpt::IO::make_FileCursor<OpenMPT::mpt::PathString>( fstream ), ctls );
+	const OpenMPT::FileCursor file = mpt::IO::make_FileCursor<OpenMPT::mpt::PathString>( fstream );
+	// Unseekable streams are cached in memory while loading, seekable streams are not.
+	load( file, ctls, false, !file.HasFastGetLength() );
+	apply_libopenmpt_defaults();
+}
+module_impl::module_impl( filename_wrapper file, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls ) : m_Log(std::move(log)) {
+	ctor( ctls );
+	if ( !file.filename ) {
+		throw openmpt::exception("no filename");
+	}
+	const mpt::os_path path = mpt::transcode<mpt::os_path>( mpt::common_encoding::utf8, std::string( file.filename ) );
+#if MPT_IO_READ_FILEDATA_MMAP
+	// Map the whole file and let the loaders read straight from the page cache.
+	// Files that cannot be mapped (pipes, empty files, ...) take the stream path below.
+	// With load.map_sample_data, the file descriptor is kept open while loading so that sample data can be mapped copy-on-write instead of being copied.
+	std::shared_ptr<mpt::IO::FileDataMMap> mapping = std::make_shared<mpt::IO::FileDataMMap>( path.c_str(), m_ctl_load_map_sample_data );
+	if ( mapping->IsValid() ) {
+		if ( mapping->GetFileDescriptor() >= 0 ) {
+			OpenMPT::SampleMappingSource source;
+			source.fd = mapping->GetFileDescriptor();
+			source.data = mapping->GetRawData();
+			source.size = mapping->GetLength();
+			m_sndFile->SetSampleMappingSource( source );
+		}
+		load( OpenMPT::FileCursor( std::static_pointer_cast<const mpt::IO::IFileData>( mapping ) ), ctls, true );
+		m_sndFile->SetSampleMappingSource( OpenMPT::SampleMappingSource() );
+		mapping = nullptr;
+		apply_libopenmpt_defaults();
+		return;
+	}
+	mapping = nullptr;
+#endif // MPT_IO_READ_FILEDATA_MMAP
+	mpt::IO::ifstream stream( path, std::ios::binary );
+	if ( !stream ) {
+		throw openmpt::exception("error opening file");
+	}
+	load( mpt::IO::make_FileCursor<OpenMPT::mpt::PathString>( stream ), ctls, false, false );
 	apply_libopenmpt_defaults();
 }
 module_impl::module_impl( std::istream & stream, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls ) : m_Log(std::move(log)) {
 	ctor( ctls );
-	load( mpt::IO::make_FileCursor<OpenMPT::mpt::PathString>( stream ), ctls );
+	const OpenMPT::FileCursor file = mpt::IO::make_FileCursor<OpenMPT::mpt::PathString>( stream );
+	// Unseekable streams are cached in memory while loading, seekable streams are not.
+	load( file, ctls, false, !file.HasFastGetLength() );
 	apply_libopenmpt_defaults();
 }
 module_impl::module_impl( const std::vector<std::byte> & data, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls ) : m_Log(std::move(log)) {
@@ -1200,6 +1514,7 @@ std::vector<std::string> module_impl::get_metadata_keys() const {
 		"message",
 		"message_raw",
 		"warnings",
+		"sample_memory",
 	};
 }
 std::string module_impl::get_message_instruments() const {
@@ -1328,6 +1643,8 @@ std::string module_impl::get_metadata( const std::string & key ) const {
 			retval += msg;
 		}
 		return retval;
+	} else if ( key == std::string("sample_memory") ) {
+		return mpt::format_value_default<std::string>( m_sndFile->GetSampleMemoryUsage() );
 	}
 	return "";
 }
@@ -1713,10 +2030,15 @@ std::string module_impl::highlight_pattern_row_channel( std::int32_t p, std::int
 std::pair<const module_impl::ctl_info *, const module_impl::ctl_info *> module_impl::get_ctl_infos() const {
 	static constexpr ctl_info ctl_infos[] = {
 		{ "load.skip_samples", ctl_type::boolean },
+		{ "load.lazy_samples", ctl_type::boolean },
+		{ "load.map_sample_data", ctl_type::boolean },
+		{ "load.sample_decode_threads", ctl_type::integer },
+		{ "load.sample_memory_budget", ctl_type::integer },
 		{ "load.skip_patterns", ctl_type::boolean },
 		{ "load.skip_plugins", ctl_type::boolean },
 		{ "load.skip_subsongs_init", ctl_type::boolean },
 		{ "seek.sync_samples", ctl_type::boolean },
+		{ "seek.checkpoint_interval", ctl_type::floatingpoint },
 		{ "subsong", ctl_type::integer },
 		{ "play.tempo_factor", ctl_type::floatingpoint },
 		{ "play.pitch_factor", ctl_type::floatingpoint },
@@ -1724,6 +2046,10 @@ std::pair<const module_impl::ctl_info *, const module_impl::ctl_info *> module_i
 		{ "render.resampler.emulate_amiga", ctl_type::boolean },
 		{ "render.resampler.emulate_amiga_type", ctl_type::text },
 		{ "render.opl.volume_factor", ctl_type::floatingpoint },
+		{ "render.mix_threads", ctl_type::integer },
+		{ "render.sample_storage", ctl_type::text },
+		{ "profile.enabled", ctl_type::boolean },
+		{ "profile.report", ctl_type::text },
 		{ "dither", ctl_type::integer }
 	};
 	return std::make_pair(std::begin(ctl_infos), std::end(ctl_infos));
@@ -1811,6 +2137,10 @@ bool module_impl::ctl_get_boolean( std::string_view ctl, bool throw_if_unknown )
 		throw openmpt::exception("empty ctl");
 	} else if ( ctl == "load.skip_samples" || ctl == "load_skip_samples" ) {
 		return m_ctl_load_skip_samples;
+	} else if ( ctl == "load.lazy_samples" ) {
+		return m_ctl_load_lazy_samples;
+	} else if ( ctl == "load.map_sample_data" ) {
+		return m_ctl_load_map_sample_data;
 	} else if ( ctl == "load.skip_patterns" || ctl == "load_skip_patterns" ) {
 		return m_ctl_load_skip_patterns;
 	} else if ( ctl == "load.skip_plugins" ) {
@@ -1821,6 +2151,12 @@ bool module_impl::ctl_get_boolean( std::string_view ctl, bool throw_if_unknown )
 		return m_ctl_seek_sync_samples;
 	} else if ( ctl == "render.resampler.emulate_amiga" ) {
 		return ( m_sndFile->m_Resampler.m_Settings.emulateAmiga != OpenMPT::Resampling::AmigaFilter::Off );
+	} else if ( ctl == "profile.enabled" ) {
+#ifdef MPT_ENABLE_RENDER_PROFILE
+		return m_sndFile->m_RenderProfile.IsEnabled();
+#else
+		return false;
+#endif
 	} else {
 		MPT_ASSERT_NOTREACHED();
 		return false;
@@ -1857,6 +2193,12 @@ std::int64_t module_impl::ctl_get_integer( std::string_view ctl, bool throw_if_u
 		throw openmpt::exception("empty ctl");
 	} else if ( ctl == "subsong" ) {
 		return get_selected_subsong();
+	} else if ( ctl == "load.sample_decode_threads" ) {
+		return m_sndFile->GetSampleDecodeThreads();
+	} else if ( ctl == "load.sample_memory_budget" ) {
+		return mpt::saturate_cast<std::int64_t>( m_sndFile->GetSampleMemoryBudget() );
+	} else if ( ctl == "render.mix_threads" ) {
+		return m_sndFile->GetMixThreads();
 	} else if ( ctl == "dither" ) {
 		return static_cast<std::int64_t>( m_Dithers->GetMode() );
 	} else {
@@ -1903,6 +2245,11 @@ double module_impl::ctl_get_floatingpoint( std::string_view ctl, bool throw_if_u
 			return 1.0;
 		}
 		return m_sndFile->m_nFreqFactor / 65536.0;
+	} else if ( ctl == "seek.checkpoint_interval" ) {
+		if ( !is_loaded() ) {
+			return 0.0;
+		}
+		return m_sndFile->GetSeekCheckpointInterval();
 	} else if ( ctl == "render.opl.volume_factor" ) {
 		return static_cast<double>( m_sndFile->m_OPLVolumeFactor ) / static_cast<double>( OpenMPT::CSoundFile::m_OPLVolumeFactorScale );
 	} else {
@@ -1961,6 +2308,17 @@ std::string module_impl::ctl_get_text( std::string_view ctl, bool throw_if_unkno
 			default:
 				return std::string();
 		}
+	} else if ( ctl == "render.sample_storage" ) {
+		switch ( m_sndFile->GetSampleStorage() ) {
+			case OpenMPT::SampleStorage::Original:
+				return "original";
+			case OpenMPT::SampleStorage::Int16:
+				return "int16";
+			default:
+				return std::string();
+		}
+	} else if ( ctl == "profile.report" ) {
+		return get_render_profile_report();
 	} else {
 		MPT_ASSERT_NOTREACHED();
 		return std::string();
@@ -2034,6 +2392,10 @@ void module_impl::ctl_set_boolean( std::string_view ctl, bool value, bool throw_
 		throw openmpt::exception("empty ctl: := " + mpt::format_value_default<std::string>( value ) );
 	} else if ( ctl == "load.skip_samples" || ctl == "load_skip_samples" ) {
 		m_ctl_load_skip_samples = value;
+	} else if ( ctl == "load.lazy_samples" ) {
+		m_ctl_load_lazy_samples = value;
+	} else if ( ctl == "load.map_sample_data" ) {
+		m_ctl_load_map_sample_data = value;
 	} else if ( ctl == "load.skip_patterns" || ctl == "load_skip_patterns" ) {
 		m_ctl_load_skip_patterns = value;
 	} else if ( ctl == "load.skip_plugins" ) {
@@ -2052,6 +2414,10 @@ void module_impl::ctl_set_boolean( std::string_view ctl, bool value, bool throw_
 		if ( newsettings != m_sndFile->m_Resampler.m_Settings ) {
 			m_sndFile->SetResamplerSettings( newsettings );
 		}
+	} else if ( ctl == "profile.enabled" ) {
+#ifdef MPT_ENABLE_RENDER_PROFILE
+		m_sndFile->m_RenderProfile.SetEnabled( value );
+#endif
 	} else {
 		MPT_ASSERT_NOTREACHED();
 	}
@@ -2085,6 +2451,21 @@ void module_impl::ctl_set_integer( std::string_view ctl, std::int64_t value, boo
 		throw openmpt::exception("empty ctl: := " + mpt::format_value_default<std::string>( value ) );
 	} else if ( ctl == "subsong" ) {
 		select_subsong( mpt::saturate_cast<std::int32_t>( value ) );
+	} else if ( ctl == "load.sample_decode_threads" ) {
+		if ( value < 0 ) {
+			throw openmpt::exception("invalid sample decode thread count");
+		}
+		m_sndFile->SetSampleDecodeThreads( mpt::saturate_cast<std::uint32_t>( value ) );
+	} else if ( ctl == "load.sample_memory_budget" ) {
+		if ( value < 0 ) {
+			throw openmpt::exception("invalid sample memory budget");
+		}
+		m_sndFile->SetSampleMemoryBudget( mpt::saturate_cast<std::size_t>( value ) );
+	} else if ( ctl == "render.mix_threads" ) {
+		if ( value < 0 ) {
+			throw openmpt::exception("invalid mix thread count");
+		}
+		m_sndFile->SetMixThreads( mpt::saturate_cast<std::uint32_t>( value ) );
 	} else if ( ctl == "dither" ) {
 		std::size_t dither = mpt::saturate_cast<std::size_t>( value );
 		if ( dither >= OpenMPT::DithersOpenMPT::GetNumDithers() ) {
@@ -2142,6 +2523,14 @@ void module_impl::ctl_set_floatingpoint( std::string_view ctl, double value, boo
 		}
 		m_sndFile->m_nFreqFactor = mpt::saturate_round<uint32_t>( 65536.0 * factor );
 		m_sndFile->RecalculateSamplesPerTick();
+	} else if ( ctl == "seek.checkpoint_interval" ) {
+		if ( !is_loaded() ) {
+			return;
+		}
+		if ( !( value >= 0.0 ) ) {
+			throw openmpt::exception("invalid seek checkpoint interval");
+		}
+		m_sndFile->SetSeekCheckpointInterval( value );
 	} else if ( ctl == "render.opl.volume_factor" ) {
 		m_sndFile->m_OPLVolumeFactor = mpt::saturate_round<std::int32_t>( value * static_cast<double>( OpenMPT::CSoundFile::m_OPLVolumeFactorScale ) );
 	} else {
@@ -2204,9 +2593,47 @@ void module_impl::ctl_set_text( std::string_view ctl, std::string_view value, bo
 				m_sndFile->SetResamplerSettings( newsettings );
 			}
 		}
+	} else if ( ctl == "render.sample_storage" ) {
+		if ( value == "original" ) {
+			m_sndFile->SetSampleStorage( OpenMPT::SampleStorage::Original );
+		} else if ( value == "int16" ) {
+			m_sndFile->SetSampleStorage( OpenMPT::SampleStorage::Int16 );
+		} else {
+			throw openmpt::exception( "invalid sample storage: " + std::string( value ) );
+		}
+	} else if ( ctl == "profile.report" ) {
+		throw openmpt::exception( "read-only ctl: profile.report" );
 	} else {
 		MPT_ASSERT_NOTREACHED();
 	}
 }
 
+std::string module_impl::get_render_profile_report() const {
+	std::string result;
+#ifdef MPT_ENABLE_RENDER_PROFILE
+	const OpenMPT::RenderProfile & profile = m_sndFile->m_RenderProfile;
+	if ( !profile.IsEnabled() ) {
+		return result;
+	}
+	const auto add = [&result]( const std::string & key, const std::string & value ) {
+		result += key + "=" + value + "\n";
+	};
+	add( "frames", mpt::format_value_default<std::string>( profile.GetFrames() ) );
+	add( "chunks", mpt::format_value_default<std::string>( profile.GetChunks() ) );
+	add( "chunks.silent", mpt::format_value_default<std::string>( profile.GetSilentChunks() ) );
+	add( "voices.average", mpt::format_value_default<std::string>( profile.GetAverageVoices() ) );
+	add( "voices.peak", mpt::format_value_default<std::string>( profile.GetPeakVoices() ) );
+	for ( int stage = 0; stage < OpenMPT::RenderProfile::NumStages; ++stage ) {
+		const OpenMPT::RenderProfile::StageCounters & counters = profile.GetStage( static_cast<OpenMPT::RenderProfile::Stage>( stage ) );
+		const std::string name = OpenMPT::RenderProfile::GetStageName( static_cast<OpenMPT::RenderProfile::Stage>( stage ) );
+		add( name + ".calls", mpt::format_value_default<std::string>( counters.calls ) );
+		add( name + ".seconds", mpt::format_value_default<std::string>( static_cast<double>( counters.nanoseconds ) / 1.0e9 ) );
+		if ( OpenMPT::RenderProfile::HasCycleCounter() ) {
+			add( name + ".cycles", mpt::format_value_default<std::string>( counters.cycles ) );
+		}
+	}
+#endif // MPT_ENABLE_RENDER_PROFILE
+	return result;
+}
+
 } // namespace openmpt
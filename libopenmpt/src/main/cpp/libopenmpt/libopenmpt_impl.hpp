@@ -92,6 +92,10 @@ struct callback_stream_wrapper {
 	std::int64_t (*tell)( void * stream );
 }; // struct callback_stream_wrapper
 
+struct filename_wrapper {
+	const char * filename;
+}; // struct filename_wrapper
+
 class module_impl {
 public:
 	enum class amiga_filter_type {
@@ -146,6 +150,8 @@ protected:
 	song_end_action m_ctl_play_at_end;
 	amiga_filter_type m_ctl_render_resampler_emulate_amiga_type = amiga_filter_type::auto_filter;
 	bool m_ctl_load_skip_samples;
+	bool m_ctl_load_lazy_samples;
+	bool m_ctl_load_map_sample_data;
 	bool m_ctl_load_skip_patterns;
 	bool m_ctl_load_skip_plugins;
 	bool m_ctl_load_skip_subsongs_init;
@@ -161,8 +167,11 @@ protected:
 	subsongs_type get_subsongs() const;
 	void init_subsongs( subsongs_type & subsongs ) const;
 	bool has_subsongs_inited() const;
+	std::string get_subsong_cache_settings() const;
+	bool load_cached_subsongs( subsong_cache & cache, const std::string & key, subsongs_type & subsongs ) const;
+	void store_cached_subsongs( subsong_cache & cache, const std::string & key, const subsongs_type & subsongs ) const;
 	void ctor( const std::map< std::string, std::string > & ctls );
-	void load( const OpenMPT::FileCursor & file, const std::map< std::string, std::string > & ctls );
+	void load( const OpenMPT::FileCursor & file, const std::map< std::string, std::string > & ctls, bool file_data_outlives_module = false, bool file_data_in_memory = true );
 	bool is_loaded() const;
 	std::size_t read_wrapper( std::size_t count, std::int16_t * left, std::int16_t * right, std::int16_t * rear_left, std::int16_t * rear_right );
 	std::size_t read_wrapper( std::size_t count, float * left, float * right, float * rear_left, float * rear_right );
@@ -170,6 +179,7 @@ protected:
 	std::size_t read_interleaved_wrapper( std::size_t count, std::size_t channels, float * interleaved );
 	std::string get_message_instruments() const;
 	std::string get_message_samples() const;
+	std::string get_render_profile_report() const;
 	std::pair< std::string, std::string > format_and_highlight_pattern_row_channel_command( std::int32_t p, std::int32_t r, std::int32_t c, int command ) const;
 	std::pair< std::string, std::string > format_and_highlight_pattern_row_channel( std::int32_t p, std::int32_t r, std::int32_t c, std::size_t width, bool pad ) const;
 	static double could_open_probability( const OpenMPT::FileCursor & file, double effort, std::unique_ptr<log_interface> log );
@@ -187,7 +197,13 @@ public:
 	static int probe_file_header( std::uint64_t flags, const void * data, std::size_t size );
 	static int probe_file_header( std::uint64_t flags, std::istream & stream );
 	static int probe_file_header( std::uint64_t flags, callback_stream_wrapper stream );
+	static void set_subsong_cache( std::shared_ptr<subsong_cache> cache );
+	static std::shared_ptr<subsong_cache> get_subsong_cache();
+	static std::shared_ptr<subsong_cache> create_subsong_cache_file( const std::string & path );
+	static std::string get_subsong_cache_key( const void * data, std::size_t size );
+	static void invalidate_subsong_cache( const std::string & key );
 	module_impl( callback_stream_wrapper stream, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls );
+	module_impl( filename_wrapper file, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls );
 	module_impl( std::istream & stream, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls );
 	module_impl( const std::vector<std::byte> & data, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls );
 	module_impl( const std::vector<std::uint8_t> & data, std::unique_ptr<log_interface> log, const std::map< std::string, std::string > & ctls );
@@ -0,0 +1,261 @@
+/*
+ * libopenmpt_stream_callbacks_mmap.h
+ * ----------------------------------
+ * Purpose: libopenmpt public c interface
+ * Notes  : (currently none)
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+#ifndef LIBOPENMPT_STREAM_CALLBACKS_MMAP_H
+#define LIBOPENMPT_STREAM_CALLBACKS_MMAP_H
+
+#include "libopenmpt.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+/*! \addtogroup libopenmpt_c
+ * @{
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* This stuff has to be in a header file because mmap is not available on all platforms libopenmpt itself supports. */
+
+typedef struct openmpt_stream_mmap {
+	void * mapping;
+	int64_t file_size;
+	int64_t file_pos;
+} openmpt_stream_mmap;
+
+static size_t openmpt_stream_mmap_read_func( void * stream, void * dst, size_t bytes ) {
+	openmpt_stream_mmap * s = (openmpt_stream_mmap*)stream;
+	int64_t offset = 0;
+	int64_t begpos = 0;
+	int64_t endpos = 0;
+	if ( !s ) {
+		return 0;
+	}
+	offset = bytes;
+	begpos = s->file_pos;
+	endpos = s->file_pos;
+	endpos = (uint64_t)endpos + (uint64_t)offset;
+	if ( ( offset > 0 ) && !( (uint64_t)endpos > (uint64_t)begpos ) ) {
+		/* integer wrapped */
+		return 0;
+	}
+	if ( bytes == 0 ) {
+		return 0;
+	}
+	if ( begpos >= s->file_size ) {
+		return 0;
+	}
+	if ( endpos > s->file_size ) {
+		/* clip to eof */
+		bytes = bytes - (size_t)( endpos - s->file_size );
+		endpos = endpos - ( endpos - s->file_size );
+	}
+	memcpy( dst, (const char*)s->mapping + s->file_pos, bytes );
+	s->file_pos = s->file_pos + bytes;
+	return bytes;
+}
+
+static int openmpt_stream_mmap_seek_func( void * stream, int64_t offset, int whence ) {
+	openmpt_stream_mmap * s = (openmpt_stream_mmap*)stream;
+	int result = -1;
+	if ( !s ) {
+		return -1;
+	}
+	switch ( whence ) {
+		case OPENMPT_STREAM_SEEK_SET:
+			if ( offset < 0 ) {
+				return -1;
+			}
+			if ( offset > s->file_size ) {
+				return -1;
+			}
+			s->file_pos = offset;
+			result = 0;
+			break;
+		case OPENMPT_STREAM_SEEK_CUR:
+			do {
+				int64_t oldpos = s->file_pos;
+				int64_t pos = s->file_pos;
+				pos = (uint64_t)pos + (uint64_t)offset;
+				if ( ( offset > 0 ) && !( (uint64_t)pos > (uint64_t)oldpos ) ) {
+					/* integer wrapped */
+					return -1;
+				}
+				if ( ( offset < 0 ) && !( (uint64_t)pos < (uint64_t)oldpos ) ) {
+					/* integer wrapped */
+					return -1;
+				}
+				s->file_pos = pos;
+			} while(0);
+			result = 0;
+			break;
+		case OPENMPT_STREAM_SEEK_END:
+			if ( offset > 0 ) {
+				return -1;
+			}
+			do {
+				int64_t oldpos = s->file_pos;
+				int64_t pos = s->file_pos;
+				pos = s->file_size;
+				pos = (uint64_t)pos + (uint64_t)offset;
+				if ( ( offset < 0 ) && !( (uint64_t)pos < (uint64_t)oldpos ) ) {
+					/* integer wrapped */
+					return -1;
+				}
+				s->file_pos = pos;
+			} while(0);
+			result = 0;
+			break;
+	}
+	return result;
+}
+
+static int64_t openmpt_stream_mmap_tell_func( void * stream ) {
+	openmpt_stream_mmap * s = (openmpt_stream_mmap*)stream;
+	if ( !s ) {
+		return -1;
+	}
+	return s->file_pos;
+}
+
+/*! \brief Map a file descriptor into memory
+ *
+ * Maps the complete regular file referred to by fd read-only into memory and initializes the openmpt_stream_mmap object to read from the mapping.
+ *
+ * \param stream The openmpt_stream_mmap object to initialize.
+ * \param fd An open file descriptor. Ownership is not transferred, and fd may be closed as soon as this function returns.
+ * \return 0 on success, -1 on failure. On failure, the object is left in a state that is safe to pass to openmpt_stream_mmap_close().
+ * \remarks Empty files and files that are not regular files cannot be mapped. Callers should fall back to openmpt_stream_get_fd_callbacks() or openmpt_stream_get_file_callbacks2() in that case.
+ * \sa openmpt_stream_mmap_open
+ * \sa openmpt_stream_mmap_close
+ */
+static int openmpt_stream_mmap_open_fd( openmpt_stream_mmap * stream, int fd ) {
+	struct stat st;
+	void * mapping = NULL;
+	if ( !stream ) {
+		return -1;
+	}
+	memset( stream, 0, sizeof( openmpt_stream_mmap ) );
+	if ( fd < 0 ) {
+		return -1;
+	}
+	memset( &st, 0, sizeof( struct stat ) );
+	if ( fstat( fd, &st ) != 0 ) {
+		return -1;
+	}
+	if ( !S_ISREG( st.st_mode ) ) {
+		return -1;
+	}
+	if ( st.st_size <= 0 ) {
+		return -1;
+	}
+	if ( (uint64_t)st.st_size > (uint64_t)SIZE_MAX ) {
+		return -1;
+	}
+	mapping = mmap( NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+	if ( mapping == MAP_FAILED ) {
+		return -1;
+	}
+	stream->mapping = mapping;
+	stream->file_size = (int64_t)st.st_size;
+	stream->file_pos = 0;
+	return 0;
+}
+
+/*! \brief Map a file into memory
+ *
+ * Opens the named file, maps it read-only into memory, and closes it again.
+ *
+ * \param stream The openmpt_stream_mmap object to initialize.
+ * \param filename Path of the file to map, in the encoding expected by open().
+ * \return 0 on success, -1 on failure. On failure, the object is left in a state that is safe to pass to openmpt_stream_mmap_close().
+ * \sa openmpt_stream_mmap_open_fd
+ * \sa openmpt_stream_mmap_close
+ */
+static int openmpt_stream_mmap_open( openmpt_stream_mmap * stream, const char * filename ) {
+	int fd = -1;
+	int flags = O_RDONLY;
+	int result = -1;
+	if ( !stream ) {
+		return -1;
+	}
+	memset( stream, 0, sizeof( openmpt_stream_mmap ) );
+	if ( !filename ) {
+		return -1;
+	}
+	#if defined(O_CLOEXEC)
+		flags |= O_CLOEXEC;
+	#endif
+	do {
+		fd = open( filename, flags );
+	} while ( ( fd == -1 ) && ( errno == EINTR ) );
+	if ( fd < 0 ) {
+		return -1;
+	}
+	result = openmpt_stream_mmap_open_fd( stream, fd );
+	close( fd );
+	return result;
+}
+
+/*! \brief Unmap a file previously mapped with openmpt_stream_mmap_open() or openmpt_stream_mmap_open_fd()
+ *
+ * \param stream The openmpt_stream_mmap object to release.
+ * \remarks An openmpt_module created from the stream does not reference the mapping any more, so it can be released as soon as the create function has returned.
+ */
+static void openmpt_stream_mmap_close( openmpt_stream_mmap * stream ) {
+	if ( !stream ) {
+		return;
+	}
+	if ( stream->mapping ) {
+		munmap( stream->mapping, (size_t)stream->file_size );
+	}
+	memset( stream, 0, sizeof( openmpt_stream_mmap ) );
+}
+
+/*! \brief Provide openmpt_stream_callbacks for memory-mapped files
+ *
+ * Fills openmpt_stream_callbacks suitable for passing a memory-mapped file as a stream parameter to functions doing file input/output.
+ * Reads are served from the operating system page cache without any system calls, which makes this considerably faster than openmpt_stream_get_fd_callbacks() for the many small reads done while probing and loading, without requiring the caller to read the whole file into memory.
+ * A suitable openmpt_stream_mmap object can be initialized with openmpt_stream_mmap_open() or openmpt_stream_mmap_open_fd().
+ *
+ * \remarks The stream argument must be passed as `(void*)(openmpt_stream_mmap*)stream_mmap`.
+ * \remarks This header is only available on POSIX systems.
+ * \sa \ref libopenmpt_c_fileio
+ * \sa openmpt_stream_callbacks
+ * \sa openmpt_could_open_probability2
+ * \sa openmpt_probe_file_header_from_stream
+ * \sa openmpt_module_create2
+ * \sa openmpt_module_create_from_file
+ */
+static openmpt_stream_callbacks openmpt_stream_get_mmap_callbacks(void) {
+	openmpt_stream_callbacks retval;
+	memset( &retval, 0, sizeof( openmpt_stream_callbacks ) );
+	retval.read = openmpt_stream_mmap_read_func;
+	retval.seek = openmpt_stream_mmap_seek_func;
+	retval.tell = openmpt_stream_mmap_tell_func;
+	return retval;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+/*!
+ * @}
+ */
+
+#endif /* LIBOPENMPT_STREAM_CALLBACKS_MMAP_H */
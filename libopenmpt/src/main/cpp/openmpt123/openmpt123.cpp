@@ -66,7 +66,9 @@ static const char * const license =
 
 #include "mpt/base/algorithm.hpp"
 #include "mpt/base/detect.hpp"
+#include "mpt/io_read/filedata_mmap.hpp"
 #include "mpt/main/main.hpp"
+#include "mpt/path/path.hpp"
 
 #include "mpt/random/crand.hpp"
 #include "mpt/random/default_engines.hpp"
@@ -75,7 +77,11 @@ static const char * const license =
 #include "mpt/random/seed.hpp"
 
 #include <algorithm>
+#include <chrono>
 #include <deque>
+#if !defined(MPT_COMPILER_QUIRK_NO_FILESYSTEM)
+#include <filesystem>
+#endif // !MPT_COMPILER_QUIRK_NO_FILESYSTEM
 #include <fstream>
 #include <iostream>
 #include <iterator>
@@ -89,6 +95,11 @@ static const char * const license =
 #include <stdexcept>
 #include <string>
 #include <vector>
+#if MPT_PLATFORM_MULTITHREADED && !defined(MPT_LIBCXX_QUIRK_NO_STD_THREAD)
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif // MPT_PLATFORM_MULTITHREADED && !MPT_LIBCXX_QUIRK_NO_STD_THREAD
 
 #include <cassert>
 #include <cmath>
@@ -416,6 +427,8 @@ static concat_stream<mpt::ustring> & operator << ( concat_stream<mpt::ustring> &
 	s << MPT_USTRING("Output filename: ") << mpt::transcode<mpt::ustring>( flags.output_filename ) << lf;
 	s << MPT_USTRING("Force overwrite output file: ") << flags.force_overwrite << lf;
 	s << MPT_USTRING("Ctls: ") << ctls_to_string( flags.ctls ) << lf;
+	s << MPT_USTRING("Scan threads: ") << flags.scan_threads << lf;
+	s << MPT_USTRING("Scan timeout: ") << flags.scan_timeout << lf;
 	s << lf;
 	s << MPT_USTRING("Files: ") << lf;
 	for ( const auto & filename : flags.filenames ) {
@@ -636,6 +649,7 @@ static void show_help( textout & log, bool longhelp = false, bool man_version =
 		log << MPT_USTRING("     --ui                   Interactively play each file") << lf;
 		log << MPT_USTRING("     --batch                Play each file") << lf;
 		log << MPT_USTRING("     --render               Render each file to individual PCM data files") << lf;
+		log << MPT_USTRING("     --scan                 Scan each file or directory and print its metadata as one line of JSON per file") << lf;
 		if ( !longhelp ) {
 			log << lf;
 			log.writeout();
@@ -682,6 +696,9 @@ static void show_help( textout & log, bool longhelp = false, bool man_version =
 		log << lf;
 		log << MPT_USTRING("     --ctl c=v              Set libopenmpt ctl c to value v") << lf;
 		log << lf;
+		log << MPT_USTRING("     --scan-threads n       Scan n files in parallel (0 means one per CPU) (only applies to --scan mode) [default: ") << commandlineflags().scan_threads << MPT_USTRING("]") << lf;
+		log << MPT_USTRING("     --scan-timeout n       Give up on a file after n seconds (0 means never) (only applies to --scan mode) [default: ") << commandlineflags().scan_timeout << MPT_USTRING("]") << lf;
+		log << lf;
 		log << MPT_USTRING("     --driver n             Set output driver [default: ") << get_driver_string( commandlineflags().driver ) << MPT_USTRING("],") << lf;
 		log << MPT_USTRING("     --device n             Set output device [default: ") << get_device_string( commandlineflags().device ) << MPT_USTRING("],") << lf;
 		log << MPT_USTRING("                            use --device help to show available devices") << lf;
@@ -1749,6 +1766,361 @@ static void render_files( commandlineflags & flags, textout & log, write_buffers
 }
 
 
+enum class scan_status {
+	ok,
+	unsupported,
+	error,
+	timeout,
+};
+
+static const char * scan_status_to_string( scan_status status ) {
+	switch ( status ) {
+		case scan_status::ok:          return "ok"; break;
+		case scan_status::unsupported: return "unsupported"; break;
+		case scan_status::error:       return "error"; break;
+		case scan_status::timeout:     return "timeout"; break;
+	}
+	return "";
+}
+
+struct scan_result {
+	scan_status status = scan_status::error;
+	std::uint64_t filesize = 0;
+	std::string json;
+};
+
+static std::string json_string( const std::string & str ) {
+	std::string result;
+	result.reserve( str.size() + 2 );
+	result += '"';
+	for ( char c : str ) {
+		switch ( c ) {
+			case '"':  result += "\\\""; break;
+			case '\\': result += "\\\\"; break;
+			case '\b': result += "\\b"; break;
+			case '\f': result += "\\f"; break;
+			case '\n': result += "\\n"; break;
+			case '\r': result += "\\r"; break;
+			case '\t': result += "\\t"; break;
+			default:
+				if ( static_cast<unsigned char>( c ) < 0x20 ) {
+					result += "\\u00";
+					result += "0123456789abcdef"[ ( static_cast<unsigned char>( c ) >> 4 ) & 0x0f ];
+					result += "0123456789abcdef"[ static_cast<unsigned char>( c ) & 0x0f ];
+				} else {
+					result += c;
+				}
+				break;
+		}
+	}
+	result += '"';
+	return result;
+}
+
+static std::string json_string( const mpt::native_path & filename ) {
+	return json_string( mpt::transcode<std::string>( libopenmpt_encoding, mpt::transcode<mpt::ustring>( filename ) ) );
+}
+
+static std::string scan_json_line( const mpt::native_path & filename, const scan_result & result, double seconds, const std::string & fields ) {
+	std::string line;
+	line += "{\"path\":" + json_string( filename );
+	line += ",\"status\":" + json_string( scan_status_to_string( result.status ) );
+	line += ",\"size\":" + mpt::format<std::string>::val( result.filesize );
+	line += fields;
+	line += ",\"seconds\":" + mpt::format<std::string>::fix( seconds, 6 );
+	line += "}";
+	return line;
+}
+
+static std::uint64_t get_file_size( const mpt::native_path & filename ) {
+	mpt::IO::ifstream file_stream( filename, std::ios::binary );
+	file_stream.seekg( 0, std::ios::end );
+	const std::streamoff filesize = file_stream.tellg();
+	if ( file_stream.fail() || filesize < 0 ) {
+		return 0;
+	}
+	return static_cast<std::uint64_t>( filesize );
+}
+
+// Loads a single file and describes it as one line of JSON.
+// This runs on the scan worker threads, so it must not touch any state besides its arguments.
+static scan_result scan_file( const commandlineflags & flags, const mpt::native_path & filename ) {
+	const auto start = std::chrono::steady_clock::now();
+	scan_result result;
+	std::string fields;
+	try {
+		const std::byte * data = nullptr;
+		std::size_t size = 0;
+#if MPT_IO_READ_FILEDATA_MMAP
+		// Map the file so that only the parts that the loader actually reads are paged in (sample data is skipped by default).
+		const mpt::IO::FileDataMMap mapping( filename.AsNative().c_str() );
+		if ( mapping.IsValid() ) {
+			data = mapping.GetRawData();
+			size = static_cast<std::size_t>( mapping.GetLength() );
+		}
+#endif // MPT_IO_READ_FILEDATA_MMAP
+		std::vector<std::byte> buffer;
+		if ( !data ) {
+			mpt::IO::ifstream file_stream( filename, std::ios::binary );
+			file_stream.seekg( 0, std::ios::end );
+			const std::streamoff filesize = file_stream.tellg();
+			file_stream.seekg( 0, std::ios::beg );
+			if ( file_stream.fail() || filesize < 0 ) {
+				throw exception( MPT_USTRING("file open error") );
+			}
+			buffer.resize( static_cast<std::size_t>( filesize ) );
+			file_stream.read( reinterpret_cast<char *>( buffer.data() ), buffer.size() );
+			if ( file_stream.fail() ) {
+				throw exception( MPT_USTRING("file read error") );
+			}
+			data = buffer.data();
+			size = buffer.size();
+		}
+		result.filesize = size;
+		if ( openmpt::probe_file_header( openmpt::probe_file_header_flags_default2, data, size, size ) == openmpt::probe_file_header_result_failure ) {
+			result.status = scan_status::unsupported;
+		} else {
+			// Neither sample data nor plugins are needed for metadata and durations, so skip them unless the user says otherwise.
+			std::map<std::string, std::string> ctls = { { "load.skip_samples", "1" }, { "load.skip_plugins", "1" } };
+			for ( const auto & ctl : flags.ctls ) {
+				ctls[ ctl.first ] = ctl.second;
+			}
+			std::ostringstream silentlog;
+			openmpt::module mod( data, size, silentlog, ctls );
+			fields += ",\"type\":" + json_string( mod.get_metadata( "type" ) );
+			fields += ",\"type_long\":" + json_string( mod.get_metadata( "type_long" ) );
+			if ( !mod.get_metadata( "container" ).empty() ) {
+				fields += ",\"container\":" + json_string( mod.get_metadata( "container" ) );
+			}
+			fields += ",\"title\":" + json_string( mod.get_metadata( "title" ) );
+			fields += ",\"artist\":" + json_string( mod.get_metadata( "artist" ) );
+			fields += ",\"tracker\":" + json_string( mod.get_metadata( "tracker" ) );
+			fields += ",\"channels\":" + mpt::format<std::string>::val( mod.get_num_channels() );
+			const std::int32_t subsongs = mod.get_num_subsongs();
+			fields += ",\"subsongs\":" + mpt::format<std::string>::val( subsongs );
+			fields += ",\"durations\":[";
+			for ( std::int32_t subsong = 0; subsong < subsongs; ++subsong ) {
+				mod.select_subsong( subsong );
+				if ( subsong > 0 ) {
+					fields += ",";
+				}
+				fields += mpt::format<std::string>::fix( mod.get_duration_seconds(), 3 );
+			}
+			fields += "]";
+			result.status = scan_status::ok;
+		}
+	} catch ( std::exception & e ) {
+		result.status = scan_status::error;
+		fields = ",\"error\":" + json_string( mpt::transcode<std::string>( libopenmpt_encoding, mpt::get_exception_text<mpt::ustring>( e ) ) );
+	} catch ( ... ) {
+		result.status = scan_status::error;
+		fields = ",\"error\":" + json_string( std::string( "unknown error" ) );
+	}
+	result.json = scan_json_line( filename, result, std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count(), fields );
+	return result;
+}
+
+static void collect_scan_files( const mpt::native_path & path, std::vector<mpt::native_path> & files ) {
+#if !defined(MPT_COMPILER_QUIRK_NO_FILESYSTEM)
+	std::error_code ec;
+	const std::filesystem::path fspath = mpt::transcode<std::filesystem::path>( path.AsNative() );
+	if ( std::filesystem::is_directory( fspath, ec ) ) {
+		std::vector<mpt::native_path> entries;
+		std::filesystem::recursive_directory_iterator it( fspath, std::filesystem::directory_options::skip_permission_denied, ec );
+		for ( ; !ec && it != std::filesystem::recursive_directory_iterator(); it.increment( ec ) ) {
+			std::error_code entry_ec;
+			if ( it->is_regular_file( entry_ec ) ) {
+				entries.push_back( mpt::native_path::FromNative( mpt::transcode<mpt::os_path>( it->path() ) ) );
+			}
+		}
+		std::sort( entries.begin(), entries.end() );
+		files.insert( files.end(), entries.begin(), entries.end() );
+		return;
+	}
+#endif // !MPT_COMPILER_QUIRK_NO_FILESYSTEM
+	files.push_back( path );
+}
+
+struct scan_summary {
+	std::size_t files = 0;
+	std::size_t ok = 0;
+	std::size_t unsupported = 0;
+	std::size_t errors = 0;
+	std::size_t timeouts = 0;
+	std::uint64_t bytes = 0;
+	std::size_t abandoned_workers = 0;
+	void add( const scan_result & result ) {
+		files++;
+		bytes += result.filesize;
+		switch ( result.status ) {
+			case scan_status::ok:          ok++; break;
+			case scan_status::unsupported: unsupported++; break;
+			case scan_status::error:       errors++; break;
+			case scan_status::timeout:     timeouts++; break;
+		}
+	}
+};
+
+static void scan_output( const scan_result & result, scan_summary & summary ) {
+	std::cout << result.json << "\n";
+	std::cout.flush();
+	summary.add( result );
+}
+
+#if MPT_PLATFORM_MULTITHREADED && !defined(MPT_LIBCXX_QUIRK_NO_STD_THREAD)
+
+// State shared between the main thread and the scan workers.
+// Workers that got abandoned after a timeout keep running until their file is done, so they own a reference to it.
+struct scan_shared_state {
+	const commandlineflags flags;
+	const std::vector<mpt::native_path> files;
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::size_t next_file = 0;
+	std::deque<scan_result> finished;
+	scan_shared_state( const commandlineflags & flags_, const std::vector<mpt::native_path> & files_ ) : flags( flags_ ), files( files_ ) {
+		return;
+	}
+};
+
+struct scan_worker_state {
+	std::optional<std::size_t> file;
+	std::chrono::steady_clock::time_point start;
+	bool abandoned = false;
+};
+
+static void scan_worker( std::shared_ptr<scan_shared_state> shared, std::shared_ptr<scan_worker_state> self ) {
+	while ( true ) {
+		std::size_t file = 0;
+		{
+			std::lock_guard<std::mutex> guard( shared->mutex );
+			if ( self->abandoned || shared->next_file >= shared->files.size() ) {
+				return;
+			}
+			file = shared->next_file++;
+			self->file = file;
+			self->start = std::chrono::steady_clock::now();
+		}
+		scan_result result = scan_file( shared->flags, shared->files[ file ] );
+		{
+			std::lock_guard<std::mutex> guard( shared->mutex );
+			if ( self->abandoned ) {
+				// Already reported as timed out, and a replacement worker has taken over.
+				return;
+			}
+			self->file.reset();
+			shared->finished.push_back( std::move( result ) );
+		}
+		shared->cv.notify_all();
+	}
+}
+
+static scan_summary scan_files_threaded( const commandlineflags & flags, const std::vector<mpt::native_path> & files ) {
+	scan_summary summary;
+	auto shared = std::make_shared<scan_shared_state>( flags, files );
+	struct worker {
+		std::shared_ptr<scan_worker_state> state;
+		std::thread thread;
+	};
+	std::vector<worker> workers;
+	auto spawn_worker = [&]() {
+		auto state = std::make_shared<scan_worker_state>();
+		workers.push_back( worker{ state, std::thread( scan_worker, shared, state ) } );
+	};
+	std::size_t num_threads = ( flags.scan_threads > 0 ) ? static_cast<std::size_t>( flags.scan_threads ) : std::max( std::thread::hardware_concurrency(), 1u );
+	num_threads = std::min( num_threads, std::max( files.size(), std::size_t( 1 ) ) );
+	for ( std::size_t i = 0; i < num_threads; ++i ) {
+		spawn_worker();
+	}
+	const bool use_timeout = ( flags.scan_timeout > 0.0 );
+	const auto timeout = std::chrono::duration_cast<std::chrono::steady_clock::duration>( std::chrono::duration<double>( flags.scan_timeout ) );
+	std::unique_lock<std::mutex> lock( shared->mutex );
+	while ( summary.files < files.size() ) {
+		while ( !shared->finished.empty() ) {
+			scan_result result = std::move( shared->finished.front() );
+			shared->finished.pop_front();
+			lock.unlock();
+			scan_output( result, summary );
+			lock.lock();
+		}
+		if ( summary.files >= files.size() ) {
+			break;
+		}
+		if ( !use_timeout ) {
+			shared->cv.wait( lock );
+			continue;
+		}
+		// A worker stuck in a pathological file cannot be interrupted.
+		// Report the file as timed out, leave the worker to finish on its own, and start a replacement so that the remaining files keep going.
+		const auto now = std::chrono::steady_clock::now();
+		std::optional<std::chrono::steady_clock::time_point> next_deadline;
+		std::size_t timed_out = 0;
+		for ( auto & w : workers ) {
+			if ( w.state->abandoned || !w.state->file ) {
+				continue;
+			}
+			const auto deadline = w.state->start + timeout;
+			if ( deadline <= now ) {
+				w.state->abandoned = true;
+				scan_result result;
+				result.status = scan_status::timeout;
+				result.filesize = get_file_size( files[ *w.state->file ] );
+				result.json = scan_json_line( files[ *w.state->file ], result, std::chrono::duration<double>( now - w.state->start ).count(), std::string() );
+				shared->finished.push_back( std::move( result ) );
+				w.thread.detach();
+				timed_out++;
+			} else if ( !next_deadline || deadline < *next_deadline ) {
+				next_deadline = deadline;
+			}
+		}
+		if ( timed_out > 0 ) {
+			summary.abandoned_workers += timed_out;
+			workers.erase( std::remove_if( workers.begin(), workers.end(), []( const worker & w ) { return w.state->abandoned; } ), workers.end() );
+			for ( std::size_t i = 0; i < timed_out; ++i ) {
+				spawn_worker();
+			}
+			continue;
+		}
+		if ( next_deadline ) {
+			shared->cv.wait_until( lock, *next_deadline );
+		} else {
+			shared->cv.wait( lock );
+		}
+	}
+	lock.unlock();
+	for ( auto & w : workers ) {
+		w.thread.join();
+	}
+	return summary;
+}
+
+#endif // MPT_PLATFORM_MULTITHREADED && !MPT_LIBCXX_QUIRK_NO_STD_THREAD
+
+// Returns the number of workers that are still busy with a timed out file.
+static std::size_t scan_files( const commandlineflags & flags, textout & log ) {
+	const auto start = std::chrono::steady_clock::now();
+	std::vector<mpt::native_path> files;
+	for ( const auto & filename : flags.filenames ) {
+		collect_scan_files( filename, files );
+	}
+	scan_summary summary;
+#if MPT_PLATFORM_MULTITHREADED && !defined(MPT_LIBCXX_QUIRK_NO_STD_THREAD)
+	summary = scan_files_threaded( flags, files );
+#else
+	for ( const auto & filename : files ) {
+		scan_output( scan_file( flags, filename ), summary );
+	}
+#endif
+	const double seconds = std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+	log << MPT_UFORMAT_MESSAGE("Scanned {} files ({} ok, {} unsupported, {} errors, {} timeouts), {} in {} s")( summary.files, summary.ok, summary.unsupported, summary.errors, summary.timeouts, bytes_to_string( summary.bytes ), mpt::format<mpt::ustring>::fix( seconds, 3 ) ) << lf;
+	if ( seconds > 0.0 ) {
+		log << MPT_UFORMAT_MESSAGE("Throughput: {} files/s, {}/s")( mpt::format<mpt::ustring>::fix( summary.files / seconds, 1 ), bytes_to_string( static_cast<std::uint64_t>( summary.bytes / seconds ) ) ) << lf;
+	}
+	log.writeout();
+	return summary.abandoned_workers;
+}
+
+
 static bool parse_playlist( commandlineflags & flags, mpt::native_path filename, concat_stream<mpt::ustring> & log ) {
 	bool is_playlist = false;
 	bool m3u8 = false;
@@ -1937,6 +2309,8 @@ static void parse_openmpt123( commandlineflags & flags, const std::vector<mpt::u
 				flags.mode = Mode::Batch;
 			} else if ( arg == MPT_USTRING("--render") ) {
 				flags.mode = Mode::Render;
+			} else if ( arg == MPT_USTRING("--scan") ) {
+				flags.mode = Mode::Scan;
 			} else if ( arg == MPT_USTRING("--assume-terminal") ) {
 				flags.assume_terminal = true;
 			} else if ( arg == MPT_USTRING("--banner") && nextarg != MPT_USTRING("") ) {
@@ -2091,6 +2465,12 @@ static void parse_openmpt123( commandlineflags & flags, const std::vector<mpt::u
 			} else if ( arg == MPT_USTRING("--end-time") && nextarg != MPT_USTRING("") ) {
 				mpt::parse_into( flags.end_time, nextarg );
 				++i;
+			} else if ( arg == MPT_USTRING("--scan-threads") && nextarg != MPT_USTRING("") ) {
+				mpt::parse_into( flags.scan_threads, nextarg );
+				++i;
+			} else if ( arg == MPT_USTRING("--scan-timeout") && nextarg != MPT_USTRING("") ) {
+				mpt::parse_into( flags.scan_timeout, nextarg );
+				++i;
 			} else if ( arg.size() > 0 && arg.substr( 0, 1 ) == MPT_USTRING("-") ) {
 				throw args_error_exception();
 			}
@@ -2229,8 +2609,9 @@ static mpt::uint8 main( std::vector<mpt::ustring> args ) {
 		[[maybe_unused]] std::optional<terminal_ui_guard> input_guard{ stdin_text && ( flags.mode == Mode::UI ) ? std::make_optional<terminal_ui_guard>() : std::nullopt };
 
 		// choose text output between quiet/stdout/stderr
+		// (scan mode reserves stdout for its JSON lines)
 		textout_dummy dummy_log;
-		textout & log = flags.quiet ? static_cast<textout&>( dummy_log ) : stdout_text ? static_cast<textout&>( std_out ) : static_cast<textout&>( std_err );
+		textout & log = flags.quiet ? static_cast<textout&>( dummy_log ) : ( stdout_text && flags.mode != Mode::Scan ) ? static_cast<textout&>( std_out ) : static_cast<textout&>( std_err );
 
 		show_banner( log, flags.banner );
 
@@ -2282,6 +2663,15 @@ static mpt::uint8 main( std::vector<mpt::ustring> args ) {
 					flags.playlist_index++;
 				}
 			} break;
+			case Mode::Scan: {
+				if ( scan_files( flags, log ) > 0 ) {
+					// Workers that timed out are still running inside libopenmpt and cannot be stopped.
+					// Do not run static destructors underneath them.
+					std::cout.flush();
+					std::fflush( nullptr );
+					std::_Exit( 0 );
+				}
+			} break;
 			case Mode::None:
 			break;
 		}
@@ -143,7 +143,8 @@ enum class Mode {
 	Info,
 	UI,
 	Batch,
-	Render
+	Render,
+	Scan
 };
 
 inline mpt::ustring mode_to_string( Mode mode ) {
@@ -154,6 +155,7 @@ inline mpt::ustring mode_to_string( Mode mode ) {
 		case Mode::UI:     return MPT_USTRING("ui"); break;
 		case Mode::Batch:  return MPT_USTRING("batch"); break;
 		case Mode::Render: return MPT_USTRING("render"); break;
+		case Mode::Scan:   return MPT_USTRING("scan"); break;
 	}
 	return MPT_USTRING("");
 }
@@ -214,6 +216,8 @@ struct commandlineflags {
 	mpt::native_path output_extension = MPT_NATIVE_PATH("auto");
 	bool force_overwrite = false;
 	bool paused = false;
+	std::int32_t scan_threads = 0;
+	double scan_timeout = 30.0;
 	mpt::ustring warnings = MPT_USTRING("");
 
 	void apply_default_buffer_sizes() {
@@ -312,6 +316,13 @@ struct commandlineflags {
 				show_pattern = false;
 				show_ui = false;
 			break;
+			case Mode::Scan:
+				show_ui = false;
+				show_progress = false;
+				show_meters = false;
+				show_channel_meters = false;
+				show_pattern = false;
+			break;
 		}
 		if ( quiet ) {
 			verbose = false;
@@ -12,7 +12,9 @@
 #include "stdafx.h"
 
 #include "EQ.h"
+#include "SIMD.h"
 
+#include "mpt/arch/feature_fence.hpp"
 #include "mpt/audio/span.hpp"
 #include "mpt/base/numbers.hpp"
 #include "openmpt/base/Types.hpp"
@@ -95,6 +97,110 @@ static void EQFilter(Tbuf & buf, const std::array<EQBANDSETTINGS, MAX_EQ_BANDS>
 }
 
 
+// Same filter as EQFilter, but with one channel per SIMD lane.
+// The order of operations is the same as in the scalar version, so results are identical.
+template <typename Vec, std::size_t channels, typename Tbuf>
+static void EQFilterSIMD(Tbuf & buf, const std::array<EQBANDSETTINGS, MAX_EQ_BANDS> &bands, std::array<std::array<EQBANDSTATE, MAX_EQ_BANDS>, MAX_EQ_CHANNELS> &states)
+{
+	static_assert(channels <= 4);
+	using f128 = typename Vec::f128;
+	std::array<std::size_t, MAX_EQ_BANDS> activeBands;
+	std::size_t numActiveBands = 0;
+	for(std::size_t b = 0; b < std::size(bands); ++b)
+	{
+		if(bands[b].Gain != 1.0f)
+			activeBands[numActiveBands++] = b;
+	}
+	if(!numActiveBands)
+		return;
+
+	f128 a0[MAX_EQ_BANDS], a1[MAX_EQ_BANDS], a2[MAX_EQ_BANDS], b1[MAX_EQ_BANDS], b2[MAX_EQ_BANDS];
+	f128 x1[MAX_EQ_BANDS], x2[MAX_EQ_BANDS], y1[MAX_EQ_BANDS], y2[MAX_EQ_BANDS];
+	for(std::size_t i = 0; i < numActiveBands; ++i)
+	{
+		const EQBANDSETTINGS &band = bands[activeBands[i]];
+		a0[i] = Vec::BroadcastFloat(band.a0);
+		a1[i] = Vec::BroadcastFloat(band.a1);
+		a2[i] = Vec::BroadcastFloat(band.a2);
+		b1[i] = Vec::BroadcastFloat(band.b1);
+		b2[i] = Vec::BroadcastFloat(band.b2);
+		float tx1[4] = {}, tx2[4] = {}, ty1[4] = {}, ty2[4] = {};
+		for(std::size_t channel = 0; channel < channels; ++channel)
+		{
+			const EQBANDSTATE &bandState = states[channel][activeBands[i]];
+			tx1[channel] = bandState.x1;
+			tx2[channel] = bandState.x2;
+			ty1[channel] = bandState.y1;
+			ty2[channel] = bandState.y2;
+		}
+		x1[i] = Vec::LoadFloat(tx1);
+		x2[i] = Vec::LoadFloat(tx2);
+		y1[i] = Vec::LoadFloat(ty1);
+		y2[i] = Vec::LoadFloat(ty2);
+	}
+
+	for(std::size_t frame = 0; frame < buf.size_frames(); ++frame)
+	{
+		float tmp[4] = {};
+		for(std::size_t channel = 0; channel < channels; ++channel)
+		{
+			tmp[channel] = mix_sample_cast<float>(buf(channel, frame));
+		}
+		f128 sample = Vec::LoadFloat(tmp);
+		for(std::size_t i = 0; i < numActiveBands; ++i)
+		{
+			f128 y = Vec::MulFloat(a1[i], x1[i]);
+			y = Vec::AddFloat(y, Vec::MulFloat(a2[i], x2[i]));
+			y = Vec::AddFloat(y, Vec::MulFloat(a0[i], sample));
+			y = Vec::AddFloat(y, Vec::MulFloat(b1[i], y1[i]));
+			y = Vec::AddFloat(y, Vec::MulFloat(b2[i], y2[i]));
+			x2[i] = x1[i];
+			y2[i] = y1[i];
+			x1[i] = sample;
+			y1[i] = y;
+			sample = y;
+		}
+		Vec::StoreFloat(tmp, sample);
+		for(std::size_t channel = 0; channel < channels; ++channel)
+		{
+			buf(channel, frame) = mix_sample_cast<typename Tbuf::sample_type>(tmp[channel]);
+		}
+	}
+
+	for(std::size_t i = 0; i < numActiveBands; ++i)
+	{
+		float tx1[4], tx2[4], ty1[4], ty2[4];
+		Vec::StoreFloat(tx1, x1[i]);
+		Vec::StoreFloat(tx2, x2[i]);
+		Vec::StoreFloat(ty1, y1[i]);
+		Vec::StoreFloat(ty2, y2[i]);
+		for(std::size_t channel = 0; channel < channels; ++channel)
+		{
+			EQBANDSTATE &bandState = states[channel][activeBands[i]];
+			bandState.x1 = tx1[channel];
+			bandState.x2 = tx2[channel];
+			bandState.y1 = ty1[channel];
+			bandState.y2 = ty2[channel];
+		}
+	}
+}
+
+
+template <std::size_t channels, typename Tbuf>
+static void EQFilterMultiChannel(Tbuf & buf, const std::array<EQBANDSETTINGS, MAX_EQ_BANDS> &bands, std::array<std::array<EQBANDSTATE, MAX_EQ_BANDS>, MAX_EQ_CHANNELS> &states)
+{
+#if defined(MPT_SIMD_NATIVE)
+	if(SIMD::Native::IsAvailable())
+	{
+		mpt::arch::feature_fence_guard arch_feature_guard;
+		EQFilterSIMD<SIMD::Native, channels>(buf, bands, states);
+		return;
+	}
+#endif
+	EQFilter<channels>(buf, bands, states);
+}
+
+
 template <typename TMixSample>
 void CEQ::ProcessTemplate(TMixSample *frontBuffer, TMixSample *rearBuffer, std::size_t countFrames, std::size_t numChannels)
 {
@@ -114,12 +220,12 @@ void CEQ::ProcessTemplate(TMixSample *frontBuffer, TMixSample *rearBuffer, std::
 	} else if(numChannels == 2)
 	{
 		mpt::audio_span_interleaved<TMixSample> buf{ frontBuffer, 2, countFrames };
-		EQFilter<2>(buf, m_Bands, m_ChannelState);
+		EQFilterMultiChannel<2>(buf, m_Bands, m_ChannelState);
 	} else if(numChannels == 4)
 	{
 		std::array<TMixSample*, 4> buffers = { &frontBuffer[0], &frontBuffer[1], &rearBuffer[0], &rearBuffer[1] };
 		mpt::audio_span_planar_strided<TMixSample> buf{ buffers.data(), 4, countFrames, 2 };
-		EQFilter<4>(buf, m_Bands, m_ChannelState);
+		EQFilterMultiChannel<4>(buf, m_Bands, m_ChannelState);
 	}
 #if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE) && defined(MPT_ARCH_INTRINSICS_X86_SSE)
 	if(CPU::HasFeatureSet(CPU::feature::sse) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
@@ -13,18 +13,12 @@
 
 #ifndef NO_REVERB
 #include "Reverb.h"
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2)
-#include "../common/mptCPU.h"
-#endif
+#include "SIMD.h"
 #include "../soundlib/MixerLoops.h"
+#include "mpt/arch/feature_fence.hpp"
 #include "mpt/base/numbers.hpp"
 
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-#if MPT_COMPILER_MSVC
-#include <intrin.h>
-#endif
-#include <emmintrin.h>
-#endif
+#include <array>
 
 #endif // NO_REVERB
 
@@ -35,15 +29,26 @@ OPENMPT_NAMESPACE_BEGIN
 #ifndef NO_REVERB
 
 
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-// Load two 32-bit values
-static MPT_FORCEINLINE __m128i Load64SSE(const int32 *x) { return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(x)); }
-// Load four 16-bit values
-static MPT_FORCEINLINE __m128i Load64SSE(const LR16 (&x)[2]) { return _mm_loadl_epi64(&reinterpret_cast<const __m128i &>(x)); }
-// Store two 32-bit or four 16-bit values from register
-static MPT_FORCEINLINE void Store64SSE(int32 *dst, __m128i src) { return _mm_storel_epi64(reinterpret_cast<__m128i *>(dst), src); }
-static MPT_FORCEINLINE void Store64SSE(LR16 (&dst)[2], __m128i src) { return _mm_storel_epi64(&reinterpret_cast<__m128i &>(dst), src); }
+// Runs a vectorized kernel with the SIMD backend selected by kernels.
+// Returns false if the scalar implementation should be used instead.
+template <typename TFunc>
+static bool ProcessSIMD(CReverb::Kernels kernels, TFunc &&func)
+{
+	if(kernels == CReverb::Kernels::EmulatedSIMD)
+	{
+		func(SIMD::Scalar{});
+		return true;
+	}
+#if defined(MPT_SIMD_NATIVE)
+	if(kernels == CReverb::Kernels::Auto && SIMD::Native::IsAvailable())
+	{
+		mpt::arch::feature_fence_guard arch_feature_guard;
+		func(SIMD::Native{});
+		return true;
+	}
 #endif
+	return false;
+}
 
 
 CReverb::CReverb()
@@ -249,7 +254,7 @@ static void I3dl2_to_Generic(
 }
 
 
-void CReverb::Shutdown(MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol)
+void CReverb::Shutdown(mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol)
 {
 	gnReverbSend = false;
 
@@ -276,7 +281,7 @@ void CReverb::Shutdown(MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol)
 }
 
 
-void CReverb::Initialize(bool bReset, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 MixingFreq)
+void CReverb::Initialize(bool bReset, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 MixingFreq)
 {
 	if (m_Settings.m_nReverbType >= NUM_REVERBTYPES) m_Settings.m_nReverbType = 0;
 	const SNDMIX_REVERB_PROPERTIES *rvbPreset = &ReverbPresets[m_Settings.m_nReverbType].first;
@@ -384,7 +389,7 @@ void CReverb::Initialize(bool bReset, MixSampleInt &gnRvbROfsVol, MixSampleInt &
 }
 
 
-void CReverb::TouchReverbSendBuffer(MixSampleInt *MixReverbBuffer, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 nSamples)
+void CReverb::TouchReverbSendBuffer(mixsample_t *MixReverbBuffer, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 nSamples)
 {
 	if(!gnReverbSend)
 	{ // and we did not clear the buffer yet, do it now because we will get new data
@@ -395,7 +400,7 @@ void CReverb::TouchReverbSendBuffer(MixSampleInt *MixReverbBuffer, MixSampleInt
 
 
 // Reverb
-void CReverb::Process(MixSampleInt *MixSoundBuffer, MixSampleInt *MixReverbBuffer, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 nSamples)
+void CReverb::Process(mixsample_t *MixSoundBuffer, mixsample_t *MixReverbBuffer, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 nSamples)
 {
 	if((!gnReverbSend) && (!gnReverbSamples))
 	{ // no data is sent to reverb and reverb decayed completely
@@ -406,6 +411,36 @@ void CReverb::Process(MixSampleInt *MixSoundBuffer, MixSampleInt *MixReverbBuffe
 		StereoFill(MixReverbBuffer, nSamples, gnRvbROfsVol, gnRvbLOfsVol);
 	}
 
+#ifdef MPT_INTMIXER
+	ProcessFixedPoint(MixSoundBuffer, MixReverbBuffer, nSamples);
+#else
+	MPT_ASSERT(nSamples <= MIXBUFFERSIZE);
+	for(uint32 i = 0; i < nSamples * 2; i++)
+	{
+		m_fixedPointSend[i] = mpt::saturate_round<MixSampleInt>(MixReverbBuffer[i] * MIXING_SCALEF);
+		m_fixedPointReturn[i] = 0;
+	}
+	ProcessFixedPoint(m_fixedPointReturn, m_fixedPointSend, nSamples);
+	for(uint32 i = 0; i < nSamples * 2; i++)
+	{
+		MixSoundBuffer[i] += static_cast<mixsample_t>(m_fixedPointReturn[i]) * (1.0f / MIXING_SCALEF);
+	}
+#endif // MPT_INTMIXER
+
+	// Automatically shut down if needed
+	if(gnReverbSend) gnReverbSamples = gnReverbDecaySamples; // reset decay counter
+	else if(gnReverbSamples > nSamples) gnReverbSamples -= nSamples; // decay
+	else // decayed
+	{
+		Shutdown(gnRvbROfsVol, gnRvbLOfsVol);
+		gnReverbSamples = 0;
+	}
+	gnReverbSend = false; // no input data in MixReverbBuffer
+}
+
+
+void CReverb::ProcessFixedPoint(int32 *MixSoundBuffer, int32 *MixReverbBuffer, uint32 nSamples)
+{
 	uint32 nIn, nOut;
 	// Dynamically adjust reverb master gains
 	int32 lMasterGain;
@@ -460,15 +495,6 @@ void CReverb::Process(MixSampleInt *MixSoundBuffer, MixSampleInt *MixReverbBuffe
 	g_RefDelay.nDelayPos = (g_RefDelay.nDelayPos - nOut + nIn) & SNDMIX_REFLECTIONS_DELAY_MASK;
 	// Upsample 2x
 	ReverbProcessPostFiltering1x(MixReverbBuffer, MixSoundBuffer, nSamples);
-	// Automatically shut down if needed
-	if(gnReverbSend) gnReverbSamples = gnReverbDecaySamples; // reset decay counter
-	else if(gnReverbSamples > nSamples) gnReverbSamples -= nSamples; // decay
-	else // decayed
-	{
-		Shutdown(gnRvbROfsVol, gnRvbLOfsVol);
-		gnReverbSamples = 0;
-	}
-	gnReverbSend = false; // no input data in MixReverbBuffer
 }
 
 
@@ -591,34 +617,34 @@ void CReverb::ReverbProcessPostFiltering2x(const int32 * MPT_RESTRICT pRvb, int3
 
 #define DCR_AMOUNT		9
 
+template <typename Vec>
+static void PostFiltering1xSIMD(int32 (&dcrY1)[2], int32 (&dcrX1)[2], const int32 * MPT_RESTRICT pRvb, int32 * MPT_RESTRICT pDry, uint32 nSamples)
+{
+	auto nDCRRvb_Y1 = Vec::LoadLow64(dcrY1);
+	auto nDCRRvb_X1 = Vec::LoadLow64(dcrX1);
+	auto in = Vec::Zero();
+	while(nSamples--)
+	{
+		in = Vec::LoadLow64(pRvb);
+		pRvb += 2;
+		// x(n-1) - x(n)
+		auto diff = Vec::SubInt32(nDCRRvb_X1, in);
+		nDCRRvb_X1 = Vec::AddInt32(nDCRRvb_Y1, Vec::SubInt32(Vec::template ShiftRightInt32<DCR_AMOUNT + 1>(diff), diff));
+		auto out = Vec::AddInt32(Vec::LoadLow64(pDry), nDCRRvb_X1);
+		nDCRRvb_Y1 = Vec::SubInt32(nDCRRvb_X1, Vec::template ShiftRightInt32<DCR_AMOUNT>(nDCRRvb_X1));
+		nDCRRvb_X1 = in;
+		Vec::StoreLow64(pDry, out);
+		pDry += 2;
+	}
+	Vec::StoreLow64(dcrX1, in);
+	Vec::StoreLow64(dcrY1, nDCRRvb_Y1);
+}
+
 // Stereo Add + DC removal
 void CReverb::ReverbProcessPostFiltering1x(const int32 * MPT_RESTRICT pRvb, int32 * MPT_RESTRICT pDry, uint32 nSamples)
 {
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
-	{
-		mpt::arch::feature_fence_guard arch_feature_guard;
-		__m128i nDCRRvb_Y1 = Load64SSE(gnDCRRvb_Y1);
-		__m128i nDCRRvb_X1 = Load64SSE(gnDCRRvb_X1);
-		__m128i in = _mm_set1_epi32(0);
-		while(nSamples--)
-		{
-			in = Load64SSE(pRvb);
-			pRvb += 2;
-			// x(n-1) - x(n)
-			__m128i diff = _mm_sub_epi32(nDCRRvb_X1, in);
-			nDCRRvb_X1 = _mm_add_epi32(nDCRRvb_Y1, _mm_sub_epi32(_mm_srai_epi32(diff, DCR_AMOUNT + 1), diff));
-			__m128i out = _mm_add_epi32(Load64SSE(pDry), nDCRRvb_X1);
-			nDCRRvb_Y1 = _mm_sub_epi32(nDCRRvb_X1, _mm_srai_epi32(nDCRRvb_X1, DCR_AMOUNT));
-			nDCRRvb_X1 = in;
-			Store64SSE(pDry, out);
-			pDry += 2;
-		}
-		Store64SSE(gnDCRRvb_X1, in);
-		Store64SSE(gnDCRRvb_Y1, nDCRRvb_Y1);
+	if(ProcessSIMD(m_kernels, [&](auto vec) { PostFiltering1xSIMD<decltype(vec)>(gnDCRRvb_Y1, gnDCRRvb_X1, pRvb, pDry, nSamples); }))
 		return;
-	}
-#endif
 	int32 X1L = gnDCRRvb_X1[0], X1R = gnDCRRvb_X1[1];
 	int32 Y1L = gnDCRRvb_Y1[0], Y1R = gnDCRRvb_Y1[1];
 	int32 inL = 0, inR = 0;
@@ -655,29 +681,30 @@ void CReverb::ReverbProcessPostFiltering1x(const int32 * MPT_RESTRICT pRvb, int3
 }
 
 
-void CReverb::ReverbDCRemoval(int32 * MPT_RESTRICT pBuffer, uint32 nSamples)
+template <typename Vec>
+static void DCRemovalSIMD(int32 (&dcrY1)[2], int32 (&dcrX1)[2], int32 * MPT_RESTRICT pBuffer, uint32 nSamples)
 {
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
+	auto nDCRRvb_Y1 = Vec::LoadLow64(dcrY1);
+	auto nDCRRvb_X1 = Vec::LoadLow64(dcrX1);
+	while(nSamples--)
 	{
-		mpt::arch::feature_fence_guard arch_feature_guard;
-		__m128i nDCRRvb_Y1 = Load64SSE(gnDCRRvb_Y1);
-		__m128i nDCRRvb_X1 = Load64SSE(gnDCRRvb_X1);
-		while(nSamples--)
-		{
-			__m128i in = Load64SSE(pBuffer);
-			__m128i diff = _mm_sub_epi32(nDCRRvb_X1, in);
-			__m128i out = _mm_add_epi32(nDCRRvb_Y1, _mm_sub_epi32(_mm_srai_epi32(diff, DCR_AMOUNT + 1), diff));
-			Store64SSE(pBuffer, out);
-			pBuffer += 2;
-			nDCRRvb_Y1 = _mm_sub_epi32(out, _mm_srai_epi32(out, DCR_AMOUNT));
-			nDCRRvb_X1 = in;
-		}
-		Store64SSE(gnDCRRvb_X1, nDCRRvb_X1);
-		Store64SSE(gnDCRRvb_Y1, nDCRRvb_Y1);
-		return;
+		auto in = Vec::LoadLow64(pBuffer);
+		auto diff = Vec::SubInt32(nDCRRvb_X1, in);
+		auto out = Vec::AddInt32(nDCRRvb_Y1, Vec::SubInt32(Vec::template ShiftRightInt32<DCR_AMOUNT + 1>(diff), diff));
+		Vec::StoreLow64(pBuffer, out);
+		pBuffer += 2;
+		nDCRRvb_Y1 = Vec::SubInt32(out, Vec::template ShiftRightInt32<DCR_AMOUNT>(out));
+		nDCRRvb_X1 = in;
 	}
-#endif
+	Vec::StoreLow64(dcrX1, nDCRRvb_X1);
+	Vec::StoreLow64(dcrY1, nDCRRvb_Y1);
+}
+
+
+void CReverb::ReverbDCRemoval(int32 * MPT_RESTRICT pBuffer, uint32 nSamples)
+{
+	if(ProcessSIMD(m_kernels, [&](auto vec) { DCRemovalSIMD<decltype(vec)>(gnDCRRvb_Y1, gnDCRRvb_X1, pBuffer, nSamples); }))
+		return;
 	int32 X1L = gnDCRRvb_X1[0], X1R = gnDCRRvb_X1[1];
 	int32 Y1L = gnDCRRvb_Y1[0], Y1R = gnDCRRvb_Y1[1];
 	int32 inL = 0, inR = 0;
@@ -719,38 +746,38 @@ void CReverb::ReverbDCRemoval(int32 * MPT_RESTRICT pBuffer, uint32 nSamples)
 // Save some typing
 static MPT_FORCEINLINE int32 Clamp16(int32 x) { return Clamp(x, std::numeric_limits<int16>::min(), std::numeric_limits<int16>::max()); }
 
+template <typename Vec>
+static void PreDelaySIMD(SWRvbRefDelay * MPT_RESTRICT pPreDelay, const int32 * MPT_RESTRICT pIn, uint32 nSamples, uint32 preDifPos, uint32 delayPos)
+{
+	const auto coeffs = Vec::FromInt32(pPreDelay->nCoeffs.lr);
+	auto history = Vec::FromInt32(pPreDelay->History.lr);
+	const auto preDifCoeffs = Vec::FromInt32(pPreDelay->nPreDifCoeffs.lr);
+	while(nSamples--)
+	{
+		auto in32 = Vec::LoadLow64(pIn);						// 16-bit unsaturated reverb input [  r  |  l  ]
+		auto inSat = Vec::PackSaturateInt32(in32, in32);	// [ r | l | r | l ] (16-bit saturated)
+		pIn += 2;
+		// Low-pass
+		auto lp = Vec::MulHighInt16(Vec::SubSaturateInt16(history, inSat), coeffs);
+		auto preDif = Vec::FromInt32(pPreDelay->PreDifBuffer[preDifPos].lr);
+		history = Vec::AddSaturateInt16(Vec::AddSaturateInt16(lp, lp), inSat);
+		// Pre-Diffusion
+		preDifPos = (preDifPos + 1) & SNDMIX_PREDIFFUSION_DELAY_MASK;
+		delayPos = (delayPos + 1) & SNDMIX_REFLECTIONS_DELAY_MASK;
+		auto preDif2 = Vec::SubSaturateInt16(history, Vec::MulHighInt16(preDif, preDifCoeffs));
+		pPreDelay->PreDifBuffer[preDifPos].lr = Vec::ToInt32(preDif2);
+		pPreDelay->RefDelayBuffer[delayPos].lr = Vec::ToInt32(Vec::AddSaturateInt16(Vec::MulHighInt16(preDifCoeffs, preDif2), preDif));
+	}
+	pPreDelay->nPreDifPos = preDifPos;
+	pPreDelay->History.lr = Vec::ToInt32(history);
+}
+
 void CReverb::ProcessPreDelay(SWRvbRefDelay * MPT_RESTRICT pPreDelay, const int32 * MPT_RESTRICT pIn, uint32 nSamples)
 {
 	uint32 preDifPos = pPreDelay->nPreDifPos;
 	uint32 delayPos = pPreDelay->nDelayPos - 1;
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
-	{
-		mpt::arch::feature_fence_guard arch_feature_guard;
-		__m128i coeffs = _mm_cvtsi32_si128(pPreDelay->nCoeffs.lr);
-		__m128i history = _mm_cvtsi32_si128(pPreDelay->History.lr);
-		__m128i preDifCoeffs = _mm_cvtsi32_si128(pPreDelay->nPreDifCoeffs.lr);
-		while(nSamples--)
-		{
-			__m128i in32 = Load64SSE(pIn);					// 16-bit unsaturated reverb input [  r  |  l  ]
-			__m128i inSat = _mm_packs_epi32(in32, in32);	// [ r | l | r | l ] (16-bit saturated)
-			pIn += 2;
-			// Low-pass
-			__m128i lp = _mm_mulhi_epi16(_mm_subs_epi16(history, inSat), coeffs);
-			__m128i preDif = _mm_cvtsi32_si128(pPreDelay->PreDifBuffer[preDifPos].lr);
-			history = _mm_adds_epi16(_mm_adds_epi16(lp, lp), inSat);
-			// Pre-Diffusion
-			preDifPos = (preDifPos + 1) & SNDMIX_PREDIFFUSION_DELAY_MASK;
-			delayPos = (delayPos + 1) & SNDMIX_REFLECTIONS_DELAY_MASK;
-			__m128i preDif2 = _mm_subs_epi16(history, _mm_mulhi_epi16(preDif, preDifCoeffs));
-			pPreDelay->PreDifBuffer[preDifPos].lr = _mm_cvtsi128_si32(preDif2);
-			pPreDelay->RefDelayBuffer[delayPos].lr = _mm_cvtsi128_si32(_mm_adds_epi16(_mm_mulhi_epi16(preDifCoeffs, preDif2), preDif));
-		}
-		pPreDelay->nPreDifPos = preDifPos;
-		pPreDelay->History.lr = _mm_cvtsi128_si32(history);
+	if(ProcessSIMD(m_kernels, [&](auto vec) { PreDelaySIMD<decltype(vec)>(pPreDelay, pIn, nSamples, preDifPos, delayPos); }))
 		return;
-	}
-#endif
 	const int32 coeffsL = pPreDelay->nCoeffs.c.l, coeffsR = pPreDelay->nCoeffs.c.r;
 	const int32 preDifCoeffsL = pPreDelay->nPreDifCoeffs.c.l, preDifCoeffsR = pPreDelay->nPreDifCoeffs.c.r;
 	int16 historyL = pPreDelay->History.c.l, historyR = pPreDelay->History.c.r;
@@ -794,58 +821,54 @@ void CReverb::ProcessPreDelay(SWRvbRefDelay * MPT_RESTRICT pPreDelay, const int3
 //	- apply reflections master gain and accumulate in the given output
 //
 
-void CReverb::ProcessReflections(SWRvbRefDelay * MPT_RESTRICT pPreDelay, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pOut, uint32 nSamples)
+template <typename Vec>
+static void ReflectionsSIMD(SWRvbRefDelay * MPT_RESTRICT pPreDelay, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pOut, uint32 nSamples)
 {
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
-	{
-		mpt::arch::feature_fence_guard arch_feature_guard;
-		union
-		{
-			__m128i xmm;
-			int16 i[8];
-		} pos;
-		const LR16 *refDelayBuffer = pPreDelay->RefDelayBuffer;
+	std::array<int16, 8> pos;
+	const LR16 *refDelayBuffer = pPreDelay->RefDelayBuffer;
 #define GETDELAY(x) static_cast<int16>(pPreDelay->Reflections[x].Delay)
-		__m128i delayPos = _mm_set_epi16(GETDELAY(7), GETDELAY(6), GETDELAY(5), GETDELAY(4), GETDELAY(3), GETDELAY(2), GETDELAY(1), GETDELAY(0));
+	auto delayPos = Vec::SetInt16(GETDELAY(0), GETDELAY(1), GETDELAY(2), GETDELAY(3), GETDELAY(4), GETDELAY(5), GETDELAY(6), GETDELAY(7));
 #undef GETDELAY
-		delayPos = _mm_sub_epi16(_mm_set1_epi16(static_cast<int16>(pPreDelay->nDelayPos - 1)), delayPos);
-		__m128i gain12 = _mm_unpacklo_epi64(Load64SSE(pPreDelay->Reflections[0].Gains), Load64SSE(pPreDelay->Reflections[1].Gains));
-		__m128i gain34 = _mm_unpacklo_epi64(Load64SSE(pPreDelay->Reflections[2].Gains), Load64SSE(pPreDelay->Reflections[3].Gains));
-		__m128i gain56 = _mm_unpacklo_epi64(Load64SSE(pPreDelay->Reflections[4].Gains), Load64SSE(pPreDelay->Reflections[5].Gains));
-		__m128i gain78 = _mm_unpacklo_epi64(Load64SSE(pPreDelay->Reflections[6].Gains), Load64SSE(pPreDelay->Reflections[7].Gains));
-		// For 28-bit final output: 16+15-3 = 28
-		__m128i refGain = _mm_srai_epi32(_mm_set_epi32(0, 0, pPreDelay->ReflectionsGain.c.r, pPreDelay->ReflectionsGain.c.l), 3);
-		__m128i delayInc = _mm_set1_epi16(1), delayMask = _mm_set1_epi16(SNDMIX_REFLECTIONS_DELAY_MASK);
-		while(nSamples--)
-		{
-			delayPos = _mm_and_si128(_mm_add_epi16(delayInc, delayPos), delayMask);
-			_mm_storeu_si128(&pos.xmm, delayPos);
-			__m128i ref12 = _mm_set_epi32(refDelayBuffer[pos.i[1]].lr, refDelayBuffer[pos.i[1]].lr, refDelayBuffer[pos.i[0]].lr, refDelayBuffer[pos.i[0]].lr);
-			__m128i ref34 = _mm_set_epi32(refDelayBuffer[pos.i[3]].lr, refDelayBuffer[pos.i[3]].lr, refDelayBuffer[pos.i[2]].lr, refDelayBuffer[pos.i[2]].lr);
-			__m128i ref56 = _mm_set_epi32(refDelayBuffer[pos.i[5]].lr, refDelayBuffer[pos.i[5]].lr, refDelayBuffer[pos.i[4]].lr, refDelayBuffer[pos.i[4]].lr);
-			__m128i ref78 = _mm_set_epi32(0,                           0,                           refDelayBuffer[pos.i[6]].lr, refDelayBuffer[pos.i[6]].lr);
-			// First stage
-			__m128i refOut1 = _mm_add_epi32(_mm_madd_epi16(ref12, gain12), _mm_madd_epi16(ref34, gain34));
-			refOut1 = _mm_srai_epi32(_mm_add_epi32(refOut1, _mm_shuffle_epi32(refOut1, _MM_SHUFFLE(1, 0, 3, 2))), 15);
-
-			// Second stage
-			__m128i refOut2 = _mm_add_epi32(_mm_madd_epi16(ref56, gain56), _mm_madd_epi16(ref78, gain78));
-			refOut2 = _mm_srai_epi32(_mm_add_epi32(refOut2, _mm_shuffle_epi32(refOut2, _MM_SHUFFLE(1, 0, 3, 2))), 15);
-
-			// Saturate to 16-bit and sum stages
-			__m128i refOut = _mm_adds_epi16(_mm_packs_epi32(refOut1, refOut1), _mm_packs_epi32(refOut2, refOut2));
-			pRefOut->lr = _mm_cvtsi128_si32(refOut);
-			pRefOut++;
-
-			__m128i out = _mm_madd_epi16(_mm_unpacklo_epi16(refOut, refOut), refGain);	// Apply reflections gain
-			// At this, point, this is the only output of the reverb
-			Store64SSE(pOut, out);
-			pOut += 2;
-		}
-		return;
+	delayPos = Vec::SubInt16(Vec::BroadcastInt16(static_cast<int16>(pPreDelay->nDelayPos - 1)), delayPos);
+	const auto gain12 = Vec::UnpackLowInt64(Vec::LoadLow64(pPreDelay->Reflections[0].Gains), Vec::LoadLow64(pPreDelay->Reflections[1].Gains));
+	const auto gain34 = Vec::UnpackLowInt64(Vec::LoadLow64(pPreDelay->Reflections[2].Gains), Vec::LoadLow64(pPreDelay->Reflections[3].Gains));
+	const auto gain56 = Vec::UnpackLowInt64(Vec::LoadLow64(pPreDelay->Reflections[4].Gains), Vec::LoadLow64(pPreDelay->Reflections[5].Gains));
+	const auto gain78 = Vec::UnpackLowInt64(Vec::LoadLow64(pPreDelay->Reflections[6].Gains), Vec::LoadLow64(pPreDelay->Reflections[7].Gains));
+	// For 28-bit final output: 16+15-3 = 28
+	const auto refGain = Vec::template ShiftRightInt32<3>(Vec::SetInt32(pPreDelay->ReflectionsGain.c.l, pPreDelay->ReflectionsGain.c.r, 0, 0));
+	const auto delayInc = Vec::BroadcastInt16(1), delayMask = Vec::BroadcastInt16(SNDMIX_REFLECTIONS_DELAY_MASK);
+	while(nSamples--)
+	{
+		delayPos = Vec::And(Vec::AddInt16(delayInc, delayPos), delayMask);
+		Vec::Store(pos.data(), delayPos);
+		auto ref12 = Vec::SetInt32(refDelayBuffer[pos[0]].lr, refDelayBuffer[pos[0]].lr, refDelayBuffer[pos[1]].lr, refDelayBuffer[pos[1]].lr);
+		auto ref34 = Vec::SetInt32(refDelayBuffer[pos[2]].lr, refDelayBuffer[pos[2]].lr, refDelayBuffer[pos[3]].lr, refDelayBuffer[pos[3]].lr);
+		auto ref56 = Vec::SetInt32(refDelayBuffer[pos[4]].lr, refDelayBuffer[pos[4]].lr, refDelayBuffer[pos[5]].lr, refDelayBuffer[pos[5]].lr);
+		auto ref78 = Vec::SetInt32(refDelayBuffer[pos[6]].lr, refDelayBuffer[pos[6]].lr, 0,                           0);
+		// First stage
+		auto refOut1 = Vec::AddInt32(Vec::MulAddInt16(ref12, gain12), Vec::MulAddInt16(ref34, gain34));
+		refOut1 = Vec::template ShiftRightInt32<15>(Vec::AddInt32(refOut1, Vec::SwapHalves(refOut1)));
+
+		// Second stage
+		auto refOut2 = Vec::AddInt32(Vec::MulAddInt16(ref56, gain56), Vec::MulAddInt16(ref78, gain78));
+		refOut2 = Vec::template ShiftRightInt32<15>(Vec::AddInt32(refOut2, Vec::SwapHalves(refOut2)));
+
+		// Saturate to 16-bit and sum stages
+		auto refOut = Vec::AddSaturateInt16(Vec::PackSaturateInt32(refOut1, refOut1), Vec::PackSaturateInt32(refOut2, refOut2));
+		pRefOut->lr = Vec::ToInt32(refOut);
+		pRefOut++;
+
+		auto out = Vec::MulAddInt16(Vec::UnpackLowInt16(refOut, refOut), refGain);	// Apply reflections gain
+		// At this, point, this is the only output of the reverb
+		Vec::StoreLow64(pOut, out);
+		pOut += 2;
 	}
-#endif
+}
+
+void CReverb::ProcessReflections(SWRvbRefDelay * MPT_RESTRICT pPreDelay, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pOut, uint32 nSamples)
+{
+	if(ProcessSIMD(m_kernels, [&](auto vec) { ReflectionsSIMD<decltype(vec)>(pPreDelay, pRefOut, pOut, nSamples); }))
+		return;
 	int pos[7];
 	for(int i = 0; i < 7; i++)
 		pos[i] = pPreDelay->nDelayPos - pPreDelay->Reflections[i].Delay - 1;
@@ -887,79 +910,81 @@ void CReverb::ProcessReflections(SWRvbRefDelay * MPT_RESTRICT pPreDelay, LR16 *
 // Late reverberation (with SW reflections)
 //
 
-void CReverb::ProcessLateReverb(SWLateReverb * MPT_RESTRICT pReverb, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pMixOut, uint32 nSamples)
-{
-	// Calculate delay line offset from current delay position
-	#define DELAY_OFFSET(x) ((delayPos - (x)) & RVBDLY_MASK)
+// Calculate delay line offset from current delay position
+#define DELAY_OFFSET(x) ((delayPos - (x)) & RVBDLY_MASK)
 
-#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
-	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
+template <typename Vec>
+static void LateReverbSIMD(SWLateReverb * MPT_RESTRICT pReverb, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pMixOut, uint32 nSamples)
+{
+	int delayPos = pReverb->nDelayPos & RVBDLY_MASK;
+	const auto rvbOutGains = Vec::LoadLow64(pReverb->RvbOutGains);
+	const auto difCoeffs = Vec::LoadLow64(pReverb->nDifCoeffs);
+	const auto decayLP = Vec::LoadLow64(pReverb->nDecayLP);
+	const auto decayDC = Vec::LoadLow64(pReverb->nDecayDC);
+	const auto dif2InGains = Vec::LoadLow64(pReverb->Dif2InGains);
+	auto lpHistory = Vec::LoadLow64(pReverb->LPHistory);
+	while(nSamples--)
 	{
-		mpt::arch::feature_fence_guard arch_feature_guard;
-		int delayPos = pReverb->nDelayPos & RVBDLY_MASK;
-		__m128i rvbOutGains = Load64SSE(pReverb->RvbOutGains);
-		__m128i difCoeffs = Load64SSE(pReverb->nDifCoeffs);
-		__m128i decayLP = Load64SSE(pReverb->nDecayLP);
-		__m128i lpHistory = Load64SSE(pReverb->LPHistory);
-		while(nSamples--)
-		{
-			__m128i refIn = _mm_cvtsi32_si128(pRefOut->lr);	// 16-bit stereo input
-			pRefOut++;
-
-			__m128i delay2 = _mm_unpacklo_epi32(
-				_mm_cvtsi32_si128(pReverb->Delay2[DELAY_OFFSET(RVBDLY2L_LEN)].lr),
-				_mm_cvtsi32_si128(pReverb->Delay2[DELAY_OFFSET(RVBDLY2R_LEN)].lr));
-
-			// Unsigned to avoid sign extension
-			uint16 diff1L = pReverb->Diffusion1[DELAY_OFFSET(RVBDIF1L_LEN)].c.l;
-			uint16 diff1R = pReverb->Diffusion1[DELAY_OFFSET(RVBDIF1R_LEN)].c.r;
-			int32 diffusion1 = diff1L | (diff1R << 16);	// diffusion1 history
-
-			uint16 diff2L = pReverb->Diffusion2[DELAY_OFFSET(RVBDIF2L_LEN)].c.l;
-			uint16 diff2R = pReverb->Diffusion2[DELAY_OFFSET(RVBDIF2R_LEN)].c.r;
-			int32 diffusion2 = diff2L | (diff2R << 16);	// diffusion2 history
-
-			__m128i lpDecay = _mm_mulhi_epi16(_mm_subs_epi16(lpHistory, delay2), decayLP);
-			lpHistory = _mm_adds_epi16(_mm_adds_epi16(lpDecay, lpDecay), delay2);	// Low-passed decay
-
-			// Apply decay gain
-			__m128i histDecay = _mm_srai_epi32(_mm_madd_epi16(Load64SSE(pReverb->nDecayDC), lpHistory), 15);
-			__m128i histDecayPacked = _mm_shuffle_epi32(_mm_packs_epi32(histDecay, histDecay), _MM_SHUFFLE(2, 0, 2, 0));
-			__m128i histDecayIn = _mm_adds_epi16(histDecayPacked, _mm_srai_epi16(_mm_unpacklo_epi32(refIn, refIn), 2));
-			__m128i histDecayInDiff = _mm_subs_epi16(histDecayIn, _mm_mulhi_epi16(_mm_cvtsi32_si128(diffusion1), difCoeffs));
-			pReverb->Diffusion1[delayPos].lr = _mm_cvtsi128_si32(histDecayInDiff);
-
-			__m128i delay1Out = _mm_adds_epi16(_mm_mulhi_epi16(difCoeffs, histDecayInDiff), _mm_cvtsi32_si128(diffusion1));
-			// Insert the diffusion output in the reverb delay line
-			pReverb->Delay1[delayPos].lr = _mm_cvtsi128_si32(delay1Out);
-			__m128i histDecayInDelay = _mm_adds_epi16(histDecayIn, _mm_unpacklo_epi32(delay1Out, delay1Out));
-
-			// Input to second diffuser
-			__m128i delay1 = _mm_unpacklo_epi32(
-				_mm_cvtsi32_si128(pReverb->Delay1[DELAY_OFFSET(RVBDLY1L_LEN)].lr),
-				_mm_cvtsi32_si128(pReverb->Delay1[DELAY_OFFSET(RVBDLY1R_LEN)].lr));
-
-			__m128i delay1Gains = _mm_srai_epi32(_mm_madd_epi16(delay1, Load64SSE(pReverb->Dif2InGains)), 15);
-			__m128i delay1GainsSat = _mm_shuffle_epi32(_mm_packs_epi32(delay1Gains, delay1Gains), _MM_SHUFFLE(2, 0, 2, 0));
-			__m128i histDelay1 = _mm_subs_epi16(_mm_adds_epi16(histDecayInDelay, delay1), delay1GainsSat);	// accumulate with reverb output
-			__m128i diff2out = _mm_subs_epi16(delay1GainsSat, _mm_mulhi_epi16(_mm_cvtsi32_si128(diffusion2), difCoeffs));
-			__m128i diff2outCoeffs = _mm_mulhi_epi16(difCoeffs, diff2out);
-			pReverb->Diffusion2[delayPos].lr = _mm_cvtsi128_si32(diff2out);
-
-			__m128i mixOut = Load64SSE(pMixOut);
-			__m128i delay2out = _mm_adds_epi16(diff2outCoeffs, _mm_cvtsi32_si128(diffusion2));
-			pReverb->Delay2[delayPos].lr = _mm_cvtsi128_si32(delay2out);
-			delayPos = (delayPos + 1) & RVBDLY_MASK;
-			// Accumulate with reverb output
-			__m128i out = _mm_add_epi32(_mm_madd_epi16(_mm_adds_epi16(histDelay1, delay2out), rvbOutGains), mixOut);
-			Store64SSE(pMixOut, out);
-			pMixOut += 2;
-		}
-		Store64SSE(pReverb->LPHistory, lpHistory);
-		pReverb->nDelayPos = delayPos;
-		return;
+		auto refIn = Vec::FromInt32(pRefOut->lr);	// 16-bit stereo input
+		pRefOut++;
+
+		auto delay2 = Vec::UnpackLowInt32(
+			Vec::FromInt32(pReverb->Delay2[DELAY_OFFSET(RVBDLY2L_LEN)].lr),
+			Vec::FromInt32(pReverb->Delay2[DELAY_OFFSET(RVBDLY2R_LEN)].lr));
+
+		// Unsigned to avoid sign extension
+		uint16 diff1L = pReverb->Diffusion1[DELAY_OFFSET(RVBDIF1L_LEN)].c.l;
+		uint16 diff1R = pReverb->Diffusion1[DELAY_OFFSET(RVBDIF1R_LEN)].c.r;
+		auto diffusion1 = Vec::FromInt32(diff1L | (diff1R << 16));	// diffusion1 history
+
+		uint16 diff2L = pReverb->Diffusion2[DELAY_OFFSET(RVBDIF2L_LEN)].c.l;
+		uint16 diff2R = pReverb->Diffusion2[DELAY_OFFSET(RVBDIF2R_LEN)].c.r;
+		auto diffusion2 = Vec::FromInt32(diff2L | (diff2R << 16));	// diffusion2 history
+
+		auto lpDecay = Vec::MulHighInt16(Vec::SubSaturateInt16(lpHistory, delay2), decayLP);
+		lpHistory = Vec::AddSaturateInt16(Vec::AddSaturateInt16(lpDecay, lpDecay), delay2);	// Low-passed decay
+
+		// Apply decay gain
+		auto histDecay = Vec::template ShiftRightInt32<15>(Vec::MulAddInt16(decayDC, lpHistory));
+		auto histDecayPacked = Vec::BroadcastLowInt32(Vec::PackSaturateInt32(histDecay, histDecay));
+		auto histDecayIn = Vec::AddSaturateInt16(histDecayPacked, Vec::template ShiftRightInt16<2>(Vec::UnpackLowInt32(refIn, refIn)));
+		auto histDecayInDiff = Vec::SubSaturateInt16(histDecayIn, Vec::MulHighInt16(diffusion1, difCoeffs));
+		pReverb->Diffusion1[delayPos].lr = Vec::ToInt32(histDecayInDiff);
+
+		auto delay1Out = Vec::AddSaturateInt16(Vec::MulHighInt16(difCoeffs, histDecayInDiff), diffusion1);
+		// Insert the diffusion output in the reverb delay line
+		pReverb->Delay1[delayPos].lr = Vec::ToInt32(delay1Out);
+		auto histDecayInDelay = Vec::AddSaturateInt16(histDecayIn, Vec::UnpackLowInt32(delay1Out, delay1Out));
+
+		// Input to second diffuser
+		auto delay1 = Vec::UnpackLowInt32(
+			Vec::FromInt32(pReverb->Delay1[DELAY_OFFSET(RVBDLY1L_LEN)].lr),
+			Vec::FromInt32(pReverb->Delay1[DELAY_OFFSET(RVBDLY1R_LEN)].lr));
+
+		auto delay1Gains = Vec::template ShiftRightInt32<15>(Vec::MulAddInt16(delay1, dif2InGains));
+		auto delay1GainsSat = Vec::BroadcastLowInt32(Vec::PackSaturateInt32(delay1Gains, delay1Gains));
+		auto histDelay1 = Vec::SubSaturateInt16(Vec::AddSaturateInt16(histDecayInDelay, delay1), delay1GainsSat);	// accumulate with reverb output
+		auto diff2out = Vec::SubSaturateInt16(delay1GainsSat, Vec::MulHighInt16(diffusion2, difCoeffs));
+		auto diff2outCoeffs = Vec::MulHighInt16(difCoeffs, diff2out);
+		pReverb->Diffusion2[delayPos].lr = Vec::ToInt32(diff2out);
+
+		auto mixOut = Vec::LoadLow64(pMixOut);
+		auto delay2out = Vec::AddSaturateInt16(diff2outCoeffs, diffusion2);
+		pReverb->Delay2[delayPos].lr = Vec::ToInt32(delay2out);
+		delayPos = (delayPos + 1) & RVBDLY_MASK;
+		// Accumulate with reverb output
+		auto out = Vec::AddInt32(Vec::MulAddInt16(Vec::AddSaturateInt16(histDelay1, delay2out), rvbOutGains), mixOut);
+		Vec::StoreLow64(pMixOut, out);
+		pMixOut += 2;
 	}
-#endif
+	Vec::StoreLow64(pReverb->LPHistory, lpHistory);
+	pReverb->nDelayPos = delayPos;
+}
+
+void CReverb::ProcessLateReverb(SWLateReverb * MPT_RESTRICT pReverb, LR16 * MPT_RESTRICT pRefOut, int32 * MPT_RESTRICT pMixOut, uint32 nSamples)
+{
+	if(ProcessSIMD(m_kernels, [&](auto vec) { LateReverbSIMD<decltype(vec)>(pReverb, pRefOut, pMixOut, nSamples); }))
+		return;
 	int delayPos = pReverb->nDelayPos & RVBDLY_MASK;
 	while(nSamples--)
 	{
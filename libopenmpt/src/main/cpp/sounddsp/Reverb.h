@@ -134,9 +134,19 @@ public:
 class CReverb
 {
 public:
+	// Selects the implementation of the reverb kernels
+	enum class Kernels
+	{
+		Auto,          // Native SIMD if available, scalar otherwise
+		Scalar,        // Plain C++ implementation
+		EmulatedSIMD,  // SIMD kernels on top of the scalar SIMD backend (for testing)
+	};
+
 	CReverbSettings m_Settings;
 
 private:
+	Kernels m_kernels = Kernels::Auto;
+
 	const SNDMIX_REVERB_PROPERTIES *m_currentPreset = nullptr;
 
 	bool gnReverbSend = false;
@@ -160,19 +170,33 @@ private:
 	SWRvbRefDelay g_RefDelay;
 	SWLateReverb g_LateReverb;
 
+#ifndef MPT_INTMIXER
+	// The reverb network always runs in fixed point, so the float mixer converts its send and return buffers
+	MixSampleInt m_fixedPointSend[MIXBUFFERSIZE * 2];
+	MixSampleInt m_fixedPointReturn[MIXBUFFERSIZE * 2];
+#endif // !MPT_INTMIXER
+
 public:
 	CReverb();
 public:
-	void Initialize(bool bReset, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 MixingFreq);
+	void Initialize(bool bReset, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 MixingFreq);
 
 	// can be called multiple times or never (if no data is sent to reverb)
-	void TouchReverbSendBuffer(MixSampleInt *MixReverbBuffer, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 nSamples);
+	void TouchReverbSendBuffer(mixsample_t *MixReverbBuffer, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 nSamples);
 
 	// call once after all data has been sent.
-	void Process(MixSampleInt *MixSoundBuffer, MixSampleInt *MixReverbBuffer, MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol, uint32 nSamples);
+	void Process(mixsample_t *MixSoundBuffer, mixsample_t *MixReverbBuffer, mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol, uint32 nSamples);
+
+	// false if no data was sent to the reverb since the last Process call and the reverb has decayed completely
+	bool IsActive() const { return gnReverbSend || gnReverbSamples; }
+
+	// Only intended for verifying the SIMD kernels against each other
+	void SetKernels(Kernels kernels) { m_kernels = kernels; }
 
 private:
-	void Shutdown(MixSampleInt &gnRvbROfsVol, MixSampleInt &gnRvbLOfsVol);
+	void Shutdown(mixsample_t &gnRvbROfsVol, mixsample_t &gnRvbLOfsVol);
+	// Mix dry send and reverb output into MixSoundBuffer. MixReverbBuffer is used as scratch space.
+	void ProcessFixedPoint(int32 *MixSoundBuffer, int32 *MixReverbBuffer, uint32 nSamples);
 	// Pre/Post resampling and filtering
 	uint32 ReverbProcessPreFiltering1x(int32 *pWet, uint32 nSamples);
 	uint32 ReverbProcessPreFiltering2x(int32 *pWet, uint32 nSamples);
@@ -181,11 +205,11 @@ private:
 	void ReverbDCRemoval(int32 *pBuffer, uint32 nSamples);
 	void ReverbDryMix(int32 *pDry, int32 *pWet, int lDryVol, uint32 nSamples);
 	// Process pre-diffusion and pre-delay
-	static void ProcessPreDelay(SWRvbRefDelay *pPreDelay, const int32 *pIn, uint32 nSamples);
+	void ProcessPreDelay(SWRvbRefDelay *pPreDelay, const int32 *pIn, uint32 nSamples);
 	// Process reflections
-	static void ProcessReflections(SWRvbRefDelay *pPreDelay, LR16 *pRefOut, int32 *pMixOut, uint32 nSamples);
+	void ProcessReflections(SWRvbRefDelay *pPreDelay, LR16 *pRefOut, int32 *pMixOut, uint32 nSamples);
 	// Process Late Reverb (SW Reflections): stereo reflections output, 32-bit reverb output, SW reverb gain
-	static void ProcessLateReverb(SWLateReverb *pReverb, LR16 *pRefOut, int32 *pMixOut, uint32 nSamples);
+	void ProcessLateReverb(SWLateReverb *pReverb, LR16 *pRefOut, int32 *pMixOut, uint32 nSamples);
 };
 
 
@@ -0,0 +1,383 @@
+/*
+ * SIMD.h
+ * ------
+ * Purpose: Minimal portable wrapper around 128-bit integer and float vectors for the DSP code.
+ * Notes  : Every backend provides the same set of operations with exactly the same semantics as the
+ *          corresponding SSE2 instructions, so a kernel written against this interface produces identical
+ *          results with all backends. The Scalar backend emulates the operations lane by lane; it is
+ *          not meant to be fast, but allows testing the vectorized kernels on any platform.
+ *          Lanes are numbered in memory order, as on little-endian targets.
+ *          The NEON backend is used on AArch64, and on 32-bit ARM only with MPT_NEON_KERNELS (see BuildSettings.h).
+ *          libopenmpt only uses it for the reverb; the EQ is not part of libopenmpt builds (NO_EQ), so its
+ *          kernels only run in the tracker.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#include "mpt/base/saturate_cast.hpp"
+#include "openmpt/base/Types.hpp"
+
+#include <array>
+
+#include <cstring>
+
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
+#define MPT_SIMD_SSE2
+#elif defined(MPT_WANT_ARCH_INTRINSICS_ARM_NEON) && defined(__ARM_NEON)
+#define MPT_SIMD_NEON
+#endif
+
+#if defined(MPT_SIMD_SSE2)
+#include "../common/mptCPU.h"
+#if MPT_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#endif
+#if defined(MPT_SIMD_NEON)
+#include <arm_neon.h>
+#endif
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+namespace SIMD
+{
+
+
+//////////////////////////////////////////////////////////////////////////
+// Lane-by-lane emulation
+
+struct Scalar
+{
+	// 4x int32, or 8x int16 when used with the 16-bit operations
+	struct i128
+	{
+		std::array<int32, 4> v;
+	};
+	// 4x float
+	struct f128
+	{
+		std::array<float, 4> v;
+	};
+
+	static MPT_FORCEINLINE bool IsAvailable() noexcept { return true; }
+
+	static MPT_FORCEINLINE std::array<int16, 8> ToInt16(i128 a) noexcept
+	{
+		std::array<int16, 8> r;
+		std::memcpy(r.data(), a.v.data(), sizeof(r));
+		return r;
+	}
+	static MPT_FORCEINLINE i128 FromInt16(const std::array<int16, 8> &a) noexcept
+	{
+		i128 r;
+		std::memcpy(r.v.data(), a.data(), sizeof(r.v));
+		return r;
+	}
+	static MPT_FORCEINLINE int32 WrapInt32(int64 x) noexcept { return static_cast<int32>(static_cast<uint32>(static_cast<uint64>(x))); }
+
+	static MPT_FORCEINLINE i128 Zero() noexcept { return {}; }
+	static MPT_FORCEINLINE i128 SetInt32(int32 a, int32 b, int32 c, int32 d) noexcept { return {{a, b, c, d}}; }
+	static MPT_FORCEINLINE i128 SetInt16(int16 a, int16 b, int16 c, int16 d, int16 e, int16 f, int16 g, int16 h) noexcept { return FromInt16({a, b, c, d, e, f, g, h}); }
+	static MPT_FORCEINLINE i128 BroadcastInt16(int16 a) noexcept { return FromInt16({a, a, a, a, a, a, a, a}); }
+	static MPT_FORCEINLINE i128 FromInt32(int32 a) noexcept { return {{a, 0, 0, 0}}; }
+	static MPT_FORCEINLINE int32 ToInt32(i128 a) noexcept { return a.v[0]; }
+
+	static MPT_FORCEINLINE i128 Load(const void *p) noexcept
+	{
+		i128 r;
+		std::memcpy(r.v.data(), p, 16);
+		return r;
+	}
+	static MPT_FORCEINLINE void Store(void *p, i128 a) noexcept { std::memcpy(p, a.v.data(), 16); }
+	static MPT_FORCEINLINE i128 LoadLow64(const void *p) noexcept
+	{
+		i128 r{};
+		std::memcpy(r.v.data(), p, 8);
+		return r;
+	}
+	static MPT_FORCEINLINE void StoreLow64(void *p, i128 a) noexcept { std::memcpy(p, a.v.data(), 8); }
+
+	static MPT_FORCEINLINE i128 AddInt32(i128 a, i128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] = WrapInt32(int64(a.v[i]) + b.v[i]);
+		return a;
+	}
+	static MPT_FORCEINLINE i128 SubInt32(i128 a, i128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] = WrapInt32(int64(a.v[i]) - b.v[i]);
+		return a;
+	}
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt32(i128 a) noexcept
+	{
+		static_assert(shift > 0 && shift < 32);
+		for(auto &x : a.v)
+			x >>= shift;
+		return a;
+	}
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt16(i128 a) noexcept
+	{
+		static_assert(shift > 0 && shift < 16);
+		auto r = ToInt16(a);
+		for(auto &x : r)
+			x = static_cast<int16>(x >> shift);
+		return FromInt16(r);
+	}
+	static MPT_FORCEINLINE i128 AddInt16(i128 a, i128 b) noexcept
+	{
+		auto ra = ToInt16(a), rb = ToInt16(b);
+		for(std::size_t i = 0; i < 8; i++)
+			ra[i] = static_cast<int16>(static_cast<uint16>(ra[i] + rb[i]));
+		return FromInt16(ra);
+	}
+	static MPT_FORCEINLINE i128 SubInt16(i128 a, i128 b) noexcept
+	{
+		auto ra = ToInt16(a), rb = ToInt16(b);
+		for(std::size_t i = 0; i < 8; i++)
+			ra[i] = static_cast<int16>(static_cast<uint16>(ra[i] - rb[i]));
+		return FromInt16(ra);
+	}
+	static MPT_FORCEINLINE i128 And(i128 a, i128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] &= b.v[i];
+		return a;
+	}
+	static MPT_FORCEINLINE i128 AddSaturateInt16(i128 a, i128 b) noexcept
+	{
+		auto ra = ToInt16(a), rb = ToInt16(b);
+		for(std::size_t i = 0; i < 8; i++)
+			ra[i] = mpt::saturate_cast<int16>(ra[i] + rb[i]);
+		return FromInt16(ra);
+	}
+	static MPT_FORCEINLINE i128 SubSaturateInt16(i128 a, i128 b) noexcept
+	{
+		auto ra = ToInt16(a), rb = ToInt16(b);
+		for(std::size_t i = 0; i < 8; i++)
+			ra[i] = mpt::saturate_cast<int16>(ra[i] - rb[i]);
+		return FromInt16(ra);
+	}
+	// Upper 16 bits of the 32-bit products
+	static MPT_FORCEINLINE i128 MulHighInt16(i128 a, i128 b) noexcept
+	{
+		auto ra = ToInt16(a), rb = ToInt16(b);
+		for(std::size_t i = 0; i < 8; i++)
+			ra[i] = static_cast<int16>((ra[i] * rb[i]) >> 16);
+		return FromInt16(ra);
+	}
+	// Multiply 16-bit lanes and add adjacent pairs of products into 32-bit lanes
+	static MPT_FORCEINLINE i128 MulAddInt16(i128 a, i128 b) noexcept
+	{
+		const auto ra = ToInt16(a), rb = ToInt16(b);
+		i128 r;
+		for(std::size_t i = 0; i < 4; i++)
+			r.v[i] = WrapInt32(int64(ra[i * 2] * rb[i * 2]) + int64(ra[i * 2 + 1] * rb[i * 2 + 1]));
+		return r;
+	}
+	// Saturate the 32-bit lanes of a and b to 16 bits, a going into the lower half of the result
+	static MPT_FORCEINLINE i128 PackSaturateInt32(i128 a, i128 b) noexcept
+	{
+		std::array<int16, 8> r;
+		for(std::size_t i = 0; i < 4; i++)
+		{
+			r[i] = mpt::saturate_cast<int16>(a.v[i]);
+			r[i + 4] = mpt::saturate_cast<int16>(b.v[i]);
+		}
+		return FromInt16(r);
+	}
+	// Interleave the lower halves of a and b
+	static MPT_FORCEINLINE i128 UnpackLowInt16(i128 a, i128 b) noexcept
+	{
+		const auto ra = ToInt16(a), rb = ToInt16(b);
+		return FromInt16({ra[0], rb[0], ra[1], rb[1], ra[2], rb[2], ra[3], rb[3]});
+	}
+	static MPT_FORCEINLINE i128 UnpackLowInt32(i128 a, i128 b) noexcept { return {{a.v[0], b.v[0], a.v[1], b.v[1]}}; }
+	static MPT_FORCEINLINE i128 UnpackLowInt64(i128 a, i128 b) noexcept { return {{a.v[0], a.v[1], b.v[0], b.v[1]}}; }
+	// Exchange the lower and upper 64 bits
+	static MPT_FORCEINLINE i128 SwapHalves(i128 a) noexcept { return {{a.v[2], a.v[3], a.v[0], a.v[1]}}; }
+	static MPT_FORCEINLINE i128 BroadcastLowInt32(i128 a) noexcept { return {{a.v[0], a.v[0], a.v[0], a.v[0]}}; }
+
+	static MPT_FORCEINLINE f128 LoadFloat(const float *p) noexcept
+	{
+		f128 r;
+		std::memcpy(r.v.data(), p, 16);
+		return r;
+	}
+	static MPT_FORCEINLINE void StoreFloat(float *p, f128 a) noexcept { std::memcpy(p, a.v.data(), 16); }
+	static MPT_FORCEINLINE f128 BroadcastFloat(float a) noexcept { return {{a, a, a, a}}; }
+	static MPT_FORCEINLINE f128 SetFloat(float a, float b, float c, float d) noexcept { return {{a, b, c, d}}; }
+	static MPT_FORCEINLINE f128 AddFloat(f128 a, f128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] += b.v[i];
+		return a;
+	}
+	static MPT_FORCEINLINE f128 SubFloat(f128 a, f128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] -= b.v[i];
+		return a;
+	}
+	static MPT_FORCEINLINE f128 MulFloat(f128 a, f128 b) noexcept
+	{
+		for(std::size_t i = 0; i < 4; i++)
+			a.v[i] *= b.v[i];
+		return a;
+	}
+};
+
+
+//////////////////////////////////////////////////////////////////////////
+// x86 SSE2
+
+#if defined(MPT_SIMD_SSE2)
+
+struct SSE2
+{
+	using i128 = __m128i;
+	using f128 = __m128;
+
+	static MPT_FORCEINLINE bool IsAvailable() noexcept { return CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse); }
+
+	static MPT_FORCEINLINE i128 Zero() noexcept { return _mm_setzero_si128(); }
+	static MPT_FORCEINLINE i128 SetInt32(int32 a, int32 b, int32 c, int32 d) noexcept { return _mm_setr_epi32(a, b, c, d); }
+	static MPT_FORCEINLINE i128 SetInt16(int16 a, int16 b, int16 c, int16 d, int16 e, int16 f, int16 g, int16 h) noexcept { return _mm_setr_epi16(a, b, c, d, e, f, g, h); }
+	static MPT_FORCEINLINE i128 BroadcastInt16(int16 a) noexcept { return _mm_set1_epi16(a); }
+	static MPT_FORCEINLINE i128 FromInt32(int32 a) noexcept { return _mm_cvtsi32_si128(a); }
+	static MPT_FORCEINLINE int32 ToInt32(i128 a) noexcept { return _mm_cvtsi128_si32(a); }
+
+	static MPT_FORCEINLINE i128 Load(const void *p) noexcept { return _mm_loadu_si128(static_cast<const __m128i *>(p)); }
+	static MPT_FORCEINLINE void Store(void *p, i128 a) noexcept { _mm_storeu_si128(static_cast<__m128i *>(p), a); }
+	static MPT_FORCEINLINE i128 LoadLow64(const void *p) noexcept { return _mm_loadl_epi64(static_cast<const __m128i *>(p)); }
+	static MPT_FORCEINLINE void StoreLow64(void *p, i128 a) noexcept { _mm_storel_epi64(static_cast<__m128i *>(p), a); }
+
+	static MPT_FORCEINLINE i128 AddInt32(i128 a, i128 b) noexcept { return _mm_add_epi32(a, b); }
+	static MPT_FORCEINLINE i128 SubInt32(i128 a, i128 b) noexcept { return _mm_sub_epi32(a, b); }
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt32(i128 a) noexcept { return _mm_srai_epi32(a, shift); }
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt16(i128 a) noexcept { return _mm_srai_epi16(a, shift); }
+	static MPT_FORCEINLINE i128 AddInt16(i128 a, i128 b) noexcept { return _mm_add_epi16(a, b); }
+	static MPT_FORCEINLINE i128 SubInt16(i128 a, i128 b) noexcept { return _mm_sub_epi16(a, b); }
+	static MPT_FORCEINLINE i128 And(i128 a, i128 b) noexcept { return _mm_and_si128(a, b); }
+	static MPT_FORCEINLINE i128 AddSaturateInt16(i128 a, i128 b) noexcept { return _mm_adds_epi16(a, b); }
+	static MPT_FORCEINLINE i128 SubSaturateInt16(i128 a, i128 b) noexcept { return _mm_subs_epi16(a, b); }
+	static MPT_FORCEINLINE i128 MulHighInt16(i128 a, i128 b) noexcept { return _mm_mulhi_epi16(a, b); }
+	static MPT_FORCEINLINE i128 MulAddInt16(i128 a, i128 b) noexcept { return _mm_madd_epi16(a, b); }
+	static MPT_FORCEINLINE i128 PackSaturateInt32(i128 a, i128 b) noexcept { return _mm_packs_epi32(a, b); }
+	static MPT_FORCEINLINE i128 UnpackLowInt16(i128 a, i128 b) noexcept { return _mm_unpacklo_epi16(a, b); }
+	static MPT_FORCEINLINE i128 UnpackLowInt32(i128 a, i128 b) noexcept { return _mm_unpacklo_epi32(a, b); }
+	static MPT_FORCEINLINE i128 UnpackLowInt64(i128 a, i128 b) noexcept { return _mm_unpacklo_epi64(a, b); }
+	static MPT_FORCEINLINE i128 SwapHalves(i128 a) noexcept { return _mm_shuffle_epi32(a, _MM_SHUFFLE(1, 0, 3, 2)); }
+	static MPT_FORCEINLINE i128 BroadcastLowInt32(i128 a) noexcept { return _mm_shuffle_epi32(a, _MM_SHUFFLE(0, 0, 0, 0)); }
+
+	static MPT_FORCEINLINE f128 LoadFloat(const float *p) noexcept { return _mm_loadu_ps(p); }
+	static MPT_FORCEINLINE void StoreFloat(float *p, f128 a) noexcept { _mm_storeu_ps(p, a); }
+	static MPT_FORCEINLINE f128 BroadcastFloat(float a) noexcept { return _mm_set1_ps(a); }
+	static MPT_FORCEINLINE f128 SetFloat(float a, float b, float c, float d) noexcept { return _mm_setr_ps(a, b, c, d); }
+	static MPT_FORCEINLINE f128 AddFloat(f128 a, f128 b) noexcept { return _mm_add_ps(a, b); }
+	static MPT_FORCEINLINE f128 SubFloat(f128 a, f128 b) noexcept { return _mm_sub_ps(a, b); }
+	static MPT_FORCEINLINE f128 MulFloat(f128 a, f128 b) noexcept { return _mm_mul_ps(a, b); }
+};
+
+using Native = SSE2;
+
+#endif // MPT_SIMD_SSE2
+
+
+//////////////////////////////////////////////////////////////////////////
+// ARM NEON
+
+#if defined(MPT_SIMD_NEON)
+
+struct NEON
+{
+	using i128 = int32x4_t;
+	using f128 = float32x4_t;
+
+	static MPT_FORCEINLINE bool IsAvailable() noexcept { return true; }
+
+	static MPT_FORCEINLINE int16x8_t As16(i128 a) noexcept { return vreinterpretq_s16_s32(a); }
+	static MPT_FORCEINLINE i128 From16(int16x8_t a) noexcept { return vreinterpretq_s32_s16(a); }
+
+	static MPT_FORCEINLINE i128 Zero() noexcept { return vdupq_n_s32(0); }
+	static MPT_FORCEINLINE i128 SetInt32(int32 a, int32 b, int32 c, int32 d) noexcept
+	{
+		alignas(16) const int32 v[4] = {a, b, c, d};
+		return vld1q_s32(v);
+	}
+	static MPT_FORCEINLINE i128 SetInt16(int16 a, int16 b, int16 c, int16 d, int16 e, int16 f, int16 g, int16 h) noexcept
+	{
+		alignas(16) const int16 v[8] = {a, b, c, d, e, f, g, h};
+		return From16(vld1q_s16(v));
+	}
+	static MPT_FORCEINLINE i128 BroadcastInt16(int16 a) noexcept { return From16(vdupq_n_s16(a)); }
+	static MPT_FORCEINLINE i128 FromInt32(int32 a) noexcept { return vsetq_lane_s32(a, vdupq_n_s32(0), 0); }
+	static MPT_FORCEINLINE int32 ToInt32(i128 a) noexcept { return vgetq_lane_s32(a, 0); }
+
+	static MPT_FORCEINLINE i128 Load(const void *p) noexcept { return vreinterpretq_s32_u8(vld1q_u8(static_cast<const uint8 *>(p))); }
+	static MPT_FORCEINLINE void Store(void *p, i128 a) noexcept { vst1q_u8(static_cast<uint8 *>(p), vreinterpretq_u8_s32(a)); }
+	static MPT_FORCEINLINE i128 LoadLow64(const void *p) noexcept { return vreinterpretq_s32_u8(vcombine_u8(vld1_u8(static_cast<const uint8 *>(p)), vdup_n_u8(0))); }
+	static MPT_FORCEINLINE void StoreLow64(void *p, i128 a) noexcept { vst1_u8(static_cast<uint8 *>(p), vget_low_u8(vreinterpretq_u8_s32(a))); }
+
+	static MPT_FORCEINLINE i128 AddInt32(i128 a, i128 b) noexcept { return vaddq_s32(a, b); }
+	static MPT_FORCEINLINE i128 SubInt32(i128 a, i128 b) noexcept { return vsubq_s32(a, b); }
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt32(i128 a) noexcept { return vshrq_n_s32(a, shift); }
+	template <int shift>
+	static MPT_FORCEINLINE i128 ShiftRightInt16(i128 a) noexcept { return From16(vshrq_n_s16(As16(a), shift)); }
+	static MPT_FORCEINLINE i128 AddInt16(i128 a, i128 b) noexcept { return From16(vaddq_s16(As16(a), As16(b))); }
+	static MPT_FORCEINLINE i128 SubInt16(i128 a, i128 b) noexcept { return From16(vsubq_s16(As16(a), As16(b))); }
+	static MPT_FORCEINLINE i128 And(i128 a, i128 b) noexcept { return vandq_s32(a, b); }
+	static MPT_FORCEINLINE i128 AddSaturateInt16(i128 a, i128 b) noexcept { return From16(vqaddq_s16(As16(a), As16(b))); }
+	static MPT_FORCEINLINE i128 SubSaturateInt16(i128 a, i128 b) noexcept { return From16(vqsubq_s16(As16(a), As16(b))); }
+	static MPT_FORCEINLINE i128 MulHighInt16(i128 a, i128 b) noexcept
+	{
+		const int32x4_t lo = vmull_s16(vget_low_s16(As16(a)), vget_low_s16(As16(b)));
+		const int32x4_t hi = vmull_s16(vget_high_s16(As16(a)), vget_high_s16(As16(b)));
+		return From16(vcombine_s16(vshrn_n_s32(lo, 16), vshrn_n_s32(hi, 16)));
+	}
+	static MPT_FORCEINLINE i128 MulAddInt16(i128 a, i128 b) noexcept
+	{
+		const int32x4_t lo = vmull_s16(vget_low_s16(As16(a)), vget_low_s16(As16(b)));
+		const int32x4_t hi = vmull_s16(vget_high_s16(As16(a)), vget_high_s16(As16(b)));
+		return vcombine_s32(vpadd_s32(vget_low_s32(lo), vget_high_s32(lo)), vpadd_s32(vget_low_s32(hi), vget_high_s32(hi)));
+	}
+	static MPT_FORCEINLINE i128 PackSaturateInt32(i128 a, i128 b) noexcept { return From16(vcombine_s16(vqmovn_s32(a), vqmovn_s32(b))); }
+	static MPT_FORCEINLINE i128 UnpackLowInt16(i128 a, i128 b) noexcept { return From16(vzipq_s16(As16(a), As16(b)).val[0]); }
+	static MPT_FORCEINLINE i128 UnpackLowInt32(i128 a, i128 b) noexcept { return vzipq_s32(a, b).val[0]; }
+	static MPT_FORCEINLINE i128 UnpackLowInt64(i128 a, i128 b) noexcept { return vcombine_s32(vget_low_s32(a), vget_low_s32(b)); }
+	static MPT_FORCEINLINE i128 SwapHalves(i128 a) noexcept { return vextq_s32(a, a, 2); }
+	static MPT_FORCEINLINE i128 BroadcastLowInt32(i128 a) noexcept { return vdupq_lane_s32(vget_low_s32(a), 0); }
+
+	static MPT_FORCEINLINE f128 LoadFloat(const float *p) noexcept { return vld1q_f32(p); }
+	static MPT_FORCEINLINE void StoreFloat(float *p, f128 a) noexcept { vst1q_f32(p, a); }
+	static MPT_FORCEINLINE f128 BroadcastFloat(float a) noexcept { return vdupq_n_f32(a); }
+	static MPT_FORCEINLINE f128 AddFloat(f128 a, f128 b) noexcept { return vaddq_f32(a, b); }
+	static MPT_FORCEINLINE f128 MulFloat(f128 a, f128 b) noexcept { return vmulq_f32(a, b); }
+};
+
+using Native = NEON;
+
+#endif // MPT_SIMD_NEON
+
+
+#if defined(MPT_SIMD_SSE2) || defined(MPT_SIMD_NEON)
+#define MPT_SIMD_NATIVE
+#endif
+
+
+}  // namespace SIMD
+
+
+OPENMPT_NAMESPACE_END
@@ -20,6 +20,8 @@
 #include "Sndfile.h"
 #include "MixerLoops.h"
 #include "MixFuncTable.h"
+#include "MixThreadPool.h"
+#include "OPL.h"
 #include "plugins/PlugInterface.h"
 #include <cfloat>  // For FLT_EPSILON
 #include <algorithm>
@@ -292,10 +294,10 @@ struct MixLoopState
 
 
 // Render count * number of channels samples
-void CSoundFile::CreateStereoMix(int count)
+CHANNELINDEX CSoundFile::CreateStereoMix(int count)
 {
 	if(!count)
-		return;
+		return 0;
 
 	// Resetting sound buffer
 	StereoFill(MixSoundBuffer, count, m_dryROfsVol, m_dryLOfsVol);
@@ -305,12 +307,220 @@ void CSoundFile::CreateStereoMix(int count)
 	// Channels that are actually mixed and not skipped (because they are paused or muted)
 	CHANNELINDEX numChannelsMixed = 0;
 
-	for(uint32 nChn = 0; nChn < m_nMixChannels; nChn++)
+#ifdef MPT_ENABLE_MIX_THREADS
+	// The parallel path decides for all voices up front whether they are mixed, which is only possible if the mix channel limit is either never or immediately hit.
+	bool mixParallel = m_mixThreadPool && m_nMixChannels > 1 && (m_MixerSettings.m_nMaxMixChannels >= m_nMixChannels || m_MixerSettings.m_nMaxMixChannels == 0);
+#ifdef MODPLUG_TRACKER
+	if(m_SamplePlayLengths != nullptr)
+		mixParallel = false;
+#endif  // MODPLUG_TRACKER
+	if(mixParallel)
+	{
+		numChannelsMixed = MixVoicesParallel(count);
+	} else
+#endif  // MPT_ENABLE_MIX_THREADS
 	{
-		if(MixChannel(count, m_PlayState.Chn[m_PlayState.ChnMix[nChn]], m_PlayState.ChnMix[nChn], numChannelsMixed < m_MixerSettings.m_nMaxMixChannels))
-			numChannelsMixed++;
+		for(uint32 nChn = 0; nChn < m_nMixChannels; nChn++)
+		{
+			if(MixChannel(count, m_PlayState.Chn[m_PlayState.ChnMix[nChn]], m_PlayState.ChnMix[nChn], numChannelsMixed < m_MixerSettings.m_nMaxMixChannels))
+				numChannelsMixed++;
+		}
 	}
 	m_nMixStat = std::max(m_nMixStat, numChannelsMixed);
+	return numChannelsMixed;
+}
+
+
+// A chunk is silent if no voice is audible, ramping or fading out a click-removal tail, and neither OPL, reverb nor plugins have anything left to render.
+// Everything that is skipped for such a chunk would only have added zeros to the mix buffers, so the result is bit-identical to a full mix.
+bool CSoundFile::IsMixSilent() const
+{
+	if(m_dryLOfsVol || m_dryROfsVol || m_surroundLOfsVol || m_surroundROfsVol)
+		return false;
+	if(m_MixerSettings.NumInputChannels > 0)
+		return false;
+	// Skipping the OPL emulator would desynchronize its envelopes and LFOs
+	if(m_opl && m_opl->IsRunning())
+		return false;
+#ifndef NO_REVERB
+	if(m_RvbROfsVol || m_RvbLOfsVol || m_Reverb.IsActive())
+		return false;
+#endif  // NO_REVERB
+
+#ifndef NO_PLUGINS
+	if(m_loadedPlugins)
+	{
+		// Mirror the decisions of ProcessPlugins: every plugin must either be skipped there or pass through silence.
+		bool masterHasInput = (m_nMixStat > 0), hasMasterEffect = false;
+		for(PLUGINDEX node = 0; node < m_pluginGraphSize; node++)
+		{
+			const SNDMIXPLUGIN &plugin = m_MixPlugins[m_pluginGraph[node].slot];
+			if(plugin.pMixPlugin->m_MixState.pMixBuffer == nullptr || !plugin.pMixPlugin->m_mixBuffer.Ok())
+				continue;
+			const SNDMIXPLUGINSTATE &state = plugin.pMixPlugin->m_MixState;
+			if(!plugin.pMixPlugin->IsSongPlaying() || state.nVolDecayL || state.nVolDecayR || (state.dwFlags & (SNDMIXPLUGINSTATE::psfMixReady | SNDMIXPLUGINSTATE::psfHasInput)))
+				return false;
+			const bool suspended = (state.dwFlags & SNDMIXPLUGINSTATE::psfSilenceBypass) && plugin.IsAutoSuspendable();
+			if(plugin.IsMasterEffect())
+			{
+				hasMasterEffect = true;
+			} else
+			{
+				if(!(state.dwFlags & SNDMIXPLUGINSTATE::psfSilenceBypass))
+					masterHasInput = true;
+				if(!plugin.pMixPlugin->ShouldProcessSilence() && !m_pluginGraph[node].hasInputs)
+					continue;
+			}
+			if(!plugin.IsBypassed() && !suspended)
+				return false;
+		}
+		// Master effects would be woken up by ProcessPlugins
+		if(hasMasterEffect && masterHasInput)
+			return false;
+	}
+#endif  // NO_PLUGINS
+
+	for(uint32 nChn = 0; nChn < m_nMixChannels; nChn++)
+	{
+		const CHANNELINDEX channel = m_PlayState.ChnMix[nChn];
+		const ModChannel &chn = m_PlayState.Chn[channel];
+		if(chn.nLOfs || chn.nROfs)
+			return false;
+		if(!chn.pCurrentSample)
+			continue;
+		if(!chn.isPaused && (chn.nRampLength || chn.leftVol || chn.rightVol))
+			return false;
+		// Silent voices still touch the buffers of the reverb and plugins they are routed to
+#ifndef NO_REVERB
+		if(((m_MixerSettings.DSPMask & SNDDSP_REVERB) && !chn.dwFlags[CHN_NOREVERB]) || chn.dwFlags[CHN_REVERB])
+			return false;
+#endif  // NO_REVERB
+#ifndef NO_PLUGINS
+		if(m_loadedPlugins && GetBestPlugin(chn, channel, PrioritiseInstrument, RespectMutes) != 0)
+			return false;
+#endif  // NO_PLUGINS
+	}
+	return true;
+}
+
+
+void CSoundFile::CreateSilentMix(int count)
+{
+	std::fill(MixSoundBuffer, MixSoundBuffer + count * 2, mixsample_t(0));
+	if(m_MixerSettings.gnChannels > 2)
+		std::fill(MixRearBuffer, MixRearBuffer + count * 2, mixsample_t(0));
+
+	// Inaudible voices still need to move on, so that they continue at the right position when they become audible again.
+	// Without a destination buffer and tail levels to update, MixVoice only advances their position and handles the end of the sample.
+	for(uint32 nChn = 0; nChn < m_nMixChannels; nChn++)
+	{
+		ModChannel &chn = m_PlayState.Chn[m_PlayState.ChnMix[nChn]];
+		if(chn.pCurrentSample)
+		{
+			mixsample_t ofsL = 0, ofsR = 0;
+			MixVoice(count, chn, MixSoundBuffer, ofsL, ofsR, false);
+		}
+	}
+}
+
+
+void CSoundFile::SetMixThreads(uint32 numThreads)
+{
+#ifdef MPT_ENABLE_MIX_THREADS
+	if(numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	numThreads = std::min(numThreads, static_cast<uint32>(MAX_CHANNELS));
+	if(numThreads == GetMixThreads())
+		return;
+	m_mixThreadPool.reset();
+	if(numThreads > 1)
+	{
+		// Allocate everything up front so that the mixer never has to.
+		// A few voice buffers per thread are enough to keep all threads busy; more voices are mixed in several batches.
+		constexpr uint32 VoicesPerThread = 4;
+		m_mixThreadPool = std::make_unique<MixThreadPool>(numThreads);
+		const uint32 batchSize = std::min(m_mixThreadPool->GetNumThreads() * VoicesPerThread, static_cast<uint32>(MAX_CHANNELS));
+		m_voiceMixTasks.reserve(MAX_CHANNELS);
+		m_voiceMixBuffer.assign(batchSize * MIXBUFFERSIZE * 2, 0);
+	} else
+	{
+		m_voiceMixTasks = {};
+		m_voiceMixBuffer = {};
+	}
+#else
+	MPT_UNREFERENCED_PARAMETER(numThreads);
+#endif  // MPT_ENABLE_MIX_THREADS
+}
+
+
+uint32 CSoundFile::GetMixThreads() const noexcept
+{
+#ifdef MPT_ENABLE_MIX_THREADS
+	if(m_mixThreadPool)
+		return m_mixThreadPool->GetNumThreads();
+#endif  // MPT_ENABLE_MIX_THREADS
+	return 1;
+}
+
+
+// Render every voice into its own zero-initialized buffer on the worker threads, then add the buffers to their destinations in voice order.
+// If there are more voices than scratch buffers, this happens in several batches.
+// Voices only touch their own ModChannel while rendering, and all shared state (destination buffers, tail levels, plugin state) is updated in the same order as in the serial path.
+// As the contribution of each voice to each sample point is a single addition in both cases, the output is bit-identical to mixing on one thread.
+// The only exception is the floating-point mixer, where the end-of-sample pop reduction level of a voice (nROfs / nLOfs) is measured against an empty buffer and may differ by rounding.
+CHANNELINDEX CSoundFile::MixVoicesParallel(int count)
+{
+#ifdef MPT_ENABLE_MIX_THREADS
+	const bool doMix = m_MixerSettings.m_nMaxMixChannels > 0;
+	m_voiceMixTasks.clear();
+	for(uint32 nChn = 0; nChn < m_nMixChannels; nChn++)
+	{
+		const CHANNELINDEX channel = m_PlayState.ChnMix[nChn];
+		ModChannel &chn = m_PlayState.Chn[channel];
+		if(chn.pCurrentSample || chn.nLOfs || chn.nROfs)
+			m_voiceMixTasks.push_back({&chn, PrepareVoiceMixRoute(count, chn, channel), 0, 0, false});
+	}
+
+	CHANNELINDEX numChannelsMixed = 0;
+	const size_t batchSize = m_voiceMixBuffer.size() / (MIXBUFFERSIZE * 2);
+	for(size_t firstTask = 0; firstTask < m_voiceMixTasks.size(); firstTask += batchSize)
+	{
+		const size_t numTasks = std::min(batchSize, m_voiceMixTasks.size() - firstTask);
+		const auto mixTask = [this, count, doMix, firstTask](uint32 task)
+		{
+			VoiceMixTask &voice = m_voiceMixTasks[firstTask + task];
+			mixsample_t *buffer = m_voiceMixBuffer.data() + task * MIXBUFFERSIZE * 2;
+			std::fill(buffer, buffer + count * 2, mixsample_t(0));
+			voice.mixed = MixVoice(count, *voice.chn, buffer, voice.ofsL, voice.ofsR, doMix);
+		};
+		m_mixThreadPool->Run(static_cast<uint32>(numTasks), mixTask);
+
+		for(size_t task = 0; task < numTasks; task++)
+		{
+			const VoiceMixTask &voice = m_voiceMixTasks[firstTask + task];
+			const mixsample_t *buffer = m_voiceMixBuffer.data() + task * MIXBUFFERSIZE * 2;
+			mixsample_t *dest = voice.route.buffer;
+			for(int i = 0; i < count * 2; i++)
+			{
+				dest[i] += buffer[i];
+			}
+			*voice.route.ofsL += voice.ofsL;
+			*voice.route.ofsR += voice.ofsR;
+			if(voice.mixed)
+			{
+				numChannelsMixed++;
+#ifndef NO_PLUGINS
+				if(voice.route.plugin > 0 && m_MixPlugins[voice.route.plugin - 1].pMixPlugin)
+					m_MixPlugins[voice.route.plugin - 1].pMixPlugin->ResetSilence();
+#endif  // NO_PLUGINS
+			}
+		}
+	}
+	return numChannelsMixed;
+#else
+	MPT_UNREFERENCED_PARAMETER(count);
+	return 0;
+#endif  // MPT_ENABLE_MIX_THREADS
 }
 
 
@@ -352,212 +562,280 @@ bool CSoundFile::MixChannel(int count, ModChannel &chn, CHANNELINDEX channel, bo
 {
 	if(chn.pCurrentSample || chn.nLOfs || chn.nROfs)
 	{
-		auto [pOfsL, pOfsR] = GetChannelOffsets(chn, channel);
+		const VoiceMixRoute route = PrepareVoiceMixRoute(count, chn, channel);
+		const bool addToMix = MixVoice(count, chn, route.buffer, *route.ofsL, *route.ofsR, doMix);
+#ifndef NO_PLUGINS
+		if(addToMix && route.plugin > 0 && m_MixPlugins[route.plugin - 1].pMixPlugin)
+		{
+			m_MixPlugins[route.plugin - 1].pMixPlugin->ResetSilence();
+		}
+#endif // NO_PLUGINS
+		return addToMix;
+	}
+	return false;
+}
 
-		uint32 functionNdx = MixFuncTable::ResamplingModeToMixFlags(static_cast<ResamplingMode>(chn.resamplingMode));
-		if(chn.dwFlags[CHN_16BIT]) functionNdx |= MixFuncTable::ndx16Bit;
-		if(chn.dwFlags[CHN_STEREO]) functionNdx |= MixFuncTable::ndxStereo;
-#ifndef NO_FILTER
-		if(chn.dwFlags[CHN_FILTER]) functionNdx |= MixFuncTable::ndxFilter;
-#endif
 
-		mixsample_t *pbuffer = MixSoundBuffer;
+// Find the buffer a voice is mixed into, and initialize that buffer if this is the first voice using it in this chunk
+CSoundFile::VoiceMixRoute CSoundFile::PrepareVoiceMixRoute(int count, const ModChannel &chn, CHANNELINDEX channel)
+{
+	auto [pOfsL, pOfsR] = GetChannelOffsets(chn, channel);
+	VoiceMixRoute route{MixSoundBuffer, pOfsL, pOfsR, 0};
+
 #ifndef NO_REVERB
-		if(((m_MixerSettings.DSPMask & SNDDSP_REVERB) && !chn.dwFlags[CHN_NOREVERB]) || chn.dwFlags[CHN_REVERB])
-		{
-			m_Reverb.TouchReverbSendBuffer(ReverbSendBuffer, m_RvbROfsVol, m_RvbLOfsVol, count);
-			pbuffer = ReverbSendBuffer;
-		}
+	if(((m_MixerSettings.DSPMask & SNDDSP_REVERB) && !chn.dwFlags[CHN_NOREVERB]) || chn.dwFlags[CHN_REVERB])
+	{
+		m_Reverb.TouchReverbSendBuffer(ReverbSendBuffer, m_RvbROfsVol, m_RvbLOfsVol, count);
+		route.buffer = ReverbSendBuffer;
+	}
 #endif
-		if(chn.dwFlags[CHN_SURROUND] && m_MixerSettings.gnChannels > 2)
-		{
-			pbuffer = MixRearBuffer;
-		}
+	if(chn.dwFlags[CHN_SURROUND] && m_MixerSettings.gnChannels > 2)
+	{
+		route.buffer = MixRearBuffer;
+	}
 
-		// Look for plugins associated with this implicit tracker channel.
+	// Look for plugins associated with this implicit tracker channel.
 #ifndef NO_PLUGINS
-		const PLUGINDEX mixPlugin = GetBestPlugin(chn, channel, PrioritiseInstrument, RespectMutes);
-		if((mixPlugin > 0) && (mixPlugin <= MAX_MIXPLUGINS) && m_MixPlugins[mixPlugin - 1].pMixPlugin != nullptr)
+	const PLUGINDEX mixPlugin = GetBestPlugin(chn, channel, PrioritiseInstrument, RespectMutes);
+	if(mixPlugin > 0 && mixPlugin <= MAX_MIXPLUGINS && m_MixPlugins[mixPlugin - 1].pMixPlugin != nullptr)
+	{
+		route.plugin = mixPlugin;
+		// Render into plugin buffer instead of global buffer
+		SNDMIXPLUGINSTATE &mixState = m_MixPlugins[mixPlugin - 1].pMixPlugin->m_MixState;
+		if (mixState.pMixBuffer)
 		{
-			// Render into plugin buffer instead of global buffer
-			SNDMIXPLUGINSTATE &mixState = m_MixPlugins[mixPlugin - 1].pMixPlugin->m_MixState;
-			if (mixState.pMixBuffer)
+			route.buffer = mixState.pMixBuffer;
+			if (!(mixState.dwFlags & SNDMIXPLUGINSTATE::psfMixReady))
 			{
-				pbuffer = mixState.pMixBuffer;
-				if (!(mixState.dwFlags & SNDMIXPLUGINSTATE::psfMixReady))
-				{
-					StereoFill(pbuffer, count, *pOfsR, *pOfsL);
-					mixState.dwFlags |= SNDMIXPLUGINSTATE::psfMixReady;
-				}
+				StereoFill(route.buffer, count, *pOfsR, *pOfsL);
+				mixState.dwFlags |= SNDMIXPLUGINSTATE::psfMixReady;
 			}
 		}
+	}
 #endif // NO_PLUGINS
+	return route;
+}
 
-		if(chn.isPaused)
-		{
-			EndChannelOfs(chn, pbuffer, count);
-			*pOfsR += chn.nROfs;
-			*pOfsL += chn.nLOfs;
-			chn.nROfs = chn.nLOfs = 0;
-			return false;
-		}
 
-		MixLoopState mixLoopState(*this, chn);
+// Render a voice into pbuffer. Only modifies the voice itself, the buffer and the given tail levels, so that different voices can be mixed concurrently.
+bool CSoundFile::MixVoice(int count, ModChannel &chn, mixsample_t *pbuffer, mixsample_t &ofsL, mixsample_t &ofsR, bool doMix) const
+{
+	uint32 functionNdx = MixFuncTable::ResamplingModeToMixFlags(static_cast<ResamplingMode>(chn.resamplingMode));
+	if(chn.dwFlags[CHN_16BIT]) functionNdx |= MixFuncTable::ndx16Bit;
+	if(chn.dwFlags[CHN_STEREO]) functionNdx |= MixFuncTable::ndxStereo;
+#ifndef NO_FILTER
+	if(chn.dwFlags[CHN_FILTER]) functionNdx |= MixFuncTable::ndxFilter;
+#endif
+	const MixFuncInterface *mixFunctions = m_mixFunctions;
+
+	if(chn.isPaused)
+	{
+		EndChannelOfs(chn, pbuffer, count);
+		ofsR += chn.nROfs;
+		ofsL += chn.nLOfs;
+		chn.nROfs = chn.nLOfs = 0;
+		return false;
+	}
+
+	MixLoopState mixLoopState(*this, chn);
 
-		////////////////////////////////////////////////////
-		bool addToMix = false;
-		int nsamples = count;
-		// Keep mixing this sample until the buffer is filled.
-		do
+	////////////////////////////////////////////////////
+	bool addToMix = false;
+	int nsamples = count;
+	// Keep mixing this sample until the buffer is filled.
+	do
+	{
+		uint32 nrampsamples = nsamples;
+		int32 nSmpCount;
+		if(chn.nRampLength > 0)
 		{
-			uint32 nrampsamples = nsamples;
-			int32 nSmpCount;
-			if(chn.nRampLength > 0)
-			{
-				if (nrampsamples > chn.nRampLength) nrampsamples = chn.nRampLength;
-			}
+			if (nrampsamples > chn.nRampLength) nrampsamples = chn.nRampLength;
+		}
 
-			if((nSmpCount = mixLoopState.GetSampleCount(chn, nrampsamples)) <= 0)
-			{
-				// Stopping the channel
-				chn.pCurrentSample = nullptr;
-				chn.nLength = 0;
-				chn.position.Set(0);
-				chn.nRampLength = 0;
-				EndChannelOfs(chn, pbuffer, nsamples);
-				*pOfsR += chn.nROfs;
-				*pOfsL += chn.nLOfs;
-				chn.nROfs = chn.nLOfs = 0;
-				chn.dwFlags.reset(CHN_PINGPONGFLAG);
-				break;
-			}
+		if((nSmpCount = mixLoopState.GetSampleCount(chn, nrampsamples)) <= 0)
+		{
+			// Stopping the channel
+			chn.pCurrentSample = nullptr;
+			chn.nLength = 0;
+			chn.position.Set(0);
+			chn.nRampLength = 0;
+			EndChannelOfs(chn, pbuffer, nsamples);
+			ofsR += chn.nROfs;
+			ofsL += chn.nLOfs;
+			chn.nROfs = chn.nLOfs = 0;
+			chn.dwFlags.reset(CHN_PINGPONGFLAG);
+			break;
+		}
 
-			// Should we mix this channel?
-			if(!doMix                                                   // Too many channels
-			   || (!chn.nRampLength && !(chn.leftVol | chn.rightVol)))  // Channel is completely silent
+		// Should we mix this channel?
+		if(!doMix                                                   // Too many channels
+		   || (!chn.nRampLength && !(chn.leftVol | chn.rightVol)))  // Channel is completely silent
+		{
+			chn.position += chn.increment * nSmpCount;
+			chn.nROfs = chn.nLOfs = 0;
+			pbuffer += nSmpCount * 2;
+			addToMix = false;
+		}
+#ifdef MODPLUG_TRACKER
+		else if(m_SamplePlayLengths != nullptr)
+		{
+			// Detecting the longest play time for each sample for optimization
+			SmpLength pos = chn.position.GetUInt();
+			chn.position += chn.increment * nSmpCount;
+			if(!chn.increment.IsNegative())
 			{
-				chn.position += chn.increment * nSmpCount;
-				chn.nROfs = chn.nLOfs = 0;
-				pbuffer += nSmpCount * 2;
-				addToMix = false;
+				pos = chn.position.GetUInt();
 			}
-#ifdef MODPLUG_TRACKER
-			else if(m_SamplePlayLengths != nullptr)
+			size_t smp = std::distance(static_cast<const ModSample*>(static_cast<std::decay<decltype(Samples)>::type>(Samples)), chn.pModSample);
+			if(smp < m_SamplePlayLengths->size())
 			{
-				// Detecting the longest play time for each sample for optimization
-				SmpLength pos = chn.position.GetUInt();
-				chn.position += chn.increment * nSmpCount;
-				if(!chn.increment.IsNegative())
-				{
-					pos = chn.position.GetUInt();
-				}
-				size_t smp = std::distance(static_cast<const ModSample*>(static_cast<std::decay<decltype(Samples)>::type>(Samples)), chn.pModSample);
-				if(smp < m_SamplePlayLengths->size())
-				{
-					(*m_SamplePlayLengths)[smp] = std::max((*m_SamplePlayLengths)[smp], pos);
-				}
+				(*m_SamplePlayLengths)[smp] = std::max((*m_SamplePlayLengths)[smp], pos);
 			}
+		}
 #endif
-			else
-			{
-				// Do mixing
-				mixsample_t *pbufmax = pbuffer + (nSmpCount * 2);
-				chn.nROfs = -*(pbufmax - 2);
-				chn.nLOfs = -*(pbufmax - 1);
+		else
+		{
+			// Do mixing
+			mixsample_t *pbufmax = pbuffer + (nSmpCount * 2);
+			chn.nROfs = -*(pbufmax - 2);
+			chn.nLOfs = -*(pbufmax - 1);
 
 #ifdef MPT_BUILD_DEBUG
-				SamplePosition targetpos = chn.position + chn.increment * nSmpCount;
+			SamplePosition targetpos = chn.position + chn.increment * nSmpCount;
 #endif
-				MixFuncTable::Functions[functionNdx | (chn.nRampLength ? MixFuncTable::ndxRamp : 0)](chn, m_Resampler, pbuffer, nSmpCount);
+			mixFunctions[functionNdx | (chn.nRampLength ? MixFuncTable::ndxRamp : 0)](chn, m_Resampler, pbuffer, nSmpCount);
 #ifdef MPT_BUILD_DEBUG
-				MPT_ASSERT(chn.position.GetUInt() == targetpos.GetUInt());
+			MPT_ASSERT(chn.position.GetUInt() == targetpos.GetUInt());
 #endif
 
-				chn.nROfs += *(pbufmax - 2);
-				chn.nLOfs += *(pbufmax - 1);
-				pbuffer = pbufmax;
-				addToMix = true;
-			}
+			chn.nROfs += *(pbufmax - 2);
+			chn.nLOfs += *(pbufmax - 1);
+			pbuffer = pbufmax;
+			addToMix = true;
+		}
 
-			nsamples -= nSmpCount;
-			if (chn.nRampLength)
+		nsamples -= nSmpCount;
+		if (chn.nRampLength)
+		{
+			if (chn.nRampLength <= static_cast<uint32>(nSmpCount))
 			{
-				if (chn.nRampLength <= static_cast<uint32>(nSmpCount))
-				{
-					// Ramping is done
-					chn.nRampLength = 0;
-					chn.leftVol = chn.newLeftVol;
-					chn.rightVol = chn.newRightVol;
-					chn.rightRamp = chn.leftRamp = 0;
-					if(chn.dwFlags[CHN_NOTEFADE] && !chn.nFadeOutVol)
-					{
-						chn.nLength = 0;
-						chn.pCurrentSample = nullptr;
-					}
-				} else
+				// Ramping is done
+				chn.nRampLength = 0;
+				chn.leftVol = chn.newLeftVol;
+				chn.rightVol = chn.newRightVol;
+				chn.rightRamp = chn.leftRamp = 0;
+				if(chn.dwFlags[CHN_NOTEFADE] && !chn.nFadeOutVol)
 				{
-					chn.nRampLength -= nSmpCount;
+					chn.nLength = 0;
+					chn.pCurrentSample = nullptr;
 				}
+			} else
+			{
+				chn.nRampLength -= nSmpCount;
 			}
+		}
 
-			const bool pastLoopEnd = chn.position.GetUInt() >= chn.nLoopEnd && chn.dwFlags[CHN_LOOP];
-			const bool pastSampleEnd = chn.position.GetUInt() >= chn.nLength && !chn.dwFlags[CHN_LOOP] && chn.nLength && !chn.nMasterChn;
-			const bool doSampleSwap = m_playBehaviour[kMODSampleSwap] && chn.swapSampleIndex && chn.swapSampleIndex <= GetNumSamples() && chn.pModSample != &Samples[chn.swapSampleIndex];
-			if((pastLoopEnd || pastSampleEnd) && doSampleSwap)
-			{
-				// ProTracker compatibility: Instrument changes without a note do not happen instantly, but rather when the sample loop has finished playing.
-				// Test case: PTInstrSwap.mod, PTSwapNoLoop.mod
+		const bool pastLoopEnd = chn.position.GetUInt() >= chn.nLoopEnd && chn.dwFlags[CHN_LOOP];
+		const bool pastSampleEnd = chn.position.GetUInt() >= chn.nLength && !chn.dwFlags[CHN_LOOP] && chn.nLength && !chn.nMasterChn;
+		const bool doSampleSwap = m_playBehaviour[kMODSampleSwap] && chn.swapSampleIndex && chn.swapSampleIndex <= GetNumSamples() && chn.pModSample != &Samples[chn.swapSampleIndex];
+		if((pastLoopEnd || pastSampleEnd) && doSampleSwap)
+		{
+			// ProTracker compatibility: Instrument changes without a note do not happen instantly, but rather when the sample loop has finished playing.
+			// Test case: PTInstrSwap.mod, PTSwapNoLoop.mod
 #ifdef MODPLUG_TRACKER
-				if(m_SamplePlayLengths != nullptr)
+			if(m_SamplePlayLengths != nullptr)
+			{
+				// Even if the sample was playing at zero volume, we need to retain its full length for correct sample swap timing
+				size_t smp = std::distance(static_cast<const ModSample *>(static_cast<std::decay<decltype(Samples)>::type>(Samples)), chn.pModSample);
+				if(smp < m_SamplePlayLengths->size())
 				{
-					// Even if the sample was playing at zero volume, we need to retain its full length for correct sample swap timing
-					size_t smp = std::distance(static_cast<const ModSample *>(static_cast<std::decay<decltype(Samples)>::type>(Samples)), chn.pModSample);
-					if(smp < m_SamplePlayLengths->size())
-					{
-						(*m_SamplePlayLengths)[smp] = std::max((*m_SamplePlayLengths)[smp], std::min(chn.nLength, chn.position.GetUInt()));
-					}
+					(*m_SamplePlayLengths)[smp] = std::max((*m_SamplePlayLengths)[smp], std::min(chn.nLength, chn.position.GetUInt()));
 				}
-#endif
-				const ModSample &smp = Samples[chn.swapSampleIndex];
-				chn.pModSample = &smp;
-				chn.pCurrentSample = smp.samplev();
-				chn.dwFlags = (chn.dwFlags & CHN_CHANNELFLAGS) | smp.uFlags;
-				if(smp.uFlags[CHN_LOOP])
-					chn.nLength = smp.nLoopEnd;
-				else if(!m_playBehaviour[kMODOneShotLoops])
-					chn.nLength = smp.nLength;
-				else
-					chn.nLength = 0; // non-looping sample continue in oneshot mode (i.e. they will most probably just play silence)
-				chn.nLoopStart = smp.nLoopStart;
-				chn.nLoopEnd = smp.nLoopEnd;
-				chn.position.SetInt(chn.nLoopStart);
-				chn.swapSampleIndex = 0;
-				mixLoopState.UpdateLookaheadPointers(chn);
-				if(!chn.pCurrentSample)
-					break;
-			} else if(pastLoopEnd && !doSampleSwap && m_playBehaviour[kMODOneShotLoops] && chn.nLoopStart == 0)
-			{
-				// ProTracker "oneshot" loops (if loop start is 0, play the whole sample once and then repeat until loop end)
-				chn.position.SetInt(0);
-				chn.nLoopEnd = chn.nLength = chn.pModSample->nLoopEnd;
 			}
-		} while(nsamples > 0);
+#endif
+			const ModSample &smp = Samples[chn.swapSampleIndex];
+			chn.pModSample = &smp;
+			chn.pCurrentSample = smp.samplev();
+			chn.dwFlags = (chn.dwFlags & CHN_CHANNELFLAGS) | smp.uFlags;
+			if(smp.uFlags[CHN_LOOP])
+				chn.nLength = smp.nLoopEnd;
+			else if(!m_playBehaviour[kMODOneShotLoops])
+				chn.nLength = smp.nLength;
+			else
+				chn.nLength = 0; // non-looping sample continue in oneshot mode (i.e. they will most probably just play silence)
+			chn.nLoopStart = smp.nLoopStart;
+			chn.nLoopEnd = smp.nLoopEnd;
+			chn.position.SetInt(chn.nLoopStart);
+			chn.swapSampleIndex = 0;
+			mixLoopState.UpdateLookaheadPointers(chn);
+			if(!chn.pCurrentSample)
+				break;
+		} else if(pastLoopEnd && !doSampleSwap && m_playBehaviour[kMODOneShotLoops] && chn.nLoopStart == 0)
+		{
+			// ProTracker "oneshot" loops (if loop start is 0, play the whole sample once and then repeat until loop end)
+			chn.position.SetInt(0);
+			chn.nLoopEnd = chn.nLength = chn.pModSample->nLoopEnd;
+		}
+	} while(nsamples > 0);
+
+	// Restore sample pointer in case it got changed through loop wrap-around
+	chn.pCurrentSample = mixLoopState.samplePointer;
+	return addToMix;
+}
+
 
-		// Restore sample pointer in case it got changed through loop wrap-around
-		chn.pCurrentSample = mixLoopState.samplePointer;
-	
 #ifndef NO_PLUGINS
-		if(addToMix && mixPlugin > 0 && mixPlugin <= MAX_MIXPLUGINS && m_MixPlugins[mixPlugin - 1].pMixPlugin)
+
+void CSoundFile::UpdatePluginGraph()
+{
+	if(!m_pluginGraphDirty)
+	{
+		for(PLUGINDEX node = 0; node < m_pluginGraphSize; node++)
+		{
+			const SNDMIXPLUGIN &plugin = m_MixPlugins[m_pluginGraph[node].slot];
+			if(plugin.pMixPlugin == nullptr || plugin.Info.dwOutputRouting != m_pluginGraph[node].outputRouting)
+			{
+				m_pluginGraphDirty = true;
+				break;
+			}
+		}
+		if(!m_pluginGraphDirty)
+			return;
+	}
+
+	// Routing to a lower slot is ignored, and so is routing from empty slots, except for deciding whether a plugin has any input.
+	std::bitset<MAX_MIXPLUGINS> hasInputs;
+	for(PLUGINDEX plug = 0; plug < MAX_MIXPLUGINS; plug++)
+	{
+		const PLUGINDEX output = m_MixPlugins[plug].GetOutputPlugin();
+		if(output > plug && output < MAX_MIXPLUGINS)
+			hasInputs.set(output);
+	}
+	m_pluginGraphSize = 0;
+	for(PLUGINDEX plug = 0; plug < MAX_MIXPLUGINS; plug++)
+	{
+		const SNDMIXPLUGIN &plugin = m_MixPlugins[plug];
+		if(plugin.pMixPlugin == nullptr)
+			continue;
+		PluginGraphNode &node = m_pluginGraph[m_pluginGraphSize++];
+		node.outputRouting = plugin.Info.dwOutputRouting;
+		node.slot = plug;
+		node.output = PLUGINDEX_INVALID;
+		if(!plugin.IsOutputToMaster())
 		{
-			m_MixPlugins[mixPlugin - 1].pMixPlugin->ResetSilence();
+			const PLUGINDEX output = plugin.GetOutputPlugin();
+			if(output > plug && output < MAX_MIXPLUGINS && m_MixPlugins[output].pMixPlugin != nullptr)
+				node.output = output;
 		}
-#endif // NO_PLUGINS
-		return addToMix;
+		node.hasInputs = hasInputs[plug];
 	}
-	return false;
+	m_pluginGraphDirty = false;
 }
 
+#endif // NO_PLUGINS
+
 
+// Plugins are processed in the order of the plugin graph, see UpdatePluginGraph
 void CSoundFile::ProcessPlugins(uint32 nCount)
 {
 #ifndef NO_PLUGINS
@@ -570,11 +848,10 @@ void CSoundFile::ProcessPlugins(uint32 nCount)
 #endif // MPT_INTMIXER
 
 	// Setup float inputs from samples
-	for(PLUGINDEX plug = 0; plug < MAX_MIXPLUGINS; plug++)
+	for(PLUGINDEX node = 0; node < m_pluginGraphSize; node++)
 	{
-		SNDMIXPLUGIN &plugin = m_MixPlugins[plug];
-		if(plugin.pMixPlugin != nullptr
-			&& plugin.pMixPlugin->m_MixState.pMixBuffer != nullptr
+		SNDMIXPLUGIN &plugin = m_MixPlugins[m_pluginGraph[node].slot];
+		if(plugin.pMixPlugin->m_MixState.pMixBuffer != nullptr
 			&& plugin.pMixPlugin->m_mixBuffer.Ok())
 		{
 			IMixPlugin *mixPlug = plugin.pMixPlugin;
@@ -633,11 +910,11 @@ void CSoundFile::ProcessPlugins(uint32 nCount)
 	const bool positionChanged = HasPositionChanged();
 
 	// Process Plugins
-	for(PLUGINDEX plug = 0; plug < MAX_MIXPLUGINS; plug++)
+	for(PLUGINDEX node = 0; node < m_pluginGraphSize; node++)
 	{
-		SNDMIXPLUGIN &plugin = m_MixPlugins[plug];
-		if (plugin.pMixPlugin != nullptr
-			&& plugin.pMixPlugin->m_MixState.pMixBuffer != nullptr
+		const PluginGraphNode &graphNode = m_pluginGraph[node];
+		SNDMIXPLUGIN &plugin = m_MixPlugins[graphNode.slot];
+		if (plugin.pMixPlugin->m_MixState.pMixBuffer != nullptr
 			&& plugin.pMixPlugin->m_mixBuffer.Ok())
 		{
 			IMixPlugin *pObject = plugin.pMixPlugin;
@@ -645,16 +922,7 @@ void CSoundFile::ProcessPlugins(uint32 nCount)
 			{
 				// If plugin has no inputs and isn't a master plugin, we shouldn't let it process silence if possible.
 				// I have yet to encounter a VST plugin which actually sets this flag.
-				bool hasInput = false;
-				for(PLUGINDEX inPlug = 0; inPlug < plug; inPlug++)
-				{
-					if(m_MixPlugins[inPlug].GetOutputPlugin() == plug)
-					{
-						hasInput = true;
-						break;
-					}
-				}
-				if(!hasInput)
+				if(!graphNode.hasInputs)
 				{
 					continue;
 				}
@@ -674,20 +942,15 @@ void CSoundFile::ProcessPlugins(uint32 nCount)
 			float *pOutL = pMixL;
 			float *pOutR = pMixR;
 
-			if (!plugin.IsOutputToMaster())
+			if (graphNode.output != PLUGINDEX_INVALID)
 			{
-				PLUGINDEX nOutput = plugin.GetOutputPlugin();
-				if(nOutput > plug && nOutput < MAX_MIXPLUGINS
-					&& m_MixPlugins[nOutput].pMixPlugin != nullptr)
-				{
-					IMixPlugin *outPlugin = m_MixPlugins[nOutput].pMixPlugin;
-					if(!(state.dwFlags & SNDMIXPLUGINSTATE::psfSilenceBypass)) outPlugin->ResetSilence();
+				IMixPlugin *outPlugin = m_MixPlugins[graphNode.output].pMixPlugin;
+				if(!(state.dwFlags & SNDMIXPLUGINSTATE::psfSilenceBypass)) outPlugin->ResetSilence();
 
-					if(outPlugin->m_mixBuffer.Ok())
-					{
-						pOutL = outPlugin->m_mixBuffer.GetInputBuffer(0);
-						pOutR = outPlugin->m_mixBuffer.GetInputBuffer(1);
-					}
+				if(outPlugin->m_mixBuffer.Ok())
+				{
+					pOutL = outPlugin->m_mixBuffer.GetInputBuffer(0);
+					pOutR = outPlugin->m_mixBuffer.GetInputBuffer(1);
 				}
 			}
 
@@ -725,7 +988,7 @@ void CSoundFile::ProcessPlugins(uint32 nCount)
 					// Samples or plugins are being rendered, so turn off auto-bypass for this master effect.
 					if(plugin.pMixPlugin != nullptr) plugin.pMixPlugin->ResetSilence();
 					SNDMIXPLUGIN *chain = &plugin;
-					PLUGINDEX out = chain->GetOutputPlugin(), prevOut = plug;
+					PLUGINDEX out = chain->GetOutputPlugin(), prevOut = graphNode.slot;
 					while(out > prevOut && out < MAX_MIXPLUGINS)
 					{
 						chain = &m_MixPlugins[out];
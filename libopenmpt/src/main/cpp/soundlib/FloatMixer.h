@@ -12,14 +12,19 @@
 
 #include "openmpt/all/BuildSettings.hpp"
 
-#include "MixerInterface.h"
 #include "Resampler.h"
+#include "MixerInterface.h"
+#include "Paula.h"
 
 OPENMPT_NAMESPACE_BEGIN
 
 template<int channelsOut, int channelsIn, typename out, typename in, int int2float>
 struct IntToFloatTraits : public MixerTraits<channelsOut, channelsIn, out, in>
 {
+	using base_t = MixerTraits<channelsOut, channelsIn, out, in>;
+	using input_t = typename base_t::input_t;
+	using output_t = typename base_t::output_t;
+
 	static_assert(std::numeric_limits<input_t>::is_integer, "Input must be integer");
 	static_assert(!std::numeric_limits<output_t>::is_integer, "Output must be floating point");
 
@@ -27,6 +32,12 @@ struct IntToFloatTraits : public MixerTraits<channelsOut, channelsIn, out, in>
 	{
 		return static_cast<output_t>(x) * (static_cast<output_t>(1) / static_cast<output_t>(int2float));
 	}
+
+	// Input sample scaled to 16 bits, as expected by the Paula emulation
+	static MPT_CONSTEXPRINLINE int32 ConvertInt16(const input_t x)
+	{
+		return static_cast<int32>(x) * (1 << (16 - sizeof(input_t) * 8));
+	}
 };
 
 using Int8MToFloatS = IntToFloatTraits<2, 1, mixsample_t, int8,  -int8_min>;
@@ -38,12 +49,78 @@ using Int16SToFloatS  = IntToFloatTraits<2, 2, mixsample_t, int16, -int16_min>;
 //////////////////////////////////////////////////////////////////////////
 // Interpolation templates
 
+
+template<class Traits>
+struct AmigaBlepInterpolation
+{
+	SamplePosition subIncrement;
+	Paula::State &paula;
+	const Paula::BlepArray &WinSincIntegral;
+	const int numSteps;
+	unsigned int remainingSamples = 0;
+
+	MPT_FORCEINLINE AmigaBlepInterpolation(ModChannel &chn, const CResampler &resampler, unsigned int numSamples)
+		: paula{chn.paulaState}
+		, WinSincIntegral{resampler.blepTables.GetAmigaTable(resampler.m_Settings.emulateAmiga, chn.dwFlags[CHN_AMIGAFILTER])}
+		, numSteps{chn.paulaState.numSteps}
+	{
+		if(numSteps)
+		{
+			subIncrement = chn.increment / numSteps;
+			// May we read past the start or end of sample if we do partial sample increments?
+			// If that's the case, don't apply any sub increments on the source sample if we reached the last output sample
+			// Note that this should only happen with notes well outside the Amiga note range, e.g. in software-mixed formats like MED
+			const int32 targetPos = (chn.position + chn.increment * numSamples).GetInt();
+			if(static_cast<SmpLength>(targetPos) > chn.nLength)
+				remainingSamples = numSamples;
+		}
+	}
+
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
+	{
+		if(--remainingSamples == 0)
+			subIncrement = {};
+
+		SamplePosition pos(0, posLo);
+		// First, process steps of full length (one Amiga clock interval)
+		for(int step = numSteps; step > 0; step--)
+		{
+			int32 inSample = 0;
+			int32 posInt = pos.GetInt() * Traits::numChannelsIn;
+			for(int32 i = 0; i < Traits::numChannelsIn; i++)
+				inSample += Traits::ConvertInt16(inBuffer[posInt + i]);
+			paula.InputSample(static_cast<int16>(inSample / (4 * Traits::numChannelsIn)));
+			paula.Clock(Paula::MINIMUM_INTERVAL);
+			pos += subIncrement;
+		}
+		paula.remainder += paula.stepRemainder;
+
+		// Now, process any remaining integer clock amount < MINIMUM_INTERVAL
+		uint32 remainClocks = paula.remainder.GetInt();
+		if(remainClocks)
+		{
+			int32 inSample = 0;
+			int32 posInt = pos.GetInt() * Traits::numChannelsIn;
+			for(int32 i = 0; i < Traits::numChannelsIn; i++)
+				inSample += Traits::ConvertInt16(inBuffer[posInt + i]);
+			paula.InputSample(static_cast<int16>(inSample / (4 * Traits::numChannelsIn)));
+			paula.Clock(remainClocks);
+			paula.remainder.RemoveInt();
+		}
+
+		auto out = paula.OutputSample(WinSincIntegral);
+		for(int i = 0; i < Traits::numChannelsOut; i++)
+			outSample[i] = out;
+	}
+};
+
+
 template<class Traits>
 struct LinearInterpolation
 {
 	MPT_FORCEINLINE LinearInterpolation(const ModChannel &, const CResampler &, unsigned int) { }
 
-	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const inBuffer, const uint32 posLo)
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
 	{
 		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
 		const typename Traits::output_t fract = posLo / static_cast<typename Traits::output_t>(0x100000000); //CResampler::LinearTablef[posLo >> 24];
@@ -62,12 +139,17 @@ struct LinearInterpolation
 template<class Traits>
 struct FastSincInterpolation
 {
-	MPT_FORCEINLINE FastSincInterpolation(const ModChannel &, const CResampler &, unsigned int) { }
+	const typename Traits::output_t *FastSincTable;
+
+	MPT_FORCEINLINE FastSincInterpolation(const ModChannel &, const CResampler &resampler, unsigned int)
+	{
+		FastSincTable = resampler.FastSincTablef;
+	}
 
-	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const inBuffer, const uint32 posLo)
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
 	{
 		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
-		const typename Traits::output_t *lut = CResampler::FastSincTablef + ((posLo >> 22) & 0x3FC);
+		const typename Traits::output_t *lut = FastSincTable + ((posLo >> 22) & 0x3FC);
 
 		for(int i = 0; i < Traits::numChannelsIn; i++)
 		{
@@ -88,11 +170,11 @@ struct PolyphaseInterpolation
 
 	MPT_FORCEINLINE PolyphaseInterpolation(const ModChannel &chn, const CResampler &resampler, unsigned int)
 	{
-		sinc = (((chn.increment > SamplePosition(0x130000000ll)) || (chn.increment < -SamplePosition(-0x130000000ll))) ?
+		sinc = (((chn.increment > SamplePosition(0x130000000ll)) || (chn.increment < SamplePosition(-0x130000000ll))) ?
 			(((chn.increment > SamplePosition(0x180000000ll)) || (chn.increment < SamplePosition(-0x180000000ll))) ? resampler.gDownsample2x : resampler.gDownsample13x) : resampler.gKaiserSinc);
 	}
 
-	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const inBuffer, const uint32 posLo)
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
 	{
 		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
 		const typename Traits::output_t *lut = sinc + ((posLo >> (32 - SINC_PHASES_BITS)) & SINC_MASK) * SINC_WIDTH;
@@ -123,7 +205,7 @@ struct FIRFilterInterpolation
 		WFIRlut = resampler.m_WindowedFIR.lut;
 	}
 
-	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const inBuffer, const uint32 posLo)
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
 	{
 		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
 		const typename Traits::output_t * const lut = WFIRlut + ((((posLo >> 16) + WFIR_FRACHALVE) >> WFIR_FRACSHIFT) & WFIR_FRACMASK);
@@ -154,8 +236,8 @@ struct NoRamp
 
 	MPT_FORCEINLINE NoRamp(const ModChannel &chn)
 	{
-		lVol = static_cast<Traits::output_t>(chn.leftVol) * (1.0f / 4096.0f);
-		rVol = static_cast<Traits::output_t>(chn.rightVol) * (1.0f / 4096.0f);
+		lVol = static_cast<typename Traits::output_t>(chn.leftVol) * (1.0f / 4096.0f);
+		rVol = static_cast<typename Traits::output_t>(chn.rightVol) * (1.0f / 4096.0f);
 	}
 };
 
@@ -184,9 +266,10 @@ struct Ramp
 template<class Traits>
 struct MixMonoFastNoRamp : public NoRamp<Traits>
 {
-	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &chn, typename Traits::output_t * const outBuffer)
+	using base_t = NoRamp<Traits>;
+	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &, typename Traits::output_t * const MPT_RESTRICT outBuffer)
 	{
-		typename Traits::output_t vol = outSample[0] * lVol;
+		typename Traits::output_t vol = outSample[0] * base_t::lVol;
 		for(int i = 0; i < Traits::numChannelsOut; i++)
 		{
 			outBuffer[i] += vol;
@@ -198,10 +281,11 @@ struct MixMonoFastNoRamp : public NoRamp<Traits>
 template<class Traits>
 struct MixMonoNoRamp : public NoRamp<Traits>
 {
-	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &, typename Traits::output_t * const outBuffer)
+	using base_t = NoRamp<Traits>;
+	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &, typename Traits::output_t * const MPT_RESTRICT outBuffer)
 	{
-		outBuffer[0] += outSample[0] * lVol;
-		outBuffer[1] += outSample[0] * rVol;
+		outBuffer[0] += outSample[0] * base_t::lVol;
+		outBuffer[1] += outSample[0] * base_t::rVol;
 	}
 };
 
@@ -209,7 +293,7 @@ struct MixMonoNoRamp : public NoRamp<Traits>
 template<class Traits>
 struct MixMonoRamp : public Ramp
 {
-	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &chn, typename Traits::output_t * const outBuffer)
+	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &chn, typename Traits::output_t * const MPT_RESTRICT outBuffer)
 	{
 		// TODO volume is not float, can we optimize this?
 		lRamp += chn.leftRamp;
@@ -223,10 +307,11 @@ struct MixMonoRamp : public Ramp
 template<class Traits>
 struct MixStereoNoRamp : public NoRamp<Traits>
 {
-	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &, typename Traits::output_t * const outBuffer)
+	using base_t = NoRamp<Traits>;
+	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &, typename Traits::output_t * const MPT_RESTRICT outBuffer)
 	{
-		outBuffer[0] += outSample[0] * lVol;
-		outBuffer[1] += outSample[1] * rVol;
+		outBuffer[0] += outSample[0] * base_t::lVol;
+		outBuffer[1] += outSample[1] * base_t::rVol;
 	}
 };
 
@@ -234,7 +319,7 @@ struct MixStereoNoRamp : public NoRamp<Traits>
 template<class Traits>
 struct MixStereoRamp : public Ramp
 {
-	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &chn, typename Traits::output_t * const outBuffer)
+	MPT_FORCEINLINE void operator() (const typename Traits::outbuf_t &outSample, const ModChannel &chn, typename Traits::output_t * const MPT_RESTRICT outBuffer)
 	{
 		// TODO volume is not float, can we optimize this?
 		lRamp += chn.leftRamp;
@@ -276,7 +361,7 @@ struct ResonantFilter
 		}
 	}
 
-	MPT_FORCEINLINE ~ResonantFilter(ModChannel &chn)
+	MPT_FORCEINLINE ~ResonantFilter()
 	{
 		for(int i = 0; i < Traits::numChannelsIn; i++)
 		{
@@ -286,7 +371,7 @@ struct ResonantFilter
 	}
 
 	// Filter values are clipped to double the input range
-#define ClipFilter(x) Clamp(x, static_cast<Traits::output_t>(-2.0f), static_cast<Traits::output_t>(2.0f))
+#define ClipFilter(x) Clamp(x, static_cast<typename Traits::output_t>(-2.0f), static_cast<typename Traits::output_t>(2.0f))
 
 	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const ModChannel &chn)
 	{
@@ -146,7 +146,11 @@ static int8 MEDEnvelopeFromSample(const ModInstrument &instr, const CSoundFile &
 		return 0;
 	
 	const auto &mptSmp = sndFile.GetSample(smp);
-	if(envelopePos >= mptSmp.nLength || mptSmp.uFlags[CHN_16BIT] || !mptSmp.sample8())
+	if(envelopePos >= mptSmp.nLength || !mptSmp.HasSampleData())
+		return 0;
+	if(sndFile.IsSampleWidened(&mptSmp))
+		return static_cast<int8>(mptSmp.sample16()[envelopePos] / 256);
+	if(mptSmp.uFlags[CHN_16BIT])
 		return 0;
 
 	return mptSmp.sample8()[envelopePos];
@@ -0,0 +1,302 @@
+/*
+ * IntMixerSIMD.h
+ * --------------
+ * Purpose: SIMD versions of the 4-tap and 8-tap fixed point interpolation classes from IntMixer.h
+ * Notes  : The functors in this file must produce bit-identical results to their scalar counterparts,
+ *          as the mixer implementation is chosen at runtime depending on the available CPU features.
+ *          Only the dot products are vectorized; the final rounding is done with exactly the same
+ *          scalar expressions as in IntMixer.h.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#include "IntMixer.h"
+
+#include <cstring>
+
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
+#define MPT_MIXER_SSE2
+#endif
+#if defined(MPT_WANT_ARCH_INTRINSICS_ARM_NEON) && defined(__ARM_NEON)
+#define MPT_MIXER_NEON
+#endif
+
+#if defined(MPT_MIXER_SSE2)
+#if MPT_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#endif
+#if defined(MPT_MIXER_NEON)
+#include <arm_neon.h>
+#endif
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+//////////////////////////////////////////////////////////////////////////
+// Dot product kernels
+//
+// Each kernel provides two functions operating on a pointer to the current sampling point:
+// Dot4 computes the 4-tap dot product of lut[0...3] with the sampling points -1...+2 for each channel.
+// Dot8 computes two partial 4-tap dot products: lut[0...3] with the sampling points -3...0 (vol[ch][0])
+// and lut[4...7] with the sampling points +1...+4 (vol[ch][1]).
+// Sampling points are scaled exactly like IntToIntTraits<..., 16>::Convert does it, i.e. 8-bit samples
+// are shifted into the upper half of a 16-bit integer, which allows us to use 16x16-bit multiplications.
+
+
+#if defined(MPT_MIXER_SSE2)
+
+struct MixKernelSSE2
+{
+	// Load four mono sampling points
+	static MPT_FORCEINLINE __m128i LoadMono4(const int16 *p) { return _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p)); }
+	static MPT_FORCEINLINE __m128i LoadMono4(const int8 *p)
+	{
+		int32 v;
+		std::memcpy(&v, p, 4);
+		return _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_cvtsi32_si128(v));
+	}
+	// Load eight mono sampling points
+	static MPT_FORCEINLINE __m128i LoadMono8(const int16 *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	static MPT_FORCEINLINE __m128i LoadMono8(const int8 *p) { return _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))); }
+	// Load four interleaved stereo sampling points
+	static MPT_FORCEINLINE __m128i LoadStereo4(const int16 *p) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(p)); }
+	static MPT_FORCEINLINE __m128i LoadStereo4(const int8 *p) { return _mm_unpacklo_epi8(_mm_setzero_si128(), _mm_loadl_epi64(reinterpret_cast<const __m128i *>(p))); }
+	// Load eight interleaved stereo sampling points
+	static MPT_FORCEINLINE void LoadStereo8(const int16 *p, __m128i &lo, __m128i &hi)
+	{
+		lo = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		hi = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 8));
+	}
+	static MPT_FORCEINLINE void LoadStereo8(const int8 *p, __m128i &lo, __m128i &hi)
+	{
+		const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(p));
+		lo = _mm_unpacklo_epi8(_mm_setzero_si128(), v);
+		hi = _mm_unpackhi_epi8(_mm_setzero_si128(), v);
+	}
+
+	// [L0 R0 L1 R1 L2 R2 L3 R3] => [L0 L1 R0 R1 L2 L3 R2 R3], so that _mm_madd_epi16 keeps the channels apart
+	static MPT_FORCEINLINE __m128i PairChannels(__m128i v)
+	{
+		return _mm_shufflehi_epi16(_mm_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+	}
+
+	// Reduce [a b c d] to a + b
+	static MPT_FORCEINLINE int32 SumLo(__m128i v)
+	{
+		return _mm_cvtsi128_si32(_mm_add_epi32(v, _mm_srli_si128(v, 4)));
+	}
+
+	template<int numChannels, typename input_t>
+	static MPT_FORCEINLINE void Dot4(const input_t *inBuffer, const int16 *lut, int32 (&vol)[numChannels])
+	{
+		const __m128i coeffs = _mm_loadl_epi64(reinterpret_cast<const __m128i *>(lut));
+		if constexpr(numChannels == 1)
+		{
+			vol[0] = SumLo(_mm_madd_epi16(LoadMono4(inBuffer - 1), coeffs));
+		} else
+		{
+			// [L01 R01 L23 R23]
+			__m128i sum = _mm_madd_epi16(PairChannels(LoadStereo4(inBuffer - 2)), _mm_unpacklo_epi32(coeffs, coeffs));
+			sum = _mm_add_epi32(sum, _mm_unpackhi_epi64(sum, sum));
+			vol[0] = _mm_cvtsi128_si32(sum);
+			vol[1] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+		}
+	}
+
+	template<int numChannels, typename input_t>
+	static MPT_FORCEINLINE void Dot8(const input_t *inBuffer, const int16 *lut, int32 (&vol)[numChannels][2])
+	{
+		const __m128i coeffs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut));
+		if constexpr(numChannels == 1)
+		{
+			// [t01 t23 t45 t67]
+			const __m128i sum = _mm_madd_epi16(LoadMono8(inBuffer - 3), coeffs);
+			vol[0][0] = SumLo(sum);
+			vol[0][1] = SumLo(_mm_unpackhi_epi64(sum, sum));
+		} else
+		{
+			__m128i lo, hi;
+			LoadStereo8(inBuffer - 6, lo, hi);
+			// [L01 R01 L23 R23] and [L45 R45 L67 R67]
+			const __m128i sumLo = _mm_madd_epi16(PairChannels(lo), _mm_unpacklo_epi32(coeffs, coeffs));
+			const __m128i sumHi = _mm_madd_epi16(PairChannels(hi), _mm_unpackhi_epi32(coeffs, coeffs));
+			Reduce8(sumLo, sumHi, vol);
+		}
+	}
+
+	// [L01 R01 L23 R23] + [L45 R45 L67 R67] => [L0123 R0123 L4567 R4567]
+	static MPT_FORCEINLINE void Reduce8(__m128i sumLo, __m128i sumHi, int32 (&vol)[2][2])
+	{
+		const __m128i sum = _mm_add_epi32(_mm_unpacklo_epi64(sumLo, sumHi), _mm_unpackhi_epi64(sumLo, sumHi));
+		vol[0][0] = _mm_cvtsi128_si32(sum);
+		vol[1][0] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 4));
+		vol[0][1] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 8));
+		vol[1][1] = _mm_cvtsi128_si32(_mm_srli_si128(sum, 12));
+	}
+};
+
+#endif // MPT_MIXER_SSE2
+
+
+#if defined(MPT_MIXER_NEON)
+
+struct MixKernelNEON
+{
+	static MPT_FORCEINLINE int16x4_t LoadMono4(const int16 *p) { return vld1_s16(p); }
+	static MPT_FORCEINLINE int16x4_t LoadMono4(const int8 *p)
+	{
+		int32 v;
+		std::memcpy(&v, p, 4);
+		return vget_low_s16(vshll_n_s8(vreinterpret_s8_s32(vdup_n_s32(v)), 8));
+	}
+	static MPT_FORCEINLINE int16x8_t LoadMono8(const int16 *p) { return vld1q_s16(p); }
+	static MPT_FORCEINLINE int16x8_t LoadMono8(const int8 *p) { return vshll_n_s8(vld1_s8(p), 8); }
+	static MPT_FORCEINLINE int16x4x2_t LoadStereo4(const int16 *p) { return vld2_s16(p); }
+	static MPT_FORCEINLINE int16x4x2_t LoadStereo4(const int8 *p)
+	{
+		const int16x8_t v = vshll_n_s8(vld1_s8(p), 8);
+		return vuzp_s16(vget_low_s16(v), vget_high_s16(v));
+	}
+	static MPT_FORCEINLINE int16x8x2_t LoadStereo8(const int16 *p) { return vld2q_s16(p); }
+	static MPT_FORCEINLINE int16x8x2_t LoadStereo8(const int8 *p)
+	{
+		const int8x8x2_t v = vld2_s8(p);
+		return {{vshll_n_s8(v.val[0], 8), vshll_n_s8(v.val[1], 8)}};
+	}
+
+	static MPT_FORCEINLINE int32 Sum(int32x4_t v)
+	{
+		const int32x2_t sum = vadd_s32(vget_low_s32(v), vget_high_s32(v));
+		return vget_lane_s32(vpadd_s32(sum, sum), 0);
+	}
+
+	template<int numChannels, typename input_t>
+	static MPT_FORCEINLINE void Dot4(const input_t *inBuffer, const int16 *lut, int32 (&vol)[numChannels])
+	{
+		const int16x4_t coeffs = vld1_s16(lut);
+		if constexpr(numChannels == 1)
+		{
+			vol[0] = Sum(vmull_s16(LoadMono4(inBuffer - 1), coeffs));
+		} else
+		{
+			const int16x4x2_t v = LoadStereo4(inBuffer - 2);
+			vol[0] = Sum(vmull_s16(v.val[0], coeffs));
+			vol[1] = Sum(vmull_s16(v.val[1], coeffs));
+		}
+	}
+
+	template<int numChannels, typename input_t>
+	static MPT_FORCEINLINE void Dot8(const input_t *inBuffer, const int16 *lut, int32 (&vol)[numChannels][2])
+	{
+		const int16x8_t coeffs = vld1q_s16(lut);
+		if constexpr(numChannels == 1)
+		{
+			const int16x8_t v = LoadMono8(inBuffer - 3);
+			vol[0][0] = Sum(vmull_s16(vget_low_s16(v), vget_low_s16(coeffs)));
+			vol[0][1] = Sum(vmull_s16(vget_high_s16(v), vget_high_s16(coeffs)));
+		} else
+		{
+			const int16x8x2_t v = LoadStereo8(inBuffer - 6);
+			for(int i = 0; i < 2; i++)
+			{
+				vol[i][0] = Sum(vmull_s16(vget_low_s16(v.val[i]), vget_low_s16(coeffs)));
+				vol[i][1] = Sum(vmull_s16(vget_high_s16(v.val[i]), vget_high_s16(coeffs)));
+			}
+		}
+	}
+};
+
+#endif // MPT_MIXER_NEON
+
+
+//////////////////////////////////////////////////////////////////////////
+// Interpolation templates
+// Table setup is inherited from the scalar implementations, only the per-sample computation is replaced.
+
+
+template<class Traits, class Kernel>
+struct FastSincInterpolationSIMD : public FastSincInterpolation<Traits>
+{
+	using FastSincInterpolation<Traits>::FastSincInterpolation;
+
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
+	{
+		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
+		const int16 *lut = CResampler::FastSincTable + ((posLo >> 22) & 0x3FC);
+
+		int32 vol[Traits::numChannelsIn];
+		Kernel::template Dot4<Traits::numChannelsIn>(inBuffer, lut, vol);
+		for(int i = 0; i < Traits::numChannelsIn; i++)
+		{
+			outSample[i] = vol[i] / 16384;
+		}
+	}
+};
+
+
+template<class Traits, class Kernel>
+struct PolyphaseInterpolationSIMD : public PolyphaseInterpolation<Traits>
+{
+	using PolyphaseInterpolation<Traits>::PolyphaseInterpolation;
+
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
+	{
+		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
+		static_assert(std::is_same<SINC_TYPE, int16>::value);
+		const SINC_TYPE *lut = this->sinc + ((posLo >> (32 - SINC_PHASES_BITS)) & SINC_MASK) * SINC_WIDTH;
+
+		int32 vol[Traits::numChannelsIn][2];
+		Kernel::template Dot8<Traits::numChannelsIn>(inBuffer, lut, vol);
+		for(int i = 0; i < Traits::numChannelsIn; i++)
+		{
+			// Use unsigned addition to get the same wrap-around behaviour as the scalar code
+			outSample[i] = static_cast<int32>(static_cast<uint32>(vol[i][0]) + static_cast<uint32>(vol[i][1])) / (1 << SINC_QUANTSHIFT);
+		}
+	}
+};
+
+
+template<class Traits, class Kernel>
+struct FIRFilterInterpolationSIMD : public FIRFilterInterpolation<Traits>
+{
+	using FIRFilterInterpolation<Traits>::FIRFilterInterpolation;
+
+	MPT_FORCEINLINE void operator() (typename Traits::outbuf_t &outSample, const typename Traits::input_t * const MPT_RESTRICT inBuffer, const uint32 posLo)
+	{
+		static_assert(static_cast<int>(Traits::numChannelsIn) <= static_cast<int>(Traits::numChannelsOut), "Too many input channels");
+		static_assert(std::is_same<WFIR_TYPE, int16>::value);
+		const int16 * const lut = this->WFIRlut + ((((posLo >> 16) + WFIR_FRACHALVE) >> WFIR_FRACSHIFT) & WFIR_FRACMASK);
+
+		int32 vol[Traits::numChannelsIn][2];
+		Kernel::template Dot8<Traits::numChannelsIn>(inBuffer, lut, vol);
+		for(int i = 0; i < Traits::numChannelsIn; i++)
+		{
+			outSample[i] = ((vol[i][0] / 2) + (vol[i][1] / 2)) / (1 << (WFIR_16BITSHIFT - 1));
+		}
+	}
+};
+
+
+// Aliases with a single template parameter, as required by the mix function table builder
+
+#if defined(MPT_MIXER_SSE2)
+template<class Traits> using FastSincInterpolationSSE2 = FastSincInterpolationSIMD<Traits, MixKernelSSE2>;
+template<class Traits> using PolyphaseInterpolationSSE2 = PolyphaseInterpolationSIMD<Traits, MixKernelSSE2>;
+template<class Traits> using FIRFilterInterpolationSSE2 = FIRFilterInterpolationSIMD<Traits, MixKernelSSE2>;
+#endif // MPT_MIXER_SSE2
+
+#if defined(MPT_MIXER_NEON)
+template<class Traits> using FastSincInterpolationNEON = FastSincInterpolationSIMD<Traits, MixKernelNEON>;
+template<class Traits> using PolyphaseInterpolationNEON = PolyphaseInterpolationSIMD<Traits, MixKernelNEON>;
+template<class Traits> using FIRFilterInterpolationNEON = FIRFilterInterpolationSIMD<Traits, MixKernelNEON>;
+#endif // MPT_MIXER_NEON
+
+
+OPENMPT_NAMESPACE_END
@@ -827,9 +827,9 @@ bool CSoundFile::ReadIT(FileReader &file, ModLoadingFlags loadFlags)
 			} else if(!sample.uFlags[SMP_KEEPONDISK])
 			{
 				SampleIO sampleIO = sampleHeader.GetSampleFormat(fileHeader.cwtv);
-				if(loadFlags & loadSampleData)
+				if((loadFlags & loadSampleData) && !((loadFlags & deferSampleData) && DeferSampleRead(i + 1, sampleIO, file)))
 				{
-					sampleIO.ReadSample(sample, file);
+					sampleIO.ReadSample(sample, file, GetSampleMappingSource());
 				} else
 				{
 					if(sampleIO.IsVariableLengthEncoded())
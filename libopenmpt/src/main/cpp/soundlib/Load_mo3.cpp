@@ -26,6 +26,9 @@
 #include "mpt/audio/span.hpp"
 #include "MPEGFrame.h"
 #include "OggStream.h"
+#include "MixThreadPool.h"
+
+#include <exception>
 
 #if defined(MPT_WITH_VORBIS) && defined(MPT_WITH_VORBISFILE)
 #include <sstream>
@@ -835,6 +838,426 @@ CSoundFile::ProbeResult CSoundFile::ProbeFileHeaderMO3(MemoryFileReader file, co
 }
 
 
+// Result of decoding a compressed MO3 sample.
+// Log messages are collected rather than emitted directly so that they appear in sample order when samples are decoded in parallel.
+struct MO3SampleDecodeResult
+{
+	std::vector<std::pair<LogLevel, mpt::ustring>> messages;
+	std::exception_ptr exception;
+	bool unsupported = false;
+};
+
+
+// Which sample's chunk contains the Ogg header shared by a sample (0 = none)
+static SAMPLEINDEX GetMO3SharedHeaderSource(SAMPLEINDEX smp, const MO3SampleInfo &smpInfo, SAMPLEINDEX numSamples)
+{
+	const SAMPLEINDEX source = (smp + smpInfo.sharedHeader > 0) ? static_cast<SAMPLEINDEX>(smp + smpInfo.sharedHeader) : smp;
+	if(source != smp && source > 0 && source <= numSamples && smpInfo.smpHeader.encoderDelay > 0)
+		return source;
+	return 0;
+}
+
+
+// Decode a compressed sample. MPEG data is passed on to readMPEGSample(FileReader &), which is expected to decode it into the same sample.
+// Only the sample, sampleData and sharedHeaderChunk (the chunk of the sample returned by GetMO3SharedHeaderSource) are modified,
+// so different samples can be decoded concurrently as long as each call gets its own copies of the file cursors.
+template <typename TReadMPEG>
+static void DecodeMO3Sample(ModSample &sample, [[maybe_unused]] SAMPLEINDEX smp, const MO3Sample &smpHeader, FileReader &sampleData, FileReader *sharedHeaderChunk, MO3SampleDecodeResult &result, const TReadMPEG &readMPEGSample)
+{
+	if(smpHeader.flags & MO3Sample::smp16Bit)
+		sample.uFlags.set(CHN_16BIT);
+	if(smpHeader.flags & MO3Sample::smpStereo)
+		sample.uFlags.set(CHN_STEREO);
+
+	const uint8 numChannels = sample.GetNumChannels();
+	const uint32 compression = (smpHeader.flags & MO3Sample::smpCompressionMask);
+
+	if(compression == MO3Sample::smpDeltaCompression || compression == MO3Sample::smpDeltaPrediction)
+	{
+		// In the best case, MO3 compression represents each sample point as two bits.
+		// As a result, if we have a file length of n, we know that the sample can be at most n*4 sample points long.
+		auto maxLength = sampleData.GetLength();
+		uint8 maxSamplesPerByte = 4 / numChannels;
+		if(Util::MaxValueOfType(maxLength) / maxSamplesPerByte >= maxLength)
+			maxLength *= maxSamplesPerByte;
+		else
+			maxLength = Util::MaxValueOfType(maxLength);
+		LimitMax(sample.nLength, mpt::saturate_cast<SmpLength>(maxLength));
+	}
+
+	if(compression == MO3Sample::smpDeltaCompression)
+	{
+		if(sample.AllocateSample())
+		{
+			if(smpHeader.flags & MO3Sample::smp16Bit)
+				UnpackMO3DeltaSample<MO3Delta16BitParams>(sampleData, sample.sample16(), sample.nLength, numChannels);
+			else
+				UnpackMO3DeltaSample<MO3Delta8BitParams>(sampleData, sample.sample8(), sample.nLength, numChannels);
+		}
+	} else if(compression == MO3Sample::smpDeltaPrediction)
+	{
+		if(sample.AllocateSample())
+		{
+			if(smpHeader.flags & MO3Sample::smp16Bit)
+				UnpackMO3DeltaPredictionSample<MO3Delta16BitParams>(sampleData, sample.sample16(), sample.nLength, numChannels);
+			else
+				UnpackMO3DeltaPredictionSample<MO3Delta8BitParams>(sampleData, sample.sample8(), sample.nLength, numChannels);
+		}
+	} else if(compression == MO3Sample::smpCompressionOgg || compression == MO3Sample::smpSharedOgg)
+	{
+		const uint16 sharedHeaderSize = smpHeader.encoderDelay;
+		// Which chunk are we going to read the header from?
+		// Note: Every Ogg stream has a unique serial number.
+		// stb_vorbis (currently) ignores this serial number so we can just stitch
+		// together our sample without adjusting the shared header's serial number.
+		const bool sharedHeader = sharedHeaderChunk != nullptr;
+
+#if defined(MPT_WITH_VORBIS) && defined(MPT_WITH_VORBISFILE)
+
+		std::vector<char> mergedData;
+		if(sharedHeader)
+		{
+			// Prepend the shared header to the actual sample data and adjust bitstream serial numbers.
+			// We do not handle multiple muxed logical streams as they do not exist in practice in mo3.
+			// We assume sequence numbers are consecutive at the end of the headers.
+			// Corrupted pages get dropped as required by Ogg spec. We cannot do any further sane parsing on them anyway.
+			// We do not match up multiple muxed stream properly as this would need parsing of actual packet data to determine or guess the codec.
+			// Ogg Vorbis files may contain at least an additional Ogg Skeleton stream. It is not clear whether these actually exist in MO3.
+			// We do not validate packet structure or logical bitstream structure (i.e. sequence numbers and granule positions).
+
+			// TODO: At least handle Skeleton streams here, as they violate our stream ordering assumptions here.
+
+#if 0
+			// This block may still turn out to be useful as it does a more thourough validation of the stream than the optimized version below.
+
+			// We copy the whole data into a single consecutive buffer in order to keep things simple when interfacing libvorbisfile.
+			// We could in theory only adjust the header and pass 2 chunks to libvorbisfile.
+			// Another option would be to demux both chunks on our own (or using libogg) and pass the raw packet data to libvorbis directly.
+
+			std::ostringstream mergedStream(std::ios::binary);
+			mergedStream.imbue(std::locale::classic());
+
+			sharedHeaderChunk->Rewind();
+			FileReader sharedChunk = sharedHeaderChunk->ReadChunk(sharedHeaderSize);
+			sharedChunk.Rewind();
+
+			std::vector<uint32> streamSerials;
+			Ogg::PageInfo oggPageInfo;
+			std::vector<uint8> oggPageData;
+
+			streamSerials.clear();
+			while(Ogg::ReadPageAndSkipJunk(sharedChunk, oggPageInfo, oggPageData))
+			{
+				auto it = std::find(streamSerials.begin(), streamSerials.end(), oggPageInfo.header.bitstream_serial_number);
+				if(it == streamSerials.end())
+				{
+					streamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
+					it = streamSerials.begin() + (streamSerials.size() - 1);
+				}
+				uint32 newSerial = it - streamSerials.begin() + 1;
+				oggPageInfo.header.bitstream_serial_number = newSerial;
+				Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
+				Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
+			}
+
+			streamSerials.clear();
+			while(Ogg::ReadPageAndSkipJunk(sampleData, oggPageInfo, oggPageData))
+			{
+				auto it = std::find(streamSerials.begin(), streamSerials.end(), oggPageInfo.header.bitstream_serial_number);
+				if(it == streamSerials.end())
+				{
+					streamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
+					it = streamSerials.begin() + (streamSerials.size() - 1);
+				}
+				uint32 newSerial = it - streamSerials.begin() + 1;
+				oggPageInfo.header.bitstream_serial_number = newSerial;
+				Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
+				Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
+			}
+
+			std::string mergedStreamData = mergedStream.str();
+			mergedData.insert(mergedData.end(), mergedStreamData.begin(), mergedStreamData.end());
+
+#else
+
+			// We assume same ordering of streams in both header and data if
+			// multiple streams are present.
+
+			std::ostringstream mergedStream(std::ios::binary);
+			mergedStream.imbue(std::locale::classic());
+
+			sharedHeaderChunk->Rewind();
+			FileReader sharedChunk = sharedHeaderChunk->ReadChunk(sharedHeaderSize);
+			sharedChunk.Rewind();
+
+			std::vector<uint32> dataStreamSerials;
+			std::vector<uint32> headStreamSerials;
+			Ogg::PageInfo oggPageInfo;
+			std::vector<uint8> oggPageData;
+
+			// Gather bitstream serial numbers form sample data chunk
+			dataStreamSerials.clear();
+			while(Ogg::ReadPageAndSkipJunk(sampleData, oggPageInfo, oggPageData))
+			{
+				if(!mpt::contains(dataStreamSerials, oggPageInfo.header.bitstream_serial_number))
+				{
+					dataStreamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
+				}
+			}
+
+			// Apply the data bitstream serial numbers to the header
+			headStreamSerials.clear();
+			while(Ogg::ReadPageAndSkipJunk(sharedChunk, oggPageInfo, oggPageData))
+			{
+				auto it = std::find(headStreamSerials.begin(), headStreamSerials.end(), oggPageInfo.header.bitstream_serial_number);
+				if(it == headStreamSerials.end())
+				{
+					headStreamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
+					it = headStreamSerials.begin() + (headStreamSerials.size() - 1);
+				}
+				uint32 newSerial = 0;
+				if(dataStreamSerials.size() >= static_cast<std::size_t>(it - headStreamSerials.begin()))
+				{
+					// Found corresponding stream in data chunk.
+					newSerial = dataStreamSerials[it - headStreamSerials.begin()];
+				} else
+				{
+					// No corresponding stream in data chunk. Find a free serialno.
+					std::size_t extraIndex = (it - headStreamSerials.begin()) - dataStreamSerials.size();
+					for(newSerial = 1; newSerial < 0xffffffffu; ++newSerial)
+					{
+						if(!mpt::contains(dataStreamSerials, newSerial))
+						{
+							extraIndex -= 1;
+						}
+						if(extraIndex == 0)
+						{
+							break;
+						}
+					}
+				}
+				oggPageInfo.header.bitstream_serial_number = newSerial;
+				Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
+				Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
+			}
+
+			if(headStreamSerials.size() > 1)
+			{
+				result.messages.emplace_back(LogWarning, MPT_UFORMAT("Sample {}: Ogg Vorbis data with shared header and multiple logical bitstreams in header chunk found. This may be handled incorrectly.")(smp));
+			} else if(dataStreamSerials.size() > 1)
+			{
+				result.messages.emplace_back(LogWarning, MPT_UFORMAT("Sample {}: Ogg Vorbis sample with shared header and multiple logical bitstreams found. This may be handled incorrectly.")(smp));
+			} else if((dataStreamSerials.size() == 1) && (headStreamSerials.size() == 1) && (dataStreamSerials[0] != headStreamSerials[0]))
+			{
+				result.messages.emplace_back(LogInformation, MPT_UFORMAT("Sample {}: Ogg Vorbis data with shared header and different logical bitstream serials found.")(smp));
+			}
+
+			std::string mergedStreamData = mergedStream.str();
+			mergedData.insert(mergedData.end(), mergedStreamData.begin(), mergedStreamData.end());
+
+			sampleData.Rewind();
+			FileReader::PinnedView sampleChunkView = sampleData.GetPinnedView();
+			mpt::span<const char> sampleChunkViewSpan = mpt::byte_cast<mpt::span<const char>>(sampleChunkView.span());
+			mergedData.insert(mergedData.end(), sampleChunkViewSpan.begin(), sampleChunkViewSpan.end());
+
+#endif
+		}
+		FileReader mergedDataChunk(mpt::byte_cast<mpt::const_byte_span>(mpt::as_span(mergedData)));
+
+		FileReader &sampleChunk = sharedHeader ? mergedDataChunk : sampleData;
+		FileReader &headerChunk = sampleChunk;
+
+#else  // !(MPT_WITH_VORBIS && MPT_WITH_VORBISFILE)
+
+		FileReader &headerChunk = sharedHeader ? *sharedHeaderChunk : sampleData;
+#if defined(MPT_WITH_STBVORBIS)
+		std::size_t initialRead = sharedHeader ? sharedHeaderSize : headerChunk.GetLength();
+#endif  // MPT_WITH_STBVORBIS
+
+#endif  // MPT_WITH_VORBIS && MPT_WITH_VORBISFILE
+
+		headerChunk.Rewind();
+		if(sharedHeader && !headerChunk.CanRead(sharedHeaderSize))
+			return;
+
+#if defined(MPT_WITH_VORBIS) && defined(MPT_WITH_VORBISFILE)
+
+		ov_callbacks callbacks = {
+		    &VorbisfileFilereaderRead,
+		    &VorbisfileFilereaderSeek,
+		    nullptr,
+		    &VorbisfileFilereaderTell};
+		OggVorbis_File vf;
+		MemsetZero(vf);
+		if(ov_open_callbacks(mpt::void_ptr<FileReader>(&sampleChunk), &vf, nullptr, 0, callbacks) == 0)
+		{
+			if(ov_streams(&vf) == 1)
+			{  // we do not support chained vorbis samples
+				vorbis_info *vi = ov_info(&vf, -1);
+				if(vi && vi->rate > 0 && vi->channels > 0)
+				{
+					sample.AllocateSample();
+					SmpLength offset = 0;
+					int channels = vi->channels;
+					int current_section = 0;
+					long decodedSamples = 0;
+					bool eof = false;
+					while(!eof && offset < sample.nLength && sample.HasSampleData())
+					{
+						float **output = nullptr;
+						long ret = ov_read_float(&vf, &output, 1024, &current_section);
+						if(ret == 0)
+						{
+							eof = true;
+						} else if(ret < 0)
+						{
+							// stream error, just try to continue
+						} else
+						{
+							decodedSamples = ret;
+							LimitMax(decodedSamples, mpt::saturate_cast<long>(sample.nLength - offset));
+							if(decodedSamples > 0 && channels == sample.GetNumChannels())
+							{
+								if(sample.uFlags[CHN_16BIT])
+								{
+									CopyAudio(mpt::audio_span_interleaved(sample.sample16() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
+								} else
+								{
+									CopyAudio(mpt::audio_span_interleaved(sample.sample8() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
+								}
+							}
+							offset += static_cast<SmpLength>(decodedSamples);
+						}
+					}
+				} else
+				{
+					result.unsupported = true;
+				}
+			} else
+			{
+				result.messages.emplace_back(LogWarning, MPT_UFORMAT("Sample {}: Unsupported Ogg Vorbis chained stream found.")(smp));
+				result.unsupported = true;
+			}
+			ov_clear(&vf);
+		} else
+		{
+			result.unsupported = true;
+		}
+
+#elif defined(MPT_WITH_STBVORBIS)
+
+		// NOTE/TODO: stb_vorbis does not handle inferred negative PCM sample
+		// position at stream start. (See
+		// <https://www.xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-132000A.2>).
+		// This means that, for remuxed and re-aligned/cutted (at stream start)
+		// Vorbis files, stb_vorbis will include superfluous samples at the
+		// beginning. MO3 files with this property are yet to be spotted in the
+		// wild, thus, this behaviour is currently not problematic.
+
+		int consumed = 0, error = 0;
+		stb_vorbis *vorb = nullptr;
+		if(sharedHeader)
+		{
+			FileReader::PinnedView headChunkView = headerChunk.GetPinnedView(initialRead);
+			vorb = stb_vorbis_open_pushdata(mpt::byte_cast<const unsigned char *>(headChunkView.data()), mpt::saturate_cast<int>(headChunkView.size()), &consumed, &error, nullptr);
+			headerChunk.Skip(consumed);
+		}
+		FileReader::PinnedView sampleDataView = sampleData.GetPinnedView();
+		const std::byte *data = sampleDataView.data();
+		std::size_t dataLeft = sampleDataView.size();
+		if(!sharedHeader)
+		{
+			vorb = stb_vorbis_open_pushdata(mpt::byte_cast<const unsigned char *>(data), mpt::saturate_cast<int>(dataLeft), &consumed, &error, nullptr);
+			sampleData.Skip(consumed);
+			data += consumed;
+			dataLeft -= consumed;
+		}
+		if(vorb)
+		{
+			// Header has been read, proceed to reading the sample data
+			sample.AllocateSample();
+			SmpLength offset = 0;
+			while((error == VORBIS__no_error || (error == VORBIS_need_more_data && dataLeft > 0))
+			      && offset < sample.nLength && sample.HasSampleData())
+			{
+				int channels = 0, decodedSamples = 0;
+				float **output;
+				consumed = stb_vorbis_decode_frame_pushdata(vorb, mpt::byte_cast<const unsigned char *>(data), mpt::saturate_cast<int>(dataLeft), &channels, &output, &decodedSamples);
+				sampleData.Skip(consumed);
+				data += consumed;
+				dataLeft -= consumed;
+				LimitMax(decodedSamples, mpt::saturate_cast<int>(sample.nLength - offset));
+				if(decodedSamples > 0 && channels == sample.GetNumChannels())
+				{
+					if(sample.uFlags[CHN_16BIT])
+					{
+						CopyAudio(mpt::audio_span_interleaved(sample.sample16() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
+					} else
+					{
+						CopyAudio(mpt::audio_span_interleaved(sample.sample8() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
+					}
+				}
+				offset += decodedSamples;
+				error = stb_vorbis_get_error(vorb);
+			}
+			stb_vorbis_close(vorb);
+		} else
+		{
+			result.unsupported = true;
+		}
+
+#else  // !VORBIS
+
+		result.unsupported = true;
+
+#endif  // VORBIS
+	} else if(compression == MO3Sample::smpCompressionMPEG)
+	{
+		// Old MO3 encoders didn't remove LAME info frames. This is unfortunate since the encoder delay
+		// specified in the sample header does not take the gapless information from the LAME info frame
+		// into account. We should not depend on the MP3 decoder's capabilities to read or ignore such frames:
+		// - libmpg123 has MPG123_IGNORE_INFOFRAME but that requires API version 31 (mpg123 v1.14) or higher
+		// - Media Foundation does (currently) not read LAME gapless information at all
+		// So we just play safe and remove such frames.
+		FileReader mpegData(sampleData);
+		MPEGFrame frame(sampleData);
+		uint16 encoderDelay = smpHeader.encoderDelay;
+		uint16 frameDelay = frame.numSamples * 2;
+		if(frame.isLAME && encoderDelay >= frameDelay)
+		{
+			// The info frame does not produce any output, but still counts towards the encoder delay.
+			encoderDelay -= frameDelay;
+			sampleData.Seek(frame.frameSize);
+			mpegData = sampleData.ReadChunk(sampleData.BytesLeft());
+		}
+
+		if(readMPEGSample(mpegData))
+		{
+			if(encoderDelay > 0 && encoderDelay < sample.GetSampleSizeInBytes())
+			{
+				SmpLength delay = encoderDelay / sample.GetBytesPerSample();
+				memmove(sample.sampleb(), sample.sampleb() + encoderDelay, sample.GetSampleSizeInBytes() - encoderDelay);
+				sample.nLength -= delay;
+			}
+			LimitMax(sample.nLength, smpHeader.length);
+		} else
+		{
+			result.unsupported = true;
+		}
+	} else if(compression == MO3Sample::smpOPLInstrument)
+	{
+		OPLPatch patch;
+		if(sampleData.ReadArray(patch))
+		{
+			sample.SetAdlib(true, patch);
+		}
+	} else
+	{
+		result.unsupported = true;
+	}
+}
+
+
 bool CSoundFile::ReadMO3(FileReader &file, ModLoadingFlags loadFlags)
 {
 	file.Rewind();
@@ -1618,415 +2041,112 @@ bool CSoundFile::ReadMO3(FileReader &file, ModLoadingFlags loadFlags)
 		}
 	}
 
+	std::vector<SAMPLEINDEX> compressedSamples;
+	bool canDecodeInParallel = true;
 	for(SAMPLEINDEX smp = 1; smp <= m_nSamples; smp++)
 	{
-		ModSample &sample = Samples[smp];
-		MO3SampleInfo &smpInfo = sampleInfos[smp - 1];
+		const MO3SampleInfo &smpInfo = sampleInfos[smp - 1];
 		const MO3Sample &smpHeader = smpInfo.smpHeader;
-
+		// Duplicate samples are resolved after decoding
 		if(smpHeader.compressedSize < 0 && (smp + smpHeader.compressedSize) > 0)
-		{
-			// Duplicate sample
-			sample.CopyWaveform(Samples[smp + smpHeader.compressedSize]);
 			continue;
-		}
-
 		// Not a compressed sample?
 		if(!smpHeader.length || !smpInfo.chunk.IsValid())
 			continue;
+		compressedSamples.push_back(smp);
+
+		// Decoding a sample with a shared header moves the cursor of the header's chunk.
+		// If that chunk belongs to a later sample that does not rewind its own chunk before decoding (i.e. anything but a plain Ogg sample), the result depends on the decoding order.
+		const SAMPLEINDEX sharedHeaderSource = GetMO3SharedHeaderSource(smp, smpInfo, m_nSamples);
+		if(sharedHeaderSource > smp && (sampleInfos[sharedHeaderSource - 1].smpHeader.flags & MO3Sample::smpCompressionMask) != MO3Sample::smpCompressionOgg)
+			canDecodeInParallel = false;
+#if defined(MPT_WITH_MEDIAFOUNDATION)
+		// Media Foundation has to be used from the thread that initialized it
+		if((smpHeader.flags & MO3Sample::smpCompressionMask) == MO3Sample::smpCompressionMPEG)
+			canDecodeInParallel = false;
+#endif  // MPT_WITH_MEDIAFOUNDATION
+	}
 
-		if(smpHeader.flags & MO3Sample::smp16Bit)
-			sample.uFlags.set(CHN_16BIT);
-		if(smpHeader.flags & MO3Sample::smpStereo)
-			sample.uFlags.set(CHN_STEREO);
-
-		FileReader &sampleData = smpInfo.chunk;
-		const uint8 numChannels = sample.GetNumChannels();
-		const uint32 compression = (smpHeader.flags & MO3Sample::smpCompressionMask);
-
-		if(compression == MO3Sample::smpDeltaCompression || compression == MO3Sample::smpDeltaPrediction)
-		{
-			// In the best case, MO3 compression represents each sample point as two bits.
-			// As a result, if we have a file length of n, we know that the sample can be at most n*4 sample points long.
-			auto maxLength = sampleData.GetLength();
-			uint8 maxSamplesPerByte = 4 / numChannels;
-			if(Util::MaxValueOfType(maxLength) / maxSamplesPerByte >= maxLength)
-				maxLength *= maxSamplesPerByte;
-			else
-				maxLength = Util::MaxValueOfType(maxLength);
-			LimitMax(sample.nLength, mpt::saturate_cast<SmpLength>(maxLength));
-		}
-
-		if(compression == MO3Sample::smpDeltaCompression)
-		{
-			if(sample.AllocateSample())
-			{
-				if(smpHeader.flags & MO3Sample::smp16Bit)
-					UnpackMO3DeltaSample<MO3Delta16BitParams>(sampleData, sample.sample16(), sample.nLength, numChannels);
-				else
-					UnpackMO3DeltaSample<MO3Delta8BitParams>(sampleData, sample.sample8(), sample.nLength, numChannels);
-			}
-		} else if(compression == MO3Sample::smpDeltaPrediction)
-		{
-			if(sample.AllocateSample())
-			{
-				if(smpHeader.flags & MO3Sample::smp16Bit)
-					UnpackMO3DeltaPredictionSample<MO3Delta16BitParams>(sampleData, sample.sample16(), sample.nLength, numChannels);
-				else
-					UnpackMO3DeltaPredictionSample<MO3Delta8BitParams>(sampleData, sample.sample8(), sample.nLength, numChannels);
-			}
-		} else if(compression == MO3Sample::smpCompressionOgg || compression == MO3Sample::smpSharedOgg)
+	const auto readMPEGSample = [this](SAMPLEINDEX smp, FileReader &mpegData)
+	{
+		return ReadMP3Sample(smp, mpegData, true, true) || ReadMediaFoundationSample(smp, mpegData, true);
+	};
+	std::vector<MO3SampleDecodeResult> decodeResults(compressedSamples.size());
+	const uint32 numDecodeThreads = std::min(GetSampleDecodeThreads(), static_cast<uint32>(compressedSamples.size()));
+#ifdef MPT_ENABLE_MIX_THREADS
+	if(numDecodeThreads > 1 && canDecodeInParallel)
+	{
+		// Pin the sample data on this thread, as reading from a file that is not completely in memory is not thread-safe.
+		// For in-memory files, this does not copy anything.
+		std::vector<FileReader::PinnedView> pinnedChunks;
+		pinnedChunks.reserve(sampleInfos.size());
+		for(MO3SampleInfo &smpInfo : sampleInfos)
 		{
-			const uint16 sharedHeaderSize = smpHeader.encoderDelay;
-			SAMPLEINDEX sharedOggHeader = (smp + smpInfo.sharedHeader > 0) ? static_cast<SAMPLEINDEX>(smp + smpInfo.sharedHeader) : smp;
-			// Which chunk are we going to read the header from?
-			// Note: Every Ogg stream has a unique serial number.
-			// stb_vorbis (currently) ignores this serial number so we can just stitch
-			// together our sample without adjusting the shared header's serial number.
-			const bool sharedHeader = sharedOggHeader != smp && sharedOggHeader > 0 && sharedOggHeader <= m_nSamples && sharedHeaderSize > 0;
-
-#if defined(MPT_WITH_VORBIS) && defined(MPT_WITH_VORBISFILE)
-
-			std::vector<char> mergedData;
-			if(sharedHeader)
+			if(smpInfo.chunk.IsValid())
 			{
-				// Prepend the shared header to the actual sample data and adjust bitstream serial numbers.
-				// We do not handle multiple muxed logical streams as they do not exist in practice in mo3.
-				// We assume sequence numbers are consecutive at the end of the headers.
-				// Corrupted pages get dropped as required by Ogg spec. We cannot do any further sane parsing on them anyway.
-				// We do not match up multiple muxed stream properly as this would need parsing of actual packet data to determine or guess the codec.
-				// Ogg Vorbis files may contain at least an additional Ogg Skeleton stream. It is not clear whether these actually exist in MO3.
-				// We do not validate packet structure or logical bitstream structure (i.e. sequence numbers and granule positions).
-
-				// TODO: At least handle Skeleton streams here, as they violate our stream ordering assumptions here.
-
-#if 0
-				// This block may still turn out to be useful as it does a more thourough validation of the stream than the optimized version below.
-
-				// We copy the whole data into a single consecutive buffer in order to keep things simple when interfacing libvorbisfile.
-				// We could in theory only adjust the header and pass 2 chunks to libvorbisfile.
-				// Another option would be to demux both chunks on our own (or using libogg) and pass the raw packet data to libvorbis directly.
-
-				std::ostringstream mergedStream(std::ios::binary);
-				mergedStream.imbue(std::locale::classic());
-
-				sampleInfos[sharedOggHeader - 1].chunk.Rewind();
-				FileReader sharedChunk = sampleInfos[sharedOggHeader - 1].chunk.ReadChunk(sharedHeaderSize);
-				sharedChunk.Rewind();
-
-				std::vector<uint32> streamSerials;
-				Ogg::PageInfo oggPageInfo;
-				std::vector<uint8> oggPageData;
-
-				streamSerials.clear();
-				while(Ogg::ReadPageAndSkipJunk(sharedChunk, oggPageInfo, oggPageData))
-				{
-					auto it = std::find(streamSerials.begin(), streamSerials.end(), oggPageInfo.header.bitstream_serial_number);
-					if(it == streamSerials.end())
-					{
-						streamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
-						it = streamSerials.begin() + (streamSerials.size() - 1);
-					}
-					uint32 newSerial = it - streamSerials.begin() + 1;
-					oggPageInfo.header.bitstream_serial_number = newSerial;
-					Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
-					Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
-				}
-
-				streamSerials.clear();
-				while(Ogg::ReadPageAndSkipJunk(smpInfo.chunk, oggPageInfo, oggPageData))
-				{
-					auto it = std::find(streamSerials.begin(), streamSerials.end(), oggPageInfo.header.bitstream_serial_number);
-					if(it == streamSerials.end())
-					{
-						streamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
-						it = streamSerials.begin() + (streamSerials.size() - 1);
-					}
-					uint32 newSerial = it - streamSerials.begin() + 1;
-					oggPageInfo.header.bitstream_serial_number = newSerial;
-					Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
-					Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
-				}
-
-				std::string mergedStreamData = mergedStream.str();
-				mergedData.insert(mergedData.end(), mergedStreamData.begin(), mergedStreamData.end());
-
-#else
-
-				// We assume same ordering of streams in both header and data if
-				// multiple streams are present.
-
-				std::ostringstream mergedStream(std::ios::binary);
-				mergedStream.imbue(std::locale::classic());
-
-				sampleInfos[sharedOggHeader - 1].chunk.Rewind();
-				FileReader sharedChunk = sampleInfos[sharedOggHeader - 1].chunk.ReadChunk(sharedHeaderSize);
-				sharedChunk.Rewind();
-
-				std::vector<uint32> dataStreamSerials;
-				std::vector<uint32> headStreamSerials;
-				Ogg::PageInfo oggPageInfo;
-				std::vector<uint8> oggPageData;
-
-				// Gather bitstream serial numbers form sample data chunk
-				dataStreamSerials.clear();
-				while(Ogg::ReadPageAndSkipJunk(smpInfo.chunk, oggPageInfo, oggPageData))
-				{
-					if(!mpt::contains(dataStreamSerials, oggPageInfo.header.bitstream_serial_number))
-					{
-						dataStreamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
-					}
-				}
-
-				// Apply the data bitstream serial numbers to the header
-				headStreamSerials.clear();
-				while(Ogg::ReadPageAndSkipJunk(sharedChunk, oggPageInfo, oggPageData))
-				{
-					auto it = std::find(headStreamSerials.begin(), headStreamSerials.end(), oggPageInfo.header.bitstream_serial_number);
-					if(it == headStreamSerials.end())
-					{
-						headStreamSerials.push_back(oggPageInfo.header.bitstream_serial_number);
-						it = headStreamSerials.begin() + (headStreamSerials.size() - 1);
-					}
-					uint32 newSerial = 0;
-					if(dataStreamSerials.size() >= static_cast<std::size_t>(it - headStreamSerials.begin()))
-					{
-						// Found corresponding stream in data chunk.
-						newSerial = dataStreamSerials[it - headStreamSerials.begin()];
-					} else
-					{
-						// No corresponding stream in data chunk. Find a free serialno.
-						std::size_t extraIndex = (it - headStreamSerials.begin()) - dataStreamSerials.size();
-						for(newSerial = 1; newSerial < 0xffffffffu; ++newSerial)
-						{
-							if(!mpt::contains(dataStreamSerials, newSerial))
-							{
-								extraIndex -= 1;
-							}
-							if(extraIndex == 0)
-							{
-								break;
-							}
-						}
-					}
-					oggPageInfo.header.bitstream_serial_number = newSerial;
-					Ogg::UpdatePageCRC(oggPageInfo, oggPageData);
-					Ogg::WritePage(mergedStream, oggPageInfo, oggPageData);
-				}
-
-				if(headStreamSerials.size() > 1)
-				{
-					AddToLog(LogWarning, MPT_UFORMAT("Sample {}: Ogg Vorbis data with shared header and multiple logical bitstreams in header chunk found. This may be handled incorrectly.")(smp));
-				} else if(dataStreamSerials.size() > 1)
-				{
-					AddToLog(LogWarning, MPT_UFORMAT("Sample {}: Ogg Vorbis sample with shared header and multiple logical bitstreams found. This may be handled incorrectly.")(smp));
-				} else if((dataStreamSerials.size() == 1) && (headStreamSerials.size() == 1) && (dataStreamSerials[0] != headStreamSerials[0]))
-				{
-					AddToLog(LogInformation, MPT_UFORMAT("Sample {}: Ogg Vorbis data with shared header and different logical bitstream serials found.")(smp));
-				}
-
-				std::string mergedStreamData = mergedStream.str();
-				mergedData.insert(mergedData.end(), mergedStreamData.begin(), mergedStreamData.end());
-
 				smpInfo.chunk.Rewind();
-				FileReader::PinnedView sampleChunkView = smpInfo.chunk.GetPinnedView();
-				mpt::span<const char> sampleChunkViewSpan = mpt::byte_cast<mpt::span<const char>>(sampleChunkView.span());
-				mergedData.insert(mergedData.end(), sampleChunkViewSpan.begin(), sampleChunkViewSpan.end());
-
-#endif
+				pinnedChunks.push_back(smpInfo.chunk.GetPinnedView());
+				smpInfo.chunk = FileReader(pinnedChunks.back().span());
 			}
-			FileReader mergedDataChunk(mpt::byte_cast<mpt::const_byte_span>(mpt::as_span(mergedData)));
-
-			FileReader &sampleChunk = sharedHeader ? mergedDataChunk : smpInfo.chunk;
-			FileReader &headerChunk = sampleChunk;
-
-#else  // !(MPT_WITH_VORBIS && MPT_WITH_VORBISFILE)
-
-			FileReader &headerChunk = sharedHeader ? sampleInfos[sharedOggHeader - 1].chunk : sampleData;
-#if defined(MPT_WITH_STBVORBIS)
-			std::size_t initialRead = sharedHeader ? sharedHeaderSize : headerChunk.GetLength();
-#endif  // MPT_WITH_STBVORBIS
-
-#endif  // MPT_WITH_VORBIS && MPT_WITH_VORBISFILE
-
-			headerChunk.Rewind();
-			if(sharedHeader && !headerChunk.CanRead(sharedHeaderSize))
-				continue;
-
-#if defined(MPT_WITH_VORBIS) && defined(MPT_WITH_VORBISFILE)
-
-			ov_callbacks callbacks = {
-			    &VorbisfileFilereaderRead,
-			    &VorbisfileFilereaderSeek,
-			    nullptr,
-			    &VorbisfileFilereaderTell};
-			OggVorbis_File vf;
-			MemsetZero(vf);
-			if(ov_open_callbacks(mpt::void_ptr<FileReader>(&sampleChunk), &vf, nullptr, 0, callbacks) == 0)
-			{
-				if(ov_streams(&vf) == 1)
-				{  // we do not support chained vorbis samples
-					vorbis_info *vi = ov_info(&vf, -1);
-					if(vi && vi->rate > 0 && vi->channels > 0)
-					{
-						sample.AllocateSample();
-						SmpLength offset = 0;
-						int channels = vi->channels;
-						int current_section = 0;
-						long decodedSamples = 0;
-						bool eof = false;
-						while(!eof && offset < sample.nLength && sample.HasSampleData())
-						{
-							float **output = nullptr;
-							long ret = ov_read_float(&vf, &output, 1024, &current_section);
-							if(ret == 0)
-							{
-								eof = true;
-							} else if(ret < 0)
-							{
-								// stream error, just try to continue
-							} else
-							{
-								decodedSamples = ret;
-								LimitMax(decodedSamples, mpt::saturate_cast<long>(sample.nLength - offset));
-								if(decodedSamples > 0 && channels == sample.GetNumChannels())
-								{
-									if(sample.uFlags[CHN_16BIT])
-									{
-										CopyAudio(mpt::audio_span_interleaved(sample.sample16() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
-									} else
-									{
-										CopyAudio(mpt::audio_span_interleaved(sample.sample8() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
-									}
-								}
-								offset += static_cast<SmpLength>(decodedSamples);
-							}
-						}
-					} else
-					{
-						unsupportedSamples = true;
-					}
-				} else
-				{
-					AddToLog(LogWarning, MPT_UFORMAT("Sample {}: Unsupported Ogg Vorbis chained stream found.")(smp));
-					unsupportedSamples = true;
-				}
-				ov_clear(&vf);
-			} else
-			{
-				unsupportedSamples = true;
-			}
-
-#elif defined(MPT_WITH_STBVORBIS)
+		}
 
-			// NOTE/TODO: stb_vorbis does not handle inferred negative PCM sample
-			// position at stream start. (See
-			// <https://www.xiph.org/vorbis/doc/Vorbis_I_spec.html#x1-132000A.2>).
-			// This means that, for remuxed and re-aligned/cutted (at stream start)
-			// Vorbis files, stb_vorbis will include superfluous samples at the
-			// beginning. MO3 files with this property are yet to be spotted in the
-			// wild, thus, this behaviour is currently not problematic.
-
-			int consumed = 0, error = 0;
-			stb_vorbis *vorb = nullptr;
-			if(sharedHeader)
-			{
-				FileReader::PinnedView headChunkView = headerChunk.GetPinnedView(initialRead);
-				vorb = stb_vorbis_open_pushdata(mpt::byte_cast<const unsigned char *>(headChunkView.data()), mpt::saturate_cast<int>(headChunkView.size()), &consumed, &error, nullptr);
-				headerChunk.Skip(consumed);
-			}
-			FileReader::PinnedView sampleDataView = sampleData.GetPinnedView();
-			const std::byte *data = sampleDataView.data();
-			std::size_t dataLeft = sampleDataView.size();
-			if(!sharedHeader)
-			{
-				vorb = stb_vorbis_open_pushdata(mpt::byte_cast<const unsigned char *>(data), mpt::saturate_cast<int>(dataLeft), &consumed, &error, nullptr);
-				sampleData.Skip(consumed);
-				data += consumed;
-				dataLeft -= consumed;
-			}
-			if(vorb)
+		// Every task only writes to its own sample and result, so the outcome does not depend on the order in which the tasks finish.
+		const auto decodeTask = [this, &compressedSamples, &sampleInfos, &decodeResults, &readMPEGSample](uint32 task)
+		{
+			const SAMPLEINDEX smp = compressedSamples[task];
+			const MO3SampleInfo &smpInfo = sampleInfos[smp - 1];
+			const SAMPLEINDEX sharedHeaderSource = GetMO3SharedHeaderSource(smp, smpInfo, m_nSamples);
+			FileReader sampleData = smpInfo.chunk;
+			FileReader sharedHeaderChunk = sharedHeaderSource ? sampleInfos[sharedHeaderSource - 1].chunk : FileReader{};
+			try
 			{
-				// Header has been read, proceed to reading the sample data
-				sample.AllocateSample();
-				SmpLength offset = 0;
-				while((error == VORBIS__no_error || (error == VORBIS_need_more_data && dataLeft > 0))
-				      && offset < sample.nLength && sample.HasSampleData())
-				{
-					int channels = 0, decodedSamples = 0;
-					float **output;
-					consumed = stb_vorbis_decode_frame_pushdata(vorb, mpt::byte_cast<const unsigned char *>(data), mpt::saturate_cast<int>(dataLeft), &channels, &output, &decodedSamples);
-					sampleData.Skip(consumed);
-					data += consumed;
-					dataLeft -= consumed;
-					LimitMax(decodedSamples, mpt::saturate_cast<int>(sample.nLength - offset));
-					if(decodedSamples > 0 && channels == sample.GetNumChannels())
-					{
-						if(sample.uFlags[CHN_16BIT])
-						{
-							CopyAudio(mpt::audio_span_interleaved(sample.sample16() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
-						} else
-						{
-							CopyAudio(mpt::audio_span_interleaved(sample.sample8() + (offset * sample.GetNumChannels()), sample.GetNumChannels(), decodedSamples), mpt::audio_span_planar(output, channels, decodedSamples));
-						}
-					}
-					offset += decodedSamples;
-					error = stb_vorbis_get_error(vorb);
-				}
-				stb_vorbis_close(vorb);
-			} else
+				DecodeMO3Sample(Samples[smp], smp, smpInfo.smpHeader, sampleData, sharedHeaderSource ? &sharedHeaderChunk : nullptr, decodeResults[task], [&](FileReader &mpegData) { return readMPEGSample(smp, mpegData); });
+			} catch(...)
 			{
-				unsupportedSamples = true;
+				decodeResults[task].exception = std::current_exception();
 			}
-
-#else  // !VORBIS
-
-			unsupportedSamples = true;
-
-#endif  // VORBIS
-		} else if(compression == MO3Sample::smpCompressionMPEG)
+		};
+		MixThreadPool(numDecodeThreads).Run(static_cast<uint32>(compressedSamples.size()), decodeTask);
+	} else
+#endif  // MPT_ENABLE_MIX_THREADS
+	{
+		MPT_UNUSED_VARIABLE(numDecodeThreads);
+		MPT_UNUSED_VARIABLE(canDecodeInParallel);
+		for(std::size_t i = 0; i < compressedSamples.size(); i++)
 		{
-			// Old MO3 encoders didn't remove LAME info frames. This is unfortunate since the encoder delay
-			// specified in the sample header does not take the gapless information from the LAME info frame
-			// into account. We should not depend on the MP3 decoder's capabilities to read or ignore such frames:
-			// - libmpg123 has MPG123_IGNORE_INFOFRAME but that requires API version 31 (mpg123 v1.14) or higher
-			// - Media Foundation does (currently) not read LAME gapless information at all
-			// So we just play safe and remove such frames.
-			FileReader mpegData(sampleData);
-			MPEGFrame frame(sampleData);
-			uint16 encoderDelay = smpHeader.encoderDelay;
-			uint16 frameDelay = frame.numSamples * 2;
-			if(frame.isLAME && encoderDelay >= frameDelay)
+			const SAMPLEINDEX smp = compressedSamples[i];
+			MO3SampleInfo &smpInfo = sampleInfos[smp - 1];
+			const SAMPLEINDEX sharedHeaderSource = GetMO3SharedHeaderSource(smp, smpInfo, m_nSamples);
+			DecodeMO3Sample(Samples[smp], smp, smpInfo.smpHeader, smpInfo.chunk, sharedHeaderSource ? &sampleInfos[sharedHeaderSource - 1].chunk : nullptr, decodeResults[i], [&](FileReader &mpegData) { return readMPEGSample(smp, mpegData); });
+			// Keep the log messages of a sample in front of an exception thrown by a later sample
+			for(const auto &[level, message] : decodeResults[i].messages)
 			{
-				// The info frame does not produce any output, but still counts towards the encoder delay.
-				encoderDelay -= frameDelay;
-				sampleData.Seek(frame.frameSize);
-				mpegData = sampleData.ReadChunk(sampleData.BytesLeft());
+				AddToLog(level, message);
 			}
+			decodeResults[i].messages.clear();
+		}
+	}
 
-			if(ReadMP3Sample(smp, mpegData, true, true) || ReadMediaFoundationSample(smp, mpegData, true))
-			{
-				if(encoderDelay > 0 && encoderDelay < sample.GetSampleSizeInBytes())
-				{
-					SmpLength delay = encoderDelay / sample.GetBytesPerSample();
-					memmove(sample.sampleb(), sample.sampleb() + encoderDelay, sample.GetSampleSizeInBytes() - encoderDelay);
-					sample.nLength -= delay;
-				}
-				LimitMax(sample.nLength, smpHeader.length);
-			} else
-			{
-				unsupportedSamples = true;
-			}
-		} else if(compression == MO3Sample::smpOPLInstrument)
+	for(const auto &result : decodeResults)
+	{
+		for(const auto &[level, message] : result.messages)
 		{
-			OPLPatch patch;
-			if(sampleData.ReadArray(patch))
-			{
-				sample.SetAdlib(true, patch);
-			}
-		} else
+			AddToLog(level, message);
+		}
+		if(result.exception)
+		{
+			std::rethrow_exception(result.exception);
+		}
+		unsupportedSamples |= result.unsupported;
+	}
+
+	for(SAMPLEINDEX smp = 1; smp <= m_nSamples; smp++)
+	{
+		const MO3Sample &smpHeader = sampleInfos[smp - 1].smpHeader;
+		if(smpHeader.compressedSize < 0 && (smp + smpHeader.compressedSize) > 0)
 		{
-			unsupportedSamples = true;
+			// Duplicate sample
+			Samples[smp].CopyWaveform(Samples[smp + smpHeader.compressedSize]);
 		}
 	}
 
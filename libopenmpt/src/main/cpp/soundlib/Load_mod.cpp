@@ -692,7 +692,7 @@ bool CSoundFile::ReadMOD(FileReader &file, ModLoadingFlags loadFlags)
 				if(isMdKd && onlyAmigaNotes && !hasEmptySampleWithVolume)
 					sample.nLength = std::max(sample.nLength, sample.nLoopEnd);
 
-				sampleIO.ReadSample(sample, file);
+				sampleIO.ReadSample(sample, file, GetSampleMappingSource());
 				file.Seek(nextSample);
 			}
 		}
@@ -578,7 +578,7 @@ bool CSoundFile::ReadS3M(FileReader &file, ModLoadingFlags loadFlags)
 			{
 				SampleIO sampleIO = sampleHeader.GetSampleFormat((fileHeader.formatVersion == S3MFileHeader::oldVersion));
 				if((loadFlags & loadSampleData) && file.Seek(sampleHeader.GetSampleOffset()))
-					sampleIO.ReadSample(Samples[smp + 1], file);
+					sampleIO.ReadSample(Samples[smp + 1], file, GetSampleMappingSource());
 				anySamples = true;
 				if(sampleIO.GetEncoding() == SampleIO::ADPCM)
 					anyADPCM = true;
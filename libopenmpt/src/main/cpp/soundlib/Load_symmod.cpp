@@ -256,7 +256,11 @@ struct SymVirtualInst
 				if(chn.position.GetUInt() >= chn.nLength)
 					chn.pCurrentSample = nullptr;
 			}
+#ifdef MPT_INTMIXER
 			CopySample<SC::ConversionChain<SC::ConvertFixedPoint<int16, mixsample_t, 27>, SC::DecodeIdentity<mixsample_t>>>(target.sample16() + writeOffset, writeCount, 1, buffer.data(), sizeof(buffer), 2);
+#else
+			CopySample<SC::ConversionChain<SC::Convert<int16, mixsample_t>, SC::DecodeIdentity<mixsample_t>>>(target.sample16() + writeOffset, writeCount, 1, buffer.data(), sizeof(buffer), 2);
+#endif // MPT_INTMIXER
 			writeOffset += writeCount;
 		}
 
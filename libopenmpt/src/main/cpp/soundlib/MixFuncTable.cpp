@@ -19,10 +19,18 @@
 
 #ifdef MPT_INTMIXER
 #include "IntMixer.h"
+#include "IntMixerSIMD.h"
+#if defined(MPT_MIXER_SSE2) || defined(MPT_WANT_MIXER_AVX2)
+#include "../common/mptCPU.h"
+#endif
 #else
 #include "FloatMixer.h"
 #endif // MPT_INTMIXER
 
+#include <algorithm>
+#include <array>
+#include <optional>
+
 OPENMPT_NAMESPACE_BEGIN
 
 namespace MixFuncTable
@@ -66,11 +74,83 @@ const MixFuncInterface Functions[6 * 16] =
 	BuildMixFuncTable(AmigaBlepInterpolation), // Amiga emulation
 };
 
+#if defined(MPT_MIXER_SSE2)
+const MixFuncInterface FunctionsSSE2[6 * 16] =
+{
+	BuildMixFuncTable(NoInterpolation),
+	BuildMixFuncTable(LinearInterpolation),
+	BuildMixFuncTable(FastSincInterpolationSSE2),
+	BuildMixFuncTable(PolyphaseInterpolationSSE2),
+	BuildMixFuncTable(FIRFilterInterpolationSSE2),
+	BuildMixFuncTable(AmigaBlepInterpolation),
+};
+#endif // MPT_MIXER_SSE2
+
+#if defined(MPT_MIXER_NEON)
+const MixFuncInterface FunctionsNEON[6 * 16] =
+{
+	BuildMixFuncTable(NoInterpolation),
+	BuildMixFuncTable(LinearInterpolation),
+	BuildMixFuncTable(FastSincInterpolationNEON),
+	BuildMixFuncTable(PolyphaseInterpolationNEON),
+	BuildMixFuncTable(FIRFilterInterpolationNEON),
+	BuildMixFuncTable(AmigaBlepInterpolation),
+};
+#endif // MPT_MIXER_NEON
+
 #undef BuildMixFuncTableRamp
 #undef BuildMixFuncTableFilter
 #undef BuildMixFuncTable
 
 
+#if defined(MPT_WANT_MIXER_AVX2)
+static const MixFuncInterface *GetFunctionsAVX2()
+{
+	static const auto functions = []() -> std::optional<std::array<MixFuncInterface, 6 * 16>>
+	{
+		const MixFuncInterface *interpolationFunctions = GetInterpolationFunctionsAVX2();
+		if(!interpolationFunctions)
+			return std::nullopt;
+		std::array<MixFuncInterface, 6 * 16> table;
+		std::copy(std::begin(Functions), std::end(Functions), table.begin());
+		std::copy(interpolationFunctions, interpolationFunctions + 3 * 16, table.begin() + ndxFastSinc);
+		return table;
+	}();
+	return functions ? functions->data() : nullptr;
+}
+#endif // MPT_WANT_MIXER_AVX2
+
+
+std::vector<const MixFuncInterface *> GetAvailableFunctions()
+{
+	std::vector<const MixFuncInterface *> tables{Functions};
+#if defined(MPT_MIXER_SSE2)
+	if(CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
+		tables.push_back(FunctionsSSE2);
+#endif
+#if defined(MPT_WANT_MIXER_AVX2)
+	if(GetFunctionsAVX2() && CPU::HasFeatureSet(CPU::feature::avx2) && CPU::HasModesEnabled(CPU::mode::xmm128sse | CPU::mode::ymm256avx))
+		tables.push_back(GetFunctionsAVX2());
+#endif
+#if defined(MPT_MIXER_NEON)
+	tables.push_back(FunctionsNEON);
+#endif
+	return tables;
+}
+
+
+const MixFuncInterface *GetFunctions()
+{
+#if defined(MODPLUG_TRACKER)
+	// CPU features can be disabled at runtime
+	return GetAvailableFunctions().back();
+#else
+	static const MixFuncInterface *const functions = GetAvailableFunctions().back();
+	return functions;
+#endif
+}
+
+
 ResamplingIndex ResamplingModeToMixFlags(ResamplingMode resamplingMode)
 {
 	switch(resamplingMode)
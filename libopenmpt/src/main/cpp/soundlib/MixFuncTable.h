@@ -12,8 +12,15 @@
 
 #include "openmpt/all/BuildSettings.hpp"
 
+#include "Mixer.h"
 #include "MixerInterface.h"
 
+#include <vector>
+
+#if defined(MPT_INTMIXER) && defined(MPT_WANT_ARCH_INTRINSICS_X86_AVX2)
+#define MPT_WANT_MIXER_AVX2
+#endif
+
 OPENMPT_NAMESPACE_BEGIN
 
 namespace MixFuncTable
@@ -44,8 +51,22 @@ namespace MixFuncTable
 		ndxAmigaBlep       = 0x50,
 	};
 
+	// Portable implementation of all mix functions
 	extern const MixFuncInterface Functions[6 * 16];
 
+	// Returns the fastest mix function table supported by the current CPU. The CPU is only checked on the first call.
+	// All tables produce bit-identical output.
+	const MixFuncInterface *GetFunctions();
+
+	// Returns all mix function tables supported by the current CPU, starting with the portable implementation.
+	std::vector<const MixFuncInterface *> GetAvailableFunctions();
+
+#if defined(MPT_WANT_MIXER_AVX2)
+	// Returns the AVX2 versions of the ndxFastSinc, ndxKaiser and ndxFIRFilter functions (in that order),
+	// or nullptr if the compiler could not generate AVX2 code. Does not check if the CPU supports AVX2.
+	const MixFuncInterface *GetInterpolationFunctionsAVX2();
+#endif // MPT_WANT_MIXER_AVX2
+
 	ResamplingIndex ResamplingModeToMixFlags(ResamplingMode resamplingMode);
 }
 
@@ -0,0 +1,119 @@
+/*
+ * MixFuncTableAVX2.cpp
+ * --------------------
+ * Purpose: Mixer functions using AVX2, chosen at runtime by MixFuncTable::GetFunctions().
+ * Notes  : With GCC and Clang, this file is the only one compiled with AVX2 code generation enabled (see Makefile).
+ *          Any inline function that is instantiated here and not inlined would be emitted with AVX2 instructions,
+ *          and the linker might then use that copy everywhere. To prevent this, the kernel type is local to this
+ *          file, which gives all mixer loops instantiated here internal linkage, and everything else used by the
+ *          loops is force-inlined.
+ *          If the compiler cannot generate AVX2 code for this file, no table is provided.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#include "stdafx.h"
+#include "MixFuncTable.h"
+#include "Mixer.h"
+#include "ModChannel.h"
+#include "Snd_defs.h"
+
+#ifdef MPT_INTMIXER
+#include "IntMixer.h"
+#include "IntMixerSIMD.h"
+#if defined(MPT_MIXER_SSE2) && defined(MPT_WANT_ARCH_INTRINSICS_X86_AVX2) && defined(MPT_ARCH_INTRINSICS_X86_AVX2)
+#define MPT_MIXER_AVX2
+#include <immintrin.h>
+#endif
+#endif // MPT_INTMIXER
+
+OPENMPT_NAMESPACE_BEGIN
+
+namespace MixFuncTable
+{
+
+#if defined(MPT_MIXER_AVX2)
+
+namespace
+{
+
+// Stereo 8-tap interpolation fits in a single 256-bit register. Everything else is identical to SSE2.
+struct MixKernelAVX2 : public MixKernelSSE2
+{
+	static MPT_FORCEINLINE __m256i LoadStereo8(const int16 *p) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)); }
+	static MPT_FORCEINLINE __m256i LoadStereo8(const int8 *p) { return _mm256_slli_epi16(_mm256_cvtepi8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))), 8); }
+
+	template<int numChannels, typename input_t>
+	static MPT_FORCEINLINE void Dot8(const input_t *inBuffer, const int16 *lut, int32 (&vol)[numChannels][2])
+	{
+		if constexpr(numChannels == 1)
+		{
+			MixKernelSSE2::Dot8<numChannels>(inBuffer, lut, vol);
+		} else
+		{
+			const __m128i coeffs = _mm_loadu_si128(reinterpret_cast<const __m128i *>(lut));
+			const __m256i coeffs2 = _mm256_inserti128_si256(_mm256_castsi128_si256(_mm_unpacklo_epi32(coeffs, coeffs)), _mm_unpackhi_epi32(coeffs, coeffs), 1);
+			// Shuffles work on each 128-bit lane separately, just like PairChannels
+			__m256i v = LoadStereo8(inBuffer - 6);
+			v = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(v, _MM_SHUFFLE(3, 1, 2, 0)), _MM_SHUFFLE(3, 1, 2, 0));
+			const __m256i sum = _mm256_madd_epi16(v, coeffs2);
+			Reduce8(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1), vol);
+		}
+	}
+};
+
+template<class Traits> using FastSincInterpolationAVX2 = FastSincInterpolationSIMD<Traits, MixKernelAVX2>;
+template<class Traits> using PolyphaseInterpolationAVX2 = PolyphaseInterpolationSIMD<Traits, MixKernelAVX2>;
+template<class Traits> using FIRFilterInterpolationAVX2 = FIRFilterInterpolationSIMD<Traits, MixKernelAVX2>;
+
+using I8M = Int8MToIntS;
+using I16M = Int16MToIntS;
+using I8S = Int8SToIntS;
+using I16S = Int16SToIntS;
+
+#define BuildMixFuncTableRamp(resampling, filter, ramp) \
+	SampleLoop<I8M, resampling<I8M>, filter<I8M>, MixMono ## ramp<I8M> >, \
+	SampleLoop<I16M, resampling<I16M>, filter<I16M>, MixMono ## ramp<I16M> >, \
+	SampleLoop<I8S, resampling<I8S>, filter<I8S>, MixStereo ## ramp<I8S> >, \
+	SampleLoop<I16S, resampling<I16S>, filter<I16S>, MixStereo ## ramp<I16S> >
+
+#define BuildMixFuncTableFilter(resampling, filter) \
+	BuildMixFuncTableRamp(resampling, filter, NoRamp), \
+	BuildMixFuncTableRamp(resampling, filter, Ramp)
+
+#define BuildMixFuncTable(resampling) \
+	BuildMixFuncTableFilter(resampling, NoFilter), \
+	BuildMixFuncTableFilter(resampling, ResonantFilter)
+
+// Only the vectorized interpolation modes (ndxFastSinc, ndxKaiser and ndxFIRFilter), the other entries are taken from the portable table
+const MixFuncInterface FunctionsAVX2[3 * 16] =
+{
+	BuildMixFuncTable(FastSincInterpolationAVX2),
+	BuildMixFuncTable(PolyphaseInterpolationAVX2),
+	BuildMixFuncTable(FIRFilterInterpolationAVX2),
+};
+
+#undef BuildMixFuncTableRamp
+#undef BuildMixFuncTableFilter
+#undef BuildMixFuncTable
+
+} // namespace
+
+#endif // MPT_MIXER_AVX2
+
+
+#if defined(MPT_WANT_MIXER_AVX2)
+const MixFuncInterface *GetInterpolationFunctionsAVX2()
+{
+#if defined(MPT_MIXER_AVX2)
+	return FunctionsAVX2;
+#else
+	return nullptr;
+#endif // MPT_MIXER_AVX2
+}
+#endif // MPT_WANT_MIXER_AVX2
+
+} // namespace MixFuncTable
+
+OPENMPT_NAMESPACE_END
@@ -0,0 +1,161 @@
+/*
+ * MixThreadPool.cpp
+ * -----------------
+ * Purpose: Worker threads for spreading independent mixer tasks (e.g. voices) across multiple cores.
+ * Notes  : (currently none)
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#include "stdafx.h"
+#include "MixThreadPool.h"
+
+#include <system_error>
+
+#ifdef MPT_ENABLE_MIX_THREADS
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+MixThreadPool::MixThreadPool(uint32 numThreads)
+{
+	try
+	{
+		m_workers.reserve(numThreads > 1 ? numThreads - 1 : 0);
+		for(uint32 i = 1; i < numThreads; i++)
+		{
+			m_workers.emplace_back(&MixThreadPool::WorkerLoop, this);
+		}
+	} catch(const std::system_error &)
+	{
+		// Continue with the threads we got
+	}
+}
+
+
+MixThreadPool::~MixThreadPool()
+{
+	StopWorkers();
+}
+
+
+// Number of times an idle thread polls for new work before it goes to sleep or starts yielding its time slice
+static constexpr int SpinCount = 4000;
+
+
+void MixThreadPool::StopWorkers()
+{
+	m_shutdown = true;
+	{
+		// Make sure that no worker is between checking m_shutdown and going to sleep
+		std::lock_guard<std::mutex> lock(m_mutex);
+	}
+	m_wakeWorkers.notify_all();
+	for(auto &worker : m_workers)
+	{
+		worker.join();
+	}
+	m_workers.clear();
+}
+
+
+void MixThreadPool::RunTasks(uint32 numTasks, TaskFunc func, const void *context)
+{
+	if(m_workers.empty() || numTasks < 2)
+	{
+		for(uint32 task = 0; task < numTasks; task++)
+		{
+			func(context, task);
+		}
+		return;
+	}
+
+	// No worker is part of the previous batch anymore, and workers only join the new one after seeing BatchOpen, so nobody reads these while we write them
+	m_func = func;
+	m_context = context;
+	m_numTasks = numTasks;
+	m_nextTask.store(0, std::memory_order_relaxed);
+	m_batchState.store(BatchOpen, std::memory_order_release);
+	// Sequentially consistent, so that either a worker that is about to sleep sees the new batch, or we see that it sleeps
+	m_batch.fetch_add(1);
+	if(m_sleepingWorkers.load() != 0)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+		}
+		m_wakeWorkers.notify_all();
+	}
+
+	ProcessTasks();
+
+	// All tasks have been claimed. Shut out the workers that have not joined yet, and wait only for those that are still finishing their last task.
+	m_batchState.fetch_and(~BatchOpen, std::memory_order_relaxed);
+	for(int spin = 0; m_batchState.load(std::memory_order_acquire) != 0; spin++)
+	{
+		if(spin >= SpinCount)
+			std::this_thread::yield();
+	}
+}
+
+
+bool MixThreadPool::JoinBatch()
+{
+	uint32 state = m_batchState.load(std::memory_order_relaxed);
+	do
+	{
+		if(!(state & BatchOpen))
+			return false;
+	} while(!m_batchState.compare_exchange_weak(state, state + 1, std::memory_order_acquire, std::memory_order_relaxed));
+	return true;
+}
+
+
+void MixThreadPool::ProcessTasks()
+{
+	uint32 task;
+	while((task = m_nextTask.fetch_add(1, std::memory_order_relaxed)) < m_numTasks)
+	{
+		m_func(m_context, task);
+	}
+}
+
+
+void MixThreadPool::WaitForBatch(uint32 lastBatch)
+{
+	for(int spin = 0; spin < SpinCount; spin++)
+	{
+		if(m_batch.load(std::memory_order_acquire) != lastBatch || m_shutdown.load(std::memory_order_relaxed))
+			return;
+	}
+
+	std::unique_lock<std::mutex> lock(m_mutex);
+	m_sleepingWorkers.fetch_add(1);
+	m_wakeWorkers.wait(lock, [&] { return m_shutdown.load() || m_batch.load() != lastBatch; });
+	m_sleepingWorkers.fetch_sub(1, std::memory_order_relaxed);
+}
+
+
+void MixThreadPool::WorkerLoop()
+{
+	uint32 batch = 0;
+	while(true)
+	{
+		WaitForBatch(batch);
+		if(m_shutdown)
+			return;
+		batch = m_batch.load(std::memory_order_acquire);
+
+		// If the calling thread has already finished this batch, there is nothing left to do.
+		// If it has started a newer one in the meantime, we join that one, and the next WaitForBatch returns immediately.
+		if(!JoinBatch())
+			continue;
+		ProcessTasks();
+		m_batchState.fetch_sub(1, std::memory_order_release);
+	}
+}
+
+
+OPENMPT_NAMESPACE_END
+
+#endif // MPT_ENABLE_MIX_THREADS
@@ -0,0 +1,82 @@
+/*
+ * MixThreadPool.h
+ * ---------------
+ * Purpose: Worker threads for spreading independent tasks (e.g. mixing voices or decoding samples) across multiple cores.
+ * Notes  : (currently none)
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#ifdef MPT_ENABLE_MIX_THREADS
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+class MixThreadPool
+{
+public:
+	// numThreads is the total number of threads working on a batch, including the calling thread.
+	// If not all worker threads can be created, the pool continues with fewer threads.
+	explicit MixThreadPool(uint32 numThreads);
+	~MixThreadPool();
+
+	MixThreadPool(const MixThreadPool &) = delete;
+	MixThreadPool &operator=(const MixThreadPool &) = delete;
+
+	uint32 GetNumThreads() const noexcept { return static_cast<uint32>(m_workers.size()) + 1; }
+
+	// Call func(task) for every task in [0, numTasks) and return once all calls have finished.
+	// Tasks are claimed one at a time from a shared counter, so threads that run out of work keep taking over the remaining tasks.
+	// The calling thread participates in processing. func must not throw.
+	// The calling thread never blocks on a lock: batches are handed over through atomics, and the mutex is only taken to wake
+	// workers that have been idle for long enough to go to sleep.
+	// Once all tasks have been claimed, only the workers that joined the batch are waited for. Workers that are still asleep
+	// or have not picked up the batch yet are shut out of it, so the calling thread never waits for a worker to wake up.
+	template <typename Tfunc>
+	void Run(uint32 numTasks, const Tfunc &func)
+	{
+		RunTasks(numTasks, [](const void *context, uint32 task) { (*static_cast<const Tfunc *>(context))(task); }, &func);
+	}
+
+private:
+	static constexpr uint32 BatchOpen = 0x80000000u;
+
+	using TaskFunc = void (*)(const void *context, uint32 task);
+
+	void RunTasks(uint32 numTasks, TaskFunc func, const void *context);
+	void ProcessTasks();
+	void WorkerLoop();
+	void WaitForBatch(uint32 lastBatch);
+	bool JoinBatch();
+	void StopWorkers();
+
+	std::vector<std::thread> m_workers;
+	std::mutex m_mutex;
+	std::condition_variable m_wakeWorkers;
+	std::atomic<uint32> m_batch{0};
+	// Number of workers processing the current batch, plus BatchOpen while workers may still join it
+	std::atomic<uint32> m_batchState{0};
+	std::atomic<uint32> m_sleepingWorkers{0};
+	std::atomic<bool> m_shutdown{false};
+
+	TaskFunc m_func = nullptr;
+	const void *m_context = nullptr;
+	uint32 m_numTasks = 0;
+	std::atomic<uint32> m_nextTask{0};
+};
+
+
+OPENMPT_NAMESPACE_END
+
+#endif // MPT_ENABLE_MIX_THREADS
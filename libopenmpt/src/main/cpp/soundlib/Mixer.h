@@ -16,7 +16,10 @@
 
 OPENMPT_NAMESPACE_BEGIN
 
+// Define MPT_FLOATMIXER to mix in 32-bit floating point instead of 27-bit fixed point.
+#ifndef MPT_FLOATMIXER
 #define MPT_INTMIXER
+#endif
 
 #ifdef MPT_INTMIXER
 using mixsample_t = MixSampleIntTraits::sample_type;
@@ -13,6 +13,25 @@
 #include "MixerLoops.h"
 #include "Snd_defs.h"
 #include "ModChannel.h"
+#include "MixerSettings.h"
+
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE2) && defined(MPT_ARCH_INTRINSICS_X86_SSE2)
+#define MPT_MIXERLOOPS_SSE2
+#endif
+#if defined(MPT_WANT_ARCH_INTRINSICS_ARM_NEON) && defined(__ARM_NEON)
+#define MPT_MIXERLOOPS_NEON
+#endif
+
+#if defined(MPT_MIXERLOOPS_SSE2)
+#include "../common/mptCPU.h"
+#if MPT_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#include <emmintrin.h>
+#endif
+#if defined(MPT_MIXERLOOPS_NEON)
+#include <arm_neon.h>
+#endif
 
 
 OPENMPT_NAMESPACE_BEGIN
@@ -71,6 +90,246 @@ void MonoFromStereo(mixsample_t *pMixBuf, uint32 nSamples)
 
 
 
+// Global volume and stereo separation for one interleaved stereo frame.
+// This is the reference implementation which all SIMD implementations must be bit-identical to.
+template<bool applyGain, bool applySeparation>
+struct StereoGainAndSeparation
+{
+#ifdef MPT_INTMIXER
+	const int32 gain;
+	const int32 separation;
+	StereoGainAndSeparation(int32 globalVolume, int32 separation_)
+		: gain{globalVolume}, separation{separation_} { }
+#else
+	const float gain;
+	const float sideFactor;
+	StereoGainAndSeparation(int32 globalVolume, int32 separation)
+		: gain{static_cast<float>(globalVolume) / static_cast<float>(MAX_GLOBAL_VOLUME)}
+		, sideFactor{(static_cast<float>(separation) / static_cast<float>(MixerSettings::StereoSeparationScale)) * 0.5f} { }
+#endif
+
+	MPT_FORCEINLINE void operator() (mixsample_t *frame) const
+	{
+		mixsample_t l = frame[0];
+		mixsample_t r = frame[1];
+		if constexpr(applyGain)
+		{
+#ifdef MPT_INTMIXER
+			l = Util::muldiv(l, gain, MAX_GLOBAL_VOLUME);
+			r = Util::muldiv(r, gain, MAX_GLOBAL_VOLUME);
+#else
+			l *= gain;
+			r *= gain;
+#endif
+		}
+		if constexpr(applySeparation)
+		{
+			// Mid/side processing: 128 = normal, 0 = mono, negative values swap L/R
+			mixsample_t m = l + r;
+			mixsample_t s = l - r;
+#ifdef MPT_INTMIXER
+			m /= 2;
+			s = Util::muldiv(s, separation, MixerSettings::StereoSeparationScale * 2);
+#else
+			m *= 0.5f;
+			s *= sideFactor;
+#endif
+			l = m + s;
+			r = m - s;
+		}
+		frame[0] = l;
+		frame[1] = r;
+	}
+};
+
+
+#if defined(MPT_MIXERLOOPS_SSE2)
+
+// Processes two stereo frames per iteration.
+// The integer version does the 32x32 bit multiplications in double precision, where they are exact, and truncates like integer division would.
+template<bool applyGain, bool applySeparation>
+static void ApplyStereoGainAndSeparationSSE2(mixsample_t *pMixBuf, uint32 nFrames, const StereoGainAndSeparation<applyGain, applySeparation> &scalar)
+{
+#ifdef MPT_INTMIXER
+	const __m128d minVal = _mm_set1_pd(static_cast<double>(int32_min));
+	const __m128d maxVal = _mm_set1_pd(static_cast<double>(int32_max));
+	for(uint32 i = nFrames / 2; i != 0; i--)
+	{
+		__m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(pMixBuf));
+		if constexpr(applyGain)
+		{
+			const __m128d gain = _mm_set1_pd(static_cast<double>(scalar.gain) / MAX_GLOBAL_VOLUME);
+			const __m128d lo = _mm_mul_pd(_mm_cvtepi32_pd(x), gain);
+			const __m128d hi = _mm_mul_pd(_mm_cvtepi32_pd(_mm_shuffle_epi32(x, _MM_SHUFFLE(1, 0, 3, 2))), gain);
+			x = _mm_unpacklo_epi64(
+				_mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(lo, minVal), maxVal)),
+				_mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(hi, minVal), maxVal)));
+		}
+		if constexpr(applySeparation)
+		{
+			const __m128d side = _mm_set1_pd(static_cast<double>(scalar.separation) / (MixerSettings::StereoSeparationScale * 2));
+			const __m128i negateRight = _mm_set_epi32(-1, 0, -1, 0);
+			const __m128i swapped = _mm_shuffle_epi32(x, _MM_SHUFFLE(2, 3, 0, 1));
+			const __m128i sum = _mm_add_epi32(x, swapped);
+			const __m128i diff = _mm_sub_epi32(x, swapped);
+			// Round towards zero
+			const __m128i m = _mm_srai_epi32(_mm_add_epi32(sum, _mm_srli_epi32(sum, 31)), 1);
+			// Side signal is computed once per frame and subtracted from the right channel
+			const __m128d sideIn = _mm_cvtepi32_pd(_mm_shuffle_epi32(diff, _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i s = _mm_cvttpd_epi32(_mm_min_pd(_mm_max_pd(_mm_mul_pd(sideIn, side), minVal), maxVal));
+			s = _mm_shuffle_epi32(s, _MM_SHUFFLE(1, 1, 0, 0));
+			s = _mm_sub_epi32(_mm_xor_si128(s, negateRight), negateRight);
+			x = _mm_add_epi32(m, s);
+		}
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(pMixBuf), x);
+		pMixBuf += 4;
+	}
+#else
+	for(uint32 i = nFrames / 2; i != 0; i--)
+	{
+		__m128 x = _mm_loadu_ps(pMixBuf);
+		if constexpr(applyGain)
+		{
+			x = _mm_mul_ps(x, _mm_set1_ps(scalar.gain));
+		}
+		if constexpr(applySeparation)
+		{
+			// The right channel computes m + (-s), which is identical to m - s
+			const __m128 swapped = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+			const __m128 m = _mm_mul_ps(_mm_add_ps(x, swapped), _mm_set1_ps(0.5f));
+			const __m128 s = _mm_mul_ps(_mm_sub_ps(x, swapped), _mm_set1_ps(scalar.sideFactor));
+			x = _mm_add_ps(m, s);
+		}
+		_mm_storeu_ps(pMixBuf, x);
+		pMixBuf += 4;
+	}
+#endif // MPT_INTMIXER
+	if(nFrames % 2u)
+	{
+		scalar(pMixBuf);
+	}
+}
+
+#endif // MPT_MIXERLOOPS_SSE2
+
+
+#if defined(MPT_MIXERLOOPS_NEON)
+
+// Processes two stereo frames per iteration.
+template<bool applyGain, bool applySeparation>
+static void ApplyStereoGainAndSeparationNEON(mixsample_t *pMixBuf, uint32 nFrames, const StereoGainAndSeparation<applyGain, applySeparation> &scalar)
+{
+#ifdef MPT_INTMIXER
+	// Truncating division of a 64-bit product by 256, saturated to 32 bits
+	const auto divide = [](int64x2_t v)
+	{
+		v = vaddq_s64(v, vreinterpretq_s64_u64(vshrq_n_u64(vreinterpretq_u64_s64(vshrq_n_s64(v, 63)), 56)));
+		return vqmovn_s64(vshrq_n_s64(v, 8));
+	};
+	static_assert(MAX_GLOBAL_VOLUME == 256 && MixerSettings::StereoSeparationScale * 2 == 256);
+	for(uint32 i = nFrames / 2; i != 0; i--)
+	{
+		int32x4_t x = vld1q_s32(pMixBuf);
+		if constexpr(applyGain)
+		{
+			const int32x2_t gain = vdup_n_s32(scalar.gain);
+			x = vcombine_s32(divide(vmull_s32(vget_low_s32(x), gain)), divide(vmull_s32(vget_high_s32(x), gain)));
+		}
+		if constexpr(applySeparation)
+		{
+			const int32x4_t swapped = vrev64q_s32(x);
+			const int32x4_t sum = vaddq_s32(x, swapped);
+			const int32x4_t diff = vsubq_s32(x, swapped);
+			// Round towards zero
+			const int32x4_t m = vshrq_n_s32(vaddq_s32(sum, vreinterpretq_s32_u32(vshrq_n_u32(vreinterpretq_u32_s32(sum), 31))), 1);
+			// Side signal is computed once per frame and subtracted from the right channel
+			const int32x2_t s = divide(vmull_s32(vget_low_s32(vuzpq_s32(diff, diff).val[0]), vdup_n_s32(scalar.separation)));
+			const int32x2x2_t sides = vzip_s32(s, vneg_s32(s));
+			x = vaddq_s32(m, vcombine_s32(sides.val[0], sides.val[1]));
+		}
+		vst1q_s32(pMixBuf, x);
+		pMixBuf += 4;
+	}
+#else
+	for(uint32 i = nFrames / 2; i != 0; i--)
+	{
+		float32x4_t x = vld1q_f32(pMixBuf);
+		if constexpr(applyGain)
+		{
+			x = vmulq_n_f32(x, scalar.gain);
+		}
+		if constexpr(applySeparation)
+		{
+			// The right channel computes m + (-s), which is identical to m - s
+			const float32x4_t swapped = vrev64q_f32(x);
+			const float32x4_t m = vmulq_n_f32(vaddq_f32(x, swapped), 0.5f);
+			const float32x4_t s = vmulq_n_f32(vsubq_f32(x, swapped), scalar.sideFactor);
+			x = vaddq_f32(m, s);
+		}
+		vst1q_f32(pMixBuf, x);
+		pMixBuf += 4;
+	}
+#endif // MPT_INTMIXER
+	if(nFrames % 2u)
+	{
+		scalar(pMixBuf);
+	}
+}
+
+#endif // MPT_MIXERLOOPS_NEON
+
+
+template<bool applyGain, bool applySeparation>
+static void ApplyStereoGainAndSeparationImpl(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool allowSIMD)
+{
+	const StereoGainAndSeparation<applyGain, applySeparation> scalar{globalVolume, separation};
+#if defined(MPT_MIXERLOOPS_SSE2)
+	if(allowSIMD && CPU::HasFeatureSet(CPU::feature::sse2) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
+	{
+		ApplyStereoGainAndSeparationSSE2(pMixBuf, nFrames, scalar);
+		return;
+	}
+#endif
+#if defined(MPT_MIXERLOOPS_NEON)
+	if(allowSIMD)
+	{
+		ApplyStereoGainAndSeparationNEON(pMixBuf, nFrames, scalar);
+		return;
+	}
+#endif
+	MPT_UNUSED_VARIABLE(allowSIMD);
+	for(uint32 i = 0; i < nFrames; i++)
+	{
+		scalar(pMixBuf);
+		pMixBuf += 2;
+	}
+}
+
+
+static void ApplyStereoGainAndSeparation(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool applyGain, bool applySeparation, bool allowSIMD)
+{
+	if(applyGain && applySeparation)
+		ApplyStereoGainAndSeparationImpl<true, true>(pMixBuf, nFrames, globalVolume, separation, allowSIMD);
+	else if(applyGain)
+		ApplyStereoGainAndSeparationImpl<true, false>(pMixBuf, nFrames, globalVolume, separation, allowSIMD);
+	else if(applySeparation)
+		ApplyStereoGainAndSeparationImpl<false, true>(pMixBuf, nFrames, globalVolume, separation, allowSIMD);
+}
+
+
+void ApplyStereoGainAndSeparation(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool applyGain, bool applySeparation)
+{
+	ApplyStereoGainAndSeparation(pMixBuf, nFrames, globalVolume, separation, applyGain, applySeparation, true);
+}
+
+
+void ApplyStereoGainAndSeparationScalar(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool applyGain, bool applySeparation)
+{
+	ApplyStereoGainAndSeparation(pMixBuf, nFrames, globalVolume, separation, applyGain, applySeparation, false);
+}
+
+
+
 #define OFSDECAYSHIFT	8
 #define OFSDECAYMASK	0xFF
 #define OFSTHRESHOLD	static_cast<mixsample_t>(1.0 / (1 << 20))	// Decay threshold for floating point mixer
@@ -24,6 +24,10 @@ void FloatToStereoMix(const float *pIn1, const float *pIn2, int32 *pOut, uint32
 void InitMixBuffer(mixsample_t *pBuffer, uint32 nSamples);
 void InterleaveFrontRear(mixsample_t *pFrontBuf, mixsample_t *pRearBuf, uint32 nFrames);
 void MonoFromStereo(mixsample_t *pMixBuf, uint32 nSamples);
+// Apply global volume (0...MAX_GLOBAL_VOLUME) and / or stereo separation (see MixerSettings::m_nStereoSeparation) to an interleaved stereo buffer in a single pass
+void ApplyStereoGainAndSeparation(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool applyGain, bool applySeparation);
+// Portable implementation of ApplyStereoGainAndSeparation, for verifying the SIMD implementations
+void ApplyStereoGainAndSeparationScalar(mixsample_t *pMixBuf, uint32 nFrames, int32 globalVolume, int32 separation, bool applyGain, bool applySeparation);
 
 #ifndef MPT_INTMIXER
 void InterleaveStereo(const mixsample_t * MPT_RESTRICT inputL, const mixsample_t * MPT_RESTRICT inputR, mixsample_t * MPT_RESTRICT output, size_t numSamples);
@@ -166,6 +166,19 @@ bool ModChannel::HasMIDIOutput() const noexcept
 }
 
 
+bool ModChannel::IsAvailableForNNA() const noexcept
+{
+	// Sample playing?
+	if(nLength)
+		return false;
+	// Can a plugin potentially be playing?
+	if(!HasMIDIOutput())
+		return true;
+	// Has the plugin note already been released? (note: lastMidiNoteWithoutArp is set from within IMixPlugin, so this implies that there is a valid plugin assignment)
+	return dwFlags[CHN_KEYOFF | CHN_NOTEFADE] || lastMidiNoteWithoutArp == NOTE_NONE;
+}
+
+
 bool ModChannel::HasCustomTuning() const noexcept
 {
 	return pModInstrument != nullptr && pModInstrument->pTuning != nullptr;
@@ -222,6 +222,8 @@ struct ModChannel
 
 	// Check if the channel has a valid MIDI output. A return value of true implies that pModInstrument != nullptr.
 	bool HasMIDIOutput() const noexcept;
+	// Check if the channel neither plays a sample nor may still be holding a plugin note, so that it can be reused as an NNA channel.
+	bool IsAvailableForNNA() const noexcept;
 	// Check if the channel uses custom tuning. A return value of true implies that pModInstrument != nullptr.
 	bool HasCustomTuning() const noexcept;
 
@@ -16,11 +16,40 @@
 #include "mpt/base/numbers.hpp"
 
 #include <cmath>
+#include <limits>
+
+#ifdef MPT_ENABLE_MAPPED_SAMPLES
+#include <sys/mman.h>
+#include <unistd.h>
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif // MPT_ENABLE_MAPPED_SAMPLES
 
 
 OPENMPT_NAMESPACE_BEGIN
 
 
+// Every sample buffer is preceded by this header (followed by the silent lookahead area before the sample start),
+// so that FreeSample knows how the buffer was obtained.
+struct SampleBufferHeader
+{
+	void *base = nullptr;  // Start of the allocation or mapping
+	size_t size = 0;       // Size of the mapping, if mapped
+	bool mapped = false;
+};
+
+static constexpr size_t SampleBufferHeaderSize = 32;
+static_assert(sizeof(SampleBufferHeader) <= SampleBufferHeaderSize);
+// Distance between start of the header and the sample data
+static constexpr size_t SampleBufferPreambleSize = SampleBufferHeaderSize + InterpolationLookaheadBufferSize * MaxSamplingPointSize;
+
+#ifdef MPT_ENABLE_MAPPED_SAMPLES
+// Samples smaller than this are copied as usual, as mapping them would not save any memory.
+static constexpr size_t MinMappedSampleSize = 64 * 1024;
+#endif // MPT_ENABLE_MAPPED_SAMPLES
+
+
 // Translate sample properties between two given formats.
 void ModSample::Convert(MODTYPE fromType, MODTYPE toType)
 {
@@ -246,13 +275,16 @@ void *ModSample::AllocateSample(SmpLength numFrames, size_t bytesPerSample)
 {
 	const size_t allocSize = GetRealSampleBufferSize(numFrames, bytesPerSample);
 
-	if(allocSize != 0)
+	if(allocSize != 0 && allocSize <= std::numeric_limits<size_t>::max() - SampleBufferHeaderSize)
 	{
-		char *p = new(std::nothrow) char[allocSize];
+		char *p = new(std::nothrow) char[SampleBufferHeaderSize + allocSize];
 		if(p != nullptr)
 		{
-			memset(p, 0, allocSize);
-			return p + (InterpolationLookaheadBufferSize * MaxSamplingPointSize);
+			memset(p, 0, SampleBufferHeaderSize + allocSize);
+			SampleBufferHeader header;
+			header.base = p;
+			memcpy(p, &header, sizeof(header));
+			return p + SampleBufferPreambleSize;
 		}
 	}
 	return nullptr;
@@ -298,8 +330,90 @@ void ModSample::FreeSample(void *samplePtr)
 {
 	if(samplePtr)
 	{
-		delete[](((char *)samplePtr) - (InterpolationLookaheadBufferSize * MaxSamplingPointSize));
+		SampleBufferHeader header;
+		memcpy(&header, static_cast<const char *>(samplePtr) - SampleBufferPreambleSize, sizeof(header));
+#ifdef MPT_ENABLE_MAPPED_SAMPLES
+		if(header.mapped)
+		{
+			munmap(header.base, header.size);
+			return;
+		}
+#endif // MPT_ENABLE_MAPPED_SAMPLES
+		delete[] static_cast<char *>(header.base);
+	}
+}
+
+
+bool ModSample::MapSample(const SampleMappingSource &source, const std::byte *data)
+{
+#ifdef MPT_ENABLE_MAPPED_SAMPLES
+	const size_t dataSize = GetSampleSizeInBytes();
+	const size_t bufferSize = GetRealSampleBufferSize(nLength, GetBytesPerSample());
+	if(source.fd < 0 || source.data == nullptr || bufferSize == 0 || dataSize < MinMappedSampleSize)
+		return false;
+	if(data < source.data || static_cast<uint64>(data - source.data) > source.size || dataSize > source.size - static_cast<uint64>(data - source.data))
+		return false;
+	const uint64 offset = static_cast<uint64>(data - source.data);
+	if(offset % GetElementarySampleSize() != 0)
+		return false;
+	const long pageSizeResult = sysconf(_SC_PAGESIZE);
+	if(pageSizeResult <= 0)
+		return false;
+	const size_t pageSize = static_cast<size_t>(pageSizeResult);
+	const auto roundUpToPage = [pageSize](size_t size) { return (size + pageSize - 1) / pageSize * pageSize; };
+
+	// The mapping looks exactly like a buffer returned by AllocateSample:
+	// header and silent lookahead area, the sample data, then the silence and loop lookahead areas written by PrecomputeLoops.
+	// The pages containing the sample data are mapped privately from the file, the remaining parts are anonymous memory.
+	const uint64 fileMapOffset = offset - offset % pageSize;
+	if(fileMapOffset > static_cast<uint64>(std::numeric_limits<off_t>::max()))
+		return false;
+	const size_t inPageOffset = static_cast<size_t>(offset - fileMapOffset);
+	const size_t leadSize = (inPageOffset >= SampleBufferPreambleSize) ? 0 : roundUpToPage(SampleBufferPreambleSize - inPageOffset);
+	const size_t fileMapSize = roundUpToPage(inPageOffset + dataSize);
+	const size_t trailSize = bufferSize - InterpolationLookaheadBufferSize * MaxSamplingPointSize - dataSize;
+	const size_t totalSize = leadSize + roundUpToPage(inPageOffset + dataSize + trailSize);
+
+	void *base = mmap(nullptr, totalSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	if(base == MAP_FAILED)
+		return false;
+	std::byte *fileMap = static_cast<std::byte *>(base) + leadSize;
+	if(mmap(fileMap, fileMapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, source.fd, static_cast<off_t>(fileMapOffset)) == MAP_FAILED)
+	{
+		munmap(base, totalSize);
+		return false;
 	}
+
+	// Overwrite the neighbouring file contents that share the first and last page with the sample data.
+	// Only these pages become private copies.
+	std::byte *sampleStart = fileMap + inPageOffset;
+	std::byte *sampleEnd = sampleStart + dataSize;
+	memset(sampleStart - SampleBufferPreambleSize, 0, SampleBufferPreambleSize);
+	memset(sampleEnd, 0, std::min(trailSize, static_cast<size_t>(fileMap + fileMapSize - sampleEnd)));
+	SampleBufferHeader header;
+	header.base = base;
+	header.size = totalSize;
+	header.mapped = true;
+	memcpy(sampleStart - SampleBufferPreambleSize, &header, sizeof(header));
+
+	FreeSample();
+	pData.pSample = sampleStart;
+	return true;
+#else
+	MPT_UNUSED(source);
+	MPT_UNUSED(data);
+	return false;
+#endif // MPT_ENABLE_MAPPED_SAMPLES
+}
+
+
+bool ModSample::HasMappedSampleData() const noexcept
+{
+	if(!pData.pSample)
+		return false;
+	SampleBufferHeader header;
+	memcpy(&header, static_cast<const char *>(pData.pSample) - SampleBufferPreambleSize, sizeof(header));
+	return header.mapped;
 }
 
 
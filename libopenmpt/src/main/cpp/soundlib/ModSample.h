@@ -17,6 +17,14 @@ OPENMPT_NAMESPACE_BEGIN
 
 class CSoundFile;
 
+// A memory-mapped module file from which uncompressed sample data can be mapped directly, see ModSample::MapSample
+struct SampleMappingSource
+{
+	int fd = -1;                      // Open file descriptor of the module file
+	const std::byte *data = nullptr;  // Start of the complete module file in memory
+	uint64 size = 0;                  // Size of the module file
+};
+
 // Sample Struct
 struct ModSample
 {
@@ -141,6 +149,15 @@ struct ModSample
 	// Compute sample buffer size in bytes, including any overhead introduced by pre-computed loops and such. Returns 0 if sample is too big.
 	static size_t GetRealSampleBufferSize(SmpLength numSamples, size_t bytesPerSample);
 
+	// Map the sample data, which must be located at the given address inside the source file, directly from the file instead of allocating and copying it.
+	// The data must already be in the format described by nLength and the sample flags.
+	// Only the memory pages around the sample start and end become private copies; the pages in between are shared with the operating system's page cache.
+	// Returns false if the data cannot be mapped (e.g. because it is too small to benefit, or if mapping is not supported on this platform), in which case nothing is changed.
+	// Note that pages that have not been accessed yet are read from disk on first access, i.e. while rendering, so mapped samples are not real-time safe.
+	bool MapSample(const SampleMappingSource &source, const std::byte *data);
+	// Returns true if the sample data was mapped from a file by MapSample.
+	bool HasMappedSampleData() const noexcept;
+
 	void FreeSample();
 	static void FreeSample(void *samplePtr);
 
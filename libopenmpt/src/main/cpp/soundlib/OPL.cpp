@@ -53,20 +53,29 @@ void OPL::Initialize(uint32 sampleRate)
 }
 
 
-void OPL::Mix(int32 *target, size_t count, uint32 volumeFactorQ16)
+void OPL::Mix(mixsample_t *target, size_t count, uint32 volumeFactorQ16)
 {
 	if(!m_isActive)
 		return;
 
 	// This factor causes a sample voice to be more or less as loud as an OPL voice
+#ifdef MPT_INTMIXER
 	const int32 factor = Util::muldiv_unsigned(volumeFactorQ16, 6169, (1 << 16));
-	while(count--)
+#else
+	const float factor = static_cast<float>(Util::muldiv_unsigned(volumeFactorQ16, 6169, (1 << 16))) * (1.0f / MIXING_SCALEF);
+#endif // MPT_INTMIXER
+	int16 lr[256 * 2];
+	while(count > 0)
 	{
-		int16 l, r;
-		m_opl->Sample(&l, &r);
-		target[0] += l * factor;
-		target[1] += r * factor;
-		target += 2;
+		const size_t block = std::min(count, std::size(lr) / 2);
+		m_opl->Render(lr, block);
+		for(size_t i = 0; i < block; i++)
+		{
+			target[0] += lr[i * 2] * factor;
+			target[1] += lr[i * 2 + 1] * factor;
+			target += 2;
+		}
+		count -= block;
 	}
 }
 
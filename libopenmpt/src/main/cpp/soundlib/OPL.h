@@ -12,6 +12,7 @@
 #include "openmpt/all/BuildSettings.hpp"
 
 #include "Snd_defs.h"
+#include "Mixer.h"
 
 OPENMPT_NAMESPACE_BEGIN
 
@@ -85,7 +86,7 @@ public:
 	~OPL();
 
 	void Initialize(uint32 sampleRate);
-	void Mix(int32 *buffer, size_t count, uint32 volumeFactorQ16);
+	void Mix(mixsample_t *buffer, size_t count, uint32 volumeFactorQ16);
 
 	void NoteOff(CHANNELINDEX c);
 	void NoteCut(CHANNELINDEX c, bool unassign = true);
@@ -94,6 +95,8 @@ public:
 	int8 Pan(CHANNELINDEX c, int32 pan);
 	void Patch(CHANNELINDEX c, const OPLPatch &patch);
 	bool IsActive(CHANNELINDEX c) const { return GetVoice(c) != OPL_CHANNEL_INVALID; }
+	// Once any voice has been played, the emulator's envelopes and LFOs keep running until the next reset
+	bool IsRunning() const { return m_isActive; }
 	void MoveChannel(CHANNELINDEX from, CHANNELINDEX to);
 	void Reset();
 
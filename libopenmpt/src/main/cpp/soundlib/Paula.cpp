@@ -14,6 +14,7 @@
 #include "Tables.h"
 #include "mpt/base/numbers.hpp"
 
+#include <algorithm>
 #include <complex>
 #include <numeric>
 
@@ -251,6 +252,15 @@ void BlepTables::InitTables()
 }
 
 
+void BlepTables::InitTables(const mixsample_t (&tables)[NumTables][BLEP_SIZE])
+{
+	for(std::size_t i = 0; i < NumTables; i++)
+	{
+		std::copy(std::begin(tables[i]), std::end(tables[i]), WinSincIntegral[i].begin());
+	}
+}
+
+
 const Paula::BlepArray &BlepTables::GetAmigaTable(Resampling::AmigaFilter amigaType, bool enableFilter) const
 {
 	if(amigaType == Resampling::AmigaFilter::A500)
@@ -296,9 +306,9 @@ void State::InputSample(int16 sample)
 
 
 // Return output simulated as series of bleps
-int State::OutputSample(const BlepArray &WinSincIntegral)
+mixsample_t State::OutputSample(const BlepArray &WinSincIntegral)
 {
-	int output = globalOutputLevel * (1 << Paula::BLEP_SCALE);
+	mixsample_t output = globalOutputLevel * (1 << Paula::BLEP_SCALE);
 	uint32 lastBlep = firstBlep + activeBleps;
 	for(uint32 i = firstBlep; i != lastBlep; i++)
 	{
@@ -307,6 +317,8 @@ int State::OutputSample(const BlepArray &WinSincIntegral)
 	}
 #ifdef MPT_INTMIXER
 	output /= (1 << (Paula::BLEP_SCALE - 2));	// - 2 to compensate for the fact that we reduced the input sample bit depth
+#else
+	output *= (1.0f / (1 << 13));	// The input sample was reduced to 14 bits
 #endif
 
 	return output;
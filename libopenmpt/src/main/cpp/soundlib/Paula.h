@@ -22,7 +22,11 @@ namespace Paula
 
 inline constexpr int PAULA_HZ = 3546895;
 inline constexpr int MINIMUM_INTERVAL = 4;  // Tradeoff between quality and speed (lower = less aliasing)
-inline constexpr int BLEP_SCALE = 17;  // TODO: Should be 0 for float mixer
+#ifdef MPT_INTMIXER
+inline constexpr int BLEP_SCALE = 17;
+#else
+inline constexpr int BLEP_SCALE = 0;
+#endif // MPT_INTMIXER
 inline constexpr int BLEP_SIZE = 2048;
 
 using BlepArray = std::array<mixsample_t, BLEP_SIZE>;
@@ -43,7 +47,11 @@ class BlepTables
 	std::array<Paula::BlepArray, AmigaFilter::NumFilterTypes> WinSincIntegral;
 
 public:
+	static constexpr std::size_t NumTables = AmigaFilter::NumFilterTypes;
+
 	void InitTables();
+	// Use precomputed tables (in the order of the AmigaFilter enum) instead of computing them
+	void InitTables(const mixsample_t (&tables)[NumTables][BLEP_SIZE]);
 	const Paula::BlepArray &GetAmigaTable(Resampling::AmigaFilter amigaType, bool enableFilter) const;
 };
 
@@ -77,7 +85,7 @@ public:
 
 	void Reset();
 	void InputSample(int16 sample);
-	int OutputSample(const BlepArray &WinSincIntegral);
+	mixsample_t OutputSample(const BlepArray &WinSincIntegral);
 	void Clock(int cycles);
 };
 
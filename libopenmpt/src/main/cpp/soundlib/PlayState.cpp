@@ -14,6 +14,8 @@
 #include "Mixer.h"
 #include "Sndfile.h"
 
+#include "mpt/base/bit.hpp"
+
 
 OPENMPT_NAMESPACE_BEGIN
 
@@ -61,6 +63,74 @@ void PlayState::UpdatePPQ(bool patternTransition) noexcept
 }
 
 
+template<typename TFrom, typename TTo>
+void PlayState::CopyGlobalState(const TFrom &from, TTo &to)
+{
+	to.m_lTotalSampleCount = from.m_lTotalSampleCount;
+	to.m_nBufferCount = from.m_nBufferCount;
+	to.m_dBufferDiff = from.m_dBufferDiff;
+	to.m_ppqPosFract = from.m_ppqPosFract;
+	to.m_ppqPosBeat = from.m_ppqPosBeat;
+	to.m_nTickCount = from.m_nTickCount;
+	to.m_nPatternDelay = from.m_nPatternDelay;
+	to.m_nFrameDelay = from.m_nFrameDelay;
+	to.m_nSamplesPerTick = from.m_nSamplesPerTick;
+	to.m_nCurrentRowsPerBeat = from.m_nCurrentRowsPerBeat;
+	to.m_nCurrentRowsPerMeasure = from.m_nCurrentRowsPerMeasure;
+	to.m_nMusicSpeed = from.m_nMusicSpeed;
+	to.m_nMusicTempo = from.m_nMusicTempo;
+	to.m_nRow = from.m_nRow;
+	to.m_nNextRow = from.m_nNextRow;
+	to.m_nextPatStartRow = from.m_nextPatStartRow;
+	to.m_breakRow = from.m_breakRow;
+	to.m_patLoopRow = from.m_patLoopRow;
+	to.m_posJump = from.m_posJump;
+	to.m_nPattern = from.m_nPattern;
+	to.m_nCurrentOrder = from.m_nCurrentOrder;
+	to.m_nNextOrder = from.m_nNextOrder;
+	to.m_nSeqOverride = from.m_nSeqOverride;
+	to.m_seqOverrideMode = from.m_seqOverrideMode;
+	to.m_nGlobalVolume = from.m_nGlobalVolume;
+	to.m_nSamplesToGlobalVolRampDest = from.m_nSamplesToGlobalVolRampDest;
+	to.m_nGlobalVolumeRampAmount = from.m_nGlobalVolumeRampAmount;
+	to.m_nGlobalVolumeDestination = from.m_nGlobalVolumeDestination;
+	to.m_lHighResRampingGlobalVolume = from.m_lHighResRampingGlobalVolume;
+	to.m_flags = from.m_flags;
+	to.m_globalScriptState = from.m_globalScriptState;
+	to.m_midiMacroEvaluationResults = from.m_midiMacroEvaluationResults;
+}
+
+
+void PlayState::SaveCheckpoint(Checkpoint &checkpoint, const CSoundFile &sndFile) const
+{
+	CopyGlobalState(*this, checkpoint);
+	const auto channels = PatternChannels(sndFile);
+	checkpoint.patternChannels.assign(channels.begin(), channels.end());
+}
+
+
+void PlayState::RestoreCheckpoint(const Checkpoint &checkpoint, const CSoundFile &sndFile)
+{
+	CopyGlobalState(checkpoint, *this);
+	const size_t numChannels = std::min(checkpoint.patternChannels.size(), Chn.size());
+	std::copy(checkpoint.patternChannels.begin(), checkpoint.patternChannels.begin() + numChannels, Chn.begin());
+	// Same as ModChannel::Reset with resetChannelSettings
+	const auto muteFlag = CSoundFile::GetChannelMuteFlag();
+	for(CHANNELINDEX chn = 0; chn < std::min(numChannels, sndFile.ChnSettings.size()); chn++)
+	{
+		const auto &settings = sndFile.ChnSettings[chn].dwFlags;
+		ModChannel &channel = Chn[chn];
+		channel.dwFlags.reset(CHN_MUTE | CHN_SYNCMUTE | CHN_NOFX);
+		if(settings[CHN_SYNCMUTE])
+			channel.dwFlags.set(CHN_SYNCMUTE);
+		if(settings[CHN_MUTE])
+			channel.dwFlags.set(muteFlag);
+		if(settings[CHN_NOFX])
+			channel.dwFlags.set(CHN_NOFX);
+	}
+}
+
+
 mpt::span<ModChannel> PlayState::PatternChannels(const CSoundFile &sndFile) noexcept
 {
 	return mpt::as_span(Chn).subspan(0, std::min(Chn.size(), static_cast<size_t>(sndFile.GetNumChannels())));
@@ -73,4 +143,34 @@ mpt::span<ModChannel> PlayState::BackgroundChannels(const CSoundFile &sndFile) n
 }
 
 
+CHANNELINDEX PlayState::FindChannelBit(CHANNELINDEX chn, uint32 invert) const noexcept
+{
+	size_t word = chn / kChannelMaskBits;
+	if(word >= m_backgroundChannelsInUse.size())
+		return static_cast<CHANNELINDEX>(Chn.size());
+	// Mask out the channels below chn in the first word
+	uint32 bits = (m_backgroundChannelsInUse[word] ^ invert) & (~uint32(0) << (chn % kChannelMaskBits));
+	while(!bits)
+	{
+		if(++word >= m_backgroundChannelsInUse.size())
+			return static_cast<CHANNELINDEX>(Chn.size());
+		bits = m_backgroundChannelsInUse[word] ^ invert;
+	}
+	return static_cast<CHANNELINDEX>(word * kChannelMaskBits + mpt::countr_zero(bits));
+}
+
+
+#ifdef MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+bool PlayState::BackgroundChannelMaskIsValid(const CSoundFile &sndFile) const noexcept
+{
+	for(CHANNELINDEX chn = sndFile.GetNumChannels(); chn < Chn.size(); chn++)
+	{
+		if(!IsBackgroundChannelInUse(chn) && !Chn[chn].IsAvailableForNNA())
+			return false;
+	}
+	return true;
+}
+#endif  // MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+
+
 OPENMPT_NAMESPACE_END
@@ -20,6 +20,10 @@
 
 OPENMPT_NAMESPACE_BEGIN
 
+#if defined(MPT_BUILD_DEBUG) || defined(MPT_BUILD_FUZZER)
+#define MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+#endif  // MPT_BUILD_DEBUG || MPT_BUILD_FUZZER
+
 struct PlayState
 {
 	friend class CSoundFile;
@@ -71,6 +75,16 @@ protected:
 public:
 	FlagSet<PlayFlags> m_flags = SONG_POSITIONCHANGED;
 
+protected:
+	// One bit per channel in Chn: Set if the background channel may be in use, i.e. play a sample or hold a plugin note.
+	// A cleared bit guarantees that the background channel is idle and can be reused for NNA without further checks,
+	// so that per-tick processing and NNA channel allocation only have to look at the channels that are actually in use.
+	// Bits of pattern channels are meaningless.
+	static constexpr size_t kChannelMaskBits = 32;
+	std::array<uint32, MAX_CHANNELS / kChannelMaskBits> m_backgroundChannelsInUse{};
+	static_assert(MAX_CHANNELS % kChannelMaskBits == 0);
+
+public:
 	std::array<CHANNELINDEX, MAX_CHANNELS> ChnMix;  // Index of channels in Chn to be actually mixed
 	std::array<ModChannel, MAX_CHANNELS> Chn;       // Mixing channels... First m_nChannels channels are directly mapped to pattern channels (i.e. they are never NNA channels)!
 	GlobalScriptState m_globalScriptState;
@@ -84,11 +98,55 @@ public:
 	std::vector<uint8> m_midiMacroScratchSpace;
 	std::optional<MIDIMacroEvaluationResults> m_midiMacroEvaluationResults;
 
+	// Copy of the playback state that only contains the pattern channels.
+	// A full PlayState is far too large to keep many copies of it around for seek checkpoints.
+	struct Checkpoint
+	{
+		samplecount_t m_lTotalSampleCount = 0;
+		samplecount_t m_nBufferCount = 0;
+		double m_dBufferDiff = 0.0;
+		double m_ppqPosFract = 0.0;
+		uint32 m_ppqPosBeat = 0;
+		uint32 m_nTickCount = 0;
+		uint32 m_nPatternDelay = 0;
+		uint32 m_nFrameDelay = 0;
+		uint32 m_nSamplesPerTick = 0;
+		ROWINDEX m_nCurrentRowsPerBeat = 0;
+		ROWINDEX m_nCurrentRowsPerMeasure = 0;
+		uint32 m_nMusicSpeed = 0;
+		TEMPO m_nMusicTempo;
+		ROWINDEX m_nRow = 0;
+		ROWINDEX m_nNextRow = 0;
+		ROWINDEX m_nextPatStartRow = 0;
+		ROWINDEX m_breakRow = 0;
+		ROWINDEX m_patLoopRow = 0;
+		ORDERINDEX m_posJump = 0;
+		PATTERNINDEX m_nPattern = 0;
+		ORDERINDEX m_nCurrentOrder = 0;
+		ORDERINDEX m_nNextOrder = 0;
+		ORDERINDEX m_nSeqOverride = ORDERINDEX_INVALID;
+		OrderTransitionMode m_seqOverrideMode = OrderTransitionMode::AtPatternEnd;
+		int32 m_nGlobalVolume = MAX_GLOBAL_VOLUME;
+		int32 m_nSamplesToGlobalVolRampDest = 0, m_nGlobalVolumeRampAmount = 0;
+		int32 m_nGlobalVolumeDestination = 0, m_lHighResRampingGlobalVolume = 0;
+		FlagSet<PlayFlags> m_flags = SONG_POSITIONCHANGED;
+		GlobalScriptState m_globalScriptState;
+		std::optional<MIDIMacroEvaluationResults> m_midiMacroEvaluationResults;
+
+		std::vector<ModChannel> patternChannels;
+	};
+
 public:
 	PlayState();
 
 	void ResetGlobalVolumeRamping() noexcept;
 
+	void SaveCheckpoint(Checkpoint &checkpoint, const CSoundFile &sndFile) const;
+	// Background channels and the mix list are left untouched. GetLength() only simulates the pattern channels,
+	// so after resuming from a checkpoint, background channels are in the same state as after seeking from the start.
+	// Mute and effect flags are taken from the current channel settings, as they may have changed since the checkpoint was saved.
+	void RestoreCheckpoint(const Checkpoint &checkpoint, const CSoundFile &sndFile);
+
 	void UpdateTimeSignature(const CSoundFile &sndFile) noexcept;
 	void UpdatePPQ(bool patternTransition) noexcept;
 
@@ -104,10 +162,38 @@ public:
 	}
 
 	mpt::span<ModChannel> BackgroundChannels(const CSoundFile &sndFile) noexcept;
+	// Must be called whenever a background channel starts playing, unless the channel has been obtained through CSoundFile::CheckNNA.
+	void SetBackgroundChannelInUse(CHANNELINDEX chn) noexcept
+	{
+		m_backgroundChannelsInUse[chn / kChannelMaskBits] |= (uint32(1) << (chn % kChannelMaskBits));
+	}
+	void SetBackgroundChannelIdle(CHANNELINDEX chn) noexcept
+	{
+		m_backgroundChannelsInUse[chn / kChannelMaskBits] &= ~(uint32(1) << (chn % kChannelMaskBits));
+	}
+	bool IsBackgroundChannelInUse(CHANNELINDEX chn) const noexcept
+	{
+		return (m_backgroundChannelsInUse[chn / kChannelMaskBits] >> (chn % kChannelMaskBits)) & 1;
+	}
+	// Return the index of the first channel >= chn that may be in use / is known to be idle, or Chn.size() if there is none.
+	CHANNELINDEX NextBackgroundChannelInUse(CHANNELINDEX chn) const noexcept { return FindChannelBit(chn, 0); }
+	CHANNELINDEX NextIdleBackgroundChannel(CHANNELINDEX chn) const noexcept { return FindChannelBit(chn, ~uint32(0)); }
+#ifdef MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+	// Compare the mask against a full scan of the background channels.
+	// Fails if a background channel was started by writing to it directly without calling SetBackgroundChannelInUse.
+	bool BackgroundChannelMaskIsValid(const CSoundFile &sndFile) const noexcept;
+#endif  // MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+
 	mpt::span<const ModChannel> BackgroundChannels(const CSoundFile &sndFile) const noexcept
 	{
 		return const_cast<PlayState *>(this)->PatternChannels(sndFile);
 	}
+
+protected:
+	CHANNELINDEX FindChannelBit(CHANNELINDEX chn, uint32 invert) const noexcept;
+
+	template<typename TFrom, typename TTo>
+	static void CopyGlobalState(const TFrom &from, TTo &to);
 };
 
 
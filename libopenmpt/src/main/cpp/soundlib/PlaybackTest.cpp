@@ -632,6 +632,17 @@ std::vector<mpt::ustring> PlaybackTest::Compare(const PlaybackTest &otherTest) c
 }
 
 
+// Filter coefficients are always stored with fixed-point precision, even if the mixer uses floating point
+static int32 FilterCoeffToFixedPoint(mixsample_t coeff) noexcept
+{
+#ifdef MPT_INTMIXER
+	return coeff;
+#else
+	return mpt::saturate_round<int32>(coeff * static_cast<float>(int32(1) << MixSampleIntTraits::filter_precision_bits));
+#endif
+}
+
+
 PlaybackTest CSoundFile::CreatePlaybackTest(PlaybackTestSettings settings)
 {
 	settings.Sanitize();
@@ -670,7 +681,7 @@ PlaybackTest CSoundFile::CreatePlaybackTest(PlaybackTestSettings settings)
 	header.fileVersion = 0;
 	header.isAmiga = m_SongFlags[SONG_ISAMIGA] ? 1 : 0;
 	header.positionPrecisionBits = static_cast<uint8>(mpt::bit_width(static_cast<typename std::make_unsigned<SamplePosition::value_t>::type>(SamplePosition{1, 0}.GetRaw())) - 1);
-	header.filterPrecisionBits = MIXING_FILTER_PRECISION;
+	header.filterPrecisionBits = MixSampleIntTraits::filter_precision_bits;
 	header.srcMode = m_Resampler.m_Settings.SrcMode;
 	header.outputChannels = static_cast<uint8>(m_MixerSettings.gnChannels);
 	header.mixerChannels = static_cast<uint16>(m_MixerSettings.m_nMaxMixChannels);
@@ -744,9 +755,9 @@ PlaybackTest CSoundFile::CreatePlaybackTest(PlaybackTestSettings settings)
 				channelData.position = channel.position.GetRaw();
 				if(channel.dwFlags[CHN_FILTER])
 					channelData.flags |= (channel.nFilter_HP ? TestDataChannel::kFilterHighPass : TestDataChannel::kFilterLowPass);
-				channelData.filterA0 = channel.nFilter_A0;
-				channelData.filterB0 = channel.nFilter_B0;
-				channelData.filterB1 = channel.nFilter_B1;
+				channelData.filterA0 = FilterCoeffToFixedPoint(channel.nFilter_A0);
+				channelData.filterB0 = FilterCoeffToFixedPoint(channel.nFilter_B0);
+				channelData.filterB1 = FilterCoeffToFixedPoint(channel.nFilter_B1);
 			}
 			std::sort(row.channels.begin(), row.channels.end());
 
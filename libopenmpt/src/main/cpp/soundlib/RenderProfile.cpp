@@ -0,0 +1,107 @@
+/*
+ * RenderProfile.cpp
+ * -----------------
+ * Purpose: Lightweight per-stage timing of the audio render path.
+ * Notes  : (currently none)
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#include "stdafx.h"
+#include "RenderProfile.h"
+
+#ifdef MPT_ENABLE_RENDER_PROFILE
+
+#include <chrono>
+
+#if (MPT_ARCH_X86 || MPT_ARCH_AMD64) && (MPT_COMPILER_MSVC || MPT_COMPILER_GCC || MPT_COMPILER_CLANG)
+#define MPT_RENDER_PROFILE_RDTSC
+#if MPT_COMPILER_MSVC
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+static uint64 ReadCycleCounter() noexcept
+{
+#ifdef MPT_RENDER_PROFILE_RDTSC
+	return __rdtsc();
+#else
+	return 0;
+#endif
+}
+
+
+bool RenderProfile::HasCycleCounter() noexcept
+{
+#ifdef MPT_RENDER_PROFILE_RDTSC
+	return true;
+#else
+	return false;
+#endif
+}
+
+
+void RenderProfile::SetEnabled(bool enabled) noexcept
+{
+	Reset();
+	m_enabled = enabled;
+}
+
+
+void RenderProfile::Reset() noexcept
+{
+	m_stages.fill({});
+	m_frames = 0;
+	m_chunks = 0;
+	m_silentChunks = 0;
+	m_voiceFrames = 0;
+	m_peakVoices = 0;
+}
+
+
+void RenderProfile::Enter(Scope::Timestamp &start) noexcept
+{
+	start.nanoseconds = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	start.cycles = ReadCycleCounter();
+}
+
+
+void RenderProfile::Leave(Stage stage, const Scope::Timestamp &start) noexcept
+{
+	const uint64 cycles = ReadCycleCounter();
+	const uint64 nanoseconds = static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	StageCounters &counters = m_stages[stage];
+	counters.calls++;
+	counters.nanoseconds += nanoseconds - start.nanoseconds;
+	counters.cycles += cycles - start.cycles;
+}
+
+
+const char *RenderProfile::GetStageName(Stage stage) noexcept
+{
+	switch(stage)
+	{
+	case StageTotal: return "total";
+	case StageReadNote: return "read_note";
+	case StageMix: return "mix";
+	case StageOPL: return "opl";
+	case StageReverb: return "reverb";
+	case StagePlugins: return "plugins";
+	case StagePostMix: return "post_mix";
+	case StageDSP: return "dsp";
+	case StageOutput: return "output";
+	case NumStages: break;
+	}
+	return "";
+}
+
+
+OPENMPT_NAMESPACE_END
+
+#endif // MPT_ENABLE_RENDER_PROFILE
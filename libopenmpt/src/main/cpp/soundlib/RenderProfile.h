@@ -0,0 +1,134 @@
+/*
+ * RenderProfile.h
+ * ---------------
+ * Purpose: Lightweight per-stage timing of the audio render path.
+ * Notes  : Disabled at runtime by default; a disabled profile only costs one branch per stage and chunk.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#ifdef MPT_ENABLE_RENDER_PROFILE
+
+#include "Snd_defs.h"
+
+#include <array>
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+class RenderProfile
+{
+public:
+	enum Stage
+	{
+		StageTotal,     // Complete CSoundFile::Read call
+		StageReadNote,  // Pattern, effect and envelope processing
+		StageMix,       // CreateStereoMix
+		StageOPL,       // OPL emulation
+		StageReverb,    // Built-in reverb
+		StagePlugins,   // Mix plugins
+		StagePostMix,   // Global volume, VU meters
+		StageDSP,       // Built-in DSP effects
+		StageOutput,    // Conversion to the output format, including dithering
+		NumStages
+	};
+
+	struct StageCounters
+	{
+		uint64 calls = 0;
+		uint64 nanoseconds = 0;
+		uint64 cycles = 0;
+	};
+
+	// Measures the time between construction and destruction if the profile is enabled
+	class Scope
+	{
+	public:
+		Scope(RenderProfile &profile, Stage stage)
+			: m_profile{profile.m_enabled ? &profile : nullptr}
+			, m_stage{stage}
+		{
+			if(m_profile)
+				m_profile->Enter(m_start);
+		}
+		~Scope()
+		{
+			if(m_profile)
+				m_profile->Leave(m_stage, m_start);
+		}
+		Scope(const Scope &) = delete;
+		Scope &operator=(const Scope &) = delete;
+
+	private:
+		struct Timestamp
+		{
+			uint64 nanoseconds;
+			uint64 cycles;
+		};
+		friend class RenderProfile;
+
+		RenderProfile *m_profile;
+		Stage m_stage;
+		Timestamp m_start;
+	};
+
+	bool IsEnabled() const noexcept { return m_enabled; }
+	// Enabling or disabling the profile also resets all counters.
+	void SetEnabled(bool enabled) noexcept;
+	void Reset() noexcept;
+
+	// Called once per rendered chunk with the number of voices that were mixed
+	void AddChunk(samplecount_t frames, CHANNELINDEX voices, bool silent) noexcept
+	{
+		if(!m_enabled)
+			return;
+		m_frames += frames;
+		m_chunks++;
+		if(silent)
+			m_silentChunks++;
+		m_voiceFrames += static_cast<uint64>(voices) * frames;
+		if(voices > m_peakVoices)
+			m_peakVoices = voices;
+	}
+
+	const StageCounters &GetStage(Stage stage) const noexcept { return m_stages[stage]; }
+	uint64 GetFrames() const noexcept { return m_frames; }
+	uint64 GetChunks() const noexcept { return m_chunks; }
+	// Chunks that took the silent fast path and skipped mixing
+	uint64 GetSilentChunks() const noexcept { return m_silentChunks; }
+	double GetAverageVoices() const noexcept { return m_frames ? static_cast<double>(m_voiceFrames) / static_cast<double>(m_frames) : 0.0; }
+	CHANNELINDEX GetPeakVoices() const noexcept { return m_peakVoices; }
+
+	static const char *GetStageName(Stage stage) noexcept;
+	// Returns false if there is no cycle counter on this platform, in which case all cycle counts are 0.
+	static bool HasCycleCounter() noexcept;
+
+private:
+	void Enter(Scope::Timestamp &start) noexcept;
+	void Leave(Stage stage, const Scope::Timestamp &start) noexcept;
+
+	std::array<StageCounters, NumStages> m_stages;
+	uint64 m_frames = 0;
+	uint64 m_chunks = 0;
+	uint64 m_silentChunks = 0;
+	uint64 m_voiceFrames = 0;
+	CHANNELINDEX m_peakVoices = 0;
+	bool m_enabled = false;
+};
+
+
+#define MPT_RENDER_PROFILE_SCOPE(profile, stage) RenderProfile::Scope renderProfileScope##stage{profile, RenderProfile::stage}
+
+
+OPENMPT_NAMESPACE_END
+
+#else // !MPT_ENABLE_RENDER_PROFILE
+
+#define MPT_RENDER_PROFILE_SCOPE(profile, stage) do { } while(0)
+
+#endif // MPT_ENABLE_RENDER_PROFILE
@@ -29,11 +29,19 @@ OPENMPT_NAMESPACE_BEGIN
 // A C++11-style function-static singleton is holding the cached values.
 #define MPT_RESAMPLER_TABLES_CACHED
 
+// Fill the tables cache from the tables in ResamplerTables.cpp, which are
+//  generated at build time for the default settings, instead of computing
+//  them when the first resampler is created.
+// The generated tables only exist for the integer mixer.
+#if defined(MPT_INTMIXER) && !defined(MPT_BUILD_NO_PRECOMPUTED_RESAMPLER_TABLES)
+#define MPT_RESAMPLER_TABLES_PRECOMPUTED
+#endif
+
 // Prime the tables cache when the library is loaded.
 // Caching gets triggered via a global object that primes the cache during
 //  construction.
 // This is only really useful with MPT_RESAMPLER_TABLES_CACHED.
-#ifdef MPT_BUILD_FUZZER
+#if defined(MPT_BUILD_FUZZER) && !defined(MPT_RESAMPLER_TABLES_PRECOMPUTED)
 #define MPT_RESAMPLER_TABLES_CACHED_ONSTARTUP
 #endif
 
@@ -136,6 +144,8 @@ public:
 private:
 	void InitFloatmixerTables();
 	void InitializeTablesFromScratch(bool force=false);
+	// Check if two settings result in the same windowed FIR table
+	static bool HaveSameWindowedFIRSettings(const CResamplerSettings &a, const CResamplerSettings &b);
 #ifdef MPT_RESAMPLER_TABLES_CACHED
 	void InitializeTablesFromCache();
 #endif
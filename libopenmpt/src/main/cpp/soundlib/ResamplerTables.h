@@ -0,0 +1,38 @@
+/*
+ * ResamplerTables.h
+ * -----------------
+ * Purpose: Precomputed resampler and Amiga BLEP tables for the default resampler settings.
+ * Notes  : The tables are generated by build/gen/gen_resampler_tables.cpp, see ResamplerTables.cpp.
+ * Authors: OpenMPT Devs
+ * The OpenMPT source code is released under the BSD license. Read LICENSE for more details.
+ */
+
+
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#include "Resampler.h"
+
+#ifdef MPT_RESAMPLER_TABLES_PRECOMPUTED
+
+OPENMPT_NAMESPACE_BEGIN
+
+
+namespace ResamplerTables
+{
+
+extern const SINC_TYPE KaiserSinc[SINC_PHASES * 8];
+extern const SINC_TYPE Downsample13x[SINC_PHASES * 8];
+extern const SINC_TYPE Downsample2x[SINC_PHASES * 8];
+// For CResamplerSettings::gdWFIRCutoff = 0.97 and CResamplerSettings::gbWFIRType = WFIR_KAISER4T
+extern const WFIR_TYPE WindowedFIR[WFIR_LUTLEN * WFIR_WIDTH];
+// In the order of Paula::BlepTables::AmigaFilter
+extern const mixsample_t AmigaBlep[Paula::BlepTables::NumTables][Paula::BLEP_SIZE];
+
+}  // namespace ResamplerTables
+
+
+OPENMPT_NAMESPACE_END
+
+#endif  // MPT_RESAMPLER_TABLES_PRECOMPUTED
@@ -66,6 +66,28 @@ void RowVisitor::MoveVisitedRowsFrom(RowVisitor &other) noexcept
 {
 	m_visitedRows = std::move(other.m_visitedRows);
 	m_visitedLoopStates = std::move(other.m_visitedLoopStates);
+	m_loopStatesReserved = other.m_loopStatesReserved;
+}
+
+
+void RowVisitor::CopyVisitedRowsFrom(const RowVisitor &other)
+{
+	m_visitedRows = other.m_visitedRows;
+	m_visitedLoopStates = other.m_visitedLoopStates;
+	m_rowsSpentInLoops = other.m_rowsSpentInLoops;
+	m_loopStatesReserved = other.m_loopStatesReserved;
+}
+
+
+// Make sure that all loop states recorded by another visitor of the same sequence can be stored without allocating memory.
+void RowVisitor::ReserveLoopStatesFrom(const RowVisitor &other)
+{
+	for(const auto &[pos, loopStates] : other.m_visitedLoopStates)
+	{
+		auto &ownLoopStates = m_visitedLoopStates[pos];
+		if(ownLoopStates.capacity() < loopStates.size())
+			ownLoopStates.reserve(loopStates.size());
+	}
 }
 
 
@@ -88,7 +110,7 @@ void RowVisitor::Initialize(bool reset)
 	m_visitedRows.resize(endOrder);
 	if(reset)
 	{
-		reserveLoopStates = m_visitedLoopStates.empty();
+		reserveLoopStates = !m_loopStatesReserved;
 		for(auto &loopState : m_visitedLoopStates)
 		{
 			loopState.second.clear();
@@ -96,8 +118,11 @@ void RowVisitor::Initialize(bool reset)
 		m_rowsSpentInLoops = 0;
 	}
 
+	// This is called from the render path whenever the song restarts, so only allocate scratch space if there is something to reserve.
 	std::vector<uint8> loopCount;
-	std::vector<ORDERINDEX> visitedPatterns(m_sndFile.Patterns.GetNumPatterns(), ORDERINDEX_INVALID);
+	std::vector<ORDERINDEX> visitedPatterns;
+	if(reserveLoopStates)
+		visitedPatterns.assign(m_sndFile.Patterns.GetNumPatterns(), ORDERINDEX_INVALID);
 	for(ORDERINDEX ord = 0; ord < endOrder; ord++)
 	{
 		const PATTERNINDEX pat = order[ord];
@@ -161,6 +186,8 @@ void RowVisitor::Initialize(bool reset)
 		if(startRow == 0)
 			visitedPatterns[pat] = ord;
 	}
+	if(reserveLoopStates && endOrder > 0)
+		m_loopStatesReserved = true;
 }
 
 
@@ -174,8 +201,10 @@ bool RowVisitor::Visit(ORDERINDEX ord, ROWINDEX row, const ChannelStates &chnSta
 	// The module might have been edited in the meantime - so we have to extend this a bit.
 	if(ord >= m_visitedRows.size() || row >= m_visitedRows[ord].size())
 	{
+		// If ord >= order.GetLengthTailTrimmed(), we are trying to play an empty order. Don't bother re-initializing in that case, as it won't change anything.
+		if(ord >= order.GetLengthTailTrimmed())
+			return false;
 		Initialize(false);
-		// If it's still past the end of the vector, this means that ord >= order.GetLengthTailTrimmed(), i.e. we are trying to play an empty order.
 		if(ord >= m_visitedRows.size())
 			return false;
 	}
@@ -198,10 +227,12 @@ bool RowVisitor::Visit(ORDERINDEX ord, ROWINDEX row, const ChannelStates &chnSta
 
 	if(oldHadLoops || newHasLoops)
 	{
+		// Storage for this row is usually reserved in advance, so avoid a second lookup
+		auto &loopStates = (rowLoopState != m_visitedLoopStates.end()) ? rowLoopState->second : m_visitedLoopStates[{ord, row}];
 		// Convert to set representation if it isn't already
 		if(!oldHadLoops && wasVisited)
-			m_visitedLoopStates[{ord, row}].emplace_back();
-		m_visitedLoopStates[{ord, row}].emplace_back(std::move(newState));
+			loopStates.emplace_back();
+		loopStates.emplace_back(std::move(newState));
 	}
 	m_visitedRows[ord][row] = true;
 	return false;
@@ -78,11 +78,16 @@ protected:
 	const CSoundFile &m_sndFile;
 	ROWINDEX m_rowsSpentInLoops = 0;
 	const SEQUENCEINDEX m_sequence;
+	// Set once loop state storage has been reserved for the whole sequence, so that resetting the visitor during playback does not allocate.
+	bool m_loopStatesReserved = false;
 
 public:
 	RowVisitor(const CSoundFile &sndFile, SEQUENCEINDEX sequence = SEQUENCEINDEX_INVALID);
 	
 	void MoveVisitedRowsFrom(RowVisitor &other) noexcept;
+	void CopyVisitedRowsFrom(const RowVisitor &other);
+	// Reserve storage for all loop states that another visitor has encountered, so that visiting the same rows does not allocate.
+	void ReserveLoopStatesFrom(const RowVisitor &other);
 
 	// Resize / Clear the row vector.
 	// If reset is true, the vector is not only resized to the required dimensions, but also completely cleared (i.e. all visited rows are unset).
@@ -31,38 +31,10 @@
 OPENMPT_NAMESPACE_BEGIN
 
 
-// Read a sample from memory
-size_t SampleIO::ReadSample(ModSample &sample, FileReader &file) const
+// Limit the sample length to what can be decoded from fileSize bytes of sample data.
+// Returns false if there is nothing to read.
+bool SampleIO::LimitSampleLength(ModSample &sample, FileReader &file, uint64 fileSize) const
 {
-	if(!file.IsValid())
-	{
-		return 0;
-	}
-
-	LimitMax(sample.nLength, MAX_SAMPLE_LENGTH);
-
-	FileReader::pos_type bytesRead = 0;	// Amount of memory that has been read from file
-
-	FileReader::pos_type filePosition = file.GetPosition();
-	const std::byte * sourceBuf = nullptr;
-	FileReader::PinnedView restrictedSampleDataView;
-	FileReader::pos_type fileSize = 0;
-	if(UsesFileReaderForDecoding())
-	{
-		sourceBuf = nullptr;
-		fileSize = file.BytesLeft();
-	} else if(!IsVariableLengthEncoded())
-	{
-		restrictedSampleDataView = file.GetPinnedView(CalculateEncodedSize(sample.nLength));
-		sourceBuf = restrictedSampleDataView.data();
-		fileSize = restrictedSampleDataView.size();
-		if(fileSize < 1)
-			return 0;
-	} else
-	{
-		MPT_ASSERT_NOTREACHED();
-	}
-
 	if(!IsVariableLengthEncoded() && sample.nLength > 0x40000)
 	{
 		// Limit sample length to available bytes in file to avoid excessive memory allocation.
@@ -105,7 +77,7 @@ size_t SampleIO::ReadSample(ModSample &sample, FileReader &file) const
 	} else if(GetEncoding() == AMS)
 	{
 		if(fileSize <= 9)
-			return 0;
+			return false;
 
 		file.Skip(4);  // Target sample size (we already know this)
 		SmpLength maxLength = std::min(file.ReadUint32LE(), mpt::saturate_cast<uint32>(fileSize));
@@ -119,13 +91,96 @@ size_t SampleIO::ReadSample(ModSample &sample, FileReader &file) const
 		LimitMax(sample.nLength, maxLength / (m_bitdepth / 8u));
 	}
 
-	if(sample.nLength < 1)
+	return sample.nLength >= 1;
+}
+
+
+// Set up sample length and flags in the same way as ReadSample, but do not read any sample data yet.
+bool SampleIO::PrepareSample(ModSample &sample, FileReader file) const
+{
+	if(!file.IsValid())
+	{
+		return false;
+	}
+
+	LimitMax(sample.nLength, MAX_SAMPLE_LENGTH);
+
+	FileReader::pos_type fileSize = file.BytesLeft();
+	if(!UsesFileReaderForDecoding())
+	{
+		fileSize = std::min(fileSize, static_cast<FileReader::pos_type>(CalculateEncodedSize(sample.nLength)));
+		if(fileSize < 1)
+			return false;
+	}
+
+	if(!LimitSampleLength(sample, file, fileSize))
+	{
+		return false;
+	}
+
+	sample.uFlags.set(CHN_16BIT, GetBitDepth() >= 16);
+	sample.uFlags.set(CHN_STEREO, GetChannelFormat() != mono);
+	return true;
+}
+
+
+bool SampleIO::IsNativeFormat() const
+{
+	if(GetEncoding() != signedPCM || (GetChannelFormat() != mono && GetChannelFormat() != stereoInterleaved))
+		return false;
+	if(GetBitDepth() == 8)
+		return true;
+	return GetBitDepth() == 16 && GetEndianness() == (mpt::endian_is_little() ? littleEndian : bigEndian);
+}
+
+
+// Read a sample from memory
+size_t SampleIO::ReadSample(ModSample &sample, FileReader &file, const SampleMappingSource *mappingSource) const
+{
+	if(!file.IsValid())
+	{
+		return 0;
+	}
+
+	LimitMax(sample.nLength, MAX_SAMPLE_LENGTH);
+
+	FileReader::pos_type bytesRead = 0;	// Amount of memory that has been read from file
+
+	FileReader::pos_type filePosition = file.GetPosition();
+	const std::byte * sourceBuf = nullptr;
+	FileReader::PinnedView restrictedSampleDataView;
+	FileReader::pos_type fileSize = 0;
+	if(UsesFileReaderForDecoding())
+	{
+		sourceBuf = nullptr;
+		fileSize = file.BytesLeft();
+	} else if(!IsVariableLengthEncoded())
+	{
+		restrictedSampleDataView = file.GetPinnedView(CalculateEncodedSize(sample.nLength));
+		sourceBuf = restrictedSampleDataView.data();
+		fileSize = restrictedSampleDataView.size();
+		if(fileSize < 1)
+			return 0;
+	} else
+	{
+		MPT_ASSERT_NOTREACHED();
+	}
+
+	if(!LimitSampleLength(sample, file, fileSize))
 	{
 		return 0;
 	}
 
 	sample.uFlags.set(CHN_16BIT, GetBitDepth() >= 16);
 	sample.uFlags.set(CHN_STEREO, GetChannelFormat() != mono);
+
+	if(mappingSource != nullptr && sourceBuf != nullptr && IsNativeFormat() && fileSize >= sample.GetSampleSizeInBytes() && sample.MapSample(*mappingSource, sourceBuf))
+	{
+		bytesRead = sample.GetSampleSizeInBytes();
+		file.Seek(filePosition + bytesRead);
+		return bytesRead;
+	}
+
 	size_t sampleSize = sample.AllocateSample();	// Target sample size in bytes
 
 	if(sampleSize == 0)
@@ -22,6 +22,7 @@ OPENMPT_NAMESPACE_BEGIN
 
 
 struct ModSample;
+struct SampleMappingSource;
 
 // Sample import / export formats
 class SampleIO
@@ -185,6 +186,9 @@ public:
 		return GetEncodedBitsPerSample() == 0;
 	}
 
+	// Returns true if the encoded data is already laid out like OpenMPT's in-memory representation of the sample
+	bool IsNativeFormat() const;
+
 	// Returns true if the decoder for a given format uses FileReader interface and thus do not need to call GetPinnedView()
 	MPT_CONSTEXPRINLINE bool UsesFileReaderForDecoding() const
 	{
@@ -244,7 +248,17 @@ public:
 	}
 
 	// Read a sample from memory
-	size_t ReadSample(ModSample &sample, FileReader &file) const;
+	// If a mapping source is provided and the sample data is stored in OpenMPT's native format, the data may be mapped from the source file instead of being copied (see ModSample::MapSample).
+	size_t ReadSample(ModSample &sample, FileReader &file, const SampleMappingSource *mappingSource = nullptr) const;
+
+	// Set up sample length and flags like ReadSample, but without reading the sample data.
+	// Returns false if ReadSample would not read any sample data.
+	bool PrepareSample(ModSample &sample, FileReader file) const;
+
+protected:
+	bool LimitSampleLength(ModSample &sample, FileReader &file, uint64 fileSize) const;
+
+public:
 
 #ifndef MODPLUG_NO_FILESAVE
 	// Write a sample to file
@@ -64,12 +64,7 @@ protected:
 
 public:
 	std::unique_ptr<PlayState> state;
-	struct ChnSettings
-	{
-		uint32 ticksToRender = 0;	// When using sample sync, we still need to render this many ticks
-		bool incChanged = false;	// When using sample sync, note frequency has changed
-		uint8 vol = 0xFF;
-	};
+	using ChnSettings = GetLengthChnSettings;
 
 	std::vector<ChnSettings> chnSettings;
 	double elapsedTime;
@@ -341,6 +336,15 @@ public:
 };
 
 
+void CSoundFile::SetSeekCheckpointInterval(double seconds)
+{
+	m_seekCheckpointInterval = (seconds > 0.0) ? std::max(seconds, MinSeekCheckpointInterval) : 0.0;
+	m_seekCheckpoints.checkpoints.clear();
+	m_seekCheckpoints.checkpoints.shrink_to_fit();
+	m_seekCheckpoints.sequence = SEQUENCEINDEX_INVALID;
+}
+
+
 // Get mod length in various cases. Parameters:
 // [in]  adjustMode: See enmGetLengthResetMode for possible adjust modes.
 // [in]  target: Time or position target which should be reached, or no target to get length of the first sub song. Use GetLengthTarget::StartPos to also specify a position from where the seeking should begin.
@@ -406,8 +410,76 @@ std::vector<GetLengthType> CSoundFile::GetLength(enmGetLengthResetMode adjustMod
 	uint32 oldTickDuration = 0;
 	bool breakToRow = false;
 
+	// When seeking to a given time, resume from the closest checkpoint that was recorded by a previous seek
+	double nextCheckpointTime = std::numeric_limits<double>::infinity();
+	if(target.mode == GetLengthTarget::SeekSeconds && m_seekCheckpointInterval > 0.0)
+	{
+		SeekCheckpointIndex &index = m_seekCheckpoints;
+#ifndef MODPLUG_TRACKER
+		const uint32 tempoFactor = m_nTempoFactor, freqFactor = m_nFreqFactor;
+#else
+		const uint32 tempoFactor = 65536, freqFactor = 65536;
+#endif // !MODPLUG_TRACKER
+		if(index.sequence != sequence || index.startOrder != target.startOrder || index.startRow != target.startRow || index.adjustMode != adjustMode
+		   || index.mixingFreq != m_MixerSettings.gdwMixingFreq || index.tempoFactor != tempoFactor || index.freqFactor != freqFactor)
+		{
+			index.checkpoints.clear();
+			index.sequence = sequence;
+			index.startOrder = target.startOrder;
+			index.startRow = target.startRow;
+			index.adjustMode = adjustMode;
+			index.mixingFreq = m_MixerSettings.gdwMixingFreq;
+			index.tempoFactor = tempoFactor;
+			index.freqFactor = freqFactor;
+			index.interval = m_seekCheckpointInterval;
+		}
+
+		// Checkpoints are taken before the time target check, so they must be strictly before the target
+		auto checkpoint = std::find_if(index.checkpoints.rbegin(), index.checkpoints.rend(), [&target](const SeekCheckpoint &cp) { return cp.elapsedTime < target.time; });
+		if(checkpoint != index.checkpoints.rend())
+		{
+			// Background channels are not part of the checkpoint, see PlayState::RestoreCheckpoint
+			playState.RestoreCheckpoint(checkpoint->playState, *this);
+			memory.chnSettings = checkpoint->chnSettings;
+			memory.elapsedTime = checkpoint->elapsedTime;
+			visitedRows.CopyVisitedRowsFrom(checkpoint->visitedRows);
+			oldTickDuration = checkpoint->oldTickDuration;
+			breakToRow = checkpoint->breakToRow;
+			retval.endOrder = checkpoint->endOrder;
+			retval.endRow = checkpoint->endRow;
+		}
+		nextCheckpointTime = (index.checkpoints.empty() ? 0.0 : index.checkpoints.back().elapsedTime) + index.interval;
+	}
+
 	for (;;)
 	{
+		// Only the first part of the song is recorded; once the search continues in unvisited rows, the timing starts over.
+		if(memory.elapsedTime >= nextCheckpointTime && results.empty())
+		{
+			SeekCheckpointIndex &index = m_seekCheckpoints;
+			if(index.checkpoints.size() >= MaxSeekCheckpoints)
+			{
+				// Keep the memory usage bounded for long songs by thinning out the checkpoints
+				std::vector<SeekCheckpoint> thinned;
+				thinned.reserve(MaxSeekCheckpoints);
+				for(std::size_t i = 0; i < index.checkpoints.size(); i += 2)
+				{
+					thinned.push_back(std::move(index.checkpoints[i]));
+				}
+				index.checkpoints = std::move(thinned);
+				index.interval *= 2.0;
+			}
+			SeekCheckpoint &checkpoint = index.checkpoints.emplace_back(visitedRows);
+			playState.SaveCheckpoint(checkpoint.playState, *this);
+			checkpoint.chnSettings = memory.chnSettings;
+			checkpoint.elapsedTime = memory.elapsedTime;
+			checkpoint.oldTickDuration = oldTickDuration;
+			checkpoint.breakToRow = breakToRow;
+			checkpoint.endOrder = retval.endOrder;
+			checkpoint.endRow = retval.endRow;
+			nextCheckpointTime = memory.elapsedTime + index.interval;
+		}
+
 		const bool ignoreRow = NextRow(playState, breakToRow).first;
 
 		// Time target reached.
@@ -1450,6 +1522,12 @@ std::vector<GetLengthType> CSoundFile::GetLength(enmGetLengthResetMode adjustMod
 	}
 	if(adjustMode & (eAdjust | eAdjustOnlyVisitedRows))
 		m_visitedRows.MoveVisitedRowsFrom(visitedRows);
+#ifndef MODPLUG_TRACKER
+	// The player will most likely go through the same pattern loops, so make room for their loop states now rather than while rendering.
+	// Not done in OpenMPT, where this function may run while the module is playing in another thread.
+	else if(sequence == Order.GetCurrentSequenceIndex())
+		m_visitedRows.ReserveLoopStatesFrom(visitedRows);
+#endif // !MODPLUG_TRACKER
 
 	return results;
 }
@@ -2233,41 +2311,50 @@ void CSoundFile::ApplyInstrumentPanning(ModChannel &chn, const ModInstrument *in
 
 CHANNELINDEX CSoundFile::GetNNAChannel(CHANNELINDEX nChn) const
 {
-	// Check for empty channel
-	for(CHANNELINDEX i = GetNumChannels(); i < m_PlayState.Chn.size(); i++)
+	// Check for empty channel. Channels that are known to be idle are always available, so only the channels in front of the first one need to be checked.
+	const CHANNELINDEX firstIdleChn = m_PlayState.NextIdleBackgroundChannel(GetNumChannels());
+	if(firstIdleChn < m_PlayState.Chn.size())
 	{
-		const ModChannel &c = m_PlayState.Chn[i];
-		// Sample playing?
-		if(c.nLength)
-			continue;
-		// Can a plugin potentially be playing?
-		if(!c.HasMIDIOutput())
-			return i;
-		// Has the plugin note already been released? (note: lastMidiNoteWithoutArp is set from within IMixPlugin, so this implies that there is a valid plugin assignment)
-		if(c.dwFlags[CHN_KEYOFF | CHN_NOTEFADE] || c.lastMidiNoteWithoutArp == NOTE_NONE)
-			return i;
+		for(CHANNELINDEX i = GetNumChannels(); i < firstIdleChn; i++)
+		{
+			if(m_PlayState.Chn[i].IsAvailableForNNA())
+				return i;
+		}
+		return firstIdleChn;
 	}
 
+	bool keepSrcChn = false;
 	int32 vol = 0x800100;
 	if(nChn < m_PlayState.Chn.size())
 	{
 		const ModChannel &srcChn = m_PlayState.Chn[nChn];
-		if(!srcChn.nFadeOutVol && srcChn.nLength)
-			return CHANNELINDEX_INVALID;
+		keepSrcChn = !srcChn.nFadeOutVol && srcChn.nLength;
 		vol = (srcChn.nRealVolume << 9) | srcChn.nVolume;
 	}
 
-	// All channels are used: check for lowest volume
+	// No channel is known to be idle: Look for an empty channel and for the channel with the lowest volume in a single pass over the channels that may be in use.
+	// An empty channel always wins, then a stopped channel, then the channel with the lowest volume.
+	CHANNELINDEX stoppedChn = CHANNELINDEX_INVALID;
 	CHANNELINDEX result = CHANNELINDEX_INVALID;
 	uint32 envpos = 0;
-	for(CHANNELINDEX i = GetNumChannels(); i < m_PlayState.Chn.size(); i++)
+	for(CHANNELINDEX i = m_PlayState.NextBackgroundChannelInUse(GetNumChannels()); i < m_PlayState.Chn.size(); i = m_PlayState.NextBackgroundChannelInUse(i + 1))
 	{
 		const ModChannel &c = m_PlayState.Chn[i];
+		if(c.IsAvailableForNNA())
+			return i;
+		if(keepSrcChn || stoppedChn != CHANNELINDEX_INVALID)
+			continue;
 		// Stopped OPL channel
 		if(c.dwFlags[CHN_ADLIB] && (!m_opl || !m_opl->IsActive(i)))
-			return i;
+		{
+			stoppedChn = i;
+			continue;
+		}
 		if(c.nLength && !c.nFadeOutVol)
-			return i;
+		{
+			stoppedChn = i;
+			continue;
+		}
 		// Use a combination of real volume [14 bit] (which includes volume envelopes, but also potentially global volume) and note volume [9 bit].
 		// Rationale: We need volume envelopes in case e.g. all NNA channels are playing at full volume but are looping on a 0-volume envelope node.
 		// But if global volume is not applied to master and the global volume temporarily drops to 0, we would kill arbitrary channels. Hence, add the note volume as well.
@@ -2285,6 +2372,10 @@ CHANNELINDEX CSoundFile::GetNNAChannel(CHANNELINDEX nChn) const
 			result = i;
 		}
 	}
+	if(keepSrcChn)
+		return CHANNELINDEX_INVALID;
+	if(stoppedChn != CHANNELINDEX_INVALID)
+		return stoppedChn;
 	return result;
 }
 
@@ -2334,6 +2425,7 @@ CHANNELINDEX CSoundFile::CheckNNA(CHANNELINDEX nChn, uint32 instr, int note, boo
 			return CHANNELINDEX_INVALID;
 		ModChannel &chn = m_PlayState.Chn[nnaChn];
 		StopOldNNA(chn, nnaChn);
+		m_PlayState.SetBackgroundChannelInUse(nnaChn);
 		// Copy Channel
 		chn = srcChn;
 		chn.dwFlags.reset(CHN_VIBRATO | CHN_TREMOLO | CHN_MUTE | CHN_PORTAMENTO);
@@ -2517,6 +2609,7 @@ CHANNELINDEX CSoundFile::CheckNNA(CHANNELINDEX nChn, uint32 instr, int note, boo
 
 	ModChannel &chn = m_PlayState.Chn[nnaChn];
 	StopOldNNA(chn, nnaChn);
+	m_PlayState.SetBackgroundChannelInUse(nnaChn);
 	// Copy Channel
 	chn = srcChn;
 	chn.dwFlags.reset(CHN_VIBRATO | CHN_TREMOLO | CHN_PORTAMENTO);
@@ -5467,6 +5560,18 @@ void CSoundFile::InvertLoop(ModChannel &chn)
 		chn.nEFxOffset = 0;
 
 	// TRASH IT!!! (Yes, the sample!)
+	if(IsSampleWidened(pModSample))
+	{
+		// Only invert the original 8 bits, the low byte must stay zero
+		const uint8 numChannels = pModSample->GetNumChannels();
+		int16 *begin = pModSample->sample16() + (loopStart + chn.nEFxOffset) * numChannels;
+		for(auto &sample : mpt::as_span(begin, numChannels))
+		{
+			sample = static_cast<int16>(~sample & 0xFF00);
+		}
+		pModSample->PrecomputeLoops(*this, false);
+		return;
+	}
 	const uint8 bps = pModSample->GetBytesPerSample();
 	uint8 *begin = mpt::byte_cast<uint8 *>(pModSample->sampleb()) + (loopStart + chn.nEFxOffset) * bps;
 	for(auto &sample : mpt::as_span(begin, bps))
@@ -5669,11 +5774,15 @@ void CSoundFile::ProcessSampleOffset(ModChannel &chn, CHANNELINDEX nChn, const P
 	const ModCommand &m = chn.rowCommand;
 	uint32 extendedRows = 0;
 	SmpLength offset = CalculateXParam(playState.m_nPattern, playState.m_nRow, nChn, &extendedRows), highOffset = 0;
+	const bool isPercentageOffset = (m.volcmd == VOLCMD_OFFSET && m.vol == 0);
+	// Offsets in the pattern refer to the original sample data, but the offset memory and cue points refer to the sample as it is stored
+	const bool downsampled = !isPercentageOffset && IsSampleDownsampled(chn.pModSample);
 	if(!extendedRows)
 	{
 		// No X-param (normal behaviour)
-		const bool isPercentageOffset = (m.volcmd == VOLCMD_OFFSET && m.vol == 0);
 		offset <<= 8;
+		if(downsampled)
+			offset /= 2u;
 		// FT2 compatibility: 9xx command without a note next to it does not update effect memory.
 		// Test case: OffsetWithoutNote.xm
 		if(offset && (!m_playBehaviour[kFT2OffsetMemoryRequiresNote] || m.IsNote()))
@@ -5682,7 +5791,10 @@ void CSoundFile::ProcessSampleOffset(ModChannel &chn, CHANNELINDEX nChn, const P
 			offset = chn.oldOffset;
 
 		if(!isPercentageOffset)
-			highOffset = static_cast<SmpLength>(chn.nOldHiOffset) << 16;
+			highOffset = static_cast<SmpLength>(chn.nOldHiOffset) << (downsampled ? 15 : 16);
+	} else if(downsampled)
+	{
+		offset /= 2u;
 	}
 	if(m.volcmd == VOLCMD_OFFSET)
 	{
@@ -5715,7 +5827,7 @@ void CSoundFile::SampleOffset(ModChannel &chn, SmpLength param) const
 		param = (param - chn.nLoopStart) % (chn.nLoopEnd - chn.nLoopStart) + chn.nLoopStart;
 	}
 
-	if((GetType() & (MOD_TYPE_MDL | MOD_TYPE_PTM)) && chn.dwFlags[CHN_16BIT])
+	if((GetType() & (MOD_TYPE_MDL | MOD_TYPE_PTM)) && chn.dwFlags[CHN_16BIT] && !IsSampleWidened(chn.pModSample))
 	{
 		// Digitrakker and Polytracker use byte offsets, not sample offsets.
 		param /= 2u;
@@ -5794,7 +5906,9 @@ void CSoundFile::ReverseSampleOffset(ModChannel &chn, ModCommand::PARAM param) c
 		chn.dwFlags.reset(CHN_LOOP);
 		chn.nLength = chn.pModSample->nLength;  // If there was a loop, extend sample to whole length.
 		SmpLength offset = param << 8;
-		if(GetType() == MOD_TYPE_PTM && chn.dwFlags[CHN_16BIT])
+		if(GetType() == MOD_TYPE_PTM && chn.dwFlags[CHN_16BIT] && !IsSampleWidened(chn.pModSample))
+			offset /= 2;
+		if(IsSampleDownsampled(chn.pModSample))
 			offset /= 2;
 		chn.position.Set((chn.nLength - 1) - std::min(offset, chn.nLength - SmpLength(1)), 0);
 	}
@@ -13,7 +13,10 @@
 #include "Sndfile.h"
 #include "Container.h"
 #include "mod_specifications.h"
+#include "modsmp_ctrl.h"
+#include "MixThreadPool.h"
 #include "OPL.h"
+#include "SampleIO.h"
 #include "Tables.h"
 #include "tuningcollection.h"
 #include "plugins/PluginManager.h"
@@ -27,6 +30,8 @@
 #include "mpt/io/io_stdstream.hpp"
 #include "mpt/random/seed.hpp"
 
+#include <map>
+
 #ifdef MODPLUG_TRACKER
 #include "../mptrack/Mainfrm.h"
 #include "../mptrack/Moddoc.h"
@@ -49,6 +54,24 @@
 OPENMPT_NAMESPACE_BEGIN
 
 
+// Samples whose data has not been decoded yet
+struct CSoundFile::DeferredSamples
+{
+	struct Sample
+	{
+		FileReader file;  // Positioned at the start of the sample data
+		SampleIO sampleIO;
+		SmpLength length = 0;  // Length of the encoded sample data, which may be longer than the sample if it is going to be downsampled
+		// Reductions chosen by ApplySampleMemoryBudget while loading, which are applied when the sample is decoded
+		bool convertTo8Bit = false;
+		bool downsample = false;
+	};
+	std::unique_ptr<std::vector<char>> containerData;  // Unpacked module data if the module was stored in a container, as the caller only keeps the packed data alive
+	std::vector<std::byte> fileCopy;                   // Copy of the caller's file data if it does not outlive the module, see CopyDeferredSampleData()
+	std::map<SAMPLEINDEX, Sample> samples;
+};
+
+
 bool SettingCacheCompleteFileBeforeLoading()
 {
 	#ifdef MODPLUG_TRACKER
@@ -234,16 +257,43 @@ void CSoundFile::InitializeGlobals(MODTYPE type, CHANNELINDEX numChannels)
 }
 
 
+// Magic bytes that every file of a format contains at a fixed offset.
+struct FileFormatSignature
+{
+	uint16 offset = 0;
+	uint8 length = 0;
+	char magic[25] = {};
+};
+
+template<std::size_t N>
+static constexpr FileFormatSignature MagicAt(uint16 offset, const char (&magic)[N])
+{
+	static_assert(N - 1 <= sizeof(FileFormatSignature::magic));
+	FileFormatSignature signature;
+	signature.offset = offset;
+	signature.length = static_cast<uint8>(N - 1);
+	for(std::size_t i = 0; i < N - 1; i++)
+	{
+		signature.magic[i] = magic[i];
+	}
+	return signature;
+}
+
+// At least one of the signatures must be present for a file to be recognized.
+// Formats without reliable magic bytes at a fixed position have no signatures and are always tried.
+using FileFormatSignatures = std::array<FileFormatSignature, 2>;
+
 struct FileFormatLoader
 {
 	decltype(CSoundFile::ProbeFileHeaderXM) *prober;
 	decltype(&CSoundFile::ReadXM) loader;
+	FileFormatSignatures signatures;
 };
 
 #if defined(MODPLUG_TRACKER) && !defined(MPT_BUILD_DEBUG)
-#define MPT_DECLARE_FORMAT(format) { nullptr, &CSoundFile::Read ## format }
+#define MPT_DECLARE_FORMAT(format, ...) { nullptr, &CSoundFile::Read ## format, { __VA_ARGS__ } }
 #else
-#define MPT_DECLARE_FORMAT(format) { CSoundFile::ProbeFileHeader ## format, &CSoundFile::Read ## format }
+#define MPT_DECLARE_FORMAT(format, ...) { CSoundFile::ProbeFileHeader ## format, &CSoundFile::Read ## format, { __VA_ARGS__ } }
 #endif
 
 // All module format loaders, in the order they should be executed.
@@ -251,68 +301,73 @@ struct FileFormatLoader
 // clashes or lack of magic bytes that can lead to mis-detection of some formats.
 // Apart from that, more common formats with sane magic bytes are also found
 // at the top of the list to match the most common cases more quickly.
+// The signatures must only list magic bytes that both the prober and the loader reject the file without.
 static constexpr FileFormatLoader ModuleFormatLoaders[] =
 {
-	MPT_DECLARE_FORMAT(XM),
-	MPT_DECLARE_FORMAT(IT),
-	MPT_DECLARE_FORMAT(S3M),
+	MPT_DECLARE_FORMAT(XM, MagicAt(0, "Extended Module: ")),
+	MPT_DECLARE_FORMAT(IT, MagicAt(0, "IMPM"), MagicAt(0, "tpm.")),
+	MPT_DECLARE_FORMAT(S3M, MagicAt(44, "SCRM")),
 	MPT_DECLARE_FORMAT(STM),
-	MPT_DECLARE_FORMAT(MED),
-	MPT_DECLARE_FORMAT(MTM),
-	MPT_DECLARE_FORMAT(MDL),
-	MPT_DECLARE_FORMAT(DBM),
-	MPT_DECLARE_FORMAT(FAR),
-	MPT_DECLARE_FORMAT(AMS),
-	MPT_DECLARE_FORMAT(AMS2),
-	MPT_DECLARE_FORMAT(OKT),
-	MPT_DECLARE_FORMAT(PTM),
-	MPT_DECLARE_FORMAT(ULT),
-	MPT_DECLARE_FORMAT(DMF),
-	MPT_DECLARE_FORMAT(DSM),
-	MPT_DECLARE_FORMAT(AMF_Asylum),
-	MPT_DECLARE_FORMAT(AMF_DSMI),
-	MPT_DECLARE_FORMAT(PSM),
-	MPT_DECLARE_FORMAT(PSM16),
-	MPT_DECLARE_FORMAT(MT2),
-	MPT_DECLARE_FORMAT(ITP),
+	MPT_DECLARE_FORMAT(MED, MagicAt(0, "MMD")),
+	MPT_DECLARE_FORMAT(MTM, MagicAt(0, "MTM")),
+	MPT_DECLARE_FORMAT(MDL, MagicAt(0, "DMDL")),
+	MPT_DECLARE_FORMAT(DBM, MagicAt(0, "DBM0")),
+	MPT_DECLARE_FORMAT(FAR, MagicAt(0, "FAR\xFE")),
+	MPT_DECLARE_FORMAT(AMS, MagicAt(0, "Extreme")),
+	MPT_DECLARE_FORMAT(AMS2, MagicAt(0, "AMShdr\x1A")),
+	MPT_DECLARE_FORMAT(OKT, MagicAt(0, "OKTASONG")),
+	MPT_DECLARE_FORMAT(PTM, MagicAt(44, "PTMF")),
+	MPT_DECLARE_FORMAT(ULT, MagicAt(0, "MAS_UTrack_V00")),
+	MPT_DECLARE_FORMAT(DMF, MagicAt(0, "DDMF")),
+	MPT_DECLARE_FORMAT(DSM, MagicAt(0, "DSMF"), MagicAt(8, "DSMF")),
+	MPT_DECLARE_FORMAT(AMF_Asylum, MagicAt(0, "ASYLUM Music Format V1.0\0")),
+	MPT_DECLARE_FORMAT(AMF_DSMI, MagicAt(0, "AMF"), MagicAt(0, "DMF")),
+#ifdef MPT_PSM_DECRYPT
+	MPT_DECLARE_FORMAT(PSM, MagicAt(0, "PSM "), MagicAt(0, "QUP$")),
+#else
+	MPT_DECLARE_FORMAT(PSM, MagicAt(0, "PSM ")),
+#endif
+	MPT_DECLARE_FORMAT(PSM16, MagicAt(0, "PSM\xFE")),
+	MPT_DECLARE_FORMAT(MT2, MagicAt(0, "MT20")),
+	MPT_DECLARE_FORMAT(ITP, MagicAt(0, "pti.")),
 #if defined(MODPLUG_TRACKER) || defined(MPT_FUZZ_TRACKER)
 	// These make little sense for a module player library
 	MPT_DECLARE_FORMAT(UAX),
 	MPT_DECLARE_FORMAT(WAV),
 	MPT_DECLARE_FORMAT(MID),
 #endif // MODPLUG_TRACKER || MPT_FUZZ_TRACKER
-	MPT_DECLARE_FORMAT(GDM),
-	MPT_DECLARE_FORMAT(IMF),
-	MPT_DECLARE_FORMAT(DIGI),
-	MPT_DECLARE_FORMAT(DTM),
-	MPT_DECLARE_FORMAT(PLM),
-	MPT_DECLARE_FORMAT(AM),
-	MPT_DECLARE_FORMAT(J2B),
-	MPT_DECLARE_FORMAT(GT2),
-	MPT_DECLARE_FORMAT(GTK),
-	MPT_DECLARE_FORMAT(PT36),
-	MPT_DECLARE_FORMAT(SymMOD),
-	MPT_DECLARE_FORMAT(MUS_KM),
-	MPT_DECLARE_FORMAT(FMT),
+	MPT_DECLARE_FORMAT(GDM, MagicAt(0, "GDM\xFE")),
+	MPT_DECLARE_FORMAT(IMF, MagicAt(60, "IM10")),
+	MPT_DECLARE_FORMAT(DIGI, MagicAt(0, "DIGI Booster module\0")),
+	MPT_DECLARE_FORMAT(DTM, MagicAt(0, "D.T.")),
+	MPT_DECLARE_FORMAT(PLM, MagicAt(0, "PLM\x1A")),
+	MPT_DECLARE_FORMAT(AM, MagicAt(8, "AMFF"), MagicAt(8, "AM  ")),
+	MPT_DECLARE_FORMAT(J2B, MagicAt(0, "MUSE")),
+	MPT_DECLARE_FORMAT(GT2, MagicAt(0, "GT2")),
+	MPT_DECLARE_FORMAT(GTK, MagicAt(0, "GTK")),
+	MPT_DECLARE_FORMAT(PT36, MagicAt(8, "MODL")),
+	MPT_DECLARE_FORMAT(SymMOD, MagicAt(0, "SymM")),
+	MPT_DECLARE_FORMAT(MUS_KM, MagicAt(0, "SONG")),
+	MPT_DECLARE_FORMAT(FMT, MagicAt(0, "FMTracker\x01\x01")),
 	MPT_DECLARE_FORMAT(SFX),
-	MPT_DECLARE_FORMAT(STP),
-	MPT_DECLARE_FORMAT(DSym),
-	MPT_DECLARE_FORMAT(STX),
+	MPT_DECLARE_FORMAT(STP, MagicAt(0, "STP3")),
+	MPT_DECLARE_FORMAT(DSym, MagicAt(0, "\x02\x01\x13\x13\x14\x12\x01\x0B")),
+	MPT_DECLARE_FORMAT(STX, MagicAt(60, "SCRM")),
 	MPT_DECLARE_FORMAT(UNIC),  // Magic bytes clash with MOD, must be tried first
 	MPT_DECLARE_FORMAT(MOD),
-	MPT_DECLARE_FORMAT(ICE),
-	MPT_DECLARE_FORMAT(KRIS),
-	MPT_DECLARE_FORMAT(669),
-	MPT_DECLARE_FORMAT(667),
+	MPT_DECLARE_FORMAT(ICE, MagicAt(1464, "MTN\0"), MagicAt(1464, "IT10")),
+	MPT_DECLARE_FORMAT(KRIS, MagicAt(952, "KRIS")),
+	MPT_DECLARE_FORMAT(669, MagicAt(0, "if"), MagicAt(0, "JN")),
+	MPT_DECLARE_FORMAT(667, MagicAt(0, "gf")),
 	MPT_DECLARE_FORMAT(C67),
-	MPT_DECLARE_FORMAT(MO3),
-	MPT_DECLARE_FORMAT(FC),
-	MPT_DECLARE_FORMAT(FTM),
-	MPT_DECLARE_FORMAT(RTM),
-	MPT_DECLARE_FORMAT(TCB),
-	MPT_DECLARE_FORMAT(CBA),
-	MPT_DECLARE_FORMAT(ETX),
-	MPT_DECLARE_FORMAT(DSm),
+	MPT_DECLARE_FORMAT(MO3, MagicAt(0, "MO3")),
+	MPT_DECLARE_FORMAT(FC, MagicAt(0, "SMOD"), MagicAt(0, "FC14")),
+	MPT_DECLARE_FORMAT(FTM, MagicAt(0, "FTMN")),
+	MPT_DECLARE_FORMAT(RTM, MagicAt(0, "RTMM")),
+	MPT_DECLARE_FORMAT(TCB, MagicAt(0, "AN COOL."), MagicAt(0, "AN COOL!")),
+	MPT_DECLARE_FORMAT(CBA, MagicAt(0, "CBA\xF9")),
+	MPT_DECLARE_FORMAT(ETX, MagicAt(0, "EASYTRAX 1.0\x01\x00")),
+	MPT_DECLARE_FORMAT(DSm, MagicAt(0, "DSm\x1A")),
 	MPT_DECLARE_FORMAT(STK),
 	MPT_DECLARE_FORMAT(XMF),
 	MPT_DECLARE_FORMAT(Puma),
@@ -323,6 +378,35 @@ static constexpr FileFormatLoader ModuleFormatLoaders[] =
 #undef MPT_DECLARE_FORMAT
 
 
+#if !defined(MPT_WITH_ANCIENT)
+static constexpr FileFormatSignatures MMCMPSignatures = {MagicAt(0, "ziRCONia")};
+static constexpr FileFormatSignatures PP20Signatures = {MagicAt(0, "PP20")};
+static constexpr FileFormatSignatures XPKSignatures = {MagicAt(0, "XPKF")};
+#endif // !MPT_WITH_ANCIENT
+static constexpr FileFormatSignatures UMXSignatures = {MagicAt(0, "\xC1\x83\x2A\x9E")};
+
+
+// Checks if a file header could belong to a format with the given signatures.
+// The header must be conclusive, i.e. either contain at least ProbeRecommendedSize bytes or the complete file.
+// Then every prober or loader of a format whose signatures do not match is guaranteed to fail,
+// so this quick check can be used to skip it without changing the outcome.
+static bool MayMatchSignatures(const FileFormatSignatures &signatures, mpt::span<const std::byte> header)
+{
+	if(!signatures[0].length)
+		return true;
+	for(const auto &signature : signatures)
+	{
+		if(signature.length
+		   && header.size() >= static_cast<std::size_t>(signature.offset) + signature.length
+		   && !std::memcmp(header.data() + signature.offset, signature.magic, signature.length))
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+
 CSoundFile::ProbeResult CSoundFile::ProbeAdditionalSize(MemoryFileReader &file, const uint64 *pfilesize, uint64 minimumAdditionalSize)
 {
 	const uint64 availableFileSize = file.GetLength();
@@ -375,20 +459,30 @@ CSoundFile::ProbeResult CSoundFile::Probe(ProbeFlags flags, mpt::span<const std:
 		throw std::invalid_argument("");
 	}
 	MemoryFileReader file(data);
+	// Probers can only ask for more data if the header is not conclusive, so only then all of them have to be tried.
+	const bool headerIsConclusive = (data.size() >= ProbeRecommendedSize) || (pfilesize && data.size() >= *pfilesize);
+	const auto mayMatch = [headerIsConclusive, data](const FileFormatSignatures &signatures)
+	{
+		return !headerIsConclusive || MayMatchSignatures(signatures, data);
+	};
 	if(flags & ProbeContainers)
 	{
 #if !defined(MPT_WITH_ANCIENT)
-		MPT_DO_PROBE(result, ProbeFileHeaderMMCMP(file, pfilesize));
-		MPT_DO_PROBE(result, ProbeFileHeaderPP20(file, pfilesize));
-		MPT_DO_PROBE(result, ProbeFileHeaderXPK(file, pfilesize));
+		if(mayMatch(MMCMPSignatures))
+			MPT_DO_PROBE(result, ProbeFileHeaderMMCMP(file, pfilesize));
+		if(mayMatch(PP20Signatures))
+			MPT_DO_PROBE(result, ProbeFileHeaderPP20(file, pfilesize));
+		if(mayMatch(XPKSignatures))
+			MPT_DO_PROBE(result, ProbeFileHeaderXPK(file, pfilesize));
 #endif // !MPT_WITH_ANCIENT
-		MPT_DO_PROBE(result, ProbeFileHeaderUMX(file, pfilesize));
+		if(mayMatch(UMXSignatures))
+			MPT_DO_PROBE(result, ProbeFileHeaderUMX(file, pfilesize));
 	}
 	if(flags & ProbeModules)
 	{
 		for(const auto &format : ModuleFormatLoaders)
 		{
-			if(format.prober != nullptr)
+			if(format.prober != nullptr && mayMatch(format.signatures))
 			{
 				MPT_DO_PROBE(result, format.prober(file, pfilesize));
 			}
@@ -458,7 +552,8 @@ bool CSoundFile::Create(FileReader file, ModLoadingFlags loadFlags, CModDoc *pMo
 					outputFile = ancientArchive->GetOutputFile();
 			}
 #endif
-			if(CreateInternal(outputFile, loadFlags))
+			// The extracted file only lives as long as the unarchiver, so its samples cannot be decoded later
+			if(CreateInternal(outputFile, static_cast<ModLoadingFlags>(loadFlags & ~deferSampleData)))
 			{
 				// Read archive comment if there is no song comment
 				if(m_songMessage.empty())
@@ -511,10 +606,24 @@ bool CSoundFile::CreateInternal(FileReader file, ModLoadingFlags loadFlags)
 			return false;
 		}
 
-		// Try all module format loaders
+		m_deferredSamples.reset();
+		if((loadFlags & (loadSampleData | deferSampleData)) == (loadSampleData | deferSampleData) && loadFlags != onlyVerifyHeader)
+		{
+			// Deferred samples are read directly from the caller's file data
+			m_deferredSamples = std::make_unique<DeferredSamples>();
+			if(packedContainerType != ModContainerType::None && !containerItems.empty())
+				m_deferredSamples->containerData = std::move(containerItems[0].data_cache);
+		}
+
+		// Try all module format loaders that could possibly recognize the file.
+		// The header view contains the complete file or at least ProbeRecommendedSize bytes, so it is always conclusive.
+		file.Rewind();
+		const FileReader::PinnedView header = file.GetPinnedView(ProbeRecommendedSize);
 		bool loaderSuccess = false;
 		for(const auto &format : ModuleFormatLoaders)
 		{
+			if(!MayMatchSignatures(format.signatures, header.span()))
+				continue;
 			loaderSuccess = (this->*(format.loader))(file, loadFlags);
 			if(loaderSuccess)
 			{
@@ -534,6 +643,7 @@ bool CSoundFile::CreateInternal(FileReader file, ModLoadingFlags loadFlags)
 		{
 			m_nType = MOD_TYPE_NONE;
 			m_ContainerType = ModContainerType::None;
+			m_deferredSamples.reset();
 		}
 		if(loadFlags == onlyVerifyHeader)
 		{
@@ -642,8 +752,9 @@ bool CSoundFile::CreateInternal(FileReader file, ModLoadingFlags loadFlags)
 
 		if(sample.HasSampleData())
 		{
-			sample.PrecomputeLoops(*this, false);
-		} else if(!sample.uFlags[SMP_KEEPONDISK])
+			if(!ApplySampleStorage(nSmp))
+				sample.PrecomputeLoops(*this, false);
+		} else if(!sample.uFlags[SMP_KEEPONDISK] && !IsSampleDataDeferred(nSmp))
 		{
 			sample.nLength = 0;
 			sample.nLoopStart = 0;
@@ -655,6 +766,12 @@ bool CSoundFile::CreateInternal(FileReader file, ModLoadingFlags loadFlags)
 		if(sample.nGlobalVol > 64) sample.nGlobalVol = 64;
 		if(sample.uFlags[CHN_ADLIB] && m_opl == nullptr) InitOPL();
 	}
+	if(m_deferredSamples && m_deferredSamples->samples.empty())
+	{
+		// The format loader did not make use of deferred loading
+		m_deferredSamples.reset();
+	}
+	ApplySampleMemoryBudget();
 	// Check invalid instruments
 	INSTRUMENTINDEX maxInstr = 0;
 	for(INSTRUMENTINDEX i = 0; i <= m_nInstruments; i++)
@@ -840,10 +957,13 @@ bool CSoundFile::Destroy()
 	m_samplePaths.clear();
 #endif // MPT_EXTERNAL_SAMPLES
 
+	m_deferredSamples.reset();
 	for(auto &smp : Samples)
 	{
 		smp.FreeSample();
 	}
+	m_widenedSamples.reset();
+	m_downsampledSamples.reset();
 	for(auto &ins : Instruments)
 	{
 		delete ins;
@@ -1595,6 +1715,12 @@ bool CSoundFile::DestroySample(SAMPLEINDEX nSample)
 	{
 		return false;
 	}
+	if(m_deferredSamples)
+	{
+		m_deferredSamples->samples.erase(nSample);
+		if(m_deferredSamples->samples.empty())
+			m_deferredSamples.reset();
+	}
 	if(!Samples[nSample].HasSampleData())
 	{
 		return true;
@@ -1616,6 +1742,8 @@ bool CSoundFile::DestroySample(SAMPLEINDEX nSample)
 	sample.nLength = 0;
 	sample.uFlags.reset(CHN_16BIT | CHN_STEREO);
 	sample.SetAdlib(false);
+	m_widenedSamples.reset(nSample);
+	m_downsampledSamples.reset(nSample);
 
 #ifdef MODPLUG_TRACKER
 	ResetSamplePath(nSample);
@@ -1970,6 +2098,333 @@ SAMPLEINDEX CSoundFile::GetSampleIndex(ModCommand::NOTE note, uint32 instr) cons
 }
 
 
+void CSoundFile::SetSampleDecodeThreads(uint32 numThreads)
+{
+#ifdef MPT_ENABLE_MIX_THREADS
+	if(numThreads == 0)
+		numThreads = std::max(std::thread::hardware_concurrency(), 1u);
+	m_sampleDecodeThreads = std::min(numThreads, static_cast<uint32>(MAX_SAMPLES));
+#else
+	MPT_UNREFERENCED_PARAMETER(numThreads);
+#endif  // MPT_ENABLE_MIX_THREADS
+}
+
+
+uint32 CSoundFile::GetSampleDecodeThreads() const noexcept
+{
+	return m_sampleDecodeThreads;
+}
+
+
+void CSoundFile::SetSampleStorage(SampleStorage storage)
+{
+	// Samples may have been narrowed again to fit into the sample memory budget
+	if(storage == m_sampleStorage)
+		return;
+	m_sampleStorage = storage;
+	for(SAMPLEINDEX smp = 1; smp <= GetNumSamples(); smp++)
+	{
+		ApplySampleStorage(smp);
+	}
+}
+
+
+// Converts the sample to the format requested by the sample storage setting.
+// Returns true if the sample was converted, in which case the loop lookahead buffers have already been updated.
+bool CSoundFile::ApplySampleStorage(SAMPLEINDEX smp)
+{
+	if(m_sampleStorage != SampleStorage::Int16 || !smp || smp >= MAX_SAMPLES)
+		return false;
+	if(!ctrlSmp::ConvertTo16Bit(Samples[smp], *this))
+		return false;
+	m_widenedSamples.set(smp);
+	return true;
+}
+
+
+bool CSoundFile::IsSampleWidened(const ModSample *sample) const noexcept
+{
+	if(sample == nullptr || sample < Samples || sample >= Samples + MAX_SAMPLES)
+		return false;
+	return m_widenedSamples[sample - Samples];
+}
+
+
+size_t CSoundFile::GetSampleMemoryUsage() const noexcept
+{
+	size_t size = 0;
+	for(SAMPLEINDEX smp = 1; smp <= GetNumSamples(); smp++)
+	{
+		const ModSample &sample = Samples[smp];
+		if(sample.HasSampleData())
+			size += ModSample::GetRealSampleBufferSize(sample.nLength, sample.GetBytesPerSample());
+	}
+	return size;
+}
+
+
+bool CSoundFile::IsSampleDownsampled(const ModSample *sample) const noexcept
+{
+	if(sample == nullptr || sample < Samples || sample >= Samples + MAX_SAMPLES)
+		return false;
+	return m_downsampledSamples[sample - Samples];
+}
+
+
+// Reduce the sample data until it fits into the sample memory budget, starting with the largest samples.
+// Deferred samples are counted with the size they will have once they are decoded. Their reductions are only recorded here and applied
+// when they are decoded, but their length and pitch are adjusted right away, so that nothing changes for a voice that is already playing them.
+void CSoundFile::ApplySampleMemoryBudget()
+{
+	if(!m_sampleMemoryBudget)
+		return;
+
+	const auto deferredSample = [this](SAMPLEINDEX smp) -> DeferredSamples::Sample *
+	{
+		if(!m_deferredSamples)
+			return nullptr;
+		auto it = m_deferredSamples->samples.find(smp);
+		return it != m_deferredSamples->samples.end() ? &it->second : nullptr;
+	};
+	// Deferred 8-bit samples are widened when they are decoded, unless they are going to be converted back
+	const auto willBeWidened = [this](const ModSample &sample, const DeferredSamples::Sample &deferred)
+	{
+		return m_sampleStorage == SampleStorage::Int16 && sample.GetElementarySampleSize() == 1 && !deferred.convertTo8Bit;
+	};
+	const auto sampleSize = [&](SAMPLEINDEX smp)
+	{
+		const ModSample &sample = Samples[smp];
+		const DeferredSamples::Sample *deferred = deferredSample(smp);
+		if(deferred == nullptr)
+			return sample.HasSampleData() ? ModSample::GetRealSampleBufferSize(sample.nLength, sample.GetBytesPerSample()) : size_t(0);
+		uint8 bytesPerSample = sample.GetBytesPerSample();
+		if(willBeWidened(sample, *deferred))
+			bytesPerSample *= 2;
+		else if(deferred->convertTo8Bit)
+			bytesPerSample /= sample.GetElementarySampleSize();
+		return ModSample::GetRealSampleBufferSize(sample.nLength, bytesPerSample);
+	};
+
+	std::vector<SAMPLEINDEX> order;
+	size_t originalUsage = 0;
+	for(SAMPLEINDEX smp = 1; smp <= GetNumSamples(); smp++)
+	{
+		const size_t size = sampleSize(smp);
+		if(!size)
+			continue;
+		order.push_back(smp);
+		originalUsage += size;
+	}
+	size_t usage = originalUsage;
+	if(usage <= m_sampleMemoryBudget)
+		return;
+	std::stable_sort(order.begin(), order.end(), [&sampleSize](SAMPLEINDEX a, SAMPLEINDEX b) { return sampleSize(a) > sampleSize(b); });
+
+	const auto reduce = [&](auto convert)
+	{
+		for(SAMPLEINDEX smp : order)
+		{
+			if(usage <= m_sampleMemoryBudget)
+				return;
+			const size_t oldSize = sampleSize(smp);
+			if(convert(smp, Samples[smp], deferredSample(smp)))
+				usage = usage - oldSize + sampleSize(smp);
+		}
+	};
+
+	// Lossless: Merge identical stereo channels and undo widening from the sample storage setting
+	reduce([&](SAMPLEINDEX smp, ModSample &sample, DeferredSamples::Sample *deferred)
+	{
+		if(deferred)
+		{
+			if(!willBeWidened(sample, *deferred))
+				return false;
+			deferred->convertTo8Bit = true;
+			return true;
+		}
+		bool converted = ctrlSmp::ConvertIdenticalStereoToMono(sample, *this);
+		if(m_widenedSamples[smp] && ctrlSmp::ConvertTo8Bit(sample, *this))
+		{
+			m_widenedSamples.reset(smp);
+			converted = true;
+		}
+		return converted;
+	});
+	// Reduce bit depth
+	reduce([&](SAMPLEINDEX smp, ModSample &sample, DeferredSamples::Sample *deferred)
+	{
+		if(deferred)
+		{
+			if(deferred->convertTo8Bit || sample.GetElementarySampleSize() != 2)
+				return false;
+			deferred->convertTo8Bit = true;
+			return true;
+		}
+		if(!ctrlSmp::ConvertTo8Bit(sample, *this))
+			return false;
+		m_widenedSamples.reset(smp);
+		return true;
+	});
+	// Halve the sample rate of long samples. Formats using period tables cannot express the resulting pitch change.
+	constexpr SmpLength MinDownsampleLength = 16384;
+	if(!UseFinetuneAndTranspose() || GetType() == MOD_TYPE_XM)
+	{
+		reduce([&](SAMPLEINDEX smp, ModSample &sample, DeferredSamples::Sample *deferred)
+		{
+			if(sample.nLength < MinDownsampleLength || m_downsampledSamples[smp])
+				return false;
+			if(deferred)
+			{
+				if(!ctrlSmp::CanDownsample2x(sample, *this))
+					return false;
+				ctrlSmp::PrepareDownsample2x(sample, *this);
+				deferred->downsample = true;
+			} else if(!ctrlSmp::Downsample2x(sample, *this))
+			{
+				return false;
+			}
+			m_downsampledSamples.set(smp);
+			return true;
+		});
+	}
+
+	if(usage > m_sampleMemoryBudget)
+		AddToLog(LogWarning, MPT_UFORMAT("Sample data uses {} bytes, which exceeds the sample memory budget of {} bytes.")(usage, m_sampleMemoryBudget));
+	else
+		AddToLog(LogInformation, MPT_UFORMAT("Sample data was reduced from {} to {} bytes to fit into the sample memory budget.")(originalUsage, usage));
+}
+
+
+// Called by format loaders instead of SampleIO::ReadSample if they support deferred sample loading.
+// If the sample data can be decoded later, only the sample length and format flags are set up and true is returned.
+// The file cursor is not advanced in that case.
+bool CSoundFile::DeferSampleRead(SAMPLEINDEX smp, const SampleIO &sampleIO, const FileReader &file)
+{
+	if(!m_deferredSamples || !smp || smp >= MAX_SAMPLES)
+	{
+		return false;
+	}
+	ModSample &sample = Samples[smp];
+	if(sampleIO.PrepareSample(sample, file))
+	{
+		m_deferredSamples->samples[smp] = {file, sampleIO, sample.nLength};
+	}
+	return true;
+}
+
+
+bool CSoundFile::IsSampleDataDeferred(SAMPLEINDEX smp) const
+{
+	return m_deferredSamples && m_deferredSamples->samples.count(smp) != 0;
+}
+
+
+bool CSoundFile::HasDeferredSamples() const noexcept
+{
+	return m_deferredSamples != nullptr;
+}
+
+
+// Make the deferred samples independent of the file data that was passed to Create().
+// The copy is only made if the loader actually deferred something, and it is freed together with the last deferred sample.
+void CSoundFile::CopyDeferredSampleData()
+{
+	if(!m_deferredSamples || m_deferredSamples->containerData || !m_deferredSamples->fileCopy.empty())
+	{
+		return;
+	}
+	// All deferred samples are read from the file reader that was passed to the format loader
+	FileReader file = m_deferredSamples->samples.begin()->second.file;
+	file.Rewind();
+	m_deferredSamples->fileCopy = file.GetRawDataAsByteVector();
+	const FileReader fileCopy{mpt::as_span(std::as_const(m_deferredSamples->fileCopy))};
+	for(auto &[smp, deferred] : m_deferredSamples->samples)
+	{
+		MPT_ASSERT(deferred.file.GetLength() == fileCopy.GetLength());
+		const auto position = deferred.file.GetPosition();
+		deferred.file = fileCopy;
+		deferred.file.Seek(position);
+	}
+}
+
+
+// Decode the sample data if it has not been decoded yet.
+void CSoundFile::DecodeDeferredSample(SAMPLEINDEX smp)
+{
+	if(!m_deferredSamples)
+	{
+		return;
+	}
+	auto it = m_deferredSamples->samples.find(smp);
+	if(it == m_deferredSamples->samples.end())
+	{
+		return;
+	}
+	DeferredSamples::Sample deferred = std::move(it->second);
+	m_deferredSamples->samples.erase(it);
+
+	// The sample properties already reflect the reductions chosen by ApplySampleMemoryBudget, only the data still needs to be converted
+	ModSample &sample = Samples[smp];
+	const SmpLength length = sample.nLength;
+	sample.nLength = deferred.length;
+	deferred.sampleIO.ReadSample(sample, deferred.file);
+	if(deferred.downsample && !ctrlSmp::Downsample2xData(sample, *this))
+		sample.FreeSample();
+	if(!sample.HasSampleData())
+		sample.nLength = length;
+	if(sample.HasSampleData())
+	{
+		bool converted = false;
+		if(deferred.convertTo8Bit)
+			converted = ctrlSmp::ConvertTo8Bit(sample, *this);
+		else
+			converted = ApplySampleStorage(smp);
+		if(!converted && !deferred.downsample)
+			sample.PrecomputeLoops(*this, false);
+	}
+
+	if(m_deferredSamples->samples.empty())
+	{
+		m_deferredSamples.reset();
+	}
+}
+
+
+// Decode up to maxSamples samples that may be triggered on the given range of pattern rows.
+void CSoundFile::PrefetchDeferredSamples(ORDERINDEX ord, ROWINDEX row, ROWINDEX numRows, SAMPLEINDEX maxSamples)
+{
+	const CPattern *pattern = Order().PatternAt(ord);
+	if(pattern == nullptr || !pattern->IsValidRow(row))
+	{
+		return;
+	}
+	const ROWINDEX endRow = std::min(row + numRows, pattern->GetNumRows());
+	const CHANNELINDEX numChannels = std::min(GetNumChannels(), pattern->GetNumChannels());
+	for(; row < endRow; row++)
+	{
+		const ModCommand *m = pattern->GetpModCommand(row, 0);
+		for(CHANNELINDEX chn = 0; chn < numChannels; chn++, m++)
+		{
+			if(!m->instr && !m->IsNote())
+			{
+				continue;
+			}
+			const ModChannel &channel = m_PlayState.Chn[chn];
+			const SAMPLEINDEX smp = GetSampleIndex(m->IsNote() ? m->note : channel.nNewNote, m->instr ? m->instr : channel.nNewIns);
+			if(!IsSampleDataDeferred(smp))
+			{
+				continue;
+			}
+			DecodeDeferredSample(smp);
+			if(!--maxSamples || !m_deferredSamples)
+			{
+				return;
+			}
+		}
+	}
+}
+
+
 // Find an unused sample slot. If it is going to be assigned to an instrument, targetInstrument should be specified.
 // SAMPLEINDEX_INVLAID is returned if no free sample slot could be found.
 SAMPLEINDEX CSoundFile::GetNextFreeSample(INSTRUMENTINDEX targetInstrument, SAMPLEINDEX start) const
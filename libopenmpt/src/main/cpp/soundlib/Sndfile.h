@@ -27,6 +27,7 @@
 #endif // MODPLUG_TRACKER
 
 #include "Mixer.h"
+#include "MixFuncTable.h"
 #include "Resampler.h"
 #ifndef NO_REVERB
 #include "../sounddsp/Reverb.h"
@@ -51,6 +52,7 @@
 #include "patternContainer.h"
 #include "PlayState.h"
 #include "plugins/PluginStructs.h"
+#include "RenderProfile.h"
 #include "RowVisitor.h"
 
 #include "mpt/audio/span.hpp"
@@ -210,6 +212,47 @@ enum enmGetLengthResetMode
 };
 
 
+// Per-channel sample seeking state of GetLength()
+struct GetLengthChnSettings
+{
+	uint32 ticksToRender = 0;  // When using sample sync, we still need to render this many ticks
+	bool incChanged = false;   // When using sample sync, note frequency has changed
+	uint8 vol = 0xFF;
+};
+
+
+// Snapshot of the GetLength() state while seeking to a given time.
+// Later seeks can resume from the closest snapshot instead of going through the whole song again.
+struct SeekCheckpoint
+{
+	PlayState::Checkpoint playState;
+	std::vector<GetLengthChnSettings> chnSettings;
+	RowVisitor visitedRows;
+	double elapsedTime = 0.0;
+	uint32 oldTickDuration = 0;
+	ORDERINDEX endOrder = ORDERINDEX_INVALID;
+	ROWINDEX endRow = ROWINDEX_INVALID;
+	bool breakToRow = false;
+
+	SeekCheckpoint(const RowVisitor &visited) : visitedRows{visited} { }
+};
+
+
+// Checkpoints are only valid for the start position and playback parameters they were recorded with
+struct SeekCheckpointIndex
+{
+	SEQUENCEINDEX sequence = SEQUENCEINDEX_INVALID;
+	ORDERINDEX startOrder = ORDERINDEX_INVALID;
+	ROWINDEX startRow = ROWINDEX_INVALID;
+	enmGetLengthResetMode adjustMode = eNoAdjust;
+	uint32 mixingFreq = 0;
+	uint32 tempoFactor = 0;
+	uint32 freqFactor = 0;
+	double interval = 0.0;  // Distance between checkpoints; doubled whenever the number of checkpoints reaches the limit
+	std::vector<SeekCheckpoint> checkpoints;
+};
+
+
 // Delete samples assigned to instrument
 enum deleteInstrumentSamples
 {
@@ -224,6 +267,8 @@ class CTuningCollection;
 using CTuningCollection = Tuning::CTuningCollection;
 struct CModSpecifications;
 class OPL;
+class MixThreadPool;
+class SampleIO;
 class PlaybackTest;
 class CModDoc;
 
@@ -272,6 +317,13 @@ struct TimingInfo
 };
 
 
+// Sample data layout used for playback (see CSoundFile::SetSampleStorage)
+enum class SampleStorage : uint8
+{
+	Original,  // Keep the sample format of the module file
+	Int16,     // Convert 8-bit samples to 16-bit
+};
+
 enum class ModMessageHeuristicOrder
 {
 	Instruments,
@@ -450,6 +502,7 @@ private:
 public:
 	MixerSettings m_MixerSettings;
 	CResampler m_Resampler;
+	const MixFuncInterface *m_mixFunctions = MixFuncTable::Functions;  // Chosen for the current CPU in InitPlayer
 #ifndef NO_REVERB
 	mixsample_t ReverbSendBuffer[MIXBUFFERSIZE * 2];
 	mixsample_t m_RvbROfsVol = 0, m_RvbLOfsVol = 0;
@@ -468,6 +521,10 @@ public:
 #ifndef NO_DSP
 	BitCrush m_BitCrush;
 #endif
+#ifdef MPT_ENABLE_RENDER_PROFILE
+	RenderProfile m_RenderProfile;
+#endif
+	bool m_skipSilentChunks = true;
 
 	static constexpr uint32 TICKS_ROW_FINISHED = uint32_max - 1u;
 
@@ -529,6 +586,23 @@ public:
 #ifndef NO_PLUGINS
 	std::array<SNDMIXPLUGIN, MAX_MIXPLUGINS> m_MixPlugins;  // Mix plugins
 	uint32 m_loadedPlugins = 0;                             // Not a PLUGINDEX because number of loaded plugins may exceed MAX_MIXPLUGINS during MIDI conversion
+private:
+	// A loaded plugin in processing order. Plugins can only send their output to plugins in higher slots, so slot order is a valid processing order.
+	struct PluginGraphNode
+	{
+		uint32 outputRouting;  // Output routing when the graph was compiled, to detect routing changes
+		PLUGINDEX slot;
+		PLUGINDEX output;      // Slot of the plugin receiving the output, or PLUGINDEX_INVALID for the master mix
+		bool hasInputs;        // Another plugin slot sends its output to this plugin
+	};
+	std::array<PluginGraphNode, MAX_MIXPLUGINS> m_pluginGraph;
+	PLUGINDEX m_pluginGraphSize = 0;
+	bool m_pluginGraphDirty = true;
+public:
+	// Loading, unloading and moving plugins and the SNDMIXPLUGIN routing setters of loaded plugins call this,
+	// and direct changes to the output routing of loaded plugins are detected automatically.
+	// Other changes that affect the plugin graph (e.g. routing an empty slot to a plugin) need to call this.
+	void InvalidatePluginGraph() noexcept { m_pluginGraphDirty = true; }
 #endif
 	mpt::charbuf<MAX_SAMPLENAME> m_szNames[MAX_SAMPLES];  // Sample names
 
@@ -555,6 +629,12 @@ protected:
 	// For handling backwards jumps and stuff to prevent infinite loops when counting the mod length or rendering to wav.
 	RowVisitor m_visitedRows;
 
+	// State snapshots taken by GetLength() every m_seekCheckpointInterval seconds when seeking to a given time (0 = disabled)
+	static constexpr double MinSeekCheckpointInterval = 0.5;
+	static constexpr std::size_t MaxSeekCheckpoints = 256;
+	double m_seekCheckpointInterval = 0.0;
+	SeekCheckpointIndex m_seekCheckpoints;
+
 public:
 #ifdef MODPLUG_TRACKER
 	std::bitset<MAX_BASECHANNELS> m_bChannelMuteTogglePending;
@@ -566,6 +646,28 @@ public:
 
 	std::unique_ptr<OPL> m_opl;
 
+private:
+	// Where a voice is mixed to, as determined by its reverb / surround / plugin routing
+	struct VoiceMixRoute
+	{
+		mixsample_t *buffer;
+		mixsample_t *ofsL, *ofsR;  // End-of-sample pop reduction tail level of the destination
+		PLUGINDEX plugin;          // 1-based, 0 if not routed to a plugin
+	};
+	// A voice rendered into its own buffer by a worker thread, to be summed into its destination afterwards
+	struct VoiceMixTask
+	{
+		ModChannel *chn;
+		VoiceMixRoute route;
+		mixsample_t ofsL, ofsR;  // Tail level to add to *route.ofsL / *route.ofsR
+		bool mixed;
+	};
+#ifdef MPT_ENABLE_MIX_THREADS
+	std::unique_ptr<MixThreadPool> m_mixThreadPool;
+#endif
+	std::vector<VoiceMixTask> m_voiceMixTasks;
+	std::vector<mixsample_t> m_voiceMixBuffer;
+
 #ifdef MODPLUG_TRACKER
 public:
 	CMIDIMapper& GetMIDIMapper() { return m_MIDIMapper; }
@@ -606,6 +708,63 @@ public:
 	bool LoadExternalSample(SAMPLEINDEX smp, const mpt::PathString &filename);
 #endif // MPT_EXTERNAL_SAMPLES
 
+	// Sample data that is decoded when the sample is played for the first time (see deferSampleData)
+protected:
+	struct DeferredSamples;
+	std::unique_ptr<DeferredSamples> m_deferredSamples;
+
+public:
+	bool DeferSampleRead(SAMPLEINDEX smp, const SampleIO &sampleIO, const FileReader &file);
+	bool IsSampleDataDeferred(SAMPLEINDEX smp) const;
+	void DecodeDeferredSample(SAMPLEINDEX smp);
+	bool HasDeferredSamples() const noexcept;
+	void CopyDeferredSampleData();
+protected:
+	void PrefetchDeferredSamples(ORDERINDEX ord, ROWINDEX row, ROWINDEX numRows, SAMPLEINDEX maxSamples);
+
+	uint32 m_sampleDecodeThreads = 1;
+public:
+	// Number of threads used for decoding compressed samples while loading (0 = one per hardware thread, 1 = decode on the calling thread only).
+	// Currently only used by the MO3 loader. The decoded samples are identical to decoding on a single thread.
+	void SetSampleDecodeThreads(uint32 numThreads);
+	uint32 GetSampleDecodeThreads() const noexcept;
+
+protected:
+	SampleStorage m_sampleStorage = SampleStorage::Original;
+	std::bitset<MAX_SAMPLES> m_widenedSamples;
+	bool ApplySampleStorage(SAMPLEINDEX smp);
+public:
+	// Converts all sample data to a single format when it is loaded, so that only the mixer functions for that format are used.
+	// Samples that have already been loaded are converted when the setting is changed. Widened samples are not narrowed again.
+	void SetSampleStorage(SampleStorage storage);
+	SampleStorage GetSampleStorage() const noexcept { return m_sampleStorage; }
+	// Returns true if the sample was stored as 8-bit data in the module file but has been widened to 16-bit because of the sample storage setting.
+	bool IsSampleWidened(const ModSample *sample) const noexcept;
+	// Number of bytes currently allocated for sample data, including the interpolation lookahead buffers
+	size_t GetSampleMemoryUsage() const noexcept;
+
+protected:
+	size_t m_sampleMemoryBudget = 0;
+	std::bitset<MAX_SAMPLES> m_downsampledSamples;
+	void ApplySampleMemoryBudget();
+public:
+	// Maximum number of bytes of sample data to keep in memory after loading (0 = unlimited). Has to be set before loading the module.
+	// If the samples exceed the budget, they are reduced step by step until they fit: identical stereo channels are merged first,
+	// then 16-bit samples are converted to 8-bit, and finally long samples are downsampled to half their sample rate.
+	void SetSampleMemoryBudget(size_t bytes) noexcept { m_sampleMemoryBudget = bytes; }
+	size_t GetSampleMemoryBudget() const noexcept { return m_sampleMemoryBudget; }
+	// Returns true if the sample has been downsampled to fit into the sample memory budget. Sample offsets refer to the original sample data.
+	bool IsSampleDownsampled(const ModSample *sample) const noexcept;
+
+protected:
+	SampleMappingSource m_sampleMappingSource;
+public:
+	// Memory-mapped module file that uncompressed sample data may be mapped from while loading (see ModSample::MapSample).
+	// The file descriptor only needs to stay open during Create(). Pass a default-constructed source to disable mapping.
+	void SetSampleMappingSource(const SampleMappingSource &source) { m_sampleMappingSource = source; }
+	const SampleMappingSource *GetSampleMappingSource() const noexcept { return (m_sampleMappingSource.fd >= 0) ? &m_sampleMappingSource : nullptr; }
+
+
 	bool m_bIsRendering = false;
 	TimingInfo m_TimingInfo; // only valid if !m_bIsRendering
 
@@ -635,6 +794,7 @@ public:
 		skipContainer      = 0x10,
 		skipModules        = 0x20,
 		onlyVerifyHeader   = 0x40, // Do not combine with other flags!
+		deferSampleData    = 0x80, // If set together with loadSampleData, formats that support it only decode a sample when it is played for the first time. The file data must stay valid until HasDeferredSamples() returns false, or CopyDeferredSampleData() must be called after loading.
 
 		// Shortcuts
 		loadCompleteModule = loadSampleData | loadPatternData | loadPluginData | loadPluginInstance,
@@ -768,6 +928,14 @@ public:
 	// Get song duration in various cases: total length, length to specific order & row, etc.
 	std::vector<GetLengthType> GetLength(enmGetLengthResetMode adjustMode, GetLengthTarget target = GetLengthTarget());
 
+	// Time-based seeking can record snapshots of the playback state every few seconds, so that following seeks into the same region are faster.
+	// Each snapshot costs about 1 KiB per pattern channel. An interval of 0 disables and frees the snapshots.
+	// Shorter intervals than MinSeekCheckpointInterval are rounded up. At most MaxSeekCheckpoints snapshots are kept;
+	// once there are that many, every other snapshot is dropped and the interval is doubled.
+	void SetSeekCheckpointInterval(double seconds);
+	double GetSeekCheckpointInterval() const noexcept { return m_seekCheckpointInterval; }
+	std::size_t GetNumSeekCheckpoints() const noexcept { return m_seekCheckpoints.checkpoints.size(); }
+
 public:
 	void RecalculateSamplesPerTick();
 	double GetRowDuration(TEMPO tempo, uint32 speed) const;
@@ -987,14 +1155,33 @@ public:
 		);
 	samplecount_t ReadOneTick();
 private:
-	void CreateStereoMix(int count);
+	// Returns the number of voices that were mixed
+	CHANNELINDEX CreateStereoMix(int count);
+	// Returns true if mixing the next chunk is guaranteed to produce nothing but silence
+	bool IsMixSilent() const;
+	// Replaces CreateStereoMix for chunks where IsMixSilent() is true: clears the mix buffers and only advances the inaudible voices
+	void CreateSilentMix(int count);
 	bool MixChannel(int count, ModChannel &chn, CHANNELINDEX channel, bool doMix);
+	VoiceMixRoute PrepareVoiceMixRoute(int count, const ModChannel &chn, CHANNELINDEX channel);
+	bool MixVoice(int count, ModChannel &chn, mixsample_t *pbuffer, mixsample_t &ofsL, mixsample_t &ofsR, bool doMix) const;
+	CHANNELINDEX MixVoicesParallel(int count);
 	std::pair<mixsample_t *, mixsample_t *> GetChannelOffsets(const ModChannel &chn, CHANNELINDEX channel);
 public:
+	// Spread voice mixing over the given number of threads (0 = one per hardware thread, 1 = mix on the calling thread only).
+	// With the fixed-point mixer, the output is bit-identical to mixing on a single thread.
+	void SetMixThreads(uint32 numThreads);
+	uint32 GetMixThreads() const noexcept;
+	// Chunks in which nothing is audible skip the mixer (see IsMixSilent). As the output is the same either way, this is only turned off to verify exactly that.
+	void SetSkipSilentChunks(bool skip) noexcept { m_skipSilentChunks = skip; }
+
 	bool FadeSong(uint32 msec);
 private:
 	void ProcessDSP(uint32 countChunk);
 	void ProcessPlugins(uint32 nCount);
+#ifndef NO_PLUGINS
+	// Recompile the plugin graph if plugins or their routing have changed since it was last compiled
+	void UpdatePluginGraph();
+#endif // NO_PLUGINS
 	void ProcessInputChannels(IAudioSource &source, std::size_t countChunk);
 public:
 	samplecount_t GetTotalSampleCount() const { return m_PlayState.m_lTotalSampleCount; }
@@ -1277,8 +1464,10 @@ public:
 	void ProcessMidiOut(CHANNELINDEX nChn);
 #endif // NO_PLUGINS
 
-	void ProcessGlobalVolume(samplecount_t countChunk);
-	void ProcessStereoSeparation(samplecount_t countChunk);
+	int32 UpdateGlobalVolumeRamp();
+	void ProcessPostMix(uint32 countChunk);
+	// Only advances the global volume ramp for a chunk whose mix buffers are silent
+	void ProcessSilentPostMix(uint32 countChunk);
 
 private:
 	PLUGINDEX GetChannelPlugin(const ModChannel &channel, CHANNELINDEX nChn, PluginMutePriority respectMutes) const;
@@ -81,6 +81,7 @@ void CSoundFile::InitPlayer(bool bReset)
 		InitAmigaResampler();
 	}
 	m_Resampler.UpdateTables();
+	m_mixFunctions = MixFuncTable::GetFunctions();
 #ifndef NO_REVERB
 	m_Reverb.Initialize(bReset, m_RvbROfsVol, m_RvbLOfsVol, m_MixerSettings.gdwMixingFreq);
 #endif
@@ -132,57 +133,6 @@ bool CSoundFile::FadeSong(uint32 msec)
 }
 
 
-// Apply stereo separation factor on an interleaved stereo/quad stream.
-// count = Number of stereo sample pairs to process
-// separation = -256...256 (negative values = swap L/R, 0 = mono, 128 = normal)
-static void ApplyStereoSeparation(mixsample_t *mixBuf, std::size_t count, int32 separation)
-{
-#ifdef MPT_INTMIXER
-	const mixsample_t factor_num = separation; // 128 =^= 1.0f
-	const mixsample_t factor_den = MixerSettings::StereoSeparationScale; // 128
-	const mixsample_t normalize_den = 2; // mid/side pre/post normalization
-	const mixsample_t mid_den = normalize_den;
-	const mixsample_t side_num = factor_num;
-	const mixsample_t side_den = factor_den * normalize_den;
-#else
-	const float normalize_factor = 0.5f; // cumulative mid/side normalization factor (1/sqrt(2))*(1/sqrt(2))
-	const float factor = static_cast<float>(separation) / static_cast<float>(MixerSettings::StereoSeparationScale); // sep / 128
-	const float mid_factor = normalize_factor;
-	const float side_factor = factor * normalize_factor;
-#endif
-	for(std::size_t i = 0; i < count; i++)
-	{
-		mixsample_t l = mixBuf[0];
-		mixsample_t r = mixBuf[1];
-		mixsample_t m = l + r;
-		mixsample_t s = l - r;
-#ifdef MPT_INTMIXER
-		m /= mid_den;
-		s = Util::muldiv(s, side_num, side_den);
-#else
-		m *= mid_factor;
-		s *= side_factor;
-#endif
-		l = m + s;
-		r = m - s;
-		mixBuf[0] = l;
-		mixBuf[1] = r;
-		mixBuf += 2;
-	}
-}
-
-
-static void ApplyStereoSeparation(mixsample_t *SoundFrontBuffer, mixsample_t *SoundRearBuffer, std::size_t channels, std::size_t countChunk, int32 separation)
-{
-	if(separation == MixerSettings::StereoSeparationScale)
-	{ // identity
-		return;
-	}
-	if(channels >= 2) ApplyStereoSeparation(SoundFrontBuffer, countChunk, separation);
-	if(channels >= 4) ApplyStereoSeparation(SoundRearBuffer , countChunk, separation);
-}
-
-
 void CSoundFile::ProcessInputChannels(IAudioSource &source, std::size_t countChunk)
 {
 	for(std::size_t channel = 0; channel < NUMMIXINPUTBUFFERS; ++channel)
@@ -222,6 +172,7 @@ samplecount_t CSoundFile::ReadOneTick()
 samplecount_t CSoundFile::Read(samplecount_t count, IAudioTarget &target, IAudioSource &source, std::optional<std::reference_wrapper<IMonitorOutput>> outputMonitor, std::optional<std::reference_wrapper<IMonitorInput>> inputMonitor)
 {
 	MPT_ASSERT_ALWAYS(m_MixerSettings.IsValid());
+	MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageTotal);
 
 	samplecount_t countRendered = 0;
 	samplecount_t countToRender = count;
@@ -232,12 +183,18 @@ samplecount_t CSoundFile::Read(samplecount_t count, IAudioTarget &target, IAudio
 		if(!m_PlayState.m_nBufferCount)
 		{
 			// Last tick or fade completely processed, find out what to do next
+			bool newTick = false;
+			if(!m_PlayState.m_flags[SONG_FADINGSONG])
+			{
+				MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageReadNote);
+				newTick = ReadNote();
+			}
 
 			if(m_PlayState.m_flags[SONG_FADINGSONG])
 			{
 				// Song was faded out
 				m_PlayState.m_flags.set(SONG_ENDREACHED);
-			} else if(ReadNote())
+			} else if(newTick)
 			{
 				// Render next tick (normal progress)
 				MPT_ASSERT(m_PlayState.m_nBufferCount > 0);
@@ -304,41 +261,60 @@ samplecount_t CSoundFile::Read(samplecount_t count, IAudioTarget &target, IAudio
 			inputMonitor->get().Process(mpt::audio_span_planar<const mixsample_t>(buffers, m_MixerSettings.NumInputChannels, countChunk));
 		}
 
-		CreateStereoMix(countChunk);
+#ifndef NO_PLUGINS
+		if(m_loadedPlugins)
+			UpdatePluginGraph();
+#endif  // NO_PLUGINS
+
+		// If nothing is audible, skip straight to the output stage with a zeroed buffer
+		const bool silentChunk = m_skipSilentChunks && IsMixSilent();
+		{
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageMix);
+			CHANNELINDEX voicesMixed = 0;
+			if(silentChunk)
+				CreateSilentMix(countChunk);
+			else
+				voicesMixed = CreateStereoMix(countChunk);
+#ifdef MPT_ENABLE_RENDER_PROFILE
+			m_RenderProfile.AddChunk(countChunk, voicesMixed, silentChunk);
+#else
+			MPT_UNUSED_VARIABLE(voicesMixed);
+#endif  // MPT_ENABLE_RENDER_PROFILE
+		}
 
-		if(m_opl)
+		if(m_opl && !silentChunk)
 		{
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageOPL);
 			m_opl->Mix(MixSoundBuffer, countChunk, m_OPLVolumeFactor * m_nVSTiVolume / 48);
 		}
 
 #ifndef NO_REVERB
-		m_Reverb.Process(MixSoundBuffer, ReverbSendBuffer, m_RvbROfsVol, m_RvbLOfsVol, countChunk);
+		if(!silentChunk)
+		{
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageReverb);
+			m_Reverb.Process(MixSoundBuffer, ReverbSendBuffer, m_RvbROfsVol, m_RvbLOfsVol, countChunk);
+		}
 #endif  // NO_REVERB
 
 #ifndef NO_PLUGINS
-		if(m_loadedPlugins)
+		if(m_loadedPlugins && !silentChunk)
 		{
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StagePlugins);
 			ProcessPlugins(countChunk);
 		}
 #endif  // NO_PLUGINS
 
-		if(m_MixerSettings.gnChannels == 1)
-		{
-			MonoFromStereo(MixSoundBuffer, countChunk);
-		}
-
-		if(m_PlayConfig.getGlobalVolumeAppliesToMaster())
-		{
-			ProcessGlobalVolume(countChunk);
-		}
-
-		if(m_MixerSettings.m_nStereoSeparation != MixerSettings::StereoSeparationScale)
 		{
-			ProcessStereoSeparation(countChunk);
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StagePostMix);
+			if(silentChunk)
+				ProcessSilentPostMix(countChunk);
+			else
+				ProcessPostMix(countChunk);
 		}
 
 		if(m_MixerSettings.DSPMask)
 		{
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageDSP);
 			ProcessDSP(countChunk);
 		}
 
@@ -351,17 +327,21 @@ samplecount_t CSoundFile::Read(samplecount_t count, IAudioTarget &target, IAudio
 		}
 #endif  // MODPLUG_TRACKER
 
-		if(m_MixerSettings.gnChannels == 4)
 		{
-			InterleaveFrontRear(MixSoundBuffer, MixRearBuffer, countChunk);
-		}
+			MPT_RENDER_PROFILE_SCOPE(m_RenderProfile, StageOutput);
 
-		if(outputMonitor)
-		{
-			outputMonitor->get().Process(mpt::audio_span_interleaved<const mixsample_t>(MixSoundBuffer, m_MixerSettings.gnChannels, countChunk));
-		}
+			if(m_MixerSettings.gnChannels == 4)
+			{
+				InterleaveFrontRear(MixSoundBuffer, MixRearBuffer, countChunk);
+			}
 
-		target.Process(mpt::audio_span_interleaved<mixsample_t>(MixSoundBuffer, m_MixerSettings.gnChannels, countChunk));
+			if(outputMonitor)
+			{
+				outputMonitor->get().Process(mpt::audio_span_interleaved<const mixsample_t>(MixSoundBuffer, m_MixerSettings.gnChannels, countChunk));
+			}
+
+			target.Process(mpt::audio_span_interleaved<mixsample_t>(MixSoundBuffer, m_MixerSettings.gnChannels, countChunk));
+		}
 
 		// Buffer ready
 		countRendered += countChunk;
@@ -728,6 +708,10 @@ bool CSoundFile::ProcessRow()
 		// Now that we know which pattern we're on, we can update time signatures (global or pattern-specific)
 		m_PlayState.UpdateTimeSignature(*this);
 
+		// Samples on the new row are normally decoded already (see below), but a jump may have taken us to an unexpected row
+		if(HasDeferredSamples())
+			PrefetchDeferredSamples(m_PlayState.m_nCurrentOrder, m_PlayState.m_nRow, 1, MAX_SAMPLES);
+
 		if(ignoreRow)
 		{
 			m_PlayState.m_nTickCount = m_PlayState.m_nMusicSpeed;
@@ -735,6 +719,10 @@ bool CSoundFile::ProcessRow()
 		}
 		break;
 	}
+	// Decode deferred samples ahead of when they are needed, but only one per tick so that the work is spread out
+	if(HasDeferredSamples())
+		PrefetchDeferredSamples(m_PlayState.m_nNextOrder, m_PlayState.m_nNextRow, 8, 1);
+
 	// Should we process tick0 effects?
 	if (!m_PlayState.m_nMusicSpeed) m_PlayState.m_nMusicSpeed = 1;
 
@@ -2173,7 +2161,12 @@ bool CSoundFile::ReadNote()
 	////////////////////////////////////////////////////////////////////////////////////
 	// Update channels data
 	m_nMixChannels = 0;
-	for(CHANNELINDEX nChn = 0; nChn < m_PlayState.Chn.size(); nChn++)
+#ifdef MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+	MPT_ASSERT(m_PlayState.BackgroundChannelMaskIsValid(*this));
+#endif  // MPT_VERIFY_BACKGROUND_CHANNEL_MASK
+	// Background channels that are known to be idle have nothing to process, so skip them
+	const auto nextChannel = [this](CHANNELINDEX nChn) { nChn++; return (nChn < GetNumChannels()) ? nChn : m_PlayState.NextBackgroundChannelInUse(nChn); };
+	for(CHANNELINDEX nChn = 0; nChn < m_PlayState.Chn.size(); nChn = nextChannel(nChn))
 	{
 		ModChannel &chn = m_PlayState.Chn[nChn];
 		// FT2 Compatibility: Prevent notes to be stopped after a fadeout. This way, a portamento effect can pick up a faded instrument which is long enough.
@@ -2194,6 +2187,10 @@ bool CSoundFile::ReadNote()
 			{
 				// Process MIDI macros on channels that are currently muted.
 				ProcessMacroOnChannel(nChn);
+			} else if(chn.IsAvailableForNNA())
+			{
+				// Nothing will happen on this channel until it is picked up by CheckNNA again
+				m_PlayState.SetBackgroundChannelIdle(nChn);
 			}
 			chn.nLeftVU = chn.nRightVU = 0;
 			continue;
@@ -2485,6 +2482,8 @@ bool CSoundFile::ReadNote()
 		chn.nRightVU = (chn.nRightVU > VUMETER_DECAY) ? (chn.nRightVU - VUMETER_DECAY) : 0;
 
 		chn.newLeftVol = chn.newRightVol = 0;
+		if(chn.pModSample && !chn.pModSample->HasSampleData() && HasDeferredSamples())
+			DecodeDeferredSample(static_cast<SAMPLEINDEX>(chn.pModSample - Samples));
 		chn.pCurrentSample = (chn.pModSample && chn.pModSample->HasSampleData() && chn.nLength && chn.IsSamplePlaying()) ? chn.pModSample->samplev() : nullptr;
 		if(chn.pCurrentSample || (chn.HasMIDIOutput() && !chn.dwFlags[CHN_KEYOFF | CHN_NOTEFADE]))
 		{
@@ -2754,37 +2753,37 @@ void CSoundFile::ProcessMidiOut(CHANNELINDEX nChn)
 #endif // NO_PLUGINS
 
 
+// Scale a mix sample by num / den
+static MPT_FORCEINLINE mixsample_t ScaleMixSample(mixsample_t sample, int32 num, int32 den)
+{
+#ifdef MPT_INTMIXER
+	return Util::muldiv(sample, num, den);
+#else
+	return sample * (static_cast<float>(num) / static_cast<float>(den));
+#endif // MPT_INTMIXER
+}
+
+
 template<int channels>
-MPT_FORCEINLINE void ApplyGlobalVolumeWithRamping(int32 *SoundBuffer, int32 *RearBuffer, uint32 lCount, int32 m_nGlobalVolume, int32 step, int32 &m_nSamplesToGlobalVolRampDest, int32 &m_lHighResRampingGlobalVolume)
+MPT_FORCEINLINE void ApplyGlobalVolumeRamp(mixsample_t *SoundBuffer, mixsample_t *RearBuffer, uint32 lCount, int32 step, int32 &m_lHighResRampingGlobalVolume)
 {
 	const bool isStereo = (channels >= 2);
 	const bool hasRear = (channels >= 4);
 	for(uint32 pos = 0; pos < lCount; ++pos)
 	{
-		if(m_nSamplesToGlobalVolRampDest > 0)
-		{
-			// Ramping required
-			m_lHighResRampingGlobalVolume += step;
-			                       SoundBuffer[0] = Util::muldiv(SoundBuffer[0], m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION);
-			if constexpr(isStereo) SoundBuffer[1] = Util::muldiv(SoundBuffer[1], m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION);
-			if constexpr(hasRear)  RearBuffer[0]  = Util::muldiv(RearBuffer[0] , m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION); else MPT_UNUSED_VARIABLE(RearBuffer);
-			if constexpr(hasRear)  RearBuffer[1]  = Util::muldiv(RearBuffer[1] , m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION); else MPT_UNUSED_VARIABLE(RearBuffer);
-			m_nSamplesToGlobalVolRampDest--;
-		} else
-		{
-			                       SoundBuffer[0] = Util::muldiv(SoundBuffer[0], m_nGlobalVolume, MAX_GLOBAL_VOLUME);
-			if constexpr(isStereo) SoundBuffer[1] = Util::muldiv(SoundBuffer[1], m_nGlobalVolume, MAX_GLOBAL_VOLUME);
-			if constexpr(hasRear)  RearBuffer[0]  = Util::muldiv(RearBuffer[0] , m_nGlobalVolume, MAX_GLOBAL_VOLUME); else MPT_UNUSED_VARIABLE(RearBuffer);
-			if constexpr(hasRear)  RearBuffer[1]  = Util::muldiv(RearBuffer[1] , m_nGlobalVolume, MAX_GLOBAL_VOLUME); else MPT_UNUSED_VARIABLE(RearBuffer);
-			m_lHighResRampingGlobalVolume = m_nGlobalVolume << VOLUMERAMPPRECISION;
-		}
+		m_lHighResRampingGlobalVolume += step;
+		                       SoundBuffer[0] = ScaleMixSample(SoundBuffer[0], m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION);
+		if constexpr(isStereo) SoundBuffer[1] = ScaleMixSample(SoundBuffer[1], m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION);
+		if constexpr(hasRear)  RearBuffer[0]  = ScaleMixSample(RearBuffer[0] , m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION); else MPT_UNUSED_VARIABLE(RearBuffer);
+		if constexpr(hasRear)  RearBuffer[1]  = ScaleMixSample(RearBuffer[1] , m_lHighResRampingGlobalVolume, MAX_GLOBAL_VOLUME << VOLUMERAMPPRECISION); else MPT_UNUSED_VARIABLE(RearBuffer);
 		SoundBuffer += isStereo ? 2 : 1;
 		if constexpr(hasRear) RearBuffer += 2;
 	}
 }
 
 
-void CSoundFile::ProcessGlobalVolume(samplecount_t lCount)
+// Update the global volume ramp state and return the ramping step
+int32 CSoundFile::UpdateGlobalVolumeRamp()
 {
 
 	// should we ramp?
@@ -2831,25 +2830,90 @@ void CSoundFile::ProcessGlobalVolume(samplecount_t lCount)
 			}
 		}
 	}
+	return step;
+}
 
-	// apply volume and ramping
-	if(m_MixerSettings.gnChannels == 1)
+
+// Mono downmix, global volume and stereo separation.
+// Global volume ramps are short and applied separately, the constant part of the chunk is processed in a single (SIMD) pass per buffer.
+void CSoundFile::ProcessPostMix(uint32 countChunk)
+{
+	const uint32 numChannels = m_MixerSettings.gnChannels;
+	const bool applyGlobalVolume = m_PlayConfig.getGlobalVolumeAppliesToMaster();
+	const bool applySeparation = (numChannels >= 2) && m_MixerSettings.m_nStereoSeparation != MixerSettings::StereoSeparationScale;
+
+	if(numChannels == 1)
 	{
-		ApplyGlobalVolumeWithRamping<1>(MixSoundBuffer, MixRearBuffer, lCount, m_PlayState.m_nGlobalVolume, step, m_PlayState.m_nSamplesToGlobalVolRampDest, m_PlayState.m_lHighResRampingGlobalVolume);
-	} else if(m_MixerSettings.gnChannels == 2)
+		MonoFromStereo(MixSoundBuffer, countChunk);
+	}
+
+	uint32 rampFrames = 0;
+	if(applyGlobalVolume)
 	{
-		ApplyGlobalVolumeWithRamping<2>(MixSoundBuffer, MixRearBuffer, lCount, m_PlayState.m_nGlobalVolume, step, m_PlayState.m_nSamplesToGlobalVolRampDest, m_PlayState.m_lHighResRampingGlobalVolume);
-	} else if(m_MixerSettings.gnChannels == 4)
+		const int32 step = UpdateGlobalVolumeRamp();
+		if(m_PlayState.m_nSamplesToGlobalVolRampDest > 0)
+		{
+			rampFrames = std::min(countChunk, static_cast<uint32>(m_PlayState.m_nSamplesToGlobalVolRampDest));
+			if(numChannels == 1)
+				ApplyGlobalVolumeRamp<1>(MixSoundBuffer, MixRearBuffer, rampFrames, step, m_PlayState.m_lHighResRampingGlobalVolume);
+			else if(numChannels == 2)
+				ApplyGlobalVolumeRamp<2>(MixSoundBuffer, MixRearBuffer, rampFrames, step, m_PlayState.m_lHighResRampingGlobalVolume);
+			else if(numChannels == 4)
+				ApplyGlobalVolumeRamp<4>(MixSoundBuffer, MixRearBuffer, rampFrames, step, m_PlayState.m_lHighResRampingGlobalVolume);
+			m_PlayState.m_nSamplesToGlobalVolRampDest -= static_cast<int32>(rampFrames);
+		}
+		if(rampFrames < countChunk)
+		{
+			m_PlayState.m_lHighResRampingGlobalVolume = m_PlayState.m_nGlobalVolume << VOLUMERAMPPRECISION;
+		}
+	}
+
+	const int32 globalVolume = m_PlayState.m_nGlobalVolume;
+	const int32 separation = m_MixerSettings.m_nStereoSeparation;
+	if(numChannels == 1)
 	{
-		ApplyGlobalVolumeWithRamping<4>(MixSoundBuffer, MixRearBuffer, lCount, m_PlayState.m_nGlobalVolume, step, m_PlayState.m_nSamplesToGlobalVolRampDest, m_PlayState.m_lHighResRampingGlobalVolume);
+		if(applyGlobalVolume)
+		{
+			for(uint32 i = rampFrames; i < countChunk; i++)
+			{
+				MixSoundBuffer[i] = ScaleMixSample(MixSoundBuffer[i], globalVolume, MAX_GLOBAL_VOLUME);
+			}
+		}
+		return;
 	}
 
+	// The ramped part of the chunk only needs stereo separation now
+	if(applySeparation && rampFrames)
+	{
+		                    ApplyStereoGainAndSeparation(MixSoundBuffer, rampFrames, globalVolume, separation, false, true);
+		if(numChannels > 2) ApplyStereoGainAndSeparation(MixRearBuffer, rampFrames, globalVolume, separation, false, true);
+	}
+	if(rampFrames < countChunk && (applyGlobalVolume || applySeparation))
+	{
+		                    ApplyStereoGainAndSeparation(MixSoundBuffer + rampFrames * 2, countChunk - rampFrames, globalVolume, separation, applyGlobalVolume, applySeparation);
+		if(numChannels > 2) ApplyStereoGainAndSeparation(MixRearBuffer + rampFrames * 2, countChunk - rampFrames, globalVolume, separation, applyGlobalVolume, applySeparation);
+	}
 }
 
 
-void CSoundFile::ProcessStereoSeparation(samplecount_t countChunk)
+// Scaling silence yields silence, so only the global volume ramp state has to be kept in sync with ProcessPostMix.
+void CSoundFile::ProcessSilentPostMix(uint32 countChunk)
 {
-	ApplyStereoSeparation(MixSoundBuffer, MixRearBuffer, m_MixerSettings.gnChannels, countChunk, m_MixerSettings.m_nStereoSeparation);
+	if(!m_PlayConfig.getGlobalVolumeAppliesToMaster())
+		return;
+
+	uint32 rampFrames = 0;
+	const int32 step = UpdateGlobalVolumeRamp();
+	if(m_PlayState.m_nSamplesToGlobalVolRampDest > 0)
+	{
+		rampFrames = std::min(countChunk, static_cast<uint32>(m_PlayState.m_nSamplesToGlobalVolRampDest));
+		m_PlayState.m_lHighResRampingGlobalVolume += step * static_cast<int32>(rampFrames);
+		m_PlayState.m_nSamplesToGlobalVolRampDest -= static_cast<int32>(rampFrames);
+	}
+	if(rampFrames < countChunk)
+	{
+		m_PlayState.m_lHighResRampingGlobalVolume = m_PlayState.m_nGlobalVolume << VOLUMERAMPPRECISION;
+	}
 }
 
 
@@ -14,6 +14,7 @@
 #include "Sndfile.h"
 
 #include "Resampler.h"
+#include "ResamplerTables.h"
 #include "WindowedFIR.h"
 #include <cmath>
 
@@ -839,14 +840,46 @@ void CResampler::InitializeTablesFromScratch(bool force)
 		return;
 	}
 
-	m_WindowedFIR.InitTable(m_Settings.gdWFIRCutoff, m_Settings.gbWFIRType);
+	if(force || !HaveSameWindowedFIRSettings(m_OldSettings, m_Settings))
+	{
+#ifdef MPT_RESAMPLER_TABLES_PRECOMPUTED
+		if(!force && HaveSameWindowedFIRSettings(m_Settings, CResamplerSettings{}))
+			std::copy(std::begin(ResamplerTables::WindowedFIR), std::end(ResamplerTables::WindowedFIR), m_WindowedFIR.lut);
+		else
+#endif  // MPT_RESAMPLER_TABLES_PRECOMPUTED
+			m_WindowedFIR.InitTable(m_Settings.gdWFIRCutoff, m_Settings.gbWFIRType);
+	}
 
 	m_OldSettings = m_Settings;
 }
 
 
+bool CResampler::HaveSameWindowedFIRSettings(const CResamplerSettings &a, const CResamplerSettings &b)
+{
+	CResamplerSettings bWithOtherSettingsFromA = b;
+	bWithOtherSettingsFromA.SrcMode = a.SrcMode;
+	bWithOtherSettingsFromA.emulateAmiga = a.emulateAmiga;
+	return a == bWithOtherSettingsFromA;
+}
+
+
 #ifdef MPT_RESAMPLER_TABLES_CACHED
 
+#ifdef MPT_RESAMPLER_TABLES_PRECOMPUTED
+
+void CResampler::InitializeTablesFromCache()
+{
+	// Default settings, see CResamplerSettings
+	InitFloatmixerTables();
+	std::copy(std::begin(ResamplerTables::KaiserSinc), std::end(ResamplerTables::KaiserSinc), gKaiserSinc);
+	std::copy(std::begin(ResamplerTables::Downsample13x), std::end(ResamplerTables::Downsample13x), gDownsample13x);
+	std::copy(std::begin(ResamplerTables::Downsample2x), std::end(ResamplerTables::Downsample2x), gDownsample2x);
+	std::copy(std::begin(ResamplerTables::WindowedFIR), std::end(ResamplerTables::WindowedFIR), m_WindowedFIR.lut);
+	blepTables.InitTables(ResamplerTables::AmigaBlep);
+}
+
+#else // !MPT_RESAMPLER_TABLES_PRECOMPUTED
+
 static const CResampler & GetCachedResampler()
 {
 	static CResampler s_CachedResampler(true);
@@ -865,6 +898,8 @@ void CResampler::InitializeTablesFromCache()
 	blepTables = s_CachedResampler.blepTables;
 }
 
+#endif // MPT_RESAMPLER_TABLES_PRECOMPUTED
+
 #endif // MPT_RESAMPLER_TABLES_CACHED
 
 
@@ -467,7 +467,7 @@ void CSoundFile::UpgradeModule()
 	{
 		for(SAMPLEINDEX i = 1; i <= GetNumSamples(); i++)
 		{
-			if(Samples[i].HasSampleData() && Samples[i].uFlags[CHN_PINGPONGLOOP | CHN_PINGPONGSUSTAIN])
+			if((Samples[i].HasSampleData() || IsSampleDataDeferred(i)) && Samples[i].uFlags[CHN_PINGPONGLOOP | CHN_PINGPONGSUSTAIN])
 			{
 				m_playBehaviour.set(kImprecisePingPongLoops);
 				break;
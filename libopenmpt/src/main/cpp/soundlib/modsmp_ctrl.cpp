@@ -303,6 +303,229 @@ bool ConvertToStereo(ModSample &smp, CSoundFile &sndFile)
 }
 
 
+bool ConvertTo16Bit(ModSample &smp, CSoundFile &sndFile)
+{
+	if(!smp.HasSampleData() || smp.GetElementarySampleSize() != 1 || smp.uFlags[CHN_ADLIB]) return false;
+
+	const SmpLength numSamples = smp.nLength * smp.GetNumChannels();
+	int16 *newSample = static_cast<int16 *>(ModSample::AllocateSample(smp.nLength, smp.GetBytesPerSample() * 2));
+	if(newSample == nullptr)
+	{
+		return false;
+	}
+
+	// The mixer scales 8-bit samples by 256 as well.
+	const int8 *source = smp.sample8();
+	for(SmpLength i = 0; i < numSamples; i++)
+	{
+		newSample[i] = static_cast<int16>(source[i] * 256);
+	}
+
+	CriticalSection cs;
+	smp.uFlags.set(CHN_16BIT);
+	smp.ReplaceWaveform(newSample, smp.nLength, sndFile);
+
+	smp.PrecomputeLoops(sndFile, false);
+	return true;
+}
+
+
+template <class T>
+static bool ChannelsAreIdenticalImpl(const T *p, SmpLength length)
+{
+	for(SmpLength i = 0; i < length; i++, p += 2)
+	{
+		if(p[0] != p[1])
+			return false;
+	}
+	return true;
+}
+
+template <class T>
+static void CopyLeftChannelImpl(T *dest, const T *source, SmpLength length)
+{
+	for(SmpLength i = 0; i < length; i++, source += 2)
+	{
+		dest[i] = source[0];
+	}
+}
+
+bool ConvertIdenticalStereoToMono(ModSample &smp, CSoundFile &sndFile)
+{
+	if(!smp.HasSampleData() || smp.GetNumChannels() != 2) return false;
+
+	const bool is16Bit = smp.GetElementarySampleSize() == 2;
+	if(is16Bit ? !ChannelsAreIdenticalImpl(smp.sample16(), smp.nLength) : !ChannelsAreIdenticalImpl(smp.sample8(), smp.nLength))
+		return false;
+
+	void *newSample = ModSample::AllocateSample(smp.nLength, smp.GetElementarySampleSize());
+	if(newSample == nullptr)
+	{
+		return false;
+	}
+
+	if(is16Bit)
+		CopyLeftChannelImpl(static_cast<int16 *>(newSample), smp.sample16(), smp.nLength);
+	else
+		CopyLeftChannelImpl(static_cast<int8 *>(newSample), smp.sample8(), smp.nLength);
+
+	CriticalSection cs;
+	smp.uFlags.reset(CHN_STEREO);
+	smp.ReplaceWaveform(newSample, smp.nLength, sndFile);
+
+	smp.PrecomputeLoops(sndFile, false);
+	return true;
+}
+
+
+bool ConvertTo8Bit(ModSample &smp, CSoundFile &sndFile)
+{
+	if(!smp.HasSampleData() || smp.GetElementarySampleSize() != 2 || smp.uFlags[CHN_ADLIB]) return false;
+
+	const uint8 numChannels = smp.GetNumChannels();
+	int8 *newSample = static_cast<int8 *>(ModSample::AllocateSample(smp.nLength, numChannels));
+	if(newSample == nullptr)
+	{
+		return false;
+	}
+
+	// The quantization error of each sample point is added to the next one, which moves most of the noise to high frequencies.
+	// Clipping is not part of the fed back error, so it always stays within half a quantization step.
+	// Samples that were widened from 8-bit data are converted back without any loss.
+	const int16 *source = smp.sample16();
+	for(uint8 chn = 0; chn < numChannels; chn++)
+	{
+		int32 error = 0;
+		for(SmpLength i = chn; i < smp.nLength * numChannels; i += numChannels)
+		{
+			const int32 value = source[i] + error;
+			const int32 quantized = (value + 128) >> 8;
+			error = value - quantized * 256;
+			newSample[i] = static_cast<int8>(Clamp(quantized, -128, 127));
+		}
+	}
+
+	CriticalSection cs;
+	smp.uFlags.reset(CHN_16BIT);
+	smp.ReplaceWaveform(newSample, smp.nLength, sndFile);
+
+	smp.PrecomputeLoops(sndFile, false);
+	return true;
+}
+
+
+// Half-band lowpass filter followed by decimation. The filter kernel is (-1, 0, 9, 16, 9, 0, -1) / 32.
+template <class T>
+static void Downsample2xImpl(T *dest, const T *source, SmpLength length, SmpLength newLength, uint8 numChannels)
+{
+	const auto tap = [source, length, numChannels](SmpLength pos, int offset, uint8 chn) -> int32
+	{
+		const int64 i = Clamp(static_cast<int64>(pos) + offset, int64(0), static_cast<int64>(length) - 1);
+		return source[static_cast<size_t>(i) * numChannels + chn];
+	};
+	for(SmpLength i = 0; i < newLength; i++)
+	{
+		const SmpLength pos = i * 2;
+		for(uint8 chn = 0; chn < numChannels; chn++)
+		{
+			const int32 sum = 16 * tap(pos, 0, chn) + 9 * (tap(pos, -1, chn) + tap(pos, 1, chn)) - (tap(pos, -3, chn) + tap(pos, 3, chn));
+			dest[i * numChannels + chn] = mpt::saturate_cast<T>((sum + 16) >> 5);
+		}
+	}
+}
+
+bool CanDownsample2x(const ModSample &smp, const CSoundFile &sndFile)
+{
+	if(smp.nLength < 2 || smp.nC5Speed < 2 || smp.uFlags[CHN_ADLIB]) return false;
+	if(sndFile.UseFinetuneAndTranspose() && smp.RelativeTone < int8_min + 12) return false;
+	// Halving loops that are only a few frames long would destroy their waveform
+	constexpr SmpLength MinLoopLength = 8;
+	if(smp.uFlags[CHN_LOOP] && smp.nLoopEnd / 2 - smp.nLoopStart / 2 < MinLoopLength) return false;
+	if(smp.uFlags[CHN_SUSTAINLOOP] && smp.nSustainEnd / 2 - smp.nSustainStart / 2 < MinLoopLength) return false;
+	return true;
+}
+
+
+static void HalveLoopsAndPitch(ModSample &smp, const CSoundFile &sndFile)
+{
+	smp.nLoopStart /= 2;
+	smp.nLoopEnd /= 2;
+	smp.nSustainStart /= 2;
+	smp.nSustainEnd /= 2;
+	for(auto &cue : smp.cues)
+	{
+		cue /= 2;
+	}
+	smp.Transpose(-1.0);
+	if(sndFile.UseFinetuneAndTranspose())
+		smp.RelativeTone -= 12;
+}
+
+
+// Returns the downsampled data, or nullptr if it could not be allocated
+static void *Downsample2xWaveform(const ModSample &smp)
+{
+	const SmpLength newLength = (smp.nLength + 1) / 2;
+	void *newSample = ModSample::AllocateSample(newLength, smp.GetBytesPerSample());
+	if(newSample == nullptr)
+	{
+		return nullptr;
+	}
+	if(smp.GetElementarySampleSize() == 2)
+		Downsample2xImpl(static_cast<int16 *>(newSample), smp.sample16(), smp.nLength, newLength, smp.GetNumChannels());
+	else
+		Downsample2xImpl(static_cast<int8 *>(newSample), smp.sample8(), smp.nLength, newLength, smp.GetNumChannels());
+	return newSample;
+}
+
+
+bool Downsample2x(ModSample &smp, CSoundFile &sndFile)
+{
+	if(!smp.HasSampleData() || !CanDownsample2x(smp, sndFile)) return false;
+
+	void *newSample = Downsample2xWaveform(smp);
+	if(newSample == nullptr)
+	{
+		return false;
+	}
+
+	CriticalSection cs;
+	HalveLoopsAndPitch(smp, sndFile);
+	smp.ReplaceWaveform(newSample, (smp.nLength + 1) / 2, sndFile);
+	smp.SanitizeLoops();
+
+	smp.PrecomputeLoops(sndFile, false);
+	return true;
+}
+
+
+void PrepareDownsample2x(ModSample &smp, const CSoundFile &sndFile)
+{
+	MPT_ASSERT(!smp.HasSampleData());
+	HalveLoopsAndPitch(smp, sndFile);
+	smp.nLength = (smp.nLength + 1) / 2;
+	smp.SanitizeLoops();
+}
+
+
+bool Downsample2xData(ModSample &smp, CSoundFile &sndFile)
+{
+	if(!smp.HasSampleData()) return false;
+	void *newSample = Downsample2xWaveform(smp);
+	if(newSample == nullptr)
+	{
+		return false;
+	}
+
+	CriticalSection cs;
+	smp.ReplaceWaveform(newSample, (smp.nLength + 1) / 2, sndFile);
+	smp.SanitizeLoops();
+
+	smp.PrecomputeLoops(sndFile, false);
+	return true;
+}
+
+
 } // namespace ctrlSmp
 
 
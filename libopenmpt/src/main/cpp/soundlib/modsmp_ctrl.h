@@ -50,6 +50,26 @@ bool SplitStereo(const ModSample &source, ModSample &left, ModSample &right, CSo
 // Convert a mono sample to stereo
 bool ConvertToStereo(ModSample &smp, CSoundFile &sndFile);
 
+// Convert an 8-bit sample to 16-bit. The mixer output does not change.
+bool ConvertTo16Bit(ModSample &smp, CSoundFile &sndFile);
+
+// Convert a stereo sample to mono if both channels are identical, freeing the unused data
+bool ConvertIdenticalStereoToMono(ModSample &smp, CSoundFile &sndFile);
+
+// Convert a 16-bit sample to 8-bit, using first-order noise shaping
+bool ConvertTo8Bit(ModSample &smp, CSoundFile &sndFile);
+
+// Halve the sample rate of a sample. Loop points, cue points and the sample frequency are adjusted, so that it plays at the same pitch.
+// Samples with loops that would end up shorter than a few frames are left alone.
+bool Downsample2x(ModSample &smp, CSoundFile &sndFile);
+bool CanDownsample2x(const ModSample &smp, const CSoundFile &sndFile);
+
+// Downsample a sample whose data is decoded later, so that its length and pitch are final before it is played for the first time.
+// PrepareDownsample2x adjusts the sample properties like Downsample2x does, without any sample data present.
+// Once the data has been decoded at its original length, Downsample2xData replaces it with the downsampled data and leaves all other properties alone.
+void PrepareDownsample2x(ModSample &smp, const CSoundFile &sndFile);
+bool Downsample2xData(ModSample &smp, CSoundFile &sndFile);
+
 } // Namespace ctrlSmp
 
 namespace ctrlChn
@@ -21,6 +21,7 @@
 
 
 
+#include <cstddef>
 #include <cstdint>
 #include "../common/mptBaseUtils.h"
 
@@ -40,6 +41,7 @@ class Opal {
         OPL3SampleRate      = 49716,
         NumChannels         = 18,
         NumOperators        = 36,
+        BlockSize           = 256,      // Chip samples rendered at once by Render()
 
         EnvOff              = -1,
         EnvAtt,
@@ -57,6 +59,8 @@ class Opal {
             void            SetChannel(Channel *chan) {  Chan = chan;  }
 
             int16_t         Output(uint16_t keyscalenum, uint32_t phase_step, int16_t vibrato, int16_t mod = 0, int16_t fbshift = 0);
+            void            SkipOutput(uint32_t phase_step, int16_t vibrato);
+            bool            IsSilent() const {  return EnvelopeStage == EnvOff;  }
 
             void            SetKeyOn(bool on);
             void            SetTremoloEnable(bool on);
@@ -132,6 +136,9 @@ class Opal {
             }
 
             void            Output(int16_t &left, int16_t &right);
+            void            SkipOutput();
+            bool            IsSilent() const;
+            bool            IsEnabled() const {  return Enable;  }
             void            SetEnable(bool on) {  Enable = on;  }
             void            SetChannelPair(Channel *pair) {  ChannelPair = pair;  }
 
@@ -154,6 +161,7 @@ class Opal {
 
         protected:
             void            ComputePhaseStep();
+            int16_t         ComputeVibrato() const;
 
             Operator *      Op[4];
 
@@ -178,10 +186,13 @@ class Opal {
         void                SetSampleRate(int sample_rate);
         void                Port(uint16_t reg_num, uint8_t val);
         void                Sample(int16_t *left, int16_t *right);
+        void                Render(int16_t *lr, std::size_t frames);
 
     protected:
         void                Init(int sample_rate);
         void                Output(int16_t &left, int16_t &right);
+        void                OutputBlock(int16_t *left, int16_t *right, int count);
+        void                AdvanceClocks();
 
         int32_t             SampleRate;
         int32_t             SampleAccum;
@@ -584,6 +595,140 @@ void Opal::Sample(int16_t *left, int16_t *right) {
 
 
 
+//==================================================================================================
+// Render a block of interleaved stereo samples at the output sample rate.  The result is identical
+// to calling Sample() for every frame, but the chip is run channel by channel over up to BlockSize
+// chip samples at a time, and channels whose operators are all off only advance their phase.
+//==================================================================================================
+void Opal::Render(int16_t *lr, std::size_t frames) {
+
+    int16_t chipleft[BlockSize], chipright[BlockSize];
+
+    while (frames > 0) {
+
+        // Find out how many output frames the next block of chip samples covers
+        int32_t accum = SampleAccum;
+        int chipsamples = 0;
+        std::size_t blockframes = 0;
+        while (blockframes < frames) {
+            int needed = 0;
+            int32_t next = accum;
+            while (next >= SampleRate) {
+                next -= SampleRate;
+                needed++;
+            }
+            if (chipsamples + needed > BlockSize)
+                break;
+            chipsamples += needed;
+            accum = next + OPL3SampleRate;
+            blockframes++;
+        }
+
+        if (blockframes == 0) {
+
+            // Extremely low output rates need more chip samples per frame than fit into a block
+            Sample(&lr[0], &lr[1]);
+            lr += 2;
+            frames--;
+            continue;
+        }
+
+        OutputBlock(chipleft, chipright, chipsamples);
+
+        // Same as Sample(), but reading the chip output from the block
+        int chippos = 0;
+        for (std::size_t i = 0; i < blockframes; i++) {
+
+            while (SampleAccum >= SampleRate) {
+
+                LastOutput[0] = CurrOutput[0];
+                LastOutput[1] = CurrOutput[1];
+
+                CurrOutput[0] = chipleft[chippos];
+                CurrOutput[1] = chipright[chippos];
+                chippos++;
+
+                SampleAccum -= SampleRate;
+            }
+
+            const int32_t fract = Util::muldivr(SampleAccum, 65536, SampleRate);
+            lr[0] = static_cast<int16_t>(LastOutput[0] + ((fract * (CurrOutput[0] - LastOutput[0])) / 65536));
+            lr[1] = static_cast<int16_t>(LastOutput[1] + ((fract * (CurrOutput[1] - LastOutput[1])) / 65536));
+            lr += 2;
+
+            SampleAccum += OPL3SampleRate;
+        }
+
+        frames -= blockframes;
+    }
+}
+
+
+
+//==================================================================================================
+// Produce a block of final output from the chip at the OPL3 sample-rate.  This is the same as
+// calling Output() count times, but processes one channel at a time.
+//==================================================================================================
+void Opal::OutputBlock(int16_t *left, int16_t *right, int count) {
+
+    // The global clocks for each sample, as seen by the channels
+    uint16_t clocks[BlockSize], tremololevels[BlockSize], vibratoclocks[BlockSize];
+    for (int i = 0; i < count; i++) {
+
+        clocks[i] = Clock;
+        tremololevels[i] = TremoloLevel;
+        vibratoclocks[i] = VibratoClock;
+        AdvanceClocks();
+    }
+    const uint16_t endclock = Clock, endtremololevel = TremoloLevel, endvibratoclock = VibratoClock;
+
+    int32_t leftmix[BlockSize] = {}, rightmix[BlockSize] = {};
+    for (int c = 0; c < NumChannels; c++) {
+
+        Channel &chan = Chan[c];
+        if (!chan.IsEnabled())
+            continue;
+
+        // Operators that are off stay off until the next register write, so the channel is silent
+        // for the whole block
+        if (chan.IsSilent()) {
+
+            for (int i = 0; i < count; i++) {
+
+                VibratoClock = vibratoclocks[i];
+                chan.SkipOutput();
+            }
+            continue;
+        }
+
+        for (int i = 0; i < count; i++) {
+
+            Clock = clocks[i];
+            TremoloLevel = tremololevels[i];
+            VibratoClock = vibratoclocks[i];
+
+            int16_t chanleft, chanright;
+            chan.Output(chanleft, chanright);
+
+            leftmix[i] += chanleft;
+            rightmix[i] += chanright;
+        }
+    }
+
+    Clock = endclock;
+    TremoloLevel = endtremololevel;
+    VibratoClock = endvibratoclock;
+
+    // Clamp
+    for (int i = 0; i < count; i++) {
+
+        left[i] = static_cast<int16_t>(leftmix[i] < -0x8000 ? -0x8000 : leftmix[i] > 0x7FFF ? 0x7FFF : leftmix[i]);
+        right[i] = static_cast<int16_t>(rightmix[i] < -0x8000 ? -0x8000 : rightmix[i] > 0x7FFF ? 0x7FFF : rightmix[i]);
+    }
+}
+
+
+
 //==================================================================================================
 // Produce final output from the chip.  This is at the OPL3 sample-rate.
 //==================================================================================================
@@ -616,6 +761,16 @@ void Opal::Output(int16_t &left, int16_t &right) {
     else
         right = static_cast<int16_t>(rightmix);
 
+    AdvanceClocks();
+}
+
+
+
+//==================================================================================================
+// Advance the envelope, tremolo and vibrato clocks by one chip sample.
+//==================================================================================================
+void Opal::AdvanceClocks() {
+
     Clock++;
 
     // Tremolo.  According to this post, the OPL3 tremolo is a 13,440 sample length triangle wave
@@ -670,23 +825,7 @@ void Opal::Channel::Output(int16_t &left, int16_t &right) {
         return;
     }
 
-    int16_t vibrato = (Freq >> 7) & 7;
-    if (!Master->VibratoDepth)
-        vibrato >>= 1;
-
-    // 0  3  7  3  0  -3  -7  -3
-    uint16_t clk = Master->VibratoClock;
-    if (!(clk & 3))
-        vibrato = 0;                // Position 0 and 4 is zero
-    else {
-        if (clk & 1)
-            vibrato >>= 1;          // Odd positions are half the magnitude
-
-        vibrato <<= Octave;
-
-        if (clk & 4)
-            vibrato = -vibrato;     // The second half positions are negative
-    }
+    int16_t vibrato = ComputeVibrato();
 
     // Combine individual operator outputs
     int16_t out, acc;
@@ -758,6 +897,62 @@ void Opal::Channel::Output(int16_t &left, int16_t &right) {
 
 
 
+//==================================================================================================
+// Compute the vibrato offset for the current vibrato clock.
+//==================================================================================================
+int16_t Opal::Channel::ComputeVibrato() const {
+
+    int16_t vibrato = (Freq >> 7) & 7;
+    if (!Master->VibratoDepth)
+        vibrato >>= 1;
+
+    // 0  3  7  3  0  -3  -7  -3
+    uint16_t clk = Master->VibratoClock;
+    if (!(clk & 3))
+        vibrato = 0;                // Position 0 and 4 is zero
+    else {
+        if (clk & 1)
+            vibrato >>= 1;          // Odd positions are half the magnitude
+
+        vibrato <<= Octave;
+
+        if (clk & 4)
+            vibrato = -vibrato;     // The second half positions are negative
+    }
+
+    return vibrato;
+}
+
+
+
+//==================================================================================================
+// Check if all operators used by the channel are off, i.e. the channel produces no output.
+//==================================================================================================
+bool Opal::Channel::IsSilent() const {
+
+    const int numops = ChannelPair ? 4 : 2;
+    for (int i = 0; i < numops; i++) {
+        if (!Op[i]->IsSilent())
+            return false;
+    }
+    return true;
+}
+
+
+
+//==================================================================================================
+// Equivalent to Output() for a silent channel: only the operator phases are advanced.
+//==================================================================================================
+void Opal::Channel::SkipOutput() {
+
+    const int16_t vibrato = ComputeVibrato();
+    const int numops = ChannelPair ? 4 : 2;
+    for (int i = 0; i < numops; i++)
+        Op[i]->SkipOutput(PhaseStep, vibrato);
+}
+
+
+
 //==================================================================================================
 // Set phase step for operators using this channel.
 //==================================================================================================
@@ -889,6 +1084,7 @@ Opal::Operator::Operator() {
     FreqMultTimes2 = 1;
     EnvelopeStage = EnvOff;
     EnvelopeLevel = 0x1FF;
+    OutputLevel = 0;
     AttackRate = 0;
     DecayRate = 0;
     SustainLevel = 0;
@@ -1112,6 +1308,19 @@ int16_t Opal::Operator::Output(uint16_t /*keyscalenum*/, uint32_t phase_step, in
 
 
 
+//==================================================================================================
+// Equivalent to Output() for an operator that is off: only the wave phase is advanced.
+//==================================================================================================
+void Opal::Operator::SkipOutput(uint32_t phase_step, int16_t vibrato) {
+
+    if (VibratoEnable)
+        phase_step += vibrato;
+    Phase += (phase_step * FreqMultTimes2) / 2;
+    Out[0] = Out[1] = 0;
+}
+
+
+
 //==================================================================================================
 // Trigger operator.
 //==================================================================================================
@@ -58,6 +58,7 @@ IMixPlugin::IMixPlugin(VSTPluginLib &factory, CSoundFile &sndFile, SNDMIXPLUGIN
 	, m_pMixStruct(&mixStruct)
 {
 	m_SndFile.m_loadedPlugins++;
+	m_SndFile.InvalidatePluginGraph();
 	m_MixState.pMixBuffer = mpt::align_bytes<8, MIXBUFFERSIZE * 2>(m_MixBuffer);
 	while(m_pMixStruct != &(m_SndFile.m_MixPlugins[m_nSlot]) && m_nSlot < MAX_MIXPLUGINS - 1)
 	{
@@ -74,6 +75,7 @@ IMixPlugin::~IMixPlugin()
 #endif // MODPLUG_TRACKER
 	m_pMixStruct->pMixPlugin = nullptr;
 	m_SndFile.m_loadedPlugins--;
+	m_SndFile.InvalidatePluginGraph();
 	m_pMixStruct = nullptr;
 }
 
@@ -84,6 +86,7 @@ void IMixPlugin::SetSlot(PLUGINDEX slot)
 {
 	m_nSlot = slot;
 	m_pMixStruct = &m_SndFile.m_MixPlugins[slot];
+	m_SndFile.InvalidatePluginGraph();
 }
 
 
@@ -1063,6 +1066,33 @@ void SNDMIXPLUGIN::SetBypass(bool bypass)
 }
 
 
+void SNDMIXPLUGIN::SetMasterEffect(bool master)
+{
+	if(master)
+		Info.routingFlags |= SNDMIXPLUGININFO::irApplyToMaster;
+	else
+		Info.routingFlags &= uint8(~SNDMIXPLUGININFO::irApplyToMaster);
+	if(pMixPlugin != nullptr) pMixPlugin->GetSoundFile().InvalidatePluginGraph();
+}
+
+
+void SNDMIXPLUGIN::SetOutputToMaster()
+{
+	Info.dwOutputRouting = 0;
+	if(pMixPlugin != nullptr) pMixPlugin->GetSoundFile().InvalidatePluginGraph();
+}
+
+
+void SNDMIXPLUGIN::SetOutputPlugin(PLUGINDEX plugin)
+{
+	if(plugin < MAX_MIXPLUGINS)
+		Info.dwOutputRouting = plugin + 0x80;
+	else
+		Info.dwOutputRouting = 0;
+	if(pMixPlugin != nullptr) pMixPlugin->GetSoundFile().InvalidatePluginGraph();
+}
+
+
 void SNDMIXPLUGIN::Destroy()
 {
 	if(pMixPlugin)
@@ -118,8 +118,7 @@ struct SNDMIXPLUGIN
 	void SetGain(uint8 gain);
 	void SetMixMode(PluginMixMode mixMode)
 		{ Info.mixMode = static_cast<uint8>(mixMode); }
-	void SetMasterEffect(bool master = true)
-		{ if(master) Info.routingFlags |= SNDMIXPLUGININFO::irApplyToMaster; else Info.routingFlags &= uint8(~SNDMIXPLUGININFO::irApplyToMaster); }
+	void SetMasterEffect(bool master = true);
 	void SetDryMix(bool wetMix = true)
 		{ if(wetMix) Info.routingFlags |= SNDMIXPLUGININFO::irDryMix; else Info.routingFlags &= uint8(~SNDMIXPLUGININFO::irDryMix); }
 	void SetExpandedMix(bool expanded = true)
@@ -135,10 +134,8 @@ struct SNDMIXPLUGIN
 		{ return Info.dwOutputRouting >= 0x80 ? static_cast<PLUGINDEX>(Info.dwOutputRouting - 0x80) : PLUGINDEX_INVALID; }
 
 	// Output routing setters
-	void SetOutputToMaster()
-		{ Info.dwOutputRouting = 0; }
-	void SetOutputPlugin(PLUGINDEX plugin)
-		{ if(plugin < MAX_MIXPLUGINS) Info.dwOutputRouting = plugin + 0x80; else Info.dwOutputRouting = 0; }
+	void SetOutputToMaster();
+	void SetOutputPlugin(PLUGINDEX plugin);
 
 	void Destroy();
 };
@@ -13,6 +13,7 @@
 #ifndef NO_PLUGINS
 #include "Chorus.h"
 #include "../../Sndfile.h"
+#include "DMOUtils.h"
 #include "mpt/base/numbers.hpp"
 #endif // !NO_PLUGINS
 
@@ -51,7 +52,11 @@ int32 Chorus::GetBufferIntOffset(int32 fpOffset) const
 	if(fpOffset < 0)
 		fpOffset += m_bufSize * 4096;
 	MPT_ASSERT(fpOffset >= 0);
-	return (m_bufPos + (fpOffset / 4096)) % m_bufSize;
+	// Offsets rarely exceed the buffer size, so avoid a costly modulo operation for every tap
+	int32 pos = m_bufPos + (fpOffset / 4096);
+	while(pos >= m_bufSize)
+		pos -= m_bufSize;
+	return pos;
 }
 
 
@@ -69,6 +74,8 @@ void Chorus::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	const uint32 phase = Phase();
 	const auto &bufferR = m_isFlanger ? m_bufferR : m_bufferL;
 
+	const DenormalGuard denormalGuard;
+
 	for(uint32 i = numFrames; i != 0; i--)
 	{
 		const float leftIn = *(in[0])++;
@@ -55,13 +55,23 @@ void Compressor::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	const float *in[2] = { m_mixBuffer.GetInputBuffer(0), m_mixBuffer.GetInputBuffer(1) };
 	float *out[2] = { m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1) };
 
+	const DenormalGuard denormalGuard;
+
+	const float attack = m_attack, release = m_release, threshold = m_threshold, ratio = m_ratio, gain = m_gain;
+	const int32 bufSize = m_bufSize;
+	float *buffer = m_buffer.data();
+	float peak = m_peak;
+	int32 bufPos = m_bufPos;
+	// The predelay does not change during a block, so the read position can trail the write position by a fixed amount
+	const int32 readDelay = ((m_predelay + bufSize - 1) / 4096) % bufSize;
+
 	for(uint32 i = numFrames; i != 0; i--)
 	{
 		float leftIn  = *(in[0])++;
 		float rightIn = *(in[1])++;
-			
-		m_buffer[m_bufPos * 2] = leftIn;
-		m_buffer[m_bufPos * 2 + 1] = rightIn;
+
+		buffer[bufPos * 2] = leftIn;
+		buffer[bufPos * 2 + 1] = rightIn;
 
 		leftIn = std::abs(leftIn);
 		rightIn = std::abs(rightIn);
@@ -69,13 +79,13 @@ void Compressor::Process(float *pOutL, float *pOutR, uint32 numFrames)
 		float mono = (leftIn + rightIn) * (0.5f * 32768.0f * 32768.0f);
 		float monoLog = std::abs(logGain(mono, 31, 5)) * (1.0f / float(1u << 31));
 
-		float newPeak = monoLog + (m_peak - monoLog) * ((m_peak <= monoLog) ? m_attack : m_release);
-		m_peak = newPeak;
+		float newPeak = monoLog + (peak - monoLog) * ((peak <= monoLog) ? attack : release);
+		peak = newPeak;
 
-		if(newPeak < m_threshold)
-			newPeak = m_threshold;
+		if(newPeak < threshold)
+			newPeak = threshold;
 
-		float compGain = (m_threshold - newPeak) * m_ratio + 0.9999999f;
+		float compGain = (threshold - newPeak) * ratio + 0.9999999f;
 
 		// Computes 2 ^ (2 ^ (log2(x) - 26) - 1) (x = 0...2^31)
 		uint32 compGainInt = static_cast<uint32>(compGain * 2147483648.0f);
@@ -87,18 +97,20 @@ void Compressor::Process(float *pOutL, float *pOutR, uint32 numFrames)
 			compGainInt--;
 		}
 		compGainPow >>= (31 - compGainInt);
-		
-		int32 readOffset = m_predelay + m_bufSize - 1;
-		readOffset /= 4096;
-		readOffset = (readOffset + m_bufPos) % m_bufSize;
-
-		float outGain = (static_cast<float>(compGainPow) * (1.0f / 2147483648.0f)) * m_gain;
-		*(out[0])++ = m_buffer[readOffset * 2] * outGain;
-		*(out[1])++ = m_buffer[readOffset * 2 + 1] * outGain;
-		
-		if(m_bufPos-- == 0)
-			m_bufPos += m_bufSize;
+
+		int32 readOffset = bufPos + readDelay;
+		if(readOffset >= bufSize)
+			readOffset -= bufSize;
+
+		float outGain = (static_cast<float>(compGainPow) * (1.0f / 2147483648.0f)) * gain;
+		*(out[0])++ = buffer[readOffset * 2] * outGain;
+		*(out[1])++ = buffer[readOffset * 2 + 1] * outGain;
+
+		if(bufPos-- == 0)
+			bufPos += bufSize;
 	}
+	m_peak = peak;
+	m_bufPos = bufPos;
 
 	ProcessMixOps(pOutL, pOutR, m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1), numFrames);
 }
@@ -14,6 +14,15 @@
 
 #ifndef NO_PLUGINS
 #include "../../Sndfile.h"
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE)
+#include "../../../common/mptCPU.h"
+#endif
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE) && defined(MPT_ARCH_INTRINSICS_X86_SSE)
+#if MPT_COMPILER_MSVC
+#include <intrin.h>
+#endif
+#include <xmmintrin.h>
+#endif
 #endif // !NO_PLUGINS
 
 OPENMPT_NAMESPACE_BEGIN
@@ -23,35 +32,29 @@ OPENMPT_NAMESPACE_BEGIN
 namespace DMO
 {
 
-// Computes (log2(x) + 1) * 2 ^ (shiftL - shiftR) (x = -2^31...2^31)
-float logGain(float x, int32 shiftL, int32 shiftR)
+DenormalGuard::DenormalGuard()
 {
-	uint32 intSample;
-	if(x <= static_cast<float>(int32_min) || x > static_cast<float>(int32_max))
-		intSample = static_cast<uint32>(int32_min);
-	else
-		intSample = static_cast<uint32>(static_cast<int32>(x));
-
-	const uint32 sign = intSample & 0x80000000;
-	if(sign)
-		intSample = (~intSample) + 1;
-
-	// Multiply until overflow (or edge shift factor is reached)
-	while(shiftL > 0 && intSample < 0x80000000)
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE) && defined(MPT_ARCH_INTRINSICS_X86_SSE)
+	if(CPU::HasFeatureSet(CPU::feature::sse) && CPU::HasModesEnabled(CPU::mode::xmm128sse))
 	{
-		intSample += intSample;
-		shiftL--;
+		m_active = true;
+		mpt::arch::feature_fence_aquire();
+		m_oldCSR = _mm_getcsr();
+		_mm_setcsr((m_oldCSR & ~(_MM_DENORMALS_ZERO_MASK | _MM_FLUSH_ZERO_MASK)) | _MM_DENORMALS_ZERO_ON | _MM_FLUSH_ZERO_ON);
 	}
-	// Unsign clipped sample
-	if(intSample >= 0x80000000)
+#endif
+}
+
+
+DenormalGuard::~DenormalGuard()
+{
+#if defined(MPT_WANT_ARCH_INTRINSICS_X86_SSE) && defined(MPT_ARCH_INTRINSICS_X86_SSE)
+	if(m_active)
 	{
-		intSample &= 0x7FFFFFFF;
-		shiftL++;
+		_mm_setcsr(m_oldCSR);
+		mpt::arch::feature_fence_release();
 	}
-	intSample = (shiftL << (31 - shiftR)) | (intSample >> shiftR);
-	if(sign)
-		intSample = ~intSample | sign;
-	return static_cast<float>(static_cast<int32>(intSample));
+#endif
 }
 
 } // namespace DMO
@@ -8,6 +8,17 @@
  */
 
 
+#pragma once
+
+#include "openmpt/all/BuildSettings.hpp"
+
+#ifndef NO_PLUGINS
+#include "mpt/base/bit.hpp"
+#include "../../../common/mptBaseTypes.h"
+
+#include <algorithm>
+#endif // !NO_PLUGINS
+
 OPENMPT_NAMESPACE_BEGIN
 
 #ifndef NO_PLUGINS
@@ -16,7 +27,55 @@ namespace DMO
 {
 
 // Computes (log2(x) + 1) * 2 ^ (shiftL - shiftR) (x = -2^31...2^31)
-float logGain(float x, int32 shiftL, int32 shiftR);
+MPT_FORCEINLINE float logGain(float x, int32 shiftL, int32 shiftR)
+{
+	uint32 intSample;
+	if(x <= static_cast<float>(int32_min) || x > static_cast<float>(int32_max))
+		intSample = static_cast<uint32>(int32_min);
+	else
+		intSample = static_cast<uint32>(static_cast<int32>(x));
+
+	const uint32 sign = intSample & 0x80000000;
+	if(sign)
+		intSample = (~intSample) + 1;
+
+	// Multiply until overflow (or edge shift factor is reached)
+	if(shiftL > 0 && intSample == 0)
+	{
+		shiftL = 0;
+	} else if(shiftL > 0)
+	{
+		const int32 shift = std::min(shiftL, static_cast<int32>(mpt::countl_zero(intSample)));
+		intSample <<= shift;
+		shiftL -= shift;
+	}
+	// Unsign clipped sample
+	if(intSample >= 0x80000000)
+	{
+		intSample &= 0x7FFFFFFF;
+		shiftL++;
+	}
+	intSample = (shiftL << (31 - shiftR)) | (intSample >> shiftR);
+	if(sign)
+		intSample = ~intSample | sign;
+	return static_cast<float>(static_cast<int32>(intSample));
+}
+
+
+// Flushes denormals to zero while a plugin renders. The recursive filters of the DMO plugins
+// decay into the denormal range once their input falls silent, which is very slow on x86.
+class DenormalGuard
+{
+	unsigned int m_oldCSR = 0;
+	bool m_active = false;
+
+public:
+	DenormalGuard();
+	~DenormalGuard();
+
+	DenormalGuard(const DenormalGuard &) = delete;
+	DenormalGuard &operator=(const DenormalGuard &) = delete;
+};
 
 }
 
@@ -53,6 +53,16 @@ void Distortion::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	const float *in[2] = { m_mixBuffer.GetInputBuffer(0), m_mixBuffer.GetInputBuffer(1) };
 	float *out[2] = { m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1) };
 
+	const DenormalGuard denormalGuard;
+
+	// Keep coefficients and filter state in locals so that they are not reloaded after every store to the output buffers
+	const float preEQa0 = m_preEQa0, preEQb1 = m_preEQb1;
+	const float postEQa0 = m_postEQa0, postEQb0 = m_postEQb0, postEQb1 = m_postEQb1;
+	const int32 edge = m_edge, shift = m_shift;
+	float preEQz1[2] = { m_preEQz1[0], m_preEQz1[1] };
+	float postEQz1[2] = { m_postEQz1[0], m_postEQz1[1] };
+	float postEQz2[2] = { m_postEQz2[0], m_postEQz2[1] };
+
 	for(uint32 i = numFrames; i != 0; i--)
 	{
 		for(uint8 channel = 0; channel < 2; channel++)
@@ -60,24 +70,31 @@ void Distortion::Process(float *pOutL, float *pOutR, uint32 numFrames)
 			float x = *(in[channel])++;
 
 			// Pre EQ
-			float z = x * m_preEQa0 + m_preEQz1[channel] * m_preEQb1;
-			m_preEQz1[channel] = z;
+			float z = x * preEQa0 + preEQz1[channel] * preEQb1;
+			preEQz1[channel] = z;
 
 			z *= 1073741824.0f;	// 32768^2
 
 			// The actual distortion
-			z = logGain(z, m_edge, m_shift);
+			z = logGain(z, edge, shift);
 
 			// Post EQ / Gain
-			z = (z * m_postEQa0) - m_postEQz1[channel] * m_postEQb1 - m_postEQz2[channel] * m_postEQb0;
-			m_postEQz1[channel] = z * m_postEQb0 + m_postEQz2[channel];
-			m_postEQz2[channel] = z;
+			z = (z * postEQa0) - postEQz1[channel] * postEQb1 - postEQz2[channel] * postEQb0;
+			postEQz1[channel] = z * postEQb0 + postEQz2[channel];
+			postEQz2[channel] = z;
 
 			z *= (1.0f / 1073741824.0f);	// 32768^2
 			*(out[channel])++ = z;
 		}
 	}
 
+	for(uint8 channel = 0; channel < 2; channel++)
+	{
+		m_preEQz1[channel] = preEQz1[channel];
+		m_postEQz1[channel] = postEQz1[channel];
+		m_postEQz2[channel] = postEQz2[channel];
+	}
+
 	ProcessMixOps(pOutL, pOutR, m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1), numFrames);
 }
 
@@ -53,34 +53,43 @@ void Echo::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	const float *in[2] = { m_mixBuffer.GetInputBuffer(0), m_mixBuffer.GetInputBuffer(1) };
 	float *out[2] = { m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1) };
 
+	// Delay line writes may alias the parameters, so keep everything used in the loop in locals
+	const float initialFeedback = m_initialFeedback, feedback = m_param[kEchoFeedback];
+	const uint32 bufferSize = m_bufferSize;
+	const uint32 delayTime[2] = { m_delayTime[0], m_delayTime[1] };
+	const uint8 readChannels[2] = { static_cast<uint8>(m_crossEcho ? 1 : 0), static_cast<uint8>(m_crossEcho ? 0 : 1) };
+	float *delayLine = m_delayLine.data();
+	uint32 writePos = m_writePos;
+
 	for(uint32 i = numFrames; i != 0; i--)
 	{
 		for(uint8 channel = 0; channel < 2; channel++)
 		{
-			const uint8 readChannel = (m_crossEcho ? (1 - channel) : channel);
-			int readPos = m_writePos - m_delayTime[readChannel];
+			const uint8 readChannel = readChannels[channel];
+			int readPos = static_cast<int>(writePos - delayTime[readChannel]);
 			if(readPos < 0)
-				readPos += m_bufferSize;
+				readPos += bufferSize;
 
 			float chnInput = *(in[channel])++;
-			float chnDelay = m_delayLine[readPos * 2 + readChannel];
+			float chnDelay = delayLine[readPos * 2 + readChannel];
 
 			// Calculate the delay
-			float chnOutput = chnInput * m_initialFeedback;
-			chnOutput += chnDelay * m_param[kEchoFeedback];
+			float chnOutput = chnInput * initialFeedback;
+			chnOutput += chnDelay * feedback;
 
 			// Prevent denormals
 			if(std::abs(chnOutput) < 1e-24f)
 				chnOutput = 0.0f;
 
-			m_delayLine[m_writePos * 2 + channel] = chnOutput;
+			delayLine[writePos * 2 + channel] = chnOutput;
 			// Output samples now
 			*(out[channel])++ = (chnInput * dryMix + chnDelay * wetMix);
 		}
-		m_writePos++;
-		if(m_writePos == m_bufferSize)
-			m_writePos = 0;
+		writePos++;
+		if(writePos == bufferSize)
+			writePos = 0;
 	}
+	m_writePos = writePos;
 
 	ProcessMixOps(pOutL, pOutR, m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1), numFrames);
 }
@@ -13,6 +13,7 @@
 #ifndef NO_PLUGINS
 #include "I3DL2Reverb.h"
 #include "../../Sndfile.h"
+#include "DMOUtils.h"
 #ifdef MODPLUG_TRACKER
 #include "../../../sounddsp/Reverb.h"
 #endif // MODPLUG_TRACKER
@@ -53,22 +54,29 @@ void I3DL2Reverb::DelayLine::Advance()
 
 MPT_FORCEINLINE void I3DL2Reverb::DelayLine::Set(float value)
 {
-	at(m_position) = value;
+	(*this)[m_position] = value;
 }
 
 
-float I3DL2Reverb::DelayLine::Get(int32 offset) const
+MPT_FORCEINLINE float I3DL2Reverb::DelayLine::Get(int32 offset) const
 {
-	offset = (offset + m_position) % m_length;
-	if(offset < 0)
-		offset += m_length;
-	return at(offset);
+	// Tap offsets are normally shorter than the delay line, so a single wrap is enough
+	offset += m_position;
+	if(offset >= m_length)
+		offset -= m_length;
+	if(offset < 0 || offset >= m_length)
+	{
+		offset %= m_length;
+		if(offset < 0)
+			offset += m_length;
+	}
+	return (*this)[offset];
 }
 
 
 MPT_FORCEINLINE float I3DL2Reverb::DelayLine::Get() const
 {
-	return at(m_delayPosition);
+	return (*this)[m_delayPosition];
 }
 
 
@@ -118,6 +126,8 @@ void I3DL2Reverb::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	const float *in[2] = { m_mixBuffer.GetInputBuffer(0), m_mixBuffer.GetInputBuffer(1) };
 	float *out[2] = { m_mixBuffer.GetOutputBuffer(0), m_mixBuffer.GetOutputBuffer(1) };
 
+	const DenormalGuard denormalGuard;
+
 	uint32 frames = numFrames;
 	if(!(m_quality & kFullSampleRate) && m_remain && frames > 0)
 	{
@@ -13,6 +13,9 @@
 #ifndef NO_PLUGINS
 #include "ParamEq.h"
 #include "../../Sndfile.h"
+#include "DMOUtils.h"
+#include "../../../sounddsp/SIMD.h"
+#include "mpt/arch/feature_fence.hpp"
 #include "mpt/base/numbers.hpp"
 #endif // !NO_PLUGINS
 
@@ -23,6 +26,45 @@ OPENMPT_NAMESPACE_BEGIN
 namespace DMO
 {
 
+// Both channels run through the same filter, so process them as two lanes of one vector
+template <typename Vec>
+static void ParamEqFilterSIMD(const float *inL, const float *inR, float *outL, float *outR, uint32 numFrames, const float (&coeffs)[5], float (&x1)[2], float (&x2)[2], float (&y1)[2], float (&y2)[2])
+{
+	const auto b0 = Vec::BroadcastFloat(coeffs[0]), b1 = Vec::BroadcastFloat(coeffs[1]), b2 = Vec::BroadcastFloat(coeffs[2]);
+	const auto a1 = Vec::BroadcastFloat(coeffs[3]), a2 = Vec::BroadcastFloat(coeffs[4]);
+	auto vx1 = Vec::SetFloat(x1[0], x1[1], 0.0f, 0.0f), vx2 = Vec::SetFloat(x2[0], x2[1], 0.0f, 0.0f);
+	auto vy1 = Vec::SetFloat(y1[0], y1[1], 0.0f, 0.0f), vy2 = Vec::SetFloat(y2[0], y2[1], 0.0f, 0.0f);
+	float out[4];
+	for(uint32 i = numFrames; i != 0; i--)
+	{
+		const auto x = Vec::SetFloat(*inL++, *inR++, 0.0f, 0.0f);
+		auto y = Vec::AddFloat(Vec::MulFloat(b0, x), Vec::MulFloat(b1, vx1));
+		y = Vec::AddFloat(y, Vec::MulFloat(b2, vx2));
+		y = Vec::SubFloat(y, Vec::MulFloat(a1, vy1));
+		y = Vec::SubFloat(y, Vec::MulFloat(a2, vy2));
+		vx2 = vx1;
+		vx1 = x;
+		vy2 = vy1;
+		vy1 = y;
+		Vec::StoreFloat(out, y);
+		*outL++ = out[0];
+		*outR++ = out[1];
+	}
+	float state[4][4];
+	Vec::StoreFloat(state[0], vx1);
+	Vec::StoreFloat(state[1], vx2);
+	Vec::StoreFloat(state[2], vy1);
+	Vec::StoreFloat(state[3], vy2);
+	for(uint8 channel = 0; channel < 2; channel++)
+	{
+		x1[channel] = state[0][channel];
+		x2[channel] = state[1][channel];
+		y1[channel] = state[2][channel];
+		y2[channel] = state[3][channel];
+	}
+}
+
+
 IMixPlugin* ParamEq::Create(VSTPluginLib &factory, CSoundFile &sndFile, SNDMIXPLUGIN &mixStruct)
 {
 	return new (std::nothrow) ParamEq(factory, sndFile, mixStruct);
@@ -55,19 +97,38 @@ void ParamEq::Process(float *pOutL, float *pOutR, uint32 numFrames)
 		memcpy(out[1], in[1], numFrames * sizeof(float));
 	} else
 	{
-		for(uint32 i = numFrames; i != 0; i--)
+		const DenormalGuard denormalGuard;
+#if defined(MPT_SIMD_NATIVE)
+		if(SIMD::Native::IsAvailable())
+		{
+			mpt::arch::feature_fence_guard arch_feature_guard;
+			const float coeffs[5] = {b0DIVa0, b1DIVa0, b2DIVa0, a1DIVa0, a2DIVa0};
+			ParamEqFilterSIMD<SIMD::Native>(in[0], in[1], out[0], out[1], numFrames, coeffs, x1, x2, y1, y2);
+		} else
+#endif
 		{
+			const float b0 = b0DIVa0, b1 = b1DIVa0, b2 = b2DIVa0, a1 = a1DIVa0, a2 = a2DIVa0;
 			for(uint8 channel = 0; channel < 2; channel++)
 			{
-				float x = *(in[channel])++;
-				float y = b0DIVa0 * x + b1DIVa0 * x1[channel] + b2DIVa0 * x2[channel] - a1DIVa0 * y1[channel] - a2DIVa0 * y2[channel];
-
-				x2[channel] = x1[channel];
-				x1[channel] = x;
-				y2[channel] = y1[channel];
-				y1[channel] = y;
-
-				*(out[channel])++ = y;
+				float sx1 = x1[channel], sx2 = x2[channel], sy1 = y1[channel], sy2 = y2[channel];
+				const float *inChn = in[channel];
+				float *outChn = out[channel];
+				for(uint32 i = numFrames; i != 0; i--)
+				{
+					float x = *inChn++;
+					float y = b0 * x + b1 * sx1 + b2 * sx2 - a1 * sy1 - a2 * sy2;
+
+					sx2 = sx1;
+					sx1 = x;
+					sy2 = sy1;
+					sy1 = y;
+
+					*outChn++ = y;
+				}
+				x1[channel] = sx1;
+				x2[channel] = sx2;
+				y1[channel] = sy1;
+				y2[channel] = sy2;
 			}
 		}
 	}
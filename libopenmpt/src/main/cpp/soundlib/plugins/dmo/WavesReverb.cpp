@@ -13,6 +13,8 @@
 #ifndef NO_PLUGINS
 #include "WavesReverb.h"
 #include "../../Sndfile.h"
+#include "../../../sounddsp/SIMD.h"
+#include "mpt/arch/feature_fence.hpp"
 #endif // !NO_PLUGINS
 
 OPENMPT_NAMESPACE_BEGIN
@@ -60,6 +62,20 @@ void WavesReverb::Process(float *pOutL, float *pOutR, uint32 numFrames)
 	float delay2old = m_state.comb[delay2][2];
 	float delay3old = m_state.comb[delay3][3];
 
+	// The state buffers are float arrays as well, so keep the coefficients in locals to avoid reloading them for every frame
+	const float dryFactor = m_dryFactor, wetFactor = m_wetFactor;
+	const float allpassCoeff1 = m_coeffs[0], allpassCoeff2 = m_coeffs[1];
+	const std::array<float, 4> combNewCoeffs = { m_coeffs[2], m_coeffs[4], m_coeffs[6], m_coeffs[8] };
+	const std::array<float, 4> combOldCoeffs = { m_coeffs[3], m_coeffs[5], m_coeffs[7], m_coeffs[9] };
+
+#if defined(MPT_SIMD_NATIVE)
+	using Vec = SIMD::Native;
+	const bool useSIMD = Vec::IsAvailable();
+	mpt::arch::feature_fence_guard arch_feature_guard;
+	const Vec::f128 combNewCoeffsVec = Vec::LoadFloat(combNewCoeffs.data());
+	const Vec::f128 combOldCoeffsVec = Vec::LoadFloat(combOldCoeffs.data());
+#endif
+
 	for(uint32 i = numFrames; i != 0; i--)
 	{
 		const float leftIn  = *(in[0])++ + 1e-30f;	// Prevent denormals
@@ -70,36 +86,54 @@ void WavesReverb::Process(float *pOutL, float *pOutR, uint32 numFrames)
 		delay1 = (delay1 - 1) & 0xFFF;
 		delay2 = (delay2 - 1) & 0xFFF;
 		delay3 = (delay3 - 1) & 0xFFF;
-		float &delay0new = m_state.comb[delay0][0];
-		float &delay1new = m_state.comb[delay1][1];
-		float &delay2new = m_state.comb[delay2][2];
-		float &delay3new = m_state.comb[delay3][3];
+		float delay0new = m_state.comb[delay0][0];
+		float delay1new = m_state.comb[delay1][1];
+		float delay2new = m_state.comb[delay2][2];
+		float delay3new = m_state.comb[delay3][3];
 
 		float r1, r2;
-		
-		r1 = delay1new * 0.61803401f + m_state.allpass1[delay4][0] * m_coeffs[0];
-		r2 = m_state.allpass1[delay4][1] * m_coeffs[0] - delay0new * 0.61803401f;
+
+		r1 = delay1new * 0.61803401f + m_state.allpass1[delay4][0] * allpassCoeff1;
+		r2 = m_state.allpass1[delay4][1] * allpassCoeff1 - delay0new * 0.61803401f;
 		m_state.allpass1[allpassPos][0] = r2 * 0.61803401f + delay0new;
 		m_state.allpass1[allpassPos][1] = delay1new - r1 * 0.61803401f;
 		delay0new = r1;
 		delay1new = r2;
 
-		r1 = delay3new * 0.61803401f + m_state.allpass2[delay5][0] * m_coeffs[1];
-		r2 = m_state.allpass2[delay5][1] * m_coeffs[1] - delay2new * 0.61803401f;
+		r1 = delay3new * 0.61803401f + m_state.allpass2[delay5][0] * allpassCoeff2;
+		r2 = m_state.allpass2[delay5][1] * allpassCoeff2 - delay2new * 0.61803401f;
 		m_state.allpass2[allpassPos][0] = r2 * 0.61803401f + delay2new;
 		m_state.allpass2[allpassPos][1] = delay3new - r1 * 0.61803401f;
 		delay2new = r1;
 		delay3new = r2;
 
-		*(out[0])++ = (leftIn  * m_dryFactor) + delay0new + delay2new;
-		*(out[1])++ = (rightIn * m_dryFactor) + delay1new + delay3new;
-
-		const float leftWet  = leftIn  * m_wetFactor;
-		const float rightWet = rightIn * m_wetFactor;
-		m_state.comb[combPos][0] = (delay0new * m_coeffs[2]) + (delay0old * m_coeffs[3]) + leftWet;
-		m_state.comb[combPos][1] = (delay1new * m_coeffs[4]) + (delay1old * m_coeffs[5]) + rightWet;
-		m_state.comb[combPos][2] = (delay2new * m_coeffs[6]) + (delay2old * m_coeffs[7]) - rightWet;
-		m_state.comb[combPos][3] = (delay3new * m_coeffs[8]) + (delay3old * m_coeffs[9]) + leftWet;
+		// Store the allpass outputs back into the comb filter taps
+		m_state.comb[delay0][0] = delay0new;
+		m_state.comb[delay1][1] = delay1new;
+		m_state.comb[delay2][2] = delay2new;
+		m_state.comb[delay3][3] = delay3new;
+
+		*(out[0])++ = (leftIn  * dryFactor) + delay0new + delay2new;
+		*(out[1])++ = (rightIn * dryFactor) + delay1new + delay3new;
+
+		const float leftWet  = leftIn  * wetFactor;
+		const float rightWet = rightIn * wetFactor;
+#if defined(MPT_SIMD_NATIVE)
+		if(useSIMD)
+		{
+			// All four comb filters are updated at once; subtracting rightWet is the same as adding its negation
+			const Vec::f128 newVal = Vec::SetFloat(delay0new, delay1new, delay2new, delay3new);
+			const Vec::f128 oldVal = Vec::SetFloat(delay0old, delay1old, delay2old, delay3old);
+			const Vec::f128 wet = Vec::SetFloat(leftWet, rightWet, -rightWet, leftWet);
+			Vec::StoreFloat(m_state.comb[combPos], Vec::AddFloat(Vec::AddFloat(Vec::MulFloat(newVal, combNewCoeffsVec), Vec::MulFloat(oldVal, combOldCoeffsVec)), wet));
+		} else
+#endif
+		{
+			m_state.comb[combPos][0] = (delay0new * combNewCoeffs[0]) + (delay0old * combOldCoeffs[0]) + leftWet;
+			m_state.comb[combPos][1] = (delay1new * combNewCoeffs[1]) + (delay1old * combOldCoeffs[1]) + rightWet;
+			m_state.comb[combPos][2] = (delay2new * combNewCoeffs[2]) + (delay2old * combOldCoeffs[2]) - rightWet;
+			m_state.comb[combPos][3] = (delay3new * combNewCoeffs[3]) + (delay3old * combOldCoeffs[3]) + leftWet;
+		}
 
 		delay0old = delay0new;
 		delay1old = delay1new;
@@ -0,0 +1,183 @@
+/* SPDX-License-Identifier: BSL-1.0 OR BSD-3-Clause */
+
+#ifndef MPT_IO_READ_FILEDATA_MMAP_HPP
+#define MPT_IO_READ_FILEDATA_MMAP_HPP
+
+
+
+#include "mpt/base/detect.hpp"
+#include "mpt/base/memory.hpp"
+#include "mpt/base/namespace.hpp"
+#include "mpt/io_read/filedata_memory.hpp"
+
+#include <limits>
+
+#include <cerrno>
+#include <cstddef>
+
+#if !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#endif // !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+
+
+
+namespace mpt {
+inline namespace MPT_INLINE_NS {
+
+
+
+namespace IO {
+
+
+
+#if !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+
+#define MPT_IO_READ_FILEDATA_MMAP 1
+
+
+
+namespace detail {
+
+// Owns a read-only private mapping of a complete regular file.
+// Kept as a separate base so that the mapping exists before FileDataMemory is constructed from it.
+class FileMapping {
+
+private:
+	void * mappingData;
+	std::size_t mappingLength;
+	int fileDescriptor;
+
+private:
+	void Map(int fd) {
+		if (fd < 0) {
+			return;
+		}
+		struct stat st {};
+		if (::fstat(fd, &st) != 0) {
+			return;
+		}
+		if (!S_ISREG(st.st_mode)) {
+			return;
+		}
+		// Empty files cannot be mapped, and files larger than the address space should not be.
+		if (st.st_size <= 0) {
+			return;
+		}
+		if (static_cast<unsigned long long>(st.st_size) > static_cast<unsigned long long>(std::numeric_limits<std::size_t>::max())) {
+			return;
+		}
+		void * data = ::mmap(nullptr, static_cast<std::size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+		if (data == MAP_FAILED) {
+			return;
+		}
+		mappingData = data;
+		mappingLength = static_cast<std::size_t>(st.st_size);
+	}
+
+public:
+	FileMapping(int fd)
+		: mappingData(nullptr)
+		, mappingLength(0)
+		, fileDescriptor(-1) {
+		Map(fd);
+	}
+	FileMapping(const char * filename, bool keepFileDescriptor)
+		: mappingData(nullptr)
+		, mappingLength(0)
+		, fileDescriptor(-1) {
+		if (!filename) {
+			return;
+		}
+		int flags = O_RDONLY;
+#if defined(O_CLOEXEC)
+		flags |= O_CLOEXEC;
+#endif
+		int fd = -1;
+		do {
+			fd = ::open(filename, flags);
+		} while ((fd == -1) && (errno == EINTR));
+		if (fd < 0) {
+			return;
+		}
+		Map(fd);
+		if (keepFileDescriptor && mappingData) {
+			fileDescriptor = fd;
+		} else {
+			::close(fd);
+		}
+	}
+	FileMapping(const FileMapping &) = delete;
+	FileMapping & operator=(const FileMapping &) = delete;
+	~FileMapping() {
+		if (mappingData) {
+			::munmap(mappingData, mappingLength);
+		}
+		if (fileDescriptor >= 0) {
+			::close(fileDescriptor);
+		}
+	}
+
+public:
+	mpt::const_byte_span GetMappedView() const {
+		if (!mappingData) {
+			return mpt::const_byte_span();
+		}
+		return mpt::as_span(static_cast<const std::byte *>(mappingData), mappingLength);
+	}
+
+	// Returns the file descriptor if it was kept open, -1 otherwise.
+	int GetFileDescriptor() const {
+		return fileDescriptor;
+	}
+};
+
+} // namespace detail
+
+
+
+// Memory-mapped view of a complete file.
+// Reads are served directly from the page cache, and HasPinnedView() allows FileCursor users to access the data without copying.
+// The mapping is private and read-only. Truncating the file while it is mapped results in SIGBUS on access,
+// which is the usual caveat of file mappings.
+// IsValid() returns false if the file could not be mapped (e.g. if it is empty, not a regular file, or too large for the address space),
+// in which case callers should fall back to a stream-based IFileData.
+class FileDataMMap
+	: private detail::FileMapping
+	, public FileDataMemory {
+
+public:
+	// Does not take ownership of fd. The mapping stays valid after fd has been closed.
+	FileDataMMap(int fd)
+		: detail::FileMapping(fd)
+		, FileDataMemory(GetMappedView()) { }
+	// If keepFileDescriptor is true, the file stays open for the lifetime of this object (see GetFileDescriptor()),
+	// which allows mapping parts of the file again, e.g. with different protection.
+	FileDataMMap(const char * filename, bool keepFileDescriptor = false)
+		: detail::FileMapping(filename, keepFileDescriptor)
+		, FileDataMemory(GetMappedView()) { }
+
+	using detail::FileMapping::GetFileDescriptor;
+};
+
+#else // MPT_OS_WINDOWS || MPT_OS_DJGPP
+
+#define MPT_IO_READ_FILEDATA_MMAP 0
+
+#endif // !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+
+
+
+} // namespace IO
+
+
+
+} // namespace MPT_INLINE_NS
+} // namespace mpt
+
+
+
+#endif // MPT_IO_READ_FILEDATA_MMAP_HPP
@@ -17,6 +17,8 @@
 #ifdef LIBOPENMPT_BUILD
 #include "mpt/arch/x86_amd64.hpp"
 #endif
+#include "mpt/arch/feature_fence.hpp"
+#include "mpt/base/bit.hpp"
 #include "mpt/base/check_platform.hpp"
 #include "mpt/base/detect.hpp"
 #include "mpt/base/numbers.hpp"
@@ -32,6 +34,7 @@
 #include "mpt/io/io_stdstream.hpp"
 #include "mpt/io_file/fstream.hpp"
 #include "mpt/io_read/filecursor_stdstream.hpp"
+#include "mpt/io_read/filedata_mmap.hpp"
 #include "mpt/osinfo/class.hpp"
 #include "mpt/osinfo/dos_version.hpp"
 #include "mpt/osinfo/dos_memory.hpp"
@@ -44,6 +47,7 @@
 
 #include "../common/version.h"
 #include "../common/misc_util.h"
+#include "../common/mptCPU.h"
 #include "../common/mptStringBuffer.h"
 #include "../common/serialization_utils.h"
 #include "../common/FileReader.h"
@@ -53,6 +57,7 @@
 #include "../soundlib/mod_specifications.h"
 #include "../soundlib/MIDIEvents.h"
 #include "../soundlib/MIDIMacros.h"
+#include "../soundlib/modsmp_ctrl.h"
 #include "openmpt/soundbase/Copy.hpp"
 #include "openmpt/soundbase/SampleConvert.hpp"
 #include "openmpt/soundbase/SampleDecode.hpp"
@@ -63,8 +68,14 @@
 #include "../soundlib/MIDIMacroParser.h"
 #include "../soundlib/ModSampleCopy.h"
 #include "../soundlib/ITCompression.h"
+#include "../soundlib/MixFuncTable.h"
+#include "../soundlib/MixerLoops.h"
+#include "../soundlib/MixThreadPool.h"
+#include "../soundlib/Resampler.h"
 #include "../soundlib/tuningcollection.h"
 #include "../soundlib/tuning.h"
+#include "../sounddsp/Reverb.h"
+#include "../sounddsp/SIMD.h"
 #include "openmpt/soundbase/Dither.hpp"
 #ifdef MODPLUG_TRACKER
 #include "../mptrack/Mptrack.h"
@@ -88,6 +99,7 @@
 #endif // LIBOPENMPT_BUILD
 #ifndef NO_PLUGINS
 #include "../soundlib/plugins/PlugInterface.h"
+#include "../soundlib/plugins/PluginManager.h"
 #endif
 #include <sstream>
 #include <limits>
@@ -96,6 +108,11 @@
 #include <iostream>
 #endif // LIBOPENMPT_BUILD
 #include <istream>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <map>
+#include <thread>
 #include <ostream>
 #include <stdexcept>
 #ifdef LIBOPENMPT_BUILD
@@ -119,8 +136,27 @@
 #include "TestTools.h"
 
 #if defined(LIBOPENMPT_BUILD)
+#include "../libopenmpt/libopenmpt.h"
 #include "../libopenmpt/libopenmpt.hpp"
+#if !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+#include "../libopenmpt/libopenmpt_stream_callbacks_mmap.h"
 #endif
+#endif
+
+// opal.h defines the emulator's member functions in the header. Putting our copy into its own namespace
+// keeps it from clashing with the copy in OPL.cpp, so that Render() and Sample() can be tested directly.
+namespace OpalTest
+{
+using namespace OPENMPT_NAMESPACE;
+#if MPT_COMPILER_GCC
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wconversion"
+#endif
+#include "../soundlib/opal.h"
+#if MPT_COMPILER_GCC
+#pragma GCC diagnostic pop
+#endif
+}  // namespace OpalTest
 
 
 // enable tests which may fail spuriously
@@ -149,11 +185,20 @@ static MPT_NOINLINE void TestSettings();
 static MPT_NOINLINE void TestStringIO();
 static MPT_NOINLINE void TestMIDIEvents();
 static MPT_NOINLINE void TestSampleConversion();
+static MPT_NOINLINE void TestMixFunctions();
+static MPT_NOINLINE void TestResamplerTables();
+static MPT_NOINLINE void TestPostMixFunctions();
+static MPT_NOINLINE void TestDMOPlugins();
+static MPT_NOINLINE void TestSIMD();
 static MPT_NOINLINE void TestITCompression();
 static MPT_NOINLINE void TestPCnoteSerialization();
 static MPT_NOINLINE void TestLoadSaveFile();
 static MPT_NOINLINE void TestEditing();
 static MPT_NOINLINE void TestMIDIMacroParser();
+static MPT_NOINLINE void TestRenderPaths();
+static MPT_NOINLINE void TestSubsongCache();
+static MPT_NOINLINE void TestModuleFileLoading();
+static MPT_NOINLINE void TestRenderProfile();
 
 
 
@@ -474,8 +519,17 @@ void DoTests()
 	DO_TEST(TestStringIO);
 	DO_TEST(TestMIDIEvents);
 	DO_TEST(TestSampleConversion);
+	DO_TEST(TestMixFunctions);
+	DO_TEST(TestResamplerTables);
+	DO_TEST(TestPostMixFunctions);
+	DO_TEST(TestDMOPlugins);
+	DO_TEST(TestSIMD);
 	DO_TEST(TestITCompression);
 	DO_TEST(TestMIDIMacroParser);
+	DO_TEST(TestRenderPaths);
+	DO_TEST(TestSubsongCache);
+	DO_TEST(TestModuleFileLoading);
+	DO_TEST(TestRenderProfile);
 
 	// slower tests, require opening a CModDoc
 	DO_TEST(TestPCnoteSerialization);
@@ -3806,6 +3860,19 @@ static MPT_NOINLINE void TestLoadSaveFile()
 
 		TestLoadS3MFile(sndFile, false);
 
+		// Probing with a partial header must not rule out formats whose magic bytes have not been seen yet
+		{
+			mpt::IO::ifstream stream(filenameBaseSrc + P_("s3m"), std::ios::binary);
+			FileReader file = mpt::IO::make_FileCursor<mpt::PathString>(stream);
+			const uint64 fileSize = file.GetLength();
+			std::vector<std::byte> header;
+			file.ReadVector(header, std::min(mpt::saturate_cast<std::size_t>(fileSize), CSoundFile::ProbeRecommendedSize));
+			VERIFY_EQUAL_NONCONT(CSoundFile::Probe(CSoundFile::ProbeFlagsDefault, header, &fileSize), CSoundFile::ProbeSuccess);
+			VERIFY_EQUAL_NONCONT(CSoundFile::Probe(CSoundFile::ProbeFlagsDefault, mpt::as_span(header).first(40), &fileSize), CSoundFile::ProbeWantMoreData);
+			header[44] = std::byte{'X'};
+			VERIFY_EQUAL_NONCONT(CSoundFile::Probe(CSoundFile::ProbeFlagsDefault, header, &fileSize), CSoundFile::ProbeFailure);
+		}
+
 		// Test GetLength code, in particular with subsongs
 		sndFile.ChnSettings[1].dwFlags.reset(CHN_MUTE);
 		
@@ -3821,6 +3888,97 @@ static MPT_NOINLINE void TestLoadSaveFile()
 		}
 		VERIFY_EQUAL_EPS(totalDuration, 3674.38, 1.0);
 
+		// Seeking from a checkpoint must end up in the same state as seeking from the start of the song
+		{
+			const auto reference = sndFile.GetLength(eAdjustSamplePositions, GetLengthTarget(12.0)).back();
+			const auto referenceState = std::make_unique<PlayState>(sndFile.m_PlayState);
+			sndFile.SetSeekCheckpointInterval(2.0);
+			sndFile.GetLength(eAdjustSamplePositions, GetLengthTarget(15.0));
+			const auto resumed = sndFile.GetLength(eAdjustSamplePositions, GetLengthTarget(12.0)).back();
+			VERIFY_EQUAL_NONCONT(resumed.targetReached, true);
+			VERIFY_EQUAL_NONCONT(resumed.restartOrder, reference.restartOrder);
+			VERIFY_EQUAL_NONCONT(resumed.restartRow, reference.restartRow);
+			VERIFY_EQUAL_EPS(resumed.duration, reference.duration, 0.0001);
+			VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.m_nMusicSpeed, referenceState->m_nMusicSpeed);
+			VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.m_nMusicTempo, referenceState->m_nMusicTempo);
+			VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.m_nGlobalVolume, referenceState->m_nGlobalVolume);
+			for(CHANNELINDEX chn = 0; chn < sndFile.GetNumChannels(); chn++)
+			{
+				VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.Chn[chn].position, referenceState->Chn[chn].position);
+				VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.Chn[chn].nPeriod, referenceState->Chn[chn].nPeriod);
+			}
+			sndFile.SetSeekCheckpointInterval(0.0);
+			VERIFY_EQUAL_NONCONT(sndFile.GetNumSeekCheckpoints(), 0u);
+		}
+
+		// Background channels keep their state, with or without checkpoints
+		{
+			const CHANNELINDEX backgroundChn = sndFile.GetNumChannels() + 3;
+			const auto seek = [&sndFile, backgroundChn](double seconds)
+			{
+				sndFile.m_PlayState.Chn[backgroundChn].nPeriod = 1234;
+				sndFile.m_PlayState.SetBackgroundChannelInUse(backgroundChn);
+				return sndFile.GetLength(eAdjustSamplePositions, GetLengthTarget(seconds)).back();
+			};
+			const double target = sndFile.GetLength(eNoAdjust).back().duration - 1.0;
+			const auto reference = seek(target);
+			const auto referenceState = std::make_unique<PlayState>(sndFile.m_PlayState);
+			VERIFY_EQUAL_NONCONT(reference.targetReached, true);
+
+			sndFile.SetSeekCheckpointInterval(0.01);
+			VERIFY_EQUAL_NONCONT(sndFile.GetSeekCheckpointInterval(), 0.5);
+			seek(target);
+			VERIFY_EQUAL_NONCONT(sndFile.GetNumSeekCheckpoints() > 0u, true);
+			const auto resumed = seek(target);
+			VERIFY_EQUAL_NONCONT(resumed.targetReached, true);
+			VERIFY_EQUAL_NONCONT(resumed.restartOrder, reference.restartOrder);
+			VERIFY_EQUAL_NONCONT(resumed.restartRow, reference.restartRow);
+			VERIFY_EQUAL_EPS(resumed.duration, reference.duration, 0.0001);
+			for(CHANNELINDEX chn = 0; chn < sndFile.GetNumChannels(); chn++)
+			{
+				VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.Chn[chn].position, referenceState->Chn[chn].position);
+				VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.Chn[chn].nPeriod, referenceState->Chn[chn].nPeriod);
+			}
+			VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.Chn[backgroundChn].nPeriod, 1234u);
+			VERIFY_EQUAL_NONCONT(sndFile.m_PlayState.IsBackgroundChannelInUse(backgroundChn), referenceState->IsBackgroundChannelInUse(backgroundChn));
+
+			sndFile.SetSeekCheckpointInterval(0.0);
+			sndFile.m_PlayState.Chn[backgroundChn].nPeriod = 0;
+			sndFile.m_PlayState.SetBackgroundChannelIdle(backgroundChn);
+		}
+
+		// Long songs keep at most 256 checkpoints, further apart than requested
+		{
+			mpt::heap_value<CSoundFile> pLongSong;
+			CSoundFile &longSong = *pLongSong;
+			longSong.Create(MOD_TYPE_MPT, 1);
+			longSong.Patterns.Insert(0, 64);
+			// 40 patterns of about 7.7 seconds each
+			longSong.Order().assign(40, 0);
+			const auto reference = longSong.GetLength(eAdjustSamplePositions, GetLengthTarget(200.0)).back();
+			VERIFY_EQUAL_NONCONT(reference.targetReached, true);
+			longSong.SetSeekCheckpointInterval(0.5);
+			longSong.GetLength(eAdjustSamplePositions, GetLengthTarget(300.0));
+			VERIFY_EQUAL_NONCONT(longSong.GetNumSeekCheckpoints() > 128u, true);
+			VERIFY_EQUAL_NONCONT(longSong.GetNumSeekCheckpoints() <= 256u, true);
+			const auto resumed = longSong.GetLength(eAdjustSamplePositions, GetLengthTarget(200.0)).back();
+			VERIFY_EQUAL_NONCONT(resumed.targetReached, true);
+			VERIFY_EQUAL_NONCONT(resumed.restartOrder, reference.restartOrder);
+			VERIFY_EQUAL_NONCONT(resumed.restartRow, reference.restartRow);
+			VERIFY_EQUAL_EPS(resumed.duration, reference.duration, 0.0001);
+
+			// Channels muted after the checkpoints were taken stay muted, like the interactive libopenmpt interface mutes them
+			longSong.ChnSettings[0].dwFlags.set(CHN_MUTE | CHN_SYNCMUTE);
+			longSong.m_PlayState.Chn[0].dwFlags.set(CHN_MUTE | CHN_SYNCMUTE);
+			VERIFY_EQUAL_NONCONT(longSong.GetLength(eAdjustSamplePositions, GetLengthTarget(150.0)).back().targetReached, true);
+			VERIFY_EQUAL_NONCONT(longSong.m_PlayState.Chn[0].dwFlags[CHN_SYNCMUTE], true);
+			VERIFY_EQUAL_NONCONT(longSong.m_PlayState.Chn[0].dwFlags[CSoundFile::GetChannelMuteFlag()], true);
+			longSong.ChnSettings[0].dwFlags.reset(CHN_MUTE | CHN_SYNCMUTE);
+			VERIFY_EQUAL_NONCONT(longSong.GetLength(eAdjustSamplePositions, GetLengthTarget(100.0)).back().targetReached, true);
+			VERIFY_EQUAL_NONCONT(longSong.m_PlayState.Chn[0].dwFlags[CHN_MUTE | CHN_SYNCMUTE], false);
+			longSong.Destroy();
+		}
+
 		#ifndef MODPLUG_NO_FILESAVE
 			// Test file saving
 			sndFile.ChnSettings[1].dwFlags.set(CHN_MUTE);
@@ -3874,6 +4032,23 @@ static MPT_NOINLINE void TestLoadSaveFile()
 #endif
 #endif
 
+		// Widening the 8-bit samples must not change what the mixer sees
+		{
+			const ModSample &sample = sndFile.GetSample(1);
+			VERIFY_EQUAL_NONCONT(sample.uFlags[CHN_16BIT], false);
+			const std::vector<int8> original(sample.sample8(), sample.sample8() + sample.nLength);
+			const size_t memory = sndFile.GetSampleMemoryUsage();
+			sndFile.SetSampleStorage(SampleStorage::Int16);
+			VERIFY_EQUAL_NONCONT(sample.uFlags[CHN_16BIT], true);
+			VERIFY_EQUAL_NONCONT(sndFile.IsSampleWidened(&sample), true);
+			VERIFY_EQUAL_NONCONT(sample.nLength, original.size());
+			for(size_t i = 0; i < original.size(); i++)
+			{
+				VERIFY_EQUAL_NONCONT(sample.sample16()[i], original[i] * 256);
+			}
+			VERIFY_EQUAL_NONCONT(sndFile.GetSampleMemoryUsage() > memory, true);
+		}
+
 		DestroySoundFileContainer(sndFileContainer);
 	}
 
@@ -3994,6 +4169,706 @@ static MPT_NOINLINE void TestEditing()
 	sndFile.Destroy();
 	modDoc->OnCloseDocument();
 #endif
+
+	// Sample conversions used for fitting samples into the sample memory budget
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_IT, 4);
+		sndFile.m_nSamples = 1;
+		ModSample &smp = sndFile.GetSample(1);
+		smp.Initialize(MOD_TYPE_IT);
+		smp.nLength = 1000;
+		smp.nLoopStart = 100;
+		smp.nLoopEnd = 901;
+		smp.nC5Speed = 44100;
+		smp.uFlags.set(CHN_16BIT | CHN_STEREO | CHN_LOOP);
+		smp.AllocateSample();
+		std::vector<int16> original(smp.nLength);
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			original[i] = static_cast<int16>(std::sin(i * 0.05) * 20000.0);
+			smp.sample16()[i * 2] = smp.sample16()[i * 2 + 1] = original[i];
+		}
+
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertIdenticalStereoToMono(smp, sndFile), true);
+		VERIFY_EQUAL_NONCONT(smp.GetNumChannels(), 1);
+		VERIFY_EQUAL_NONCONT(std::equal(original.begin(), original.end(), smp.sample16()), true);
+		smp.sample16()[0]++;
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertToStereo(smp, sndFile), true);
+		smp.sample16()[1]--;
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertIdenticalStereoToMono(smp, sndFile), false);
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertToMono(smp, sndFile, ctrlSmp::onlyRight), true);
+
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertTo8Bit(smp, sndFile), true);
+		VERIFY_EQUAL_NONCONT(smp.GetElementarySampleSize(), 1);
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			VERIFY_EQUAL_EPS(smp.sample8()[i] * 256, original[i], 256);
+		}
+
+		VERIFY_EQUAL_NONCONT(ctrlSmp::Downsample2x(smp, sndFile), true);
+		VERIFY_EQUAL_NONCONT(smp.nLength, 500);
+		VERIFY_EQUAL_NONCONT(smp.nLoopStart, 50);
+		VERIFY_EQUAL_NONCONT(smp.nLoopEnd, 450);
+		VERIFY_EQUAL_NONCONT(smp.nC5Speed, 22050);
+		for(SmpLength i = 2; i < smp.nLength - 2; i++)
+		{
+			VERIFY_EQUAL_EPS(smp.sample8()[i] * 256, original[i * 2], 512);
+		}
+
+		// Loops that would be only a few frames long are not downsampled
+		smp.nLoopStart = 100;
+		smp.nLoopEnd = 110;
+		VERIFY_EQUAL_NONCONT(ctrlSmp::Downsample2x(smp, sndFile), false);
+		VERIFY_EQUAL_NONCONT(smp.nLength, 500);
+		smp.nLoopEnd = 140;
+		VERIFY_EQUAL_NONCONT(ctrlSmp::Downsample2x(smp, sndFile), true);
+		VERIFY_EQUAL_NONCONT(smp.nLength, 250);
+
+		// Full-scale square wave followed by silence: clipping must not leak into the dither error
+		smp.FreeSample();
+		smp.nLength = 3000;
+		smp.nLoopStart = smp.nLoopEnd = 0;
+		smp.uFlags.reset(CHN_LOOP);
+		smp.uFlags.set(CHN_16BIT);
+		smp.AllocateSample();
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			if(i >= 2000)
+				smp.sample16()[i] = 0;
+			else
+				smp.sample16()[i] = ((i / 50) % 2) ? int16_min : int16_max;
+		}
+		VERIFY_EQUAL_NONCONT(ctrlSmp::ConvertTo8Bit(smp, sndFile), true);
+		bool squareOk = true;
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			const int8 expected = (i >= 2000) ? 0 : (((i / 50) % 2) ? int8_min : int8_max);
+			if(smp.sample8()[i] != expected)
+				squareOk = false;
+		}
+		VERIFY_EQUAL_NONCONT(squareOk, true);
+
+		sndFile.Destroy();
+	}
+}
+
+
+
+// Collects the output of CSoundFile::Read so that renders through different code paths can be compared
+class TestRenderTarget final : public IAudioTarget
+{
+public:
+	std::vector<double> output;
+
+	void Process(mpt::audio_span_interleaved<MixSampleInt> buffer) override { Append(buffer); }
+	void Process(mpt::audio_span_interleaved<MixSampleFloat> buffer) override { Append(buffer); }
+
+private:
+	template <typename Tspan>
+	void Append(Tspan buffer)
+	{
+		for(std::size_t frame = 0; frame < buffer.size_frames(); frame++)
+		{
+			for(std::size_t channel = 0; channel < buffer.size_channels(); channel++)
+			{
+				output.push_back(static_cast<double>(buffer(channel, frame)));
+			}
+		}
+	}
+};
+
+
+static std::vector<double> RenderSoundFile(CSoundFile &sndFile, samplecount_t frames)
+{
+	TestRenderTarget target;
+	while(frames > 0)
+	{
+		const samplecount_t rendered = sndFile.Read(std::min(frames, samplecount_t(1000)), target);
+		if(rendered == 0)
+			break;
+		frames -= rendered;
+	}
+	return std::move(target.output);
+}
+
+
+#ifndef MODPLUG_NO_FILESAVE
+
+static std::string SaveSoundFile(CSoundFile &sndFile)
+{
+	std::ostringstream f;
+	sndFile.m_dwLastSavedWithVersion = Version::Current();
+	sndFile.SaveIT(f, P_(""), false);
+	return f.str();
+}
+
+
+// Loads a module into a new CSoundFile, with settings applied before loading.
+// With deferSampleData, data must outlive the returned CSoundFile.
+static std::unique_ptr<CSoundFile> LoadSoundFile(const std::string &data, CSoundFile::ModLoadingFlags loadFlags = CSoundFile::loadCompleteModule, const std::function<void(CSoundFile &)> &settings = {})
+{
+	auto sndFile = std::make_unique<CSoundFile>();
+	if(settings)
+		settings(*sndFile);
+	FileReader file(mpt::byte_cast<mpt::const_byte_span>(mpt::as_span(data)));
+	VERIFY_EQUAL_NONCONT(sndFile->Create(file, loadFlags), true);
+	sndFile->InitPlayer(true);
+	return sndFile;
+}
+
+
+// Saves the module as MPTM and loads it into a new CSoundFile, with settings applied before loading
+static std::unique_ptr<CSoundFile> ReloadSoundFile(CSoundFile &sndFile, const std::function<void(CSoundFile &)> &settings = {})
+{
+	return LoadSoundFile(SaveSoundFile(sndFile), CSoundFile::loadCompleteModule, settings);
+}
+
+#endif // !MODPLUG_NO_FILESAVE
+
+
+// Verify that optional render paths produce the same output as the paths they replace
+static MPT_NOINLINE void TestRenderPaths()
+{
+#ifndef MODPLUG_NO_FILESAVE
+	// All kinds of sample offsets must refer to the same audio on samples that were downsampled to fit into the sample memory budget
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, 1);
+		sndFile.m_nSamples = 1;
+		ModSample &smp = sndFile.GetSample(1);
+		smp.Initialize(MOD_TYPE_MPT);
+		smp.nLength = 65536;
+		smp.nC5Speed = 44100;
+		smp.cues[0] = 16384;
+		smp.AllocateSample();
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			// Low-frequency content so that downsampling keeps the waveform intact
+			smp.sample8()[i] = static_cast<int8>(std::sin(i * 0.002) * 100.0 + (i >> 12));
+		}
+		sndFile.Patterns.Insert(0, 64);
+		sndFile.Order().assign(1, 0);
+		ModCommand &m = *sndFile.Patterns[0].GetpModCommand(0, 0);
+		m.note = NOTE_MIDDLEC;
+		m.instr = 1;
+
+		// The command is written after loading, as not all of the tested commands can be saved in a module
+		const auto setOffset = [&](ModCommand::VOLCMD volcmd, ModCommand::VOL vol, ModCommand::COMMAND command, ModCommand::PARAM param)
+		{
+			auto newSndFile = ReloadSoundFile(sndFile, [](CSoundFile &loadSndFile) { loadSndFile.SetSampleMemoryBudget(1); });
+			ModCommand &newM = *newSndFile->Patterns[0].GetpModCommand(0, 0);
+			newM.volcmd = volcmd;
+			newM.vol = vol;
+			newM.command = command;
+			newM.param = param;
+			return newSndFile;
+		};
+
+		const auto noOffset = setOffset(VOLCMD_NONE, 0, CMD_NONE, 0);
+		VERIFY_EQUAL_NONCONT(noOffset->IsSampleDownsampled(&noOffset->GetSample(1)), true);
+		VERIFY_EQUAL_NONCONT(noOffset->GetSample(1).nLength, 32768u);
+		VERIFY_EQUAL_NONCONT(noOffset->GetSample(1).cues[0], 8192u);
+		const auto reference = RenderSoundFile(*setOffset(VOLCMD_NONE, 0, CMD_OFFSET, 0x40), 4000);
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*noOffset, 4000), false);
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*setOffset(VOLCMD_OFFSET, 1, CMD_NONE, 0), 4000), true);
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*setOffset(VOLCMD_OFFSET, 0, CMD_OFFSET, 0x40), 4000), true);
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*setOffset(VOLCMD_NONE, 0, CMD_OFFSETPERCENTAGE, 0x40), 4000), true);
+
+		// Deferred samples have their final length and pitch right after loading, and sound like samples that were reduced while loading
+		const std::string data = SaveSoundFile(sndFile);
+		const auto lazy = LoadSoundFile(data, static_cast<CSoundFile::ModLoadingFlags>(CSoundFile::loadCompleteModule | CSoundFile::deferSampleData), [](CSoundFile &loadSndFile) { loadSndFile.SetSampleMemoryBudget(1); });
+		VERIFY_EQUAL_NONCONT(lazy->IsSampleDataDeferred(1), true);
+		VERIFY_EQUAL_NONCONT(lazy->IsSampleDownsampled(&lazy->GetSample(1)), true);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).nLength, 32768u);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).nC5Speed, noOffset->GetSample(1).nC5Speed);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).cues[0], 8192u);
+		VERIFY_EQUAL_NONCONT(RenderSoundFile(*lazy, 4000) == RenderSoundFile(*setOffset(VOLCMD_NONE, 0, CMD_NONE, 0), 4000), true);
+		VERIFY_EQUAL_NONCONT(lazy->IsSampleDataDeferred(1), false);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).nLength, 32768u);
+
+		sndFile.Destroy();
+	}
+
+	// Samples decoded on first use (deferSampleData) must sound exactly like samples decoded while loading
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, 4);
+		sndFile.m_nSamples = 6;
+		for(SAMPLEINDEX smp = 1; smp <= sndFile.GetNumSamples(); smp++)
+		{
+			ModSample &sample = sndFile.GetSample(smp);
+			sample.Initialize(MOD_TYPE_MPT);
+			sample.nLength = 2000 * smp;
+			sample.nC5Speed = 22050;
+			if(smp % 2)
+				sample.uFlags.set(CHN_16BIT);
+			if(smp % 3)
+			{
+				sample.nLoopStart = sample.nLength / 4;
+				sample.nLoopEnd = sample.nLength;
+				sample.uFlags.set(CHN_LOOP);
+			}
+			sample.AllocateSample();
+			for(SmpLength i = 0; i < sample.nLength; i++)
+			{
+				const double value = std::sin(i * 0.01 * smp) * (1.0 - 0.5 * i / sample.nLength);
+				if(sample.uFlags[CHN_16BIT])
+					sample.sample16()[i] = static_cast<int16>(value * 30000.0);
+				else
+					sample.sample8()[i] = static_cast<int8>(value * 120.0);
+			}
+		}
+		sndFile.Patterns.Insert(0, 64);
+		sndFile.Order().assign(1, 0);
+		for(ROWINDEX row = 0; row < 64; row++)
+		{
+			for(CHANNELINDEX chn = 0; chn < 4; chn++)
+			{
+				if((row * 3 + chn) % 5)
+					continue;
+				ModCommand &m = *sndFile.Patterns[0].GetpModCommand(row, chn);
+				m.note = static_cast<ModCommand::NOTE>(NOTE_MIDDLEC - 12 + (row % 24));
+				m.instr = static_cast<ModCommand::INSTR>(1 + (row + chn) % 5);
+			}
+		}
+
+		const std::string data = SaveSoundFile(sndFile);
+		const auto eager = LoadSoundFile(data);
+		const auto lazy = LoadSoundFile(data, static_cast<CSoundFile::ModLoadingFlags>(CSoundFile::loadCompleteModule | CSoundFile::deferSampleData));
+		VERIFY_EQUAL_NONCONT(eager->HasDeferredSamples(), false);
+		VERIFY_EQUAL_NONCONT(lazy->IsSampleDataDeferred(1), true);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).HasSampleData(), false);
+		const auto reference = RenderSoundFile(*eager, 350000);
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*lazy, 350000), true);
+		VERIFY_EQUAL_NONCONT(lazy->GetSample(1).HasSampleData(), true);
+		// Sample 6 is never played
+		VERIFY_EQUAL_NONCONT(lazy->IsSampleDataDeferred(6), true);
+
+		// The file data may go away after loading if the deferred samples have their own copy
+		std::string tempData = data;
+		const auto lazyCopy = LoadSoundFile(tempData, static_cast<CSoundFile::ModLoadingFlags>(CSoundFile::loadCompleteModule | CSoundFile::deferSampleData));
+		lazyCopy->CopyDeferredSampleData();
+		std::fill(tempData.begin(), tempData.end(), '\0');
+		tempData.clear();
+		tempData.shrink_to_fit();
+		VERIFY_EQUAL_NONCONT(reference == RenderSoundFile(*lazyCopy, 350000), true);
+		// Decoding the remaining samples releases the copy
+		for(SAMPLEINDEX smp = 1; smp <= lazyCopy->GetNumSamples(); smp++)
+			lazyCopy->DecodeDeferredSample(smp);
+		VERIFY_EQUAL_NONCONT(lazyCopy->HasDeferredSamples(), false);
+		VERIFY_EQUAL_NONCONT(lazyCopy->GetSample(6).HasSampleData(), true);
+
+		// Deferred samples are fitted into the sample memory budget while loading, and decoding one does not change any other sample
+		const size_t budget = eager->GetSampleMemoryUsage() * 3 / 4;
+		const auto lazyBudget = LoadSoundFile(data, static_cast<CSoundFile::ModLoadingFlags>(CSoundFile::loadCompleteModule | CSoundFile::deferSampleData), [budget](CSoundFile &loadSndFile) { loadSndFile.SetSampleMemoryBudget(budget); });
+		lazyBudget->DecodeDeferredSample(1);
+		const void *firstSampleData = lazyBudget->GetSample(1).samplev();
+		for(SAMPLEINDEX smp = 2; smp <= lazyBudget->GetNumSamples(); smp++)
+			lazyBudget->DecodeDeferredSample(smp);
+		VERIFY_EQUAL_NONCONT(lazyBudget->GetSample(1).samplev(), firstSampleData);
+		VERIFY_EQUAL_NONCONT(lazyBudget->GetSampleMemoryUsage() <= budget, true);
+		VERIFY_EQUAL_NONCONT(lazyBudget->GetSample(5).GetElementarySampleSize(), 1);
+
+		sndFile.Destroy();
+	}
+
+#if MPT_IO_READ_FILEDATA_MMAP && defined(MPT_ENABLE_MAPPED_SAMPLES)
+	// Sample data mapped from the module file must sound exactly like sample data that was copied into memory
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, 3);
+		sndFile.m_nSamples = 3;
+		for(SAMPLEINDEX smp = 1; smp <= sndFile.GetNumSamples(); smp++)
+		{
+			ModSample &sample = sndFile.GetSample(smp);
+			sample.Initialize(MOD_TYPE_MPT);
+			sample.nC5Speed = 22050;
+			sample.nLoopStart = 1000;
+			sample.uFlags.set(CHN_LOOP);
+		}
+		// Mapped: Uncompressed mono data. 8-bit, as 16-bit data is not mapped from odd file offsets.
+		sndFile.GetSample(1).nLength = 80000;
+		// Copied: Stereo samples are not interleaved in IT files
+		sndFile.GetSample(2).nLength = 40000;
+		sndFile.GetSample(2).uFlags.set(CHN_16BIT | CHN_STEREO);
+		// Copied: Too small to be worth mapping
+		sndFile.GetSample(3).nLength = 3000;
+		for(SAMPLEINDEX smp = 1; smp <= sndFile.GetNumSamples(); smp++)
+		{
+			ModSample &sample = sndFile.GetSample(smp);
+			sample.nLoopEnd = sample.nLength;
+			sample.AllocateSample();
+			const SmpLength numValues = sample.nLength * sample.GetNumChannels();
+			for(SmpLength i = 0; i < numValues; i++)
+			{
+				const double value = std::sin(i * 0.013 * smp) * (1.0 - 0.5 * i / numValues);
+				if(sample.uFlags[CHN_16BIT])
+					sample.sample16()[i] = static_cast<int16>(value * 30000.0);
+				else
+					sample.sample8()[i] = static_cast<int8>(value * 120.0);
+			}
+		}
+		sndFile.Patterns.Insert(0, 64);
+		sndFile.Order().assign(1, 0);
+		for(CHANNELINDEX chn = 0; chn < 3; chn++)
+		{
+			ModCommand &m = *sndFile.Patterns[0].GetpModCommand(chn * 4, chn);
+			m.note = static_cast<ModCommand::NOTE>(NOTE_MIDDLEC + chn * 5);
+			m.instr = static_cast<ModCommand::INSTR>(chn + 1);
+		}
+
+		const std::string data = SaveSoundFile(sndFile);
+		const mpt::PathString filename = GetTempFilenameBase() + P_("mapped.mptm");
+		{
+			mpt::IO::ofstream f(filename, std::ios::binary);
+			f.write(data.data(), data.size());
+		}
+
+		const auto copied = LoadSoundFile(data);
+		auto mapped = std::make_unique<CSoundFile>();
+		{
+			auto mapping = std::make_shared<mpt::IO::FileDataMMap>(filename.AsNative().c_str(), true);
+			VERIFY_EQUAL_NONCONT(mapping->IsValid(), true);
+			SampleMappingSource source;
+			source.fd = mapping->GetFileDescriptor();
+			source.data = mapping->GetRawData();
+			source.size = mapping->GetLength();
+			mapped->SetSampleMappingSource(source);
+			VERIFY_EQUAL_NONCONT(mapped->Create(FileReader(std::static_pointer_cast<const mpt::IO::IFileData>(mapping)), CSoundFile::loadCompleteModule), true);
+			mapped->SetSampleMappingSource(SampleMappingSource());
+		}
+		mapped->InitPlayer(true);
+		RemoveFile(filename);
+
+		VERIFY_EQUAL_NONCONT(mapped->GetSample(1).HasMappedSampleData(), true);
+		VERIFY_EQUAL_NONCONT(mapped->GetSample(2).HasMappedSampleData(), false);
+		VERIFY_EQUAL_NONCONT(mapped->GetSample(3).HasMappedSampleData(), false);
+		VERIFY_EQUAL_NONCONT(copied->GetSample(1).HasMappedSampleData(), false);
+		VERIFY_EQUAL_NONCONT(RenderSoundFile(*copied, 200000) == RenderSoundFile(*mapped, 200000), true);
+
+		sndFile.Destroy();
+	}
+#endif // MPT_IO_READ_FILEDATA_MMAP && MPT_ENABLE_MAPPED_SAMPLES
+
+	// Skipping the mixer for silent chunks must not change the output, including reverb, surround and plugin tails that ring into the silence
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, 3);
+		sndFile.m_nSamples = 1;
+		ModSample &smp = sndFile.GetSample(1);
+		smp.Initialize(MOD_TYPE_MPT);
+		smp.nLength = 4000;
+		smp.nC5Speed = 22050;
+		smp.uFlags.set(CHN_16BIT);
+		smp.AllocateSample();
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			smp.sample16()[i] = static_cast<int16>(std::sin(i * 0.07) * 20000.0 * (smp.nLength - i) / smp.nLength);
+		}
+		sndFile.ChnSettings[1].dwFlags.set(CHN_SURROUND);
+#ifndef NO_PLUGINS
+		SNDMIXPLUGIN &mixPlugin = sndFile.m_MixPlugins[0];
+		mixPlugin.Info.dwPluginId1 = kDmoMagic;
+		mixPlugin.Info.dwPluginId2 = int32(0xEF3E932C);
+		mixPlugin.Info.szLibraryName = "Echo";
+		mixPlugin.Info.szName = "Echo";
+		mixPlugin.SetAutoSuspend();
+		VERIFY_EQUAL_NONCONT(CreateMixPluginProc(mixPlugin, sndFile), true);
+		if(mixPlugin.pMixPlugin)
+			mixPlugin.pMixPlugin->SetParameter(1, 0.0f);  // No feedback, so that the plugin gets suspended within the silent stretch
+		sndFile.ChnSettings[2].nMixPlugin = 1;
+#endif // !NO_PLUGINS
+		sndFile.Patterns.Insert(0, 160);
+		sndFile.Order().assign(1, 0);
+		for(ROWINDEX row : {ROWINDEX(0), ROWINDEX(100)})
+		{
+			for(CHANNELINDEX chn = 0; chn < 3; chn++)
+			{
+				ModCommand &m = *sndFile.Patterns[0].GetpModCommand(row + chn * 4, chn);
+				m.note = NOTE_MIDDLEC;
+				m.instr = 1;
+			}
+		}
+
+		const std::string data = SaveSoundFile(sndFile);
+		const auto render = [&data](bool skipSilentChunks)
+		{
+			auto renderSndFile = LoadSoundFile(data);
+			MixerSettings mixerSettings = renderSndFile->m_MixerSettings;
+			mixerSettings.gnChannels = 4;
+			mixerSettings.DSPMask |= SNDDSP_REVERB;
+			renderSndFile->SetMixerSettings(mixerSettings);
+			renderSndFile->SetSkipSilentChunks(skipSilentChunks);
+			renderSndFile->InitPlayer(true);
+			renderSndFile->SuspendPlugins();
+			renderSndFile->ResumePlugins();
+#ifdef MPT_ENABLE_RENDER_PROFILE
+			renderSndFile->m_RenderProfile.SetEnabled(true);
+#endif
+			auto output = RenderSoundFile(*renderSndFile, 900000);
+#ifdef MPT_ENABLE_RENDER_PROFILE
+			VERIFY_EQUAL_NONCONT(renderSndFile->m_RenderProfile.GetSilentChunks() > 0, skipSilentChunks);
+#endif
+			return output;
+		};
+		const auto fullMix = render(false);
+		VERIFY_EQUAL_NONCONT(std::any_of(fullMix.begin(), fullMix.end(), [](double v) { return v != 0.0; }), true);
+		VERIFY_EQUAL_NONCONT(fullMix == render(true), true);
+
+		sndFile.Destroy();
+	}
+
+#ifdef MPT_ENABLE_MIX_THREADS
+	// Every task of a batch runs exactly once, also with fewer tasks than threads and when workers have gone to sleep between batches
+	{
+		MixThreadPool pool(4);
+		std::vector<std::atomic<uint32>> counts(64);
+		bool allTasksRanOnce = true;
+		for(uint32 batch = 0; batch < 500; batch++)
+		{
+			const uint32 numTasks = 2 + batch % 63;
+			for(auto &count : counts)
+			{
+				count = 0;
+			}
+			if(batch % 100 == 0)
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			pool.Run(numTasks, [&counts](uint32 task) { counts[task]++; });
+			for(uint32 task = 0; task < counts.size(); task++)
+			{
+				if(counts[task] != (task < numTasks ? 1u : 0u))
+					allTasksRanOnce = false;
+			}
+		}
+		VERIFY_EQUAL_NONCONT(allTasksRanOnce, true);
+	}
+
+	// Mixing voices on several threads must produce the same output as mixing them on one thread, also with more voices than scratch buffers
+	{
+		constexpr CHANNELINDEX numChannels = 40;
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, numChannels);
+		sndFile.m_nSamples = 2;
+		for(SAMPLEINDEX smp = 1; smp <= 2; smp++)
+		{
+			ModSample &sample = sndFile.GetSample(smp);
+			sample.Initialize(MOD_TYPE_MPT);
+			sample.nLength = 3000 * smp;
+			sample.nC5Speed = 11025 * smp;
+			if(smp == 2)
+			{
+				sample.uFlags.set(CHN_16BIT | CHN_LOOP);
+				sample.nLoopStart = 1000;
+				sample.nLoopEnd = sample.nLength;
+			}
+			sample.AllocateSample();
+			for(SmpLength i = 0; i < sample.nLength; i++)
+			{
+				const double value = std::sin(i * 0.03 * smp) * (1.0 - 0.5 * i / sample.nLength);
+				if(sample.uFlags[CHN_16BIT])
+					sample.sample16()[i] = static_cast<int16>(value * 20000.0);
+				else
+					sample.sample8()[i] = static_cast<int8>(value * 100.0);
+			}
+		}
+		for(CHANNELINDEX chn = 0; chn < numChannels; chn += 3)
+		{
+			sndFile.ChnSettings[chn].dwFlags.set(CHN_SURROUND);
+		}
+		sndFile.Patterns.Insert(0, 64);
+		sndFile.Order().assign(1, 0);
+		for(ROWINDEX row = 0; row < 64; row += 4)
+		{
+			for(CHANNELINDEX chn = 0; chn < numChannels; chn++)
+			{
+				ModCommand &m = *sndFile.Patterns[0].GetpModCommand(row + chn % 4, chn);
+				m.note = static_cast<ModCommand::NOTE>(NOTE_MIDDLEC - 12 + (row + chn) % 24);
+				m.instr = static_cast<ModCommand::INSTR>(1 + chn % 2);
+				m.volcmd = VOLCMD_PANNING;
+				m.vol = static_cast<ModCommand::VOL>((chn * 7) % 65);
+			}
+		}
+
+		const std::string data = SaveSoundFile(sndFile);
+		const auto render = [&data](uint32 mixThreads)
+		{
+			auto renderSndFile = LoadSoundFile(data);
+			MixerSettings mixerSettings = renderSndFile->m_MixerSettings;
+			mixerSettings.gnChannels = 4;
+			mixerSettings.DSPMask |= SNDDSP_REVERB;
+			renderSndFile->SetMixerSettings(mixerSettings);
+			renderSndFile->SetMixThreads(mixThreads);
+			VERIFY_EQUAL_NONCONT(renderSndFile->GetMixThreads(), mixThreads);
+			renderSndFile->InitPlayer(true);
+			return RenderSoundFile(*renderSndFile, 100000);
+		};
+		const auto singleThreaded = render(1);
+		VERIFY_EQUAL_NONCONT(std::any_of(singleThreaded.begin(), singleThreaded.end(), [](double v) { return v != 0.0; }), true);
+#ifdef MPT_INTMIXER
+		// The floating-point mixer may round the end-of-sample pop reduction differently
+		VERIFY_EQUAL_NONCONT(singleThreaded == render(2), true);
+		VERIFY_EQUAL_NONCONT(singleThreaded == render(4), true);
+#endif
+
+		sndFile.Destroy();
+	}
+
+	// Decoding compressed MO3 samples on several threads must produce the same samples as decoding them on one thread
+	{
+		struct TestSample
+		{
+			uint16 flags;
+			uint32 length;
+			int32 compressedSize;
+		};
+		// Delta and delta prediction compression in all sample formats, an uncompressed sample and a duplicate of sample 2
+		const TestSample testSamples[] =
+		{
+			{0x2000, 7000, 2000},
+			{0x2000 | 0x01, 6000, 3000},
+			{0x4000 | 0x01 | 0x400, 5000, 4000},
+			{0x4000, 4000, 1000},
+			{0x00, 500, 0},
+			{0x2000 | 0x01, 6000, -4},
+		};
+
+		const auto write8 = [](std::string &s, uint32 value) { s.push_back(static_cast<char>(value & 0xFF)); };
+		const auto write16 = [&write8](std::string &s, uint32 value) { write8(s, value); write8(s, value >> 8); };
+		const auto write32 = [&write16](std::string &s, uint32 value) { write16(s, value); write16(s, value >> 16); };
+		std::string music;
+		music.append(2, '\0');  // Song name and message
+		write8(music, 1);  // Channels
+		write16(music, 0);  // Orders
+		write16(music, 0);  // Restart position
+		write16(music, 0);  // Patterns
+		write16(music, 0);  // Tracks
+		write16(music, 0);  // Instruments
+		write16(music, static_cast<uint32>(std::size(testSamples)));
+		write8(music, 6);  // Speed
+		write8(music, 125);  // Tempo
+		write32(music, 0x20000 | 0x100);  // IT module
+		write8(music, 128);  // Global volume
+		write8(music, 128);  // Pan separation
+		write8(music, 0);  // Sample volume
+		music.append(64, '\x40');  // Channel volume
+		music.append(64, '\x20');  // Channel panning
+		music.append(16 + 128 * 2, '\0');  // Macros
+		for(const auto &smp : testSamples)
+		{
+			music.append(2, '\0');  // Sample name and file name
+			write32(music, 8363);
+			write8(music, 0);  // Transpose
+			write8(music, 64);  // Volume
+			write16(music, 0xFFFF);  // Panning
+			write32(music, smp.length);
+			write32(music, 0);  // Loop start
+			write32(music, 0);  // Loop end
+			write16(music, smp.flags);
+			write32(music, 0);  // Auto vibrato
+			write8(music, 64);  // Global volume
+			write32(music, 0);  // Sustain loop start
+			write32(music, 0);  // Sustain loop end
+			write32(music, static_cast<uint32>(smp.compressedSize));
+			write16(music, 0);  // Encoder delay
+		}
+
+		// Store the music data as literals: The first byte is always stored verbatim, then every control byte is followed by eight bytes
+		std::string compressed(1, music[0]);
+		for(std::size_t i = 1; i < music.size(); i += 8)
+		{
+			compressed.push_back('\0');
+			compressed.append(music, i, 8);
+		}
+
+		std::string data = "MO3\x05";
+		write32(data, static_cast<uint32>(music.size()));
+		write32(data, static_cast<uint32>(compressed.size()));
+		data.append(compressed);
+		// The compressed sample data is pseudo-random; any input decodes to some deterministic sample data
+		uint32 seed = 0x12345678;
+		for(const auto &smp : testSamples)
+		{
+			const uint32 numBytes = (smp.compressedSize > 0) ? static_cast<uint32>(smp.compressedSize) : (smp.compressedSize == 0 ? smp.length : 0);
+			for(uint32 i = 0; i < numBytes; i++)
+			{
+				seed = seed * 1103515245u + 12345u;
+				write8(data, seed >> 24);
+			}
+		}
+
+		const auto load = [&data](uint32 decodeThreads)
+		{
+			return LoadSoundFile(data, CSoundFile::loadCompleteModule, [decodeThreads](CSoundFile &sndFile) { sndFile.SetSampleDecodeThreads(decodeThreads); });
+		};
+		const auto singleThreaded = load(1);
+		const auto multiThreaded = load(4);
+		VERIFY_EQUAL_NONCONT(singleThreaded->GetType(), MOD_TYPE_IT);
+		VERIFY_EQUAL_NONCONT(multiThreaded->GetSampleDecodeThreads(), 4u);
+		VERIFY_EQUAL_NONCONT(singleThreaded->GetNumSamples(), static_cast<SAMPLEINDEX>(std::size(testSamples)));
+		VERIFY_EQUAL_NONCONT(multiThreaded->GetNumSamples(), static_cast<SAMPLEINDEX>(std::size(testSamples)));
+		for(SAMPLEINDEX smp = 1; smp <= singleThreaded->GetNumSamples(); smp++)
+		{
+			const ModSample &expected = singleThreaded->GetSample(smp);
+			const ModSample &actual = multiThreaded->GetSample(smp);
+			VERIFY_EQUAL_NONCONT(expected.HasSampleData(), true);
+			VERIFY_EQUAL_NONCONT(actual.nLength, expected.nLength);
+			VERIFY_EQUAL_NONCONT(actual.GetElementarySampleSize(), expected.GetElementarySampleSize());
+			VERIFY_EQUAL_NONCONT(actual.GetNumChannels(), expected.GetNumChannels());
+			const auto expectedData = mpt::as_span(static_cast<const std::byte *>(expected.samplev()), expected.GetSampleSizeInBytes());
+			const auto actualData = mpt::as_span(static_cast<const std::byte *>(actual.samplev()), actual.GetSampleSizeInBytes());
+			VERIFY_EQUAL_NONCONT(std::equal(expectedData.begin(), expectedData.end(), actualData.begin(), actualData.end()), true);
+			VERIFY_EQUAL_NONCONT(std::any_of(expectedData.begin(), expectedData.end(), [](std::byte b) { return b != std::byte{}; }), true);
+		}
+		VERIFY_EQUAL_NONCONT(multiThreaded->GetSample(6).nLength, multiThreaded->GetSample(2).nLength);
+		VERIFY_EQUAL_NONCONT(std::memcmp(multiThreaded->GetSample(6).samplev(), multiThreaded->GetSample(2).samplev(), multiThreaded->GetSample(2).GetSampleSizeInBytes()), 0);
+	}
+#endif // MPT_ENABLE_MIX_THREADS
+#endif // !MODPLUG_NO_FILESAVE
+
+	// Rendering the OPL3 emulator in blocks must produce the same output as generating one frame at a time
+	{
+		using Opal = OpalTest::OPENMPT_NAMESPACE::Opal;
+		mpt::default_prng &prng = *s_PRNG;
+		static constexpr std::size_t blockSizes[] = {1, 3, 17, 255, 256, 257, 1001};
+		for(int sampleRate : {11025, 44100, 49716, 96000})
+		{
+			const auto blockOpal = std::make_unique<Opal>(sampleRate);
+			const auto sampleOpal = std::make_unique<Opal>(sampleRate);
+			std::vector<int16> blockOutput, sampleOutput;
+			bool identical = true, audible = false;
+			for(std::size_t round = 0; round < 100; round++)
+			{
+				for(int write = 0; write < 16; write++)
+				{
+					const uint16 reg = mpt::random<uint16>(prng) & 0x1FF;
+					const uint8 value = mpt::random<uint8>(prng);
+					blockOpal->Port(reg, value);
+					sampleOpal->Port(reg, value);
+				}
+				const std::size_t frames = blockSizes[round % std::size(blockSizes)];
+				blockOutput.assign(frames * 2, 0);
+				sampleOutput.assign(frames * 2, 0);
+				blockOpal->Render(blockOutput.data(), frames);
+				for(std::size_t frame = 0; frame < frames; frame++)
+				{
+					sampleOpal->Sample(&sampleOutput[frame * 2], &sampleOutput[frame * 2 + 1]);
+				}
+				if(blockOutput != sampleOutput)
+					identical = false;
+				if(std::any_of(sampleOutput.begin(), sampleOutput.end(), [](int16 v) { return v != 0; }))
+					audible = true;
+			}
+			VERIFY_EQUAL_NONCONT(identical, true);
+			VERIFY_EQUAL_NONCONT(audible, true);
+		}
+	}
 }
 
 
@@ -4025,6 +4900,888 @@ static void RunITCompressionTest(const std::vector<int8> &sampleData, FlagSet<Ch
 }
 
 
+#if defined(LIBOPENMPT_BUILD) && !defined(MODPLUG_NO_FILESAVE)
+
+namespace
+{
+
+class CountingSubsongCache : public openmpt::subsong_cache
+{
+public:
+	std::map<std::string, std::string> entries;
+	int lookups = 0, hits = 0, stores = 0;
+
+	bool lookup(const std::string &key, std::string &value) override
+	{
+		lookups++;
+		auto it = entries.find(key);
+		if(it == entries.end())
+			return false;
+		hits++;
+		value = it->second;
+		return true;
+	}
+	void store(const std::string &key, const std::string &value) override
+	{
+		stores++;
+		entries[key] = value;
+	}
+	void invalidate(const std::string &key) override
+	{
+		if(key.empty())
+			entries.clear();
+		else
+			entries.erase(key);
+	}
+};
+
+static std::string SaveSubsongCacheTestModule(ROWINDEX rows)
+{
+	mpt::heap_value<CSoundFile> pSndFile;
+	CSoundFile &sndFile = *pSndFile;
+	sndFile.Create(MOD_TYPE_MPT, 1);
+	sndFile.Patterns.Insert(0, rows);
+	sndFile.Patterns.Insert(1, 64);
+	// Two sequences separated by a stop marker yield two subsongs
+	sndFile.Order().assign(3, 0);
+	sndFile.Order()[1] = PATTERNINDEX_INVALID;
+	sndFile.Order()[2] = 1;
+	return SaveSoundFile(sndFile);
+}
+
+}  // namespace
+
+#endif // LIBOPENMPT_BUILD && !MODPLUG_NO_FILESAVE
+
+
+// Verify that the subsong cache is queried, filled and invalidated as documented
+static MPT_NOINLINE void TestSubsongCache()
+{
+#if defined(LIBOPENMPT_BUILD) && !defined(MODPLUG_NO_FILESAVE)
+	const std::string data = SaveSubsongCacheTestModule(32);
+	const std::string otherData = SaveSubsongCacheTestModule(48);
+
+	auto cache = std::make_shared<CountingSubsongCache>();
+	openmpt::set_subsong_cache(cache);
+
+	// Miss, then store
+	double duration;
+	{
+		openmpt::module mod(data.data(), data.size());
+		VERIFY_EQUAL(mod.get_num_subsongs(), 2);
+		duration = mod.get_duration_seconds();
+		VERIFY_EQUAL(cache->lookups, 1);
+		VERIFY_EQUAL(cache->hits, 0);
+		VERIFY_EQUAL(cache->stores, 1);
+		VERIFY_EQUAL(cache->entries.count(openmpt::get_subsong_cache_key(data.data(), data.size())), 1u);
+	}
+
+	// Hit, with the same results as the simulated pass
+	{
+		openmpt::module mod(data.data(), data.size());
+		VERIFY_EQUAL(mod.get_num_subsongs(), 2);
+		VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+		mod.select_subsong(1);
+		VERIFY_EQUAL(mod.get_duration_seconds() > 0.0, true);
+		VERIFY_EQUAL(cache->lookups, 2);
+		VERIFY_EQUAL(cache->hits, 1);
+		VERIFY_EQUAL(cache->stores, 1);
+	}
+
+	// Different file contents miss
+	{
+		openmpt::module mod(otherData.data(), otherData.size());
+		VERIFY_EQUAL(mod.get_duration_seconds() > duration, true);
+		VERIFY_EQUAL(cache->lookups, 3);
+		VERIFY_EQUAL(cache->hits, 1);
+		VERIFY_EQUAL(cache->stores, 2);
+	}
+
+	// Invalidated entries miss again
+	openmpt::invalidate_subsong_cache(openmpt::get_subsong_cache_key(data.data(), data.size()));
+	VERIFY_EQUAL(cache->entries.size(), 1u);
+	{
+		openmpt::module mod(data.data(), data.size());
+		VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+		VERIFY_EQUAL(cache->lookups, 4);
+		VERIFY_EQUAL(cache->hits, 1);
+		VERIFY_EQUAL(cache->stores, 3);
+	}
+	openmpt::invalidate_subsong_cache();
+	VERIFY_EQUAL(cache->entries.size(), 0u);
+
+	// Seekable streams bypass the cache
+	{
+		std::istringstream stream(data);
+		openmpt::module mod(stream);
+		VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+		VERIFY_EQUAL(cache->lookups, 4);
+		VERIFY_EQUAL(cache->stores, 3);
+	}
+
+	// Entries with positions that do not exist in the module are rejected and replaced
+	{
+		const std::string key = openmpt::get_subsong_cache_key(data.data(), data.size());
+		{
+			openmpt::module mod(data.data(), data.size());
+		}
+		const std::string valid = cache->entries[key];
+		const std::string prefix = valid.substr(0, valid.find('|') + 1);
+		// Order 0 has 32 rows, the first sequence has 3 orders
+		for(const char *entry : {"1 0 4 0 0 0", "1 32 0 0 0 0", "1 -1 0 0 0 0", "1 0 0 0 0 7", "1 0 0 0 32 0", "1 0 0 0 1 3"})
+		{
+			cache->entries[key] = prefix + entry + ";" + valid.substr(prefix.size());
+			openmpt::module mod(data.data(), data.size());
+			VERIFY_EQUAL(mod.get_num_subsongs(), 2);
+			VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+			VERIFY_EQUAL(cache->entries[key], valid);
+		}
+		// Unknown restart positions and the end of the sequence are accepted
+		cache->entries[key] = prefix + "1 31 0 0 -1 65535;1 0 3 0 0 3";
+		{
+			openmpt::module mod(data.data(), data.size());
+			VERIFY_EQUAL(mod.get_num_subsongs(), 2);
+			VERIFY_EQUAL(mod.get_duration_seconds(), 1.0);
+		}
+		openmpt::invalidate_subsong_cache();
+	}
+
+	// The same through the C callbacks, which must hand back values of any length intact
+	{
+		struct CallbackCache
+		{
+			std::map<std::string, std::string> entries;
+			int hits = 0, stores = 0;
+		} callbackCache;
+		auto lookup = [](void *user, const char *key, char *value, size_t value_size) -> size_t
+		{
+			auto &self = *static_cast<CallbackCache *>(user);
+			auto it = self.entries.find(key);
+			if(it == self.entries.end())
+				return 0;
+			self.hits++;
+			if(it->second.size() + 1 <= value_size)
+				std::copy(it->second.c_str(), it->second.c_str() + it->second.size() + 1, value);
+			return it->second.size() + 1;
+		};
+		auto store = [](void *user, const char *key, const char *value)
+		{
+			auto &self = *static_cast<CallbackCache *>(user);
+			self.stores++;
+			self.entries[key] = value;
+		};
+		VERIFY_EQUAL(openmpt_subsong_cache_set_callbacks(lookup, store, nullptr, &callbackCache), 1);
+		{
+			openmpt::module mod(data.data(), data.size());
+		}
+		VERIFY_EQUAL(callbackCache.stores, 1);
+		{
+			openmpt::module mod(data.data(), data.size());
+			VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+		}
+		// Values that do not fit into the initial lookup buffer are queried a second time
+		VERIFY_EQUAL(callbackCache.hits, callbackCache.entries.begin()->second.size() + 1 > 256 ? 2 : 1);
+		VERIFY_EQUAL(callbackCache.stores, 1);
+	}
+
+	// The default file cache persists entries, drops superseded lines when loading the file and keeps at most 4096 entries
+	{
+		const mpt::PathString filename = GetTempFilenameBase() + P_("subsongcache.txt");
+		const std::string path = filename.ToUTF8();
+		RemoveFile(filename);
+		const auto countLines = [&filename]()
+		{
+			mpt::IO::ifstream f(filename, std::ios::binary);
+			std::size_t lines = 0;
+			std::string line;
+			while(std::getline(f, line))
+				lines++;
+			return lines;
+		};
+		const std::string key = openmpt::get_subsong_cache_key(data.data(), data.size());
+		std::string value;
+
+		openmpt::set_subsong_cache(openmpt::create_subsong_cache_file(path));
+		{
+			openmpt::module mod(data.data(), data.size());
+		}
+		VERIFY_EQUAL(openmpt::get_subsong_cache()->lookup(key, value), true);
+		openmpt::get_subsong_cache()->store("superseded", "1");
+		openmpt::get_subsong_cache()->store("superseded", "2");
+		VERIFY_EQUAL(countLines(), 3u);
+		openmpt::set_subsong_cache(nullptr);
+
+		auto cache = openmpt::create_subsong_cache_file(path);
+		VERIFY_EQUAL(countLines(), 2u);
+		std::string reloadedValue;
+		VERIFY_EQUAL(cache->lookup(key, reloadedValue), true);
+		VERIFY_EQUAL(reloadedValue, value);
+		VERIFY_EQUAL(cache->lookup("superseded", reloadedValue), true);
+		VERIFY_EQUAL(reloadedValue, "2");
+		openmpt::set_subsong_cache(cache);
+		{
+			openmpt::module mod(data.data(), data.size());
+			VERIFY_EQUAL(mod.get_duration_seconds(), duration);
+		}
+		openmpt::set_subsong_cache(nullptr);
+
+		constexpr std::size_t maxEntries = 4096;
+		for(std::size_t i = 0; i < maxEntries; i++)
+		{
+			cache->store("entry" + std::to_string(i), "value");
+		}
+		VERIFY_EQUAL(countLines(), maxEntries);
+		VERIFY_EQUAL(cache->lookup(key, reloadedValue), false);
+		VERIFY_EQUAL(cache->lookup("superseded", reloadedValue), false);
+		VERIFY_EQUAL(cache->lookup("entry0", reloadedValue), true);
+		cache = openmpt::create_subsong_cache_file(path);
+		VERIFY_EQUAL(cache->lookup("entry0", reloadedValue), true);
+		cache->store("entry" + std::to_string(maxEntries), "value");
+		VERIFY_EQUAL(countLines(), maxEntries);
+		VERIFY_EQUAL(cache->lookup("entry0", reloadedValue), false);
+		VERIFY_EQUAL(cache->lookup("entry1", reloadedValue), true);
+		VERIFY_EQUAL(cache->lookup("entry" + std::to_string(maxEntries), reloadedValue), true);
+		cache = nullptr;
+		RemoveFile(filename);
+	}
+
+	openmpt::set_subsong_cache(nullptr);
+#endif // LIBOPENMPT_BUILD && !MODPLUG_NO_FILESAVE
+}
+
+
+#if defined(LIBOPENMPT_BUILD)
+
+namespace
+{
+
+static std::vector<float> RenderModule(openmpt_module *mod)
+{
+	VERIFY_EQUAL_NONCONT(mod != nullptr, true);
+	std::vector<float> output;
+	if(mod == nullptr)
+		return output;
+	std::vector<float> buffer(1024 * 2);
+	for(int chunk = 0; chunk < 64; chunk++)
+	{
+		const size_t frames = openmpt_module_read_interleaved_float_stereo(mod, 48000, buffer.size() / 2, buffer.data());
+		output.insert(output.end(), buffer.begin(), buffer.begin() + frames * 2);
+	}
+	openmpt_module_destroy(mod);
+	return output;
+}
+
+}  // namespace
+
+#endif // LIBOPENMPT_BUILD
+
+
+// Verify that loading a module from a file name or a memory-mapped stream produces the same module as loading it from memory
+static MPT_NOINLINE void TestModuleFileLoading()
+{
+#if defined(LIBOPENMPT_BUILD)
+	for(const auto &extension : {P_("mptm"), P_("xm"), P_("s3m"), P_("mod")})
+	{
+		const mpt::PathString filename = GetTestFilenameBase() + extension;
+		mpt::IO::ifstream f(filename, std::ios::binary);
+		if(!f)
+			continue;
+		const std::vector<char> data{std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>()};
+		const std::string utf8Filename = filename.ToUTF8();
+
+		const std::vector<float> reference = RenderModule(openmpt_module_create_from_memory2(data.data(), data.size(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+		VERIFY_EQUAL_NONCONT(reference.empty(), false);
+		VERIFY_EQUAL_NONCONT(reference == RenderModule(openmpt_module_create_from_file(utf8Filename.c_str(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr)), true);
+		const openmpt_module_initial_ctl mapSampleData[] = {{"load.map_sample_data", "1"}, {nullptr, nullptr}};
+		VERIFY_EQUAL_NONCONT(reference == RenderModule(openmpt_module_create_from_file(utf8Filename.c_str(), nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, mapSampleData)), true);
+
+#if !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+		openmpt_stream_mmap stream;
+		VERIFY_EQUAL_NONCONT(openmpt_stream_mmap_open(&stream, filename.AsNative().c_str()), 0);
+		openmpt_module *mod = openmpt_module_create2(openmpt_stream_get_mmap_callbacks(), &stream, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+		// The module must not reference the mapping after it has been created
+		openmpt_stream_mmap_close(&stream);
+		VERIFY_EQUAL_NONCONT(reference == RenderModule(mod), true);
+#endif // !MPT_OS_WINDOWS && !MPT_OS_DJGPP
+	}
+
+	// Missing files are reported as errors
+	int error = OPENMPT_ERROR_OK;
+	const std::string missingFilename = (GetTempFilenameBase() + P_("missing.it")).ToUTF8();
+	VERIFY_EQUAL_NONCONT(openmpt_module_create_from_file(missingFilename.c_str(), nullptr, nullptr, nullptr, nullptr, &error, nullptr, nullptr) == nullptr, true);
+	VERIFY_EQUAL_NONCONT(error != OPENMPT_ERROR_OK, true);
+#endif // LIBOPENMPT_BUILD
+}
+
+
+// Verify that the profile.enabled and profile.report ctls produce a complete report of the rendered audio
+static MPT_NOINLINE void TestRenderProfile()
+{
+#if defined(LIBOPENMPT_BUILD) && !defined(MODPLUG_NO_FILESAVE)
+	// A looped note from the first row on, so that there is always a voice to mix
+	std::string data;
+	{
+		mpt::heap_value<CSoundFile> pSndFile;
+		CSoundFile &sndFile = *pSndFile;
+		sndFile.Create(MOD_TYPE_MPT, 1);
+		sndFile.m_nSamples = 1;
+		ModSample &smp = sndFile.GetSample(1);
+		smp.Initialize(MOD_TYPE_MPT);
+		smp.nLength = 64;
+		smp.nLoopStart = 0;
+		smp.nLoopEnd = smp.nLength;
+		smp.uFlags.set(CHN_16BIT | CHN_LOOP);
+		smp.AllocateSample();
+		for(SmpLength i = 0; i < smp.nLength; i++)
+		{
+			smp.sample16()[i] = static_cast<int16>(std::sin(i * 2.0 * mpt::numbers::pi / smp.nLength) * 20000.0);
+		}
+		sndFile.Patterns.Insert(0, 64);
+		sndFile.Order().assign(1, 0);
+		ModCommand &m = *sndFile.Patterns[0].GetpModCommand(0, 0);
+		m.note = NOTE_MIDDLEC;
+		m.instr = 1;
+		data = SaveSoundFile(sndFile);
+		sndFile.Destroy();
+	}
+	openmpt::module mod(data.data(), data.size());
+
+	VERIFY_EQUAL(mod.ctl_get_boolean("profile.enabled"), false);
+	VERIFY_EQUAL(mod.ctl_get_text("profile.report"), "");
+	mod.ctl_set_boolean("profile.enabled", true);
+#ifdef MPT_ENABLE_RENDER_PROFILE
+	VERIFY_EQUAL(mod.ctl_get_boolean("profile.enabled"), true);
+#else
+	VERIFY_EQUAL(mod.ctl_get_boolean("profile.enabled"), false);
+	VERIFY_EQUAL(mod.ctl_get_text("profile.report"), "");
+#endif // MPT_ENABLE_RENDER_PROFILE
+
+	std::vector<float> buffer(2 * 1000);
+	std::size_t frames = 0;
+	for(int chunk = 0; chunk < 10; chunk++)
+	{
+		frames += mod.read_interleaved_stereo(44100, 1000, buffer.data());
+	}
+	VERIFY_EQUAL(frames, 10000u);
+
+#ifdef MPT_ENABLE_RENDER_PROFILE
+	// Every line is a key=value pair with a unique key and a non-negative numeric value
+	std::map<std::string, double> report;
+	bool wellFormed = true;
+	const std::string text = mod.ctl_get_text("profile.report");
+	VERIFY_EQUAL(text.empty(), false);
+	VERIFY_EQUAL(text.back(), '\n');
+	std::istringstream lines(text);
+	for(std::string line; std::getline(lines, line); )
+	{
+		const auto separator = line.find('=');
+		if(separator == std::string::npos || separator == 0 || separator + 1 == line.size())
+		{
+			wellFormed = false;
+			continue;
+		}
+		const std::string value = line.substr(separator + 1);
+		char *end = nullptr;
+		const double number = std::strtod(value.c_str(), &end);
+		if(end != value.c_str() + value.size() || number < 0.0)
+			wellFormed = false;
+		if(!report.emplace(line.substr(0, separator), number).second)
+			wellFormed = false;
+	}
+	VERIFY_EQUAL(wellFormed, true);
+
+	for(const char *key : {"frames", "chunks", "chunks.silent", "voices.average", "voices.peak"})
+	{
+		VERIFY_EQUAL_NONCONT(report.count(key), 1u);
+	}
+	for(int stage = 0; stage < RenderProfile::NumStages; stage++)
+	{
+		const std::string name = RenderProfile::GetStageName(static_cast<RenderProfile::Stage>(stage));
+		VERIFY_EQUAL_NONCONT(report.count(name + ".calls"), 1u);
+		VERIFY_EQUAL_NONCONT(report.count(name + ".seconds"), 1u);
+		VERIFY_EQUAL_NONCONT(report.count(name + ".cycles"), (RenderProfile::HasCycleCounter() ? 1u : 0u));
+	}
+	VERIFY_EQUAL(report["frames"], 10000.0);
+	VERIFY_EQUAL(report["chunks"] > 0.0, true);
+	VERIFY_EQUAL(report["chunks.silent"] <= report["chunks"], true);
+	VERIFY_EQUAL(report["voices.peak"] > 0.0, true);
+	VERIFY_EQUAL(report["voices.average"] <= report["voices.peak"], true);
+	VERIFY_EQUAL(report["total.calls"] > 0.0, true);
+	VERIFY_EQUAL(report["read_note.calls"] > 0.0, true);
+	VERIFY_EQUAL(report["mix.calls"] > 0.0, true);
+
+	// Setting the ctl again resets the counters
+	mod.ctl_set_boolean("profile.enabled", true);
+	VERIFY_EQUAL(mod.ctl_get_text("profile.report").find("frames=0\n") == 0, true);
+#endif // MPT_ENABLE_RENDER_PROFILE
+
+	bool reportIsReadOnly = false;
+	try
+	{
+		mod.ctl_set_text("profile.report", "");
+	} catch(const openmpt::exception &)
+	{
+		reportIsReadOnly = true;
+	}
+	VERIFY_EQUAL(reportIsReadOnly, true);
+	mod.ctl_set_boolean("profile.enabled", false);
+	VERIFY_EQUAL(mod.ctl_get_boolean("profile.enabled"), false);
+	VERIFY_EQUAL(mod.ctl_get_text("profile.report"), "");
+#endif // LIBOPENMPT_BUILD && !MODPLUG_NO_FILESAVE
+}
+
+
+// Verify that all mix functions supported by the current CPU are bit-identical to the portable implementation
+static MPT_NOINLINE void TestMixFunctions()
+{
+	mpt::default_prng &prng = *s_PRNG;
+	const auto resampler = std::make_unique<CResampler>();
+
+	// Sample data for all formats with enough padding for the interpolation lookahead in both directions
+	constexpr SmpLength numFrames = 1024, padding = InterpolationLookaheadBufferSize;
+	std::vector<int16> sampleData((numFrames + 2 * padding) * 2);
+	for(auto &smp : sampleData)
+	{
+		smp = mpt::random<int16>(prng);
+	}
+
+	const auto availableFunctions = MixFuncTable::GetAvailableFunctions();
+	VERIFY_EQUAL(availableFunctions.front() == MixFuncTable::Functions, true);
+	VERIFY_EQUAL(availableFunctions.back() == MixFuncTable::GetFunctions(), true);
+#if MPT_ARCH_AARCH64 && !defined(MPT_FLOATMIXER)
+	// The NEON kernels are always built on AArch64, so make sure that they are actually compared here
+	VERIFY_EQUAL(availableFunctions.size(), 2u);
+#endif
+	const double speeds[] = {0.25, 0.9, 1.0, 1.2, 1.5, 2.3};
+	for(const MixFuncInterface *mixFunctions : availableFunctions)
+	{
+		for(uint32 ndx = 0; ndx < 6 * 16; ndx++)
+		{
+			for(const double speed : speeds)
+			{
+				ModChannel chn{};
+				chn.pCurrentSample = (ndx & MixFuncTable::ndx16Bit)
+					? static_cast<const void *>(sampleData.data() + padding * 2)
+					: static_cast<const void *>(reinterpret_cast<const int8 *>(sampleData.data()) + padding * 2);
+				chn.nLength = numFrames / 2;
+				chn.position = SamplePosition(mpt::random<uint32>(prng, 8), mpt::random<uint32>(prng));
+				chn.increment = SamplePosition::FromDouble(speed);
+				chn.leftVol = 4096;
+				chn.rightVol = 3000;
+				chn.rampLeftVol = 1000 << VOLUMERAMPPRECISION;
+				chn.rampRightVol = 2000 << VOLUMERAMPPRECISION;
+				chn.leftRamp = 3 << VOLUMERAMPPRECISION;
+				chn.rightRamp = -(2 << VOLUMERAMPPRECISION);
+				chn.nFilter_A0 = 1 << 22;
+				chn.nFilter_B0 = 1 << 23;
+				chn.nFilter_B1 = -(1 << 21);
+				ModChannel chnSIMD = chn;
+
+				constexpr unsigned int numSamples = 256;
+				std::vector<mixsample_t> expected(numSamples * 2), actual(numSamples * 2);
+				MixFuncTable::Functions[ndx](chn, *resampler, expected.data(), numSamples);
+				mixFunctions[ndx](chnSIMD, *resampler, actual.data(), numSamples);
+
+				VERIFY_EQUAL_NONCONT(expected == actual, true);
+				VERIFY_EQUAL_NONCONT(chn.position.GetRaw(), chnSIMD.position.GetRaw());
+			}
+		}
+	}
+}
+
+
+// The precomputed tables may have been generated on a machine with a different libm,
+// so an entry may differ from a freshly computed one by one unit in the last place.
+template <typename TTable>
+static bool ResamplerTablesMatch(const TTable &computed, const TTable &cached)
+{
+	return std::equal(std::begin(computed), std::end(computed), std::begin(cached), [](const auto a, const auto b)
+	{
+		using value_type = std::decay_t<decltype(a)>;
+		if constexpr(std::is_integral<value_type>::value)
+			return std::abs(static_cast<int64>(a) - static_cast<int64>(b)) <= 1;
+		else
+			return std::abs(a - b) <= std::numeric_limits<value_type>::epsilon() * std::max(std::abs(a), value_type(1));
+	});
+}
+
+// Verify that the cached (and possibly precomputed) resampler tables match freshly computed ones
+static MPT_NOINLINE void TestResamplerTables()
+{
+	const auto computed = std::make_unique<CResampler>(true);
+	const auto cached = std::make_unique<CResampler>();
+
+	VERIFY_EQUAL(ResamplerTablesMatch(computed->gKaiserSinc, cached->gKaiserSinc), true);
+	VERIFY_EQUAL(ResamplerTablesMatch(computed->gDownsample13x, cached->gDownsample13x), true);
+	VERIFY_EQUAL(ResamplerTablesMatch(computed->gDownsample2x, cached->gDownsample2x), true);
+	VERIFY_EQUAL(ResamplerTablesMatch(computed->m_WindowedFIR.lut, cached->m_WindowedFIR.lut), true);
+	for(const auto amigaType : {Resampling::AmigaFilter::A500, Resampling::AmigaFilter::A1200, Resampling::AmigaFilter::Unfiltered})
+	{
+		for(const bool enableFilter : {false, true})
+		{
+			VERIFY_EQUAL(ResamplerTablesMatch(computed->blepTables.GetAmigaTable(amigaType, enableFilter), cached->blepTables.GetAmigaTable(amigaType, enableFilter)), true);
+		}
+	}
+
+	// Non-default FIR settings are computed at runtime, and going back to the defaults restores the default table
+	const std::vector<WFIR_TYPE> defaultLUT(std::begin(cached->m_WindowedFIR.lut), std::end(cached->m_WindowedFIR.lut));
+	cached->m_Settings.gdWFIRCutoff = 0.9;
+	cached->UpdateTables();
+	VERIFY_EQUAL(std::equal(defaultLUT.begin(), defaultLUT.end(), std::begin(cached->m_WindowedFIR.lut)), false);
+	cached->m_Settings = CResamplerSettings{};
+	cached->UpdateTables();
+	VERIFY_EQUAL(std::equal(defaultLUT.begin(), defaultLUT.end(), std::begin(cached->m_WindowedFIR.lut)), true);
+}
+
+
+// Verify that the post-mix global volume / stereo separation pass is bit-identical to the portable implementation.
+// This checks the SSE2 code on x86 and the NEON code on AArch64.
+static MPT_NOINLINE void TestPostMixFunctions()
+{
+	mpt::default_prng &prng = *s_PRNG;
+
+	constexpr uint32 numFrames = 255;
+	std::vector<mixsample_t> input(numFrames * 2);
+	for(auto &smp : input)
+	{
+#ifdef MPT_INTMIXER
+		smp = mpt::random<int32>(prng) / 4;
+#else
+		smp = mpt::random<int32>(prng) / 4 / MIXING_SCALEF;
+#endif
+	}
+	input[0] = MixSampleIntTraits::mix_clip_max;
+	input[1] = MixSampleIntTraits::mix_clip_min;
+
+	const int32 globalVolumes[] = {0, 1, 77, 128, 255, MAX_GLOBAL_VOLUME};
+	const int32 separations[] = {-256, -128, 0, 1, 64, 200, 256};
+	for(const int32 globalVolume : globalVolumes)
+	{
+		for(const int32 separation : separations)
+		{
+			for(int flags = 1; flags <= 3; flags++)
+			{
+				const bool applyGain = (flags & 1) != 0, applySeparation = (flags & 2) != 0;
+				std::vector<mixsample_t> expected = input, actual = input;
+				ApplyStereoGainAndSeparationScalar(expected.data(), numFrames, globalVolume, separation, applyGain, applySeparation);
+				ApplyStereoGainAndSeparation(actual.data(), numFrames, globalVolume, separation, applyGain, applySeparation);
+				VERIFY_EQUAL_NONCONT(expected == actual, true);
+			}
+		}
+	}
+}
+
+
+// Test input for block-based DSP code, fed in blocks of varying length.
+// The noise is generated without the global PRNG so that results can be compared against fixed reference values.
+struct BlockTestInput
+{
+	uint32 numFrames;
+	uint32 silenceStart;
+	uint32 seed;
+
+	uint32 NextRandom() noexcept
+	{
+		seed = seed * 1103515245u + 12345u;
+		return seed;
+	}
+
+	bool IsSilent(uint32 frame) const noexcept { return frame >= silenceStart; }
+
+	// Calls func(firstFrame, count) for each block
+	template <typename TFunc>
+	void ForEachBlock(TFunc &&func) const
+	{
+		static constexpr uint32 blockSizes[] = {1, 17, 256, MIXBUFFERSIZE, 100};
+		for(uint32 frame = 0, block = 0; frame < numFrames; block++)
+		{
+			const uint32 count = std::min(blockSizes[block % std::size(blockSizes)], numFrames - frame);
+			func(frame, count);
+			frame += count;
+		}
+	}
+};
+
+
+#ifndef NO_PLUGINS
+
+// Renders a fixed test signal through a DMO plugin in blocks of varying length.
+static std::vector<float> RenderDMOPlugin(int32 pluginID, const char *libraryName, const std::vector<std::pair<PlugParamIndex, PlugParamValue>> &params)
+{
+	BlockTestInput input{8192, 6144, 1};
+	std::vector<float> output;
+
+	auto sndFile = std::make_shared<CSoundFile>();
+	MixerSettings mixerSettings = sndFile->m_MixerSettings;
+	mixerSettings.gdwMixingFreq = 48000;
+	sndFile->SetMixerSettings(mixerSettings);
+
+	SNDMIXPLUGIN &mixPlugin = sndFile->m_MixPlugins[0];
+	mixPlugin.Info.dwPluginId1 = kDmoMagic;
+	mixPlugin.Info.dwPluginId2 = pluginID;
+	mixPlugin.Info.szLibraryName = libraryName;
+	if(!CreateMixPluginProc(mixPlugin, *sndFile) || !mixPlugin.pMixPlugin)
+		return output;
+	IMixPlugin &plugin = *mixPlugin.pMixPlugin;
+	for(const auto &[index, value] : params)
+	{
+		plugin.SetParameter(index, value);
+	}
+	plugin.Resume();
+
+	output.reserve(input.numFrames * 2);
+	std::vector<float> dummy(MIXBUFFERSIZE * 2);
+	input.ForEachBlock([&](uint32 firstFrame, uint32 count)
+	{
+		float *inL = plugin.m_mixBuffer.GetInputBuffer(0), *inR = plugin.m_mixBuffer.GetInputBuffer(1);
+		for(uint32 i = 0; i < count; i++)
+		{
+			const uint32 frame = firstFrame + i;
+			const float noise = static_cast<float>((input.NextRandom() >> 16) & 0x7FFF) * (1.0f / 16384.0f) - 1.0f;
+			const float t = static_cast<float>(frame);
+			inL[i] = input.IsSilent(frame) ? 0.0f : 0.5f * std::sin(t * 0.05f) + 0.25f * noise;
+			inR[i] = input.IsSilent(frame) ? 0.0f : 0.4f * std::sin(t * 0.031f) - 0.2f * noise;
+		}
+		plugin.Process(dummy.data(), dummy.data() + MIXBUFFERSIZE, count);
+		const float *outL = plugin.m_mixBuffer.GetOutputBuffer(0), *outR = plugin.m_mixBuffer.GetOutputBuffer(1);
+		for(uint32 i = 0; i < count; i++)
+		{
+			output.push_back(outL[i]);
+			output.push_back(outR[i]);
+		}
+	});
+	return output;
+}
+
+#endif // !NO_PLUGINS
+
+
+// Verify that the DMO plugin emulations keep producing the same output as the original sample-by-sample implementations.
+// The reference values allow for small rounding differences, as compilers may contract multiplications and additions
+// differently depending on the target, and denormals are flushed to zero where supported.
+static MPT_NOINLINE void TestDMOPlugins()
+{
+#ifndef NO_PLUGINS
+	struct DMOTestCase
+	{
+		int32 id;
+		const char *name;
+		std::vector<std::pair<PlugParamIndex, PlugParamValue>> params;
+		double energy;
+		float probes[8];
+	};
+	static const DMOTestCase testCases[] =
+	{
+		{ int32(0xEFE6629C), "Chorus", {}, 613.664373, {0.266835034f, 0.0914581865f, 0.354484439f, 0.478684664f, -0.144307017f, 0.216395974f, -0.0127104102f, -0.00841103122f} },
+		{ int32(0xEFE6629C), "Chorus", {{0, 0.7f}, {1, 0.5f}, {2, 0.3f}, {3, 0.0f}, {4, 0.25f}, {5, 0.8f}, {6, 0.3f}}, 306.720001, {0.1563631f, 0.130042464f, 0.0938457698f, 0.0753900707f, -0.182300538f, -0.00856474042f, 0.0473952554f, -0.00336192874f} },
+		{ int32(0xEF011F79), "Compressor", {}, 840.418142, {0.36207813f, 0.287415177f, 0.0338301137f, 0.1439244f, -0.375327379f, 0.25659439f, 0.0f, 0.0f} },
+		{ int32(0xEF011F79), "Compressor", {{0, 0.7f}, {1, 0.1f}, {2, 0.2f}, {3, 0.3f}, {4, 0.5f}, {5, 0.5f}}, 141568.035, {6.27248621f, 6.41021633f, 0.151701182f, 0.331163317f, -0.63332665f, 0.370536029f, 0.0f, 0.0f} },
+		{ int32(0xEF114C90), "Distortion", {}, 3712.65763, {0.530553222f, 0.574167132f, 0.565674245f, 0.588916302f, -0.600745857f, 0.635106564f, 0.0f, 0.0f} },
+		{ int32(0xEF114C90), "Distortion", {{0, 0.9f}, {1, 0.6f}, {2, 0.5f}, {3, 0.6f}, {4, 0.4f}}, 25592.7815, {-1.2759937f, -1.27018619f, -1.1465199f, 1.41845202f, -1.19247591f, -1.77828896f, 2.82574698e-30f, 0.0f} },
+		{ int32(0xEF3E932C), "Echo", {}, 371.229068, {0.204900086f, 0.130288035f, 0.135440797f, 0.244722858f, -0.337005258f, 0.206116378f, 0.0f, 0.0f} },
+		{ int32(0xEF3E932C), "Echo", {{0, 0.5f}, {1, 0.7f}, {2, 0.01f}, {3, 0.3f}, {4, 1.0f}}, 481.57139, {0.204900086f, 0.297691494f, 0.135440797f, 0.203401163f, -0.337005258f, 0.0769028664f, 0.0f, 0.0f} },
+		{ int32(0xEFCA3D92), "Flanger", {}, 774.21144, {0.442754149f, -0.0935053527f, -0.0210753009f, -0.333002329f, -0.614267886f, -0.187666982f, 0.000186797246f, 4.17195423e-07f} },
+		{ int32(0xEFCA3D92), "Flanger", {{0, 0.3f}, {1, 0.9f}, {2, 0.6f}, {3, 0.0f}, {4, 0.5f}, {5, 0.1f}, {6, 1.0f}}, 971.426946, {0.243813455f, 0.367499411f, -0.499088645f, 0.217761159f, -0.274808168f, 0.29551053f, 0.145922393f, -0.0100352801f} },
+		{ int32(0xDAFD8210), "Gargle", {}, 529.506339, {0.367097706f, 0.054305695f, 0.186438635f, 0.203578547f, -0.324020803f, 0.257013768f, 0.0f, 0.0f} },
+		{ int32(0xEF985E71), "I3DL2Reverb", {{12, 0.0f}}, 136.057439, {0.0f, 0.0f, 0.0f, -0.0085631879f, 0.0633311495f, -0.230026573f, 0.154035658f, 0.0341568552f} },
+		{ int32(0xEF985E71), "I3DL2Reverb", {{12, 1.0f / 3.0f}}, 72.4207154, {0.0f, 0.0f, 0.0f, -0.00267175166f, 0.0151225748f, -0.169912741f, 0.154350787f, -0.103053391f} },
+		{ int32(0xEF985E71), "I3DL2Reverb", {{12, 2.0f / 3.0f}}, 118.746388, {0.0f, 0.0f, 0.0f, 0.0168171562f, 0.0761885121f, -0.23471117f, 0.0743103474f, -0.0764771551f} },
+		{ int32(0xEF985E71), "I3DL2Reverb", {{12, 1.0f}, {3, 0.3f}, {9, 0.4f}}, 25.6669699, {0.0f, 0.0f, 0.0f, -0.0103141405f, 0.00345814787f, 0.126105562f, 0.00684685167f, -0.0532786548f} },
+		{ int32(0x120CED89), "ParamEq", {{0, 0.3f}, {1, 0.3f}, {2, 0.8f}}, 1659.92887, {0.363263696f, 0.228065848f, 0.345964164f, 0.50851965f, -0.616301894f, 0.411306262f, 0.0f, 0.0f} },
+		{ int32(0x120CED89), "ParamEq", {{0, 0.9f}, {1, 0.1f}, {2, 0.1f}}, 1420.15182, {0.37966609f, 0.266805738f, 0.240531623f, 0.470994115f, -0.611265838f, 0.40516901f, 0.0f, 0.0f} },
+		{ int32(0x87FC0268), "WavesReverb", {}, 2313.23222, {0.0f, 0.125872627f, 0.573017001f, -0.396229386f, 0.306391954f, 0.374471635f, -0.408706933f, 0.523945689f} },
+		{ int32(0x87FC0268), "WavesReverb", {{0, 0.8f}, {1, 0.5f}, {2, 0.7f}, {3, 0.5f}}, 17.8669403, {0.0449333563f, 0.0286122523f, 0.0298916232f, 0.0535273179f, -0.0738059357f, 0.0453265235f, -0.000128449668f, 0.000161872347f} },
+	};
+
+	const auto verifyPlugins = [&]()
+	{
+		for(const auto &testCase : testCases)
+		{
+			const std::vector<float> output = RenderDMOPlugin(testCase.id, testCase.name, testCase.params);
+			VERIFY_EQUAL_NONCONT(output.size(), 8192u * 2u);
+			if(output.size() != 8192u * 2u)
+				continue;
+			double energy = 0.0;
+			for(const float smp : output)
+			{
+				energy += static_cast<double>(smp) * static_cast<double>(smp);
+			}
+			VERIFY_EQUAL_EPS(energy, testCase.energy, testCase.energy * 1e-4);
+			for(uint32 probe = 0; probe < 8; probe++)
+			{
+				const float expected = testCase.probes[probe];
+				VERIFY_EQUAL_EPS(output[(1023 + probe * 1024) * 2 + (probe & 1)], expected, std::max(std::abs(expected), 1.0f) * 1e-4f);
+			}
+		}
+	};
+
+	verifyPlugins();
+#if defined(MPT_ENABLE_ARCH_INTRINSICS) && defined(MODPLUG_TRACKER) && !defined(MPT_BUILD_WINESUPPORT)
+	// Run the scalar fallbacks as well
+	const auto enabledFeatures = CPU::detail::EnabledFeatures;
+	CPU::detail::EnabledFeatures = {};
+	verifyPlugins();
+	CPU::detail::EnabledFeatures = enabledFeatures;
+#endif
+#endif // !NO_PLUGINS
+}
+
+
+// Runs every operation of a SIMD backend on the given inputs and collects the results
+template <typename Vec>
+static std::vector<int32> RunSIMDOps(const std::array<int32, 4> &a32, const std::array<int32, 4> &b32, const std::array<float, 4> &af, const std::array<float, 4> &bf)
+{
+	std::vector<int32> results;
+	const auto add = [&results](typename Vec::i128 v)
+	{
+		int32 tmp[4];
+		Vec::Store(tmp, v);
+		for(const int32 i : tmp)
+			results.push_back(i);
+	};
+	const auto addFloat = [&results](typename Vec::f128 v)
+	{
+		float tmp[4];
+		Vec::StoreFloat(tmp, v);
+		for(const float f : tmp)
+			results.push_back(mpt::bit_cast<int32>(f));
+	};
+	const auto a = Vec::Load(a32.data()), b = Vec::Load(b32.data());
+	add(Vec::Zero());
+	add(Vec::SetInt32(a32[0], a32[1], a32[2], a32[3]));
+	add(Vec::SetInt16(static_cast<int16>(a32[0]), static_cast<int16>(a32[1]), static_cast<int16>(a32[2]), static_cast<int16>(a32[3]), static_cast<int16>(b32[0]), static_cast<int16>(b32[1]), static_cast<int16>(b32[2]), static_cast<int16>(b32[3])));
+	add(Vec::BroadcastInt16(static_cast<int16>(b32[1])));
+	add(Vec::FromInt32(a32[2]));
+	results.push_back(Vec::ToInt32(b));
+	add(Vec::LoadLow64(b32.data()));
+	int32 low[4] = {1, 2, 3, 4};
+	Vec::StoreLow64(low, a);
+	for(const int32 i : low)
+		results.push_back(i);
+	add(Vec::AddInt32(a, b));
+	add(Vec::SubInt32(a, b));
+	add(Vec::template ShiftRightInt32<1>(a));
+	add(Vec::template ShiftRightInt32<17>(b));
+	add(Vec::template ShiftRightInt16<1>(a));
+	add(Vec::template ShiftRightInt16<15>(b));
+	add(Vec::AddInt16(a, b));
+	add(Vec::SubInt16(a, b));
+	add(Vec::And(a, b));
+	add(Vec::AddSaturateInt16(a, b));
+	add(Vec::SubSaturateInt16(a, b));
+	add(Vec::MulHighInt16(a, b));
+	add(Vec::MulAddInt16(a, b));
+	add(Vec::PackSaturateInt32(a, b));
+	add(Vec::UnpackLowInt16(a, b));
+	add(Vec::UnpackLowInt32(a, b));
+	add(Vec::UnpackLowInt64(a, b));
+	add(Vec::SwapHalves(a));
+	add(Vec::BroadcastLowInt32(b));
+	const auto fa = Vec::LoadFloat(af.data()), fb = Vec::LoadFloat(bf.data());
+	addFloat(fa);
+	addFloat(Vec::BroadcastFloat(bf[3]));
+	addFloat(Vec::SetFloat(bf[2], af[1], bf[0], af[3]));
+	addFloat(Vec::AddFloat(fa, fb));
+	addFloat(Vec::SubFloat(fa, fb));
+	addFloat(Vec::MulFloat(fa, fb));
+	return results;
+}
+
+
+#ifndef NO_REVERB
+
+// Renders random input followed by silence through the reverb, and returns the wet output
+static std::vector<mixsample_t> RenderReverb(CReverb::Kernels kernels, uint32 reverbType, uint32 seed)
+{
+	auto reverb = std::make_unique<CReverb>();
+	reverb->SetKernels(kernels);
+	reverb->m_Settings.m_nReverbType = reverbType;
+	reverb->m_Settings.m_nReverbDepth = 12;
+	mixsample_t rOfsVol = 0, lOfsVol = 0;
+	reverb->Initialize(true, rOfsVol, lOfsVol, 44100);
+
+	BlockTestInput input{16384, 12288, seed};
+	std::vector<mixsample_t> output;
+	output.reserve(input.numFrames * 2);
+	std::vector<mixsample_t> dry(MIXBUFFERSIZE * 2), send(MIXBUFFERSIZE * 2);
+	input.ForEachBlock([&](uint32 firstFrame, uint32 count)
+	{
+		std::fill(dry.begin(), dry.end(), mixsample_t(0));
+		// Leave the send buffer untouched once the input is silent, so that the reverb has to detect the silence itself
+		if(!input.IsSilent(firstFrame))
+		{
+			reverb->TouchReverbSendBuffer(send.data(), rOfsVol, lOfsVol, count);
+			for(uint32 i = 0; i < count * 2; i++)
+			{
+				const int32 value = input.IsSilent(firstFrame + i / 2) ? 0 : static_cast<int32>(input.NextRandom()) / 8;
+#ifdef MPT_INTMIXER
+				send[i] += value;
+#else
+				send[i] += value / MIXING_SCALEF;
+#endif
+			}
+		}
+		reverb->Process(dry.data(), send.data(), rOfsVol, lOfsVol, count);
+		output.insert(output.end(), dry.begin(), dry.begin() + count * 2);
+	});
+	return output;
+}
+
+#endif // !NO_REVERB
+
+
+// Verify that the native SIMD backend and the kernels using it behave exactly like the scalar emulation
+static MPT_NOINLINE void TestSIMD()
+{
+	mpt::default_prng &prng = *s_PRNG;
+
+	const std::array<int32, 4> edgeCases = {int32_min, int32_max, -1, 0x7FFF8000};
+	for(int i = 0; i < 64; i++)
+	{
+		std::array<int32, 4> a32, b32;
+		std::array<float, 4> af, bf;
+		for(std::size_t lane = 0; lane < 4; lane++)
+		{
+			a32[lane] = (i == 0) ? edgeCases[lane] : mpt::random<int32>(prng);
+			b32[lane] = (i == 0) ? edgeCases[3 - lane] : mpt::random<int32>(prng);
+			af[lane] = static_cast<float>(mpt::random<int16>(prng)) / 1024.0f;
+			bf[lane] = static_cast<float>(mpt::random<int16>(prng)) / 4096.0f;
+		}
+		const std::vector<int32> emulated = RunSIMDOps<SIMD::Scalar>(a32, b32, af, bf);
+		VERIFY_EQUAL_NONCONT(emulated.empty(), false);
+#if defined(MPT_SIMD_NATIVE)
+		if(SIMD::Native::IsAvailable())
+		{
+			mpt::arch::feature_fence_guard arch_feature_guard;
+			const std::vector<int32> native = RunSIMDOps<SIMD::Native>(a32, b32, af, bf);
+			VERIFY_EQUAL_NONCONT(native == emulated, true);
+		}
+#endif
+	}
+
+#ifndef NO_REVERB
+	for(const uint32 reverbType : {0u, 5u, 13u, 28u})
+	{
+		const uint32 seed = mpt::random<uint32>(prng);
+		const std::vector<mixsample_t> scalar = RenderReverb(CReverb::Kernels::Scalar, reverbType, seed);
+		const std::vector<mixsample_t> emulated = RenderReverb(CReverb::Kernels::EmulatedSIMD, reverbType, seed);
+		const std::vector<mixsample_t> automatic = RenderReverb(CReverb::Kernels::Auto, reverbType, seed);
+		VERIFY_EQUAL_NONCONT(emulated == automatic, true);
+		// The SIMD kernels round some intermediate results differently than the scalar code
+		VERIFY_EQUAL_NONCONT(scalar.size(), emulated.size());
+		double scalarEnergy = 0.0, emulatedEnergy = 0.0;
+		for(std::size_t i = 0; i < std::min(scalar.size(), emulated.size()); i++)
+		{
+			scalarEnergy += static_cast<double>(scalar[i]) * static_cast<double>(scalar[i]);
+			emulatedEnergy += static_cast<double>(emulated[i]) * static_cast<double>(emulated[i]);
+		}
+		VERIFY_EQUAL_NONCONT(emulatedEnergy > 0.0, true);
+		VERIFY_EQUAL_EPS(emulatedEnergy, scalarEnergy, scalarEnergy * 1e-2);
+	}
+#endif // !NO_REVERB
+}
+
+
 static MPT_NOINLINE void TestITCompression()
 {
 	// Test loading / saving of IT-compressed samples
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/**
+ * AudioRingBuffer - Wait-free single-producer/single-consumer ring of interleaved float frames
+ *
+ * The producer (render thread) only calls write() and getFramesToWrite(), the consumer
+ * (audio callback) only calls read(), peek() and discardUntil(). Neither side ever blocks or allocates.
+ * Read and write positions are monotonically increasing frame counters, so the fill level is
+ * simply their difference and no slot has to be sacrificed to tell "full" from "empty".
+ */
+class AudioRingBuffer {
+public:
+    AudioRingBuffer(size_t capacityFrames, int32_t channelCount)
+        : buffer_(capacityFrames * channelCount),
+          capacityFrames_(capacityFrames),
+          channelCount_(channelCount),
+          readPosition_(0),
+          writePosition_(0) {
+    }
+
+    size_t getCapacityFrames() const {
+        return capacityFrames_;
+    }
+
+    /**
+     * Number of frames that can currently be read (consumer side)
+     */
+    size_t getFramesToRead() const {
+        return writePosition_.load(std::memory_order_acquire) - readPosition_.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * Number of frames that can currently be written (producer side)
+     */
+    size_t getFramesToWrite() const {
+        return capacityFrames_ - (writePosition_.load(std::memory_order_relaxed) - readPosition_.load(std::memory_order_acquire));
+    }
+
+    /**
+     * Number of frames buffered, as seen from any thread. Only an estimate while both sides are running.
+     */
+    size_t getFramesBuffered() const {
+        return writePosition_.load(std::memory_order_acquire) - readPosition_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Total number of frames consumed so far (consumer position, readable from any thread)
+     */
+    uint64_t getReadPosition() const {
+        return readPosition_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Total number of frames written so far (producer position)
+     */
+    uint64_t getWritePosition() const {
+        return writePosition_.load(std::memory_order_acquire);
+    }
+
+    /**
+     * Append up to numFrames frames (producer side)
+     * @return Number of frames actually written
+     */
+    size_t write(const float* data, size_t numFrames) {
+        const uint64_t writePos = writePosition_.load(std::memory_order_relaxed);
+        numFrames = std::min(numFrames, getFramesToWrite());
+        copyIn(data, writePos, numFrames);
+        writePosition_.store(writePos + numFrames, std::memory_order_release);
+        return numFrames;
+    }
+
+    /**
+     * Remove up to numFrames frames (consumer side)
+     * @return Number of frames actually read
+     */
+    size_t read(float* data, size_t numFrames) {
+        const uint64_t readPos = readPosition_.load(std::memory_order_relaxed);
+        numFrames = std::min(numFrames, getFramesToRead());
+        copyOut(data, readPos, numFrames);
+        readPosition_.store(readPos + numFrames, std::memory_order_release);
+        return numFrames;
+    }
+
+    /**
+     * Copy up to numFrames frames without consuming them (consumer side)
+     * @return Number of frames actually copied
+     */
+    size_t peek(float* data, size_t numFrames) const {
+        numFrames = std::min(numFrames, getFramesToRead());
+        copyOut(data, readPosition_.load(std::memory_order_relaxed), numFrames);
+        return numFrames;
+    }
+
+    /**
+     * Drop all frames written before the given producer position (consumer side).
+     * Frames that were already consumed are not affected, so this never moves the read position backwards.
+     */
+    void discardUntil(uint64_t position) {
+        const uint64_t readPos = readPosition_.load(std::memory_order_relaxed);
+        if (position > readPos) {
+            readPosition_.store(position, std::memory_order_release);
+        }
+    }
+
+private:
+    void copyIn(const float* data, uint64_t position, size_t numFrames) {
+        const size_t offset = static_cast<size_t>(position % capacityFrames_);
+        const size_t firstPart = std::min(numFrames, capacityFrames_ - offset);
+        std::memcpy(buffer_.data() + offset * channelCount_, data, firstPart * channelCount_ * sizeof(float));
+        std::memcpy(buffer_.data(), data + firstPart * channelCount_, (numFrames - firstPart) * channelCount_ * sizeof(float));
+    }
+
+    void copyOut(float* data, uint64_t position, size_t numFrames) const {
+        const size_t offset = static_cast<size_t>(position % capacityFrames_);
+        const size_t firstPart = std::min(numFrames, capacityFrames_ - offset);
+        std::memcpy(data, buffer_.data() + offset * channelCount_, firstPart * channelCount_ * sizeof(float));
+        std::memcpy(data + firstPart * channelCount_, buffer_.data(), (numFrames - firstPart) * channelCount_ * sizeof(float));
+    }
+
+    std::vector<float> buffer_;
+    const size_t capacityFrames_;
+    const int32_t channelCount_;
+
+    // Each position is only modified by one side; keep them on separate cache lines
+    alignas(64) std::atomic<uint64_t> readPosition_;
+    alignas(64) std::atomic<uint64_t> writePosition_;
+};
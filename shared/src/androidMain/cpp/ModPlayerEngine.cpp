@@ -1,5 +1,7 @@
 #include "ModPlayerEngine.h"
 #include <android/log.h>
+#include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <fstream>
 #include <vector>
@@ -13,26 +15,41 @@ ModPlayerEngine::ModPlayerEngine()
     : module_(nullptr),
       stream_(nullptr),
       playing_(false),
-      shouldStop_(false) {
+      shouldStop_(false),
+      renderThreadRunning_(true),
+      renderEnded_(false),
+      renderWaiting_(false),
+      renderAheadFrames_(DEFAULT_RENDER_AHEAD_MS * SAMPLE_RATE / 1000),
+      renderBuffer_(RENDER_CHUNK_FRAMES * CHANNEL_COUNT),
+      ringBuffer_(RING_BUFFER_FRAMES, CHANNEL_COUNT),
+      flushPosition_(0),
+      flushCrossfade_(false),
+      lastFlushPosition_(0),
+      crossfadeBuffer_(CROSSFADE_FRAMES * CHANNEL_COUNT),
+      crossfadeFrames_(0),
+      crossfadePosition_(0) {
+    renderThread_ = std::thread(&ModPlayerEngine::renderThreadLoop, this);
     LOGD("ModPlayerEngine created");
 }
 
 ModPlayerEngine::~ModPlayerEngine() {
     LOGD("ModPlayerEngine destroyed");
-    unloadModule();
     destroyAudioStream();
+    stopRenderThread();
+    unloadModule();
 }
 
 // ========== Module Management ==========
 
 bool ModPlayerEngine::loadModule(const uint8_t* data, size_t size) {
-    std::lock_guard<std::mutex> lock(moduleMutex_);
+    std::unique_lock<std::mutex> lock(moduleMutex_);
     
     // Unload any existing module
     if (module_) {
         openmpt_module_destroy(module_);
         module_ = nullptr;
     }
+    flushRenderedAudio();
     
     // Load new module from memory
     module_ = openmpt_module_create_from_memory2(
@@ -47,6 +64,9 @@ bool ModPlayerEngine::loadModule(const uint8_t* data, size_t size) {
         return false;
     }
     
+    // Let repeated seeks (scrubbing) resume from a nearby snapshot instead of replaying the whole song
+    openmpt_module_ctl_set_floatingpoint(module_, "seek.checkpoint_interval", SEEK_CHECKPOINT_INTERVAL_SECONDS);
+    
     LOGI("Module loaded successfully");
     LOGI("Title: %s", openmpt_module_get_metadata(module_, "title"));
     LOGI("Type: %s", openmpt_module_get_metadata(module_, "type_long"));
@@ -57,6 +77,8 @@ bool ModPlayerEngine::loadModule(const uint8_t* data, size_t size) {
         createAudioStream();
     }
     
+    lock.unlock();
+    wakeRenderThread();
     return true;
 }
 
@@ -83,13 +105,16 @@ bool ModPlayerEngine::loadModuleFromFile(const char* path) {
 }
 
 void ModPlayerEngine::unloadModule() {
+    // stop() takes moduleMutex_ itself
+    stop();
+    
     std::lock_guard<std::mutex> lock(moduleMutex_);
     
     if (module_) {
         LOGD("Unloading module");
-        stop();
         openmpt_module_destroy(module_);
         module_ = nullptr;
+        flushRenderedAudio();
     }
 }
 
@@ -113,6 +138,7 @@ bool ModPlayerEngine::play() {
     
     shouldStop_.store(false);
     playing_.store(true);
+    wakeRenderThread();
     
     oboe::Result result = stream_->requestStart();
     if (result != oboe::Result::OK) {
@@ -163,7 +189,9 @@ void ModPlayerEngine::stop() {
     if (module_) {
         std::lock_guard<std::mutex> lock(moduleMutex_);
         openmpt_module_set_position_seconds(module_, 0.0);
+        flushRenderedAudio();
     }
+    wakeRenderThread();
     
     LOGI("Playback stopped");
 }
@@ -174,8 +202,12 @@ void ModPlayerEngine::seek(double positionSeconds) {
         return;
     }
     
-    std::lock_guard<std::mutex> lock(moduleMutex_);
-    openmpt_module_set_position_seconds(module_, positionSeconds);
+    {
+        std::lock_guard<std::mutex> lock(moduleMutex_);
+        openmpt_module_set_position_seconds(module_, positionSeconds);
+        flushRenderedAudio();
+    }
+    wakeRenderThread();
     LOGD("Seeked to %.2f seconds", positionSeconds);
 }
 
@@ -184,14 +216,21 @@ void ModPlayerEngine::seek(double positionSeconds) {
 void ModPlayerEngine::setRepeatCount(int32_t count) {
     if (!module_) return;
     
-    std::lock_guard<std::mutex> lock(moduleMutex_);
-    openmpt_module_set_repeat_count(module_, count);
+    {
+        std::lock_guard<std::mutex> lock(moduleMutex_);
+        openmpt_module_set_repeat_count(module_, count);
+        // The audio rendered so far is still valid, but if the render thread already stopped at
+        // the song end, it has to continue now that the song may be repeated again
+        renderEnded_.store(false, std::memory_order_release);
+    }
+    wakeRenderThread();
     LOGD("Repeat count set to %d", count);
 }
 
 void ModPlayerEngine::setMasterGain(int32_t gainMillibel) {
     if (!module_) return;
     
+    // Not flushed, so that moving the slider does not cause dropouts
     std::lock_guard<std::mutex> lock(moduleMutex_);
     openmpt_module_set_render_param(module_, OPENMPT_MODULE_RENDER_MASTERGAIN_MILLIBEL, gainMillibel);
     LOGD("Master gain set to %d mB", gainMillibel);
@@ -200,6 +239,7 @@ void ModPlayerEngine::setMasterGain(int32_t gainMillibel) {
 void ModPlayerEngine::setStereoSeparation(int32_t percent) {
     if (!module_) return;
     
+    // Not flushed, so that moving the slider does not cause dropouts
     std::lock_guard<std::mutex> lock(moduleMutex_);
     openmpt_module_set_render_param(module_, OPENMPT_MODULE_RENDER_STEREOSEPARATION_PERCENT, percent);
     LOGD("Stereo separation set to %d%%", percent);
@@ -208,11 +248,22 @@ void ModPlayerEngine::setStereoSeparation(int32_t percent) {
 void ModPlayerEngine::setTempoFactor(double factor) {
     if (!module_) return;
     
-    std::lock_guard<std::mutex> lock(moduleMutex_);
-    openmpt_module_ctl_set_floatingpoint(module_, "play.tempo_factor", factor);
+    {
+        std::lock_guard<std::mutex> lock(moduleMutex_);
+        openmpt_module_ctl_set_floatingpoint(module_, "play.tempo_factor", factor);
+        flushRenderedAudio(true);
+    }
+    wakeRenderThread();
     LOGD("Tempo factor set to %.2f", factor);
 }
 
+void ModPlayerEngine::setRenderAheadMs(int32_t milliseconds) {
+    milliseconds = std::clamp(milliseconds, MIN_RENDER_AHEAD_MS, MAX_RENDER_AHEAD_MS);
+    renderAheadFrames_.store(milliseconds * SAMPLE_RATE / 1000);
+    wakeRenderThread();
+    LOGD("Render-ahead set to %d ms", milliseconds);
+}
+
 double ModPlayerEngine::getTempoFactor() const {
     if (!module_) return 1.0;
     
@@ -222,8 +273,12 @@ double ModPlayerEngine::getTempoFactor() const {
 void ModPlayerEngine::setPitchFactor(double factor) {
     if (!module_) return;
     
-    std::lock_guard<std::mutex> lock(moduleMutex_);
-    openmpt_module_ctl_set_floatingpoint(module_, "play.pitch_factor", factor);
+    {
+        std::lock_guard<std::mutex> lock(moduleMutex_);
+        openmpt_module_ctl_set_floatingpoint(module_, "play.pitch_factor", factor);
+        flushRenderedAudio(true);
+    }
+    wakeRenderThread();
     LOGD("Pitch factor set to %.2f", factor);
 }
 
@@ -242,8 +297,11 @@ bool ModPlayerEngine::isPlaying() const {
 double ModPlayerEngine::getPositionSeconds() const {
     if (!module_) return 0.0;
     
-    // Note: This is thread-safe as it's a read operation
-    return openmpt_module_get_position_seconds(module_);
+    // Note: This is thread-safe as it's a read operation.
+    // libopenmpt is ahead of what is audible by the amount of audio waiting in the ring buffer.
+    double position = openmpt_module_get_position_seconds(module_)
+        - static_cast<double>(getFramesAhead()) / SAMPLE_RATE;
+    return std::max(position, 0.0);
 }
 
 double ModPlayerEngine::getDurationSeconds() const {
@@ -308,38 +366,58 @@ oboe::DataCallbackResult ModPlayerEngine::onAudioReady(
         void* audioData,
         int32_t numFrames) {
     
-    if (!module_ || !playing_.load()) {
+    float* buffer = static_cast<float*>(audioData);
+    
+    if (!playing_.load()) {
         // Fill with silence
-        memset(audioData, 0, numFrames * CHANNEL_COUNT * sizeof(float));
+        memset(buffer, 0, numFrames * CHANNEL_COUNT * sizeof(float));
         return oboe::DataCallbackResult::Continue;
     }
     
-    // Lock for reading from module
-    std::lock_guard<std::mutex> lock(moduleMutex_);
+    // Drop audio that was rendered before the most recent seek or parameter change.
+    // Everything else here is wait-free: no locks, no allocation, no libopenmpt calls.
+    const uint64_t flushPosition = flushPosition_.load(std::memory_order_acquire);
+    if (flushPosition != lastFlushPosition_) {
+        crossfadeFrames_ = 0;
+        crossfadePosition_ = 0;
+        if (flushCrossfade_.load(std::memory_order_relaxed)) {
+            // Keep the start of the stale audio to fade it out over the new audio
+            const uint64_t readPosition = ringBuffer_.getReadPosition();
+            const size_t staleFrames = flushPosition > readPosition ? static_cast<size_t>(flushPosition - readPosition) : 0;
+            crossfadeFrames_ = ringBuffer_.peek(crossfadeBuffer_.data(), std::min(staleFrames, CROSSFADE_FRAMES));
+        }
+        ringBuffer_.discardUntil(flushPosition);
+        lastFlushPosition_ = flushPosition;
+    }
     
-    // Render audio from libopenmpt
-    size_t framesRendered = openmpt_module_read_interleaved_float_stereo(
-        module_,
-        SAMPLE_RATE,
-        numFrames,
-        static_cast<float*>(audioData)
-    );
+    // Check for the end of the module before looking at the fill level,
+    // so that the last frames rendered before it are not missed
+    const bool ended = renderEnded_.load(std::memory_order_acquire);
+    size_t framesRead = ringBuffer_.read(buffer, numFrames);
     
-    // If we rendered fewer frames than requested, fill the rest with silence
-    if (framesRendered < static_cast<size_t>(numFrames)) {
-        float* buffer = static_cast<float*>(audioData);
-        size_t silenceStart = framesRendered * CHANNEL_COUNT;
-        size_t silenceCount = (numFrames - framesRendered) * CHANNEL_COUNT;
+    // If we got fewer frames than requested, fill the rest with silence
+    if (framesRead < static_cast<size_t>(numFrames)) {
+        size_t silenceStart = framesRead * CHANNEL_COUNT;
+        size_t silenceCount = (numFrames - framesRead) * CHANNEL_COUNT;
         memset(buffer + silenceStart, 0, silenceCount * sizeof(float));
-        
-        // If we got 0 frames, the module has ended
-        if (framesRendered == 0 && !shouldStop_.load()) {
-            LOGD("Module playback ended");
-            playing_.store(false);
-            return oboe::DataCallbackResult::Stop;
-        }
     }
     
+    // After a tempo or pitch change, the audio that was about to be played fades out over the new audio
+    applyCrossfade(buffer, numFrames);
+    
+    // If nothing is left and the render thread has reached the end, the module has ended
+    if (framesRead == 0 && ended && !shouldStop_.load()) {
+        LOGD("Module playback ended");
+        playing_.store(false);
+        return oboe::DataCallbackResult::Stop;
+    }
+    
+    // Only wake up the render thread once the buffer drops below the render-ahead target, and only if it is actually waiting.
+    // Notifying on every callback would cost a futex syscall per callback for nothing most of the time.
+    if (ringBuffer_.getFramesToRead() < static_cast<size_t>(renderAheadFrames_.load(std::memory_order_relaxed))
+        && renderWaiting_.exchange(false)) {
+        renderCondition_.notify_one();
+    }
     return oboe::DataCallbackResult::Continue;
 }
 
@@ -392,3 +470,89 @@ void ModPlayerEngine::destroyAudioStream() {
         stream_.reset();
     }
 }
+
+void ModPlayerEngine::renderThreadLoop() {
+    std::unique_lock<std::mutex> lock(moduleMutex_);
+    
+    while (renderThreadRunning_.load()) {
+        if (!module_ || renderEnded_.load()) {
+            renderCondition_.wait(lock);
+            continue;
+        }
+        
+        const size_t targetFrames = static_cast<size_t>(renderAheadFrames_.load());
+        const auto bufferFull = [this, targetFrames]() {
+            return getFramesAhead() >= targetFrames || ringBuffer_.getFramesToWrite() < RENDER_CHUNK_FRAMES;
+        };
+        if (bufferFull()) {
+            // Buffer is full enough; the audio callback wakes us up once it drops below the target.
+            // Check again after announcing the wait, so that a callback that drained the buffer in between is not missed.
+            // The callback cannot take the lock, so a notification can still arrive just before the wait starts; the timeout covers that.
+            renderWaiting_.store(true);
+            if (bufferFull()) {
+                const auto timeout = std::chrono::milliseconds(
+                    std::max<int64_t>(1, targetFrames * 1000 / SAMPLE_RATE / 4));
+                renderCondition_.wait_for(lock, timeout);
+            }
+            renderWaiting_.store(false);
+            continue;
+        }
+        
+        // Render with the lock held, so that a flush can never be followed by stale audio
+        size_t framesRendered = openmpt_module_read_interleaved_float_stereo(
+            module_,
+            SAMPLE_RATE,
+            RENDER_CHUNK_FRAMES,
+            renderBuffer_.data()
+        );
+        
+        if (framesRendered == 0) {
+            renderEnded_.store(true, std::memory_order_release);
+            continue;
+        }
+        
+        ringBuffer_.write(renderBuffer_.data(), framesRendered);
+    }
+}
+
+void ModPlayerEngine::stopRenderThread() {
+    if (!renderThread_.joinable()) {
+        return;
+    }
+    
+    {
+        std::lock_guard<std::mutex> lock(moduleMutex_);
+        renderThreadRunning_.store(false);
+    }
+    renderCondition_.notify_one();
+    renderThread_.join();
+}
+
+void ModPlayerEngine::wakeRenderThread() {
+    renderCondition_.notify_one();
+}
+
+void ModPlayerEngine::flushRenderedAudio(bool crossfade) {
+    // The audio callback discards everything before this position the next time it runs
+    flushCrossfade_.store(crossfade, std::memory_order_relaxed);
+    flushPosition_.store(ringBuffer_.getWritePosition(), std::memory_order_release);
+    renderEnded_.store(false, std::memory_order_release);
+}
+
+void ModPlayerEngine::applyCrossfade(float* buffer, int32_t numFrames) {
+    const size_t frames = std::min(static_cast<size_t>(numFrames), crossfadeFrames_ - crossfadePosition_);
+    for (size_t frame = 0; frame < frames; frame++, crossfadePosition_++) {
+        const float gain = static_cast<float>(crossfadePosition_) / static_cast<float>(crossfadeFrames_);
+        for (int32_t channel = 0; channel < CHANNEL_COUNT; channel++) {
+            const float stale = crossfadeBuffer_[crossfadePosition_ * CHANNEL_COUNT + channel];
+            float& sample = buffer[frame * CHANNEL_COUNT + channel];
+            sample = sample * gain + stale * (1.0f - gain);
+        }
+    }
+}
+
+size_t ModPlayerEngine::getFramesAhead() const {
+    const uint64_t writePosition = ringBuffer_.getWritePosition();
+    const uint64_t validFrom = std::max(ringBuffer_.getReadPosition(), flushPosition_.load(std::memory_order_acquire));
+    return writePosition > validFrom ? static_cast<size_t>(writePosition - validFrom) : 0;
+}
@@ -4,16 +4,24 @@
 #include <oboe/Oboe.h>
 #include <memory>
 #include <atomic>
+#include <condition_variable>
 #include <mutex>
+#include <thread>
 #include <vector>
 #include <string>
 
+#include "AudioRingBuffer.h"
+
 /**
  * ModPlayerEngine - Core C++ engine for MOD music playback
  * 
  * This class integrates libopenmpt (for MOD rendering) with Oboe (for audio output).
  * It manages the audio stream, renders audio in real-time, and provides thread-safe
  * playback control.
+ *
+ * Rendering happens on a dedicated render thread that keeps a configurable amount of
+ * audio ahead of playback in a wait-free ring buffer. The Oboe callback only copies
+ * out of that ring buffer, so it never takes moduleMutex_ and never calls into libopenmpt.
  */
 class ModPlayerEngine : public oboe::AudioStreamDataCallback,
                         public oboe::AudioStreamErrorCallback {
@@ -76,13 +84,15 @@ public:
     void setRepeatCount(int32_t count);
     
     /**
-     * Set master gain
+     * Set master gain.
+     * Takes effect after the audio that has already been rendered ahead.
      * @param gainMillibel Gain in millibels
      */
     void setMasterGain(int32_t gainMillibel);
     
     /**
      * Set stereo separation.
+     * Takes effect after the audio that has already been rendered ahead.
      * @param percent Separation percentage (0-200, default 100)
      */
     void setStereoSeparation(int32_t percent);
@@ -99,6 +109,14 @@ public:
      */
     double getTempoFactor() const;
     
+    /**
+     * Set how much audio the render thread keeps ahead of playback.
+     * Larger values are more robust against CPU spikes, smaller values make
+     * seeking and parameter changes react faster.
+     * @param milliseconds Render-ahead time (clamped to 10-500 ms, default 50 ms)
+     */
+    void setRenderAheadMs(int32_t milliseconds);
+
     /**
      * Set pitch factor (pitch without changing tempo)
      * @param factor Pitch factor (0.25 to 2.0, 1.0 = normal)
@@ -198,6 +216,30 @@ private:
     // Audio stream management
     void createAudioStream();
     void destroyAudioStream();
+
+    // Render thread management
+    void renderThreadLoop();
+    void stopRenderThread();
+    void wakeRenderThread();
+
+    /**
+     * Discard audio that has been rendered but not played yet.
+     * Must be called with moduleMutex_ held, so that no chunk rendered before the
+     * change can be written to the ring buffer afterwards.
+     * @param crossfade Fade the first CROSSFADE_FRAMES of the discarded audio out over the new audio
+     *                  instead of cutting it off, for changes that should not be heard as a dropout
+     */
+    void flushRenderedAudio(bool crossfade = false);
+
+    /**
+     * Mix the audio kept by a crossfading flush into the start of the new audio (audio callback only)
+     */
+    void applyCrossfade(float* buffer, int32_t numFrames);
+
+    /**
+     * Number of rendered frames that are still waiting to be played, not counting flushed audio
+     */
+    size_t getFramesAhead() const;
     
     // Module object from libopenmpt
     openmpt_module* module_;
@@ -216,4 +258,38 @@ private:
     static constexpr int32_t SAMPLE_RATE = 48000;
     static constexpr int32_t CHANNEL_COUNT = 2;  // Stereo
     static constexpr oboe::AudioFormat AUDIO_FORMAT = oboe::AudioFormat::Float;
+    static constexpr double SEEK_CHECKPOINT_INTERVAL_SECONDS = 10.0;
+
+    // Render-ahead configuration
+    static constexpr int32_t MIN_RENDER_AHEAD_MS = 10;
+    static constexpr int32_t MAX_RENDER_AHEAD_MS = 500;
+    static constexpr int32_t DEFAULT_RENDER_AHEAD_MS = 50;
+    static constexpr size_t RENDER_CHUNK_FRAMES = 256;
+    static constexpr size_t CROSSFADE_FRAMES = 10 * SAMPLE_RATE / 1000;
+    // Room for a full render-ahead window on top of stale audio that has not been discarded yet
+    static constexpr size_t RING_BUFFER_FRAMES = 2 * MAX_RENDER_AHEAD_MS * SAMPLE_RATE / 1000;
+
+    // Render thread state (protected by moduleMutex_ unless atomic)
+    std::thread renderThread_;
+    std::condition_variable renderCondition_;
+    std::atomic<bool> renderThreadRunning_;
+    std::atomic<bool> renderEnded_;  // libopenmpt reported the end of the module
+    std::atomic<bool> renderWaiting_;  // The render thread waits for the audio callback to drain the buffer
+    std::atomic<int32_t> renderAheadFrames_;
+    std::vector<float> renderBuffer_;
+
+    // Rendered audio, written by the render thread and read by the audio callback
+    AudioRingBuffer ringBuffer_;
+    // Ring buffer write position at the most recent flush; everything before it is stale
+    std::atomic<uint64_t> flushPosition_;
+    // The most recent flush should crossfade instead of cutting off (written before flushPosition_)
+    std::atomic<bool> flushCrossfade_;
+
+    // Last flush position applied by the audio callback
+    uint64_t lastFlushPosition_;
+
+    // Stale audio that the audio callback fades out after a crossfading flush
+    std::vector<float> crossfadeBuffer_;
+    size_t crossfadeFrames_;
+    size_t crossfadePosition_;
 };
@@ -189,6 +189,15 @@ Java_com_beyondeye_openmpt_core_ModPlayerNative_nativeGetPitchFactor(
     return engine->getPitchFactor();
 }
 
+JNIEXPORT void JNICALL
+Java_com_beyondeye_openmpt_core_ModPlayerNative_nativeSetRenderAheadMs(
+        JNIEnv* env, jobject thiz, jlong handle, jint milliseconds) {
+    ModPlayerEngine* engine = handle_to_engine(handle);
+    if (engine) {
+        engine->setRenderAheadMs(milliseconds);
+    }
+}
+
 // ========== State Queries ==========
 
 JNIEXPORT jboolean JNICALL
@@ -174,6 +174,17 @@ class AndroidModPlayer : ModPlayer {
         return native.nativeGetPitchFactor(handle)
     }
     
+    /**
+     * Set how much audio is rendered ahead of playback on the native render thread.
+     * Larger values tolerate CPU spikes better, smaller values make seeking and
+     * parameter changes audible sooner.
+     * @param ms Render-ahead time in milliseconds (clamped to 10-500, default 50)
+     */
+    fun setRenderAheadMs(ms: Int) {
+        d(TAG, "Setting render-ahead to $ms ms")
+        native.nativeSetRenderAheadMs(handle, ms)
+    }
+    
     // ========== State Queries ==========
     
     override val playbackState: PlaybackState
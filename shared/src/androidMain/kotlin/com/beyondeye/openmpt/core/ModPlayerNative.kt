@@ -60,6 +60,8 @@ class ModPlayerNative {
     
     external fun nativeGetPitchFactor(handle: Long): Double
     
+    external fun nativeSetRenderAheadMs(handle: Long, milliseconds: Int)
+    
     // ========== State Queries ==========
     
     external fun nativeIsPlaying(handle: Long): Boolean